@@ -53,6 +53,11 @@ extern "C"
         get_main_handler(mh)->process(timestep);
     }
 
+    void scrutiny_c_main_handler_process_budget(scrutiny_c_main_handler_t *mh, scrutiny_c_timediff_t const timestep, uint32_t const budget)
+    {
+        get_main_handler(mh)->process(timestep, budget);
+    }
+
     scrutiny_c_config_t *scrutiny_c_config_construct(void *mem, size_t const bufsize)
     {
         if (bufsize < SCRUTINY_C_CONFIG_SIZE || mem == nullptr)
@@ -106,6 +111,16 @@ extern "C"
         get_config(config)->set_user_command_callback(reinterpret_cast<scrutiny::user_command_callback_t>(callback));
     }
 
+    void scrutiny_c_config_set_async_user_command_callback(scrutiny_c_config_t *config, scrutiny_c_async_user_command_callback_t callback)
+    {
+        get_config(config)->set_async_user_command_callback(reinterpret_cast<scrutiny::async_user_command_callback_t>(callback));
+    }
+
+    void scrutiny_c_config_set_user_command_timeout(scrutiny_c_config_t *config, scrutiny_c_timediff_t const timeout_100ns)
+    {
+        get_config(config)->set_user_command_timeout(timeout_100ns);
+    }
+
 #if SCRUTINY_ENABLE_DATALOGGING == 1
     void scrutiny_c_config_set_datalogging_buffers(scrutiny_c_config_t *config, uint8_t *buffer, scrutiny_c_datalogging_buffer_size_t size)
     {
@@ -153,6 +168,11 @@ extern "C"
         return get_main_handler(mh)->data_to_send();
     }
 
+    int scrutiny_c_main_handler_complete_user_command(scrutiny_c_main_handler_t *mh, uint8_t const *response_data, uint16_t const response_data_length, int const success)
+    {
+        return get_main_handler(mh)->complete_user_command(response_data, response_data_length, static_cast<bool>(success)) ? 1 : 0;
+    }
+
     scrutiny_c_loop_handler_ff_t *scrutiny_c_loop_handler_fixed_freq_construct(void *mem, size_t const size, uint32_t const timestep_100ns, char const *name)
     {
         if (size < SCRUTINY_C_LOOP_HANDLER_FF_SIZE || mem == nullptr)
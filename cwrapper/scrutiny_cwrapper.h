@@ -51,6 +51,13 @@ extern "C"
     /// @param timestep Amount of time elapsed since the last call to this function expressed as multiple of 100ns.
     void scrutiny_c_main_handler_process(scrutiny_c_main_handler_t *main_handler, scrutiny_c_timediff_t const timestep);
 
+    /// @brief Wrapper for `MainHandler::process()` with a budget.
+    /// Long operations are split in slices that are resumed on the next calls
+    /// @param main_handler The `MainHandler` object to work on.
+    /// @param timestep Amount of time elapsed since the last call to this function expressed as multiple of 100ns.
+    /// @param budget Maximum number of bytes copied to memory by this call. 0 means no limit.
+    void scrutiny_c_main_handler_process_budget(scrutiny_c_main_handler_t *main_handler, scrutiny_c_timediff_t const timestep, uint32_t const budget);
+
     /// @brief Wrapper for `MainHandler::receive_data()`.
     /// Pass data received from the server to the scrutiny-embedded lib input stream.
     /// @param main_handler The `MainHandler` object to work on.
@@ -72,6 +79,16 @@ extern "C"
     /// @return Number of bytes available
     uint16_t scrutiny_c_main_handler_data_to_send(scrutiny_c_main_handler_t *main_handler);
 
+    /// @brief Wrapper for `MainHandler::complete_user_command()`.
+    /// Gives the response of an asynchronous User Command whose callback returned `SCRUTINY_C_USER_COMMAND_STATUS_PENDING`.
+    /// The data is copied by the next call to `scrutiny_c_main_handler_process()` and must stay valid until then.
+    /// @param main_handler The `MainHandler` object to work on.
+    /// @param response_data The response payload
+    /// @param response_data_length The response payload size
+    /// @param success 0 to answer the request with a failure
+    /// @return 0 if the previous completion has not been processed yet. 1 otherwise
+    int scrutiny_c_main_handler_complete_user_command(scrutiny_c_main_handler_t *main_handler, uint8_t const *response_data, uint16_t const response_data_length, int const success);
+
     // ==== Config ====
 
     /// @brief Wrapper for `Config::Config()`.
@@ -146,6 +163,19 @@ extern "C"
     /// @param callback The callback
     void scrutiny_c_config_set_user_command_callback(scrutiny_c_config_t *config, scrutiny_c_user_command_callback_t callback);
 
+    /// @brief Wrapper for `Config::set_async_user_command_callback()`
+    /// Same as `scrutiny_c_config_set_user_command_callback()`, but the callback can return `SCRUTINY_C_USER_COMMAND_STATUS_PENDING`
+    /// and give the response later with `scrutiny_c_main_handler_complete_user_command()`
+    /// @param config The `scrutiny::Config` object to work on
+    /// @param callback The callback
+    void scrutiny_c_config_set_async_user_command_callback(scrutiny_c_config_t *config, scrutiny_c_async_user_command_callback_t callback);
+
+    /// @brief Wrapper for `Config::set_user_command_timeout()`
+    /// @param config The `scrutiny::Config` object to work on
+    /// @param timeout_100ns Time given to a pending asynchronous User Command to complete, in multiple of 100ns.
+    /// Limited to `Config::MAX_USER_COMMAND_TIMEOUT_100NS`, which ends before the session times out
+    void scrutiny_c_config_set_user_command_timeout(scrutiny_c_config_t *config, scrutiny_c_timediff_t const timeout_100ns);
+
 #if SCRUTINY_ENABLE_DATALOGGING == 1
     /// @brief Wrapper for `Config::set_datalogging_buffers()`
     /// Sets the buffer used to store data when doing a datalogging acquisition
@@ -0,0 +1,623 @@
+//    scrutiny_raw_format_decoder.cpp
+//        Host side decoder of the datalogging acquisitions encoded with the RawFormat encoder.
+//        Converts the downloaded bytes into one array of values per logged item
+//
+//   - License : MIT - See LICENSE file.
+//   - Project : Scrutiny Debugger (github.com/scrutinydebugger/scrutiny-embedded)
+//
+//   Copyright (c) 2021 Scrutiny Debugger
+
+#include <string.h>
+#if defined(_MSC_VER)
+#include <stdlib.h> // _byteswap_*
+#endif
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SCRUTINY_DECODER_SIMD_X86 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SCRUTINY_DECODER_SIMD_NEON 1
+#endif
+#endif
+
+#include "scrutiny_raw_format_decoder.hpp"
+
+namespace scrutiny
+{
+    namespace decoder
+    {
+        // Values are big endian. The strided loops read them byte by byte and write them in host order, one value at a time.
+        // They work on any host but the bytes spread across the entries keep compilers from vectorizing them.
+        // When the values are contiguous (Columns layout), the whole run is copied then swapped in place, 16 or 32 bytes at a time
+        // with a byte shuffle when the host has one (see swap_blocks), and with a byte swap builtin for what is left.
+        // Hosts whose byte order or builtins are not known use the strided loops only.
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define SCRUTINY_DECODER_CONTIGUOUS 1
+#define SCRUTINY_DECODER_SWAP16(x) __builtin_bswap16(x)
+#define SCRUTINY_DECODER_SWAP32(x) __builtin_bswap32(x)
+#define SCRUTINY_DECODER_SWAP64(x) __builtin_bswap64(x)
+#elif defined(__GNUC__) && defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define SCRUTINY_DECODER_CONTIGUOUS 1
+#define SCRUTINY_DECODER_SWAP16(x) (x)
+#define SCRUTINY_DECODER_SWAP32(x) (x)
+#define SCRUTINY_DECODER_SWAP64(x) (x)
+#elif defined(_MSC_VER) // Every target of MSVC is little endian
+#define SCRUTINY_DECODER_CONTIGUOUS 1
+#define SCRUTINY_DECODER_SWAP16(x) _byteswap_ushort(x)
+#define SCRUTINY_DECODER_SWAP32(x) _byteswap_ulong(x)
+#define SCRUTINY_DECODER_SWAP64(x) _byteswap_uint64(x)
+#else
+#define SCRUTINY_DECODER_CONTIGUOUS 0
+#endif
+
+#if SCRUTINY_DECODER_SIMD_X86
+        // Byte order of a block of 16 bytes once its values of 2, 4 or 8 bytes are swapped
+        static uint8_t const swap_masks[3][16] = {
+            {1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14},
+            {3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12},
+            {7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8},
+        };
+
+        static inline uint8_t const *swap_mask(uint8_t const size)
+        {
+            return swap_masks[(size == sizeof(uint16_t)) ? 0 : ((size == sizeof(uint32_t)) ? 1 : 2)];
+        }
+
+        // The shuffles are compiled for their instruction set only and chosen at run time, so that the decoder needs no target flag
+        typedef uint32_t (*swap_blocks_func_t)(uint8_t *const data, uint32_t const len, uint8_t const *const mask);
+
+        static uint32_t swap_blocks_none(uint8_t *const data, uint32_t const len, uint8_t const *const mask)
+        {
+            static_cast<void>(data);
+            static_cast<void>(len);
+            static_cast<void>(mask);
+            return 0;
+        }
+
+        __attribute__((target("ssse3"))) static uint32_t swap_blocks_ssse3(uint8_t *const data, uint32_t const len, uint8_t const *const mask)
+        {
+            __m128i const shuffle = _mm_loadu_si128(reinterpret_cast<__m128i const *>(mask));
+            uint32_t i = 0;
+            for (; i + 16 <= len; i += 16)
+            {
+                __m128i *const block = reinterpret_cast<__m128i *>(&data[i]);
+                _mm_storeu_si128(block, _mm_shuffle_epi8(_mm_loadu_si128(block), shuffle));
+            }
+            return i;
+        }
+
+        __attribute__((target("avx2"))) static uint32_t swap_blocks_avx2(uint8_t *const data, uint32_t const len, uint8_t const *const mask)
+        {
+            __m128i const shuffle = _mm_loadu_si128(reinterpret_cast<__m128i const *>(mask));
+            __m256i const shuffle2 = _mm256_broadcastsi128_si256(shuffle); // vpshufb shuffles each 128 bits lane on its own
+            uint32_t i = 0;
+            for (; i + 32 <= len; i += 32)
+            {
+                __m256i *const block = reinterpret_cast<__m256i *>(&data[i]);
+                _mm256_storeu_si256(block, _mm256_shuffle_epi8(_mm256_loadu_si256(block), shuffle2));
+            }
+            if (i + 16 <= len)
+            {
+                __m128i *const block = reinterpret_cast<__m128i *>(&data[i]);
+                _mm_storeu_si128(block, _mm_shuffle_epi8(_mm_loadu_si128(block), shuffle));
+                i += 16;
+            }
+            return i;
+        }
+
+        static swap_blocks_func_t select_swap_blocks(void)
+        {
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2"))
+            {
+                return swap_blocks_avx2;
+            }
+            if (__builtin_cpu_supports("ssse3"))
+            {
+                return swap_blocks_ssse3;
+            }
+            return swap_blocks_none;
+        }
+#endif
+
+        /// @brief Swaps in place the values of size bytes found in the whole blocks of 16 bytes at the beginning of data.
+        /// @return The number of bytes swapped. The caller swaps the rest, if any.
+        static inline uint32_t swap_blocks(uint8_t *const data, uint32_t const len, uint8_t const size)
+        {
+#if SCRUTINY_DECODER_SIMD_X86
+            static swap_blocks_func_t const func = select_swap_blocks(); // CPU checked once
+            return func(data, len, swap_mask(size));
+#elif SCRUTINY_DECODER_SIMD_NEON
+            uint32_t i = 0;
+            if (size == sizeof(uint16_t))
+            {
+                for (; i + 16 <= len; i += 16)
+                {
+                    vst1q_u8(&data[i], vrev16q_u8(vld1q_u8(&data[i])));
+                }
+            }
+            else if (size == sizeof(uint32_t))
+            {
+                for (; i + 16 <= len; i += 16)
+                {
+                    vst1q_u8(&data[i], vrev32q_u8(vld1q_u8(&data[i])));
+                }
+            }
+            else
+            {
+                for (; i + 16 <= len; i += 16)
+                {
+                    vst1q_u8(&data[i], vrev64q_u8(vld1q_u8(&data[i])));
+                }
+            }
+            return i;
+#else
+            static_cast<void>(data);
+            static_cast<void>(len);
+            static_cast<void>(size);
+            return 0;
+#endif
+        }
+
+        static void decode_big_endian_16(uint8_t const *src, uint32_t const stride, uint32_t const count, uint8_t *const dst)
+        {
+            uint16_t *const out = reinterpret_cast<uint16_t *>(dst);
+#if SCRUTINY_DECODER_CONTIGUOUS
+            if (stride == sizeof(uint16_t))
+            {
+                memcpy(out, src, static_cast<size_t>(count) * sizeof(uint16_t));
+                uint32_t const swapped = swap_blocks(dst, count * static_cast<uint32_t>(sizeof(uint16_t)), sizeof(uint16_t)) / static_cast<uint32_t>(sizeof(uint16_t));
+                for (uint32_t i = swapped; i < count; i++)
+                {
+                    out[i] = SCRUTINY_DECODER_SWAP16(out[i]);
+                }
+                return;
+            }
+#endif
+            for (uint32_t i = 0; i < count; i++)
+            {
+                out[i] = static_cast<uint16_t>((static_cast<uint16_t>(src[0]) << 8) | static_cast<uint16_t>(src[1]));
+                src += stride;
+            }
+        }
+
+        static void decode_big_endian_32(uint8_t const *src, uint32_t const stride, uint32_t const count, uint8_t *const dst)
+        {
+            uint32_t *const out = reinterpret_cast<uint32_t *>(dst);
+#if SCRUTINY_DECODER_CONTIGUOUS
+            if (stride == sizeof(uint32_t))
+            {
+                memcpy(out, src, static_cast<size_t>(count) * sizeof(uint32_t));
+                uint32_t const swapped = swap_blocks(dst, count * static_cast<uint32_t>(sizeof(uint32_t)), sizeof(uint32_t)) / static_cast<uint32_t>(sizeof(uint32_t));
+                for (uint32_t i = swapped; i < count; i++)
+                {
+                    out[i] = SCRUTINY_DECODER_SWAP32(out[i]);
+                }
+                return;
+            }
+#endif
+            for (uint32_t i = 0; i < count; i++)
+            {
+                out[i] = (static_cast<uint32_t>(src[0]) << 24) | (static_cast<uint32_t>(src[1]) << 16) | (static_cast<uint32_t>(src[2]) << 8) |
+                         static_cast<uint32_t>(src[3]);
+                src += stride;
+            }
+        }
+
+        static void decode_big_endian_64(uint8_t const *src, uint32_t const stride, uint32_t const count, uint8_t *const dst)
+        {
+            uint64_t *const out = reinterpret_cast<uint64_t *>(dst);
+#if SCRUTINY_DECODER_CONTIGUOUS
+            if (stride == sizeof(uint64_t))
+            {
+                memcpy(out, src, static_cast<size_t>(count) * sizeof(uint64_t));
+                uint32_t const swapped = swap_blocks(dst, count * static_cast<uint32_t>(sizeof(uint64_t)), sizeof(uint64_t)) / static_cast<uint32_t>(sizeof(uint64_t));
+                for (uint32_t i = swapped; i < count; i++)
+                {
+                    out[i] = SCRUTINY_DECODER_SWAP64(out[i]);
+                }
+                return;
+            }
+#endif
+            for (uint32_t i = 0; i < count; i++)
+            {
+                out[i] = (static_cast<uint64_t>(src[0]) << 56) | (static_cast<uint64_t>(src[1]) << 48) | (static_cast<uint64_t>(src[2]) << 40) |
+                         (static_cast<uint64_t>(src[3]) << 32) | (static_cast<uint64_t>(src[4]) << 24) | (static_cast<uint64_t>(src[5]) << 16) |
+                         (static_cast<uint64_t>(src[6]) << 8) | static_cast<uint64_t>(src[7]);
+                src += stride;
+            }
+        }
+
+        /// @brief Copies the values without conversion. Used by the MEMORY items and the 8 bits values
+        static void copy_strided(uint8_t const *src, uint32_t const stride, uint32_t const count, uint8_t const size, uint8_t *const dst)
+        {
+            if (stride == size)
+            {
+                memcpy(dst, src, static_cast<size_t>(count) * size);
+                return;
+            }
+
+            for (uint32_t i = 0; i < count; i++)
+            {
+                memcpy(&dst[i * size], src, size);
+                src += stride;
+            }
+        }
+
+        /// @brief Extracts a VARBIT value from its group. Bits are packed LSB first
+        static uint_biggest_t read_packed_bits(uint8_t const *const src, uint_fast16_t bitpos, uint_fast8_t bitsize)
+        {
+            uint_biggest_t value = 0;
+            uint_fast8_t shift = 0;
+            while (bitsize > 0)
+            {
+                uint_fast8_t const offset = bitpos & 0x7;
+                uint_fast8_t const n = SCRUTINY_MIN(static_cast<uint_fast8_t>(8 - offset), bitsize);
+                uint_biggest_t const bits = (src[bitpos >> 3] >> offset) & ((1u << n) - 1);
+                value |= bits << shift;
+                shift += n;
+                bitpos += n;
+                bitsize -= n;
+            }
+            return value;
+        }
+
+        static void decode_bits(uint8_t const *src, uint32_t const stride, uint32_t const count, Signal const *const signal, uint8_t *const dst)
+        {
+            uint8_t const size = signal->element_size();
+            for (uint32_t i = 0; i < count; i++)
+            {
+                uint_biggest_t const value = read_packed_bits(src, signal->bitoffset(), signal->bitsize());
+                if (size == sizeof(uint8_t))
+                {
+                    dst[i] = static_cast<uint8_t>(value);
+                }
+                else if (size == sizeof(uint16_t))
+                {
+                    reinterpret_cast<uint16_t *>(dst)[i] = static_cast<uint16_t>(value);
+                }
+                else if (size == sizeof(uint32_t))
+                {
+                    reinterpret_cast<uint32_t *>(dst)[i] = static_cast<uint32_t>(value);
+                }
+#if SCRUTINY_SUPPORT_64BITS
+                else
+                {
+                    reinterpret_cast<uint64_t *>(dst)[i] = static_cast<uint64_t>(value);
+                }
+#endif
+                src += stride;
+            }
+        }
+
+        RawFormatDecoder::RawFormatDecoder(void) : m_signals(),
+                                                   m_fields(),
+                                                   m_entry_size(0),
+                                                   m_layout(datalogging::ReadLayout::Rows),
+                                                   m_expected_entries(0),
+                                                   m_decoded_entries(0),
+                                                   m_column(0),
+                                                   m_column_position(0),
+                                                   m_pending(),
+                                                   m_error(true) // Not configured
+        {
+        }
+
+        bool RawFormatDecoder::configure(datalogging::Configuration const *const config, RuntimePublishedValue const *const rpvs, uint16_t const rpv_count)
+        {
+            m_signals.clear();
+            m_fields.clear();
+            m_entry_size = 0;
+            m_error = false;
+
+            uint_fast16_t packed_bits = 0; // Number of bits in the current group of VARBIT items
+            uint16_t group_start = 0;      // First signal of the current group of VARBIT items
+            m_signals.resize(config->items_count);
+            for (uint16_t i = 0; i < config->items_count; i++)
+            {
+                datalogging::LoggableItem const *const item = &config->items_to_log[i];
+                Signal *const signal = &m_signals[i];
+                signal->m_item_type = item->type;
+                signal->m_bitoffset = 0;
+                signal->m_bitsize = 0;
+
+                if (item->type != datalogging::LoggableType::VARBIT && packed_bits > 0)
+                {
+                    add_field(static_cast<uint16_t>((packed_bits + 7) >> 3), group_start, static_cast<uint16_t>(i - group_start));
+                    packed_bits = 0;
+                }
+
+                if (item->type == datalogging::LoggableType::MEMORY)
+                {
+                    signal->m_type = VariableType::unknown;
+                    signal->m_element_size = item->data.memory.size;
+                }
+                else if (item->type == datalogging::LoggableType::RPV)
+                {
+                    signal->m_type = VariableType::unknown;
+                    for (uint16_t j = 0; j < rpv_count; j++)
+                    {
+                        if (rpvs[j].id == item->data.rpv.id)
+                        {
+                            signal->m_type = rpvs[j].type;
+                            break;
+                        }
+                    }
+                    signal->m_element_size = (signal->m_type == VariableType::unknown) ? 0 : tools::get_type_size(signal->m_type);
+                }
+                else if (item->type == datalogging::LoggableType::TIME)
+                {
+                    signal->m_type = VariableType::uint32;
+                    signal->m_element_size = sizeof(timestamp_t);
+                }
+                else if (item->type == datalogging::LoggableType::VARBIT)
+                {
+                    uint8_t const bitsize = item->data.varbit.bitsize;
+                    if (bitsize == 0 || bitsize > sizeof(uint_biggest_t) * 8)
+                    {
+                        m_error = true;
+                        break;
+                    }
+                    if (packed_bits == 0)
+                    {
+                        group_start = i;
+                    }
+                    signal->m_bitoffset = static_cast<uint8_t>(packed_bits); // Cannot exceed the group size, limited by the item count
+                    signal->m_bitsize = bitsize;
+                    if (bitsize <= 8)
+                    {
+                        signal->m_type = VariableType::uint8;
+                    }
+                    else if (bitsize <= 16)
+                    {
+                        signal->m_type = VariableType::uint16;
+                    }
+                    else if (bitsize <= 32)
+                    {
+                        signal->m_type = VariableType::uint32;
+                    }
+                    else
+                    {
+                        signal->m_type = BiggestUint;
+                    }
+                    signal->m_element_size = tools::get_type_size(signal->m_type);
+                    packed_bits += bitsize;
+                    continue;
+                }
+                else
+                {
+                    signal->m_element_size = 0;
+                }
+
+                if (signal->m_element_size == 0)
+                {
+                    m_error = true;
+                    break;
+                }
+                add_field(signal->m_element_size, i, 1);
+            }
+
+            if (!m_error && packed_bits > 0)
+            {
+                add_field(static_cast<uint16_t>((packed_bits + 7) >> 3), group_start, static_cast<uint16_t>(config->items_count - group_start));
+            }
+
+            if (m_entry_size == 0)
+            {
+                m_error = true;
+            }
+
+            start(datalogging::ReadLayout::Rows);
+            return !m_error;
+        }
+
+        void RawFormatDecoder::add_field(uint16_t const size, uint16_t const first_signal, uint16_t const signal_count)
+        {
+            Field field;
+            field.offset = m_entry_size;
+            field.size = size;
+            field.first_signal = first_signal;
+            field.signal_count = signal_count;
+            m_fields.push_back(field);
+            m_entry_size = static_cast<uint16_t>(m_entry_size + size);
+        }
+
+        void RawFormatDecoder::start(datalogging::ReadLayout const layout, uint32_t const entry_count)
+        {
+            m_layout = layout;
+            m_expected_entries = entry_count;
+            m_decoded_entries = 0;
+            m_column = 0;
+            m_column_position = 0;
+            m_pending.clear();
+
+            for (size_t i = 0; i < m_signals.size(); i++)
+            {
+                m_signals[i].m_data.clear();
+                m_signals[i].m_data.reserve(static_cast<size_t>(entry_count) * m_signals[i].m_element_size);
+            }
+
+            if (layout == datalogging::ReadLayout::Columns && entry_count == 0)
+            {
+                m_column = static_cast<uint16_t>(m_fields.size()); // Empty acquisition. Nothing to decode
+            }
+        }
+
+        bool RawFormatDecoder::feed(uint8_t const *const data, uint32_t const len)
+        {
+            if (m_error)
+            {
+                return false;
+            }
+
+            if (m_layout == datalogging::ReadLayout::Columns)
+            {
+                if (!feed_columns(data, len))
+                {
+                    m_error = true;
+                }
+            }
+            else
+            {
+                feed_rows(data, len);
+                if (m_expected_entries > 0 && m_decoded_entries + (m_pending.empty() ? 0 : 1) > m_expected_entries)
+                {
+                    m_error = true;
+                }
+            }
+
+            return !m_error;
+        }
+
+        /// @brief Decodes the entries that are complete, field after field. Keeps the bytes of the last entry if it is incomplete.
+        void RawFormatDecoder::feed_rows(uint8_t const *data, uint32_t len)
+        {
+            if (!m_pending.empty())
+            {
+                uint32_t const missing = SCRUTINY_MIN(static_cast<uint32_t>(m_entry_size - m_pending.size()), len);
+                m_pending.insert(m_pending.end(), data, data + missing);
+                data += missing;
+                len -= missing;
+                if (m_pending.size() < m_entry_size)
+                {
+                    return;
+                }
+
+                for (size_t i = 0; i < m_fields.size(); i++)
+                {
+                    decode_field(&m_fields[i], &m_pending[m_fields[i].offset], m_entry_size, 1);
+                }
+                m_decoded_entries++;
+                m_pending.clear();
+            }
+
+            uint32_t const count = len / m_entry_size;
+            if (count > 0)
+            {
+                for (size_t i = 0; i < m_fields.size(); i++)
+                {
+                    decode_field(&m_fields[i], &data[m_fields[i].offset], m_entry_size, count);
+                }
+                m_decoded_entries += count;
+            }
+
+            uint32_t const consumed = count * m_entry_size;
+            m_pending.insert(m_pending.end(), data + consumed, data + len);
+        }
+
+        /// @brief Decodes the fields in the order they arrive. Each field is contiguous for every entry, which is the fastest case
+        bool RawFormatDecoder::feed_columns(uint8_t const *data, uint32_t len)
+        {
+            while (len > 0)
+            {
+                if (m_column >= m_fields.size())
+                {
+                    return false; // More data than the acquisition holds
+                }
+
+                Field const *const field = &m_fields[m_column];
+                uint32_t const column_size = m_expected_entries * field->size;
+                if (!m_pending.empty())
+                {
+                    uint32_t const missing = SCRUTINY_MIN(static_cast<uint32_t>(field->size - m_pending.size()), len);
+                    m_pending.insert(m_pending.end(), data, data + missing);
+                    data += missing;
+                    len -= missing;
+                    if (m_pending.size() < field->size)
+                    {
+                        return true;
+                    }
+                    decode_field(field, m_pending.data(), field->size, 1);
+                    m_column_position += field->size;
+                    m_pending.clear();
+                }
+
+                uint32_t const available = SCRUTINY_MIN(len, column_size - m_column_position);
+                uint32_t const count = available / field->size;
+                if (count > 0)
+                {
+                    decode_field(field, data, field->size, count);
+                    data += count * field->size;
+                    len -= count * field->size;
+                    m_column_position += count * field->size;
+                }
+
+                if (m_column_position >= column_size)
+                {
+                    m_column++;
+                    m_column_position = 0;
+                }
+                else if (len > 0)
+                {
+                    m_pending.insert(m_pending.end(), data, data + len); // Less than a value left
+                    len = 0;
+                }
+            }
+
+            return true;
+        }
+
+        /// @brief Appends count values of each signal stored in a field
+        /// @param field The field to decode
+        /// @param src First byte of the field in the first entry
+        /// @param stride Distance between 2 values of the field in src
+        /// @param count Number of values to decode
+        void RawFormatDecoder::decode_field(Field const *const field, uint8_t const *const src, uint32_t const stride, uint32_t const count)
+        {
+            for (uint16_t i = 0; i < field->signal_count; i++)
+            {
+                Signal *const signal = &m_signals[field->first_signal + i];
+                size_t const start = signal->m_data.size();
+                signal->m_data.resize(start + static_cast<size_t>(count) * signal->m_element_size);
+                uint8_t *const dst = &signal->m_data[start];
+
+                if (signal->m_item_type == datalogging::LoggableType::VARBIT)
+                {
+                    decode_bits(src, stride, count, signal, dst);
+                }
+                else if (signal->m_item_type == datalogging::LoggableType::MEMORY || signal->m_element_size == sizeof(uint8_t))
+                {
+                    copy_strided(src, stride, count, signal->m_element_size, dst);
+                }
+                else if (signal->m_element_size == sizeof(uint16_t))
+                {
+                    decode_big_endian_16(src, stride, count, dst);
+                }
+                else if (signal->m_element_size == sizeof(uint32_t))
+                {
+                    decode_big_endian_32(src, stride, count, dst);
+                }
+                else if (signal->m_element_size == sizeof(uint64_t))
+                {
+                    decode_big_endian_64(src, stride, count, dst);
+                }
+            }
+        }
+
+        bool RawFormatDecoder::complete(void) const
+        {
+            if (m_error || !m_pending.empty())
+            {
+                return false;
+            }
+
+            if (m_layout == datalogging::ReadLayout::Columns)
+            {
+                return m_column >= m_fields.size();
+            }
+
+            return m_expected_entries == 0 || m_decoded_entries == m_expected_entries;
+        }
+
+        uint32_t RawFormatDecoder::entry_count(void) const
+        {
+            if (m_layout == datalogging::ReadLayout::Columns)
+            {
+                return complete() ? m_expected_entries : 0;
+            }
+
+            return m_decoded_entries;
+        }
+    }
+}
@@ -0,0 +1,140 @@
+//    scrutiny_raw_format_decoder.hpp
+//        Host side decoder of the datalogging acquisitions encoded with the RawFormat encoder.
+//        Converts the downloaded bytes into one array of values per logged item
+//
+//   - License : MIT - See LICENSE file.
+//   - Project : Scrutiny Debugger (github.com/scrutinydebugger/scrutiny-embedded)
+//
+//   Copyright (c) 2021 Scrutiny Debugger
+
+#ifndef ___SCRUTINY_RAW_FORMAT_DECODER_H___
+#define ___SCRUTINY_RAW_FORMAT_DECODER_H___
+
+#include <stdint.h>
+#include <vector>
+
+#include "scrutiny.hpp"
+
+#if !SCRUTINY_ENABLE_DATALOGGING
+#error "The RawFormat decoder requires the datalogging feature"
+#endif
+
+namespace scrutiny
+{
+    namespace decoder
+    {
+        /// @brief The decoded values of one logged item
+        class Signal
+        {
+        public:
+            /// @brief Returns the values as an array of T. T must match the element size
+            template <class T>
+            inline T const *values(void) const { return reinterpret_cast<T const *>(m_data.data()); }
+
+            /// @brief Returns the raw decoded bytes. Values are in host byte order, except for MEMORY items that are copied as is
+            inline uint8_t const *data(void) const { return m_data.data(); }
+
+            /// @brief Returns the number of values decoded up to now
+            inline uint32_t count(void) const { return static_cast<uint32_t>(m_data.size() / m_element_size); }
+
+            /// @brief Returns the type of the logged item
+            inline datalogging::LoggableType item_type(void) const { return m_item_type; }
+
+            /// @brief Returns the type of the values. unknown for MEMORY items, whose bytes are left in the device byte order
+            inline VariableType type(void) const { return m_type; }
+
+            /// @brief Returns the size of a single value in bytes
+            inline uint8_t element_size(void) const { return m_element_size; }
+
+            /// @brief Returns the position of the first bit of a VARBIT item in its group of consecutive VARBIT items
+            inline uint8_t bitoffset(void) const { return m_bitoffset; }
+
+            /// @brief Returns the number of bits of a VARBIT item
+            inline uint8_t bitsize(void) const { return m_bitsize; }
+
+        protected:
+            friend class RawFormatDecoder;
+
+            datalogging::LoggableType m_item_type; // What was logged
+            VariableType m_type;                   // Type of the decoded values
+            uint8_t m_element_size;                // Size of a value in the output
+            uint8_t m_bitoffset;                   // Position of the first bit in its VARBIT group. VARBIT only
+            uint8_t m_bitsize;                     // Number of bits. VARBIT only
+            std::vector<uint8_t> m_data;           // Decoded values
+        };
+
+        /// @brief Decodes an acquisition as sent by the ReadAcquisition requests, in either layout.
+        /// The data can be given in chunks of any size, as it is downloaded.
+        /// Values are decoded one field at a time over many entries. With the Columns layout, the values of a field are contiguous
+        /// and are byte swapped in bulk, which is faster than the Rows layout.
+        class RawFormatDecoder
+        {
+        public:
+            RawFormatDecoder(void);
+
+            /// @brief Computes the layout of the entries from the datalogging configuration
+            /// @param config The configuration given to the device
+            /// @param rpvs The Runtime Published Values of the device. Gives the type of the RPV items
+            /// @param rpv_count Number of RPVs in rpvs
+            /// @return false if the configuration cannot be decoded
+            bool configure(datalogging::Configuration const *const config, RuntimePublishedValue const *const rpvs, uint16_t const rpv_count);
+
+            /// @brief Clears the decoded values and waits for a new acquisition
+            /// @param layout The layout requested in the ReadAcquisition request
+            /// @param entry_count Number of entries in the acquisition. Required by the Columns layout. Optional with Rows
+            void start(datalogging::ReadLayout const layout, uint32_t const entry_count = 0);
+
+            /// @brief Decodes the next bytes of the acquisition
+            /// @param data The bytes, following those given at the previous call
+            /// @param len Number of bytes
+            /// @return false if the data goes beyond the expected acquisition size
+            bool feed(uint8_t const *const data, uint32_t const len);
+
+            /// @brief Returns true if all the expected data has been decoded. With Rows and no entry count, when no partial entry is pending
+            bool complete(void) const;
+
+            /// @brief Returns the number of entries completely decoded
+            uint32_t entry_count(void) const;
+
+            /// @brief Returns the size of an entry in the acquisition
+            inline uint16_t entry_size(void) const { return m_entry_size; }
+
+            /// @brief Returns the number of signals, one per logged item
+            inline uint16_t signal_count(void) const { return static_cast<uint16_t>(m_signals.size()); }
+
+            /// @brief Returns the decoded values of a logged item
+            inline Signal const *signal(uint16_t const index) const { return &m_signals[index]; }
+
+            /// @brief Returns true if the configuration was invalid or if too much data was given
+            inline bool error(void) const { return m_error; }
+
+        protected:
+            /// @brief A group of bytes in the entry. A single item, or a group of consecutive VARBIT items
+            struct Field
+            {
+                uint16_t offset;       // Position in the entry
+                uint16_t size;         // Number of bytes
+                uint16_t first_signal; // Index of the first signal stored in this field
+                uint16_t signal_count; // Number of signals stored in this field. More than 1 for a VARBIT group only
+            };
+
+            void add_field(uint16_t const size, uint16_t const first_signal, uint16_t const signal_count);
+            void decode_field(Field const *const field, uint8_t const *const src, uint32_t const stride, uint32_t const count);
+            void feed_rows(uint8_t const *data, uint32_t len);
+            bool feed_columns(uint8_t const *data, uint32_t len);
+
+            std::vector<Signal> m_signals;    // Output. One per logged item
+            std::vector<Field> m_fields;      // The entry, field by field
+            uint16_t m_entry_size;            // Size of an entry
+            datalogging::ReadLayout m_layout; // Order of the data being decoded
+            uint32_t m_expected_entries;      // Number of entries expected. 0 if unknown
+            uint32_t m_decoded_entries;       // Number of entries decoded. Rows layout only
+            uint16_t m_column;                // Field being decoded. Columns layout only
+            uint32_t m_column_position;       // Number of bytes of the actual field decoded. Columns layout only
+            std::vector<uint8_t> m_pending;   // Bytes of an entry or a field cut between 2 calls to feed()
+            bool m_error;                     // Error flag
+        };
+    }
+}
+
+#endif // ___SCRUTINY_RAW_FORMAT_DECODER_H___
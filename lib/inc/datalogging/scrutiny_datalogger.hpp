@@ -53,6 +53,17 @@ namespace scrutiny
                 buffer_size_t const buffer_size,
                 trigger_callback_t trigger_callback = nullptr);
 
+            /// @brief Initializes the datalogger with an external storage instead of a RAM buffer
+            /// @param main_handler A pointer to the main handler to be used to access memory and RPVs
+            /// @param timebase The timebase used to keep track of time
+            /// @param storage The storage that holds the acquisition
+            /// @param trigger_callback A function pointer to call when the datalogging trigger condition trigs. Executed in the owner loop (no thread safety)
+            void init(
+                MainHandler const *const main_handler,
+                Timebase const *const timebase,
+                Storage *const storage,
+                trigger_callback_t trigger_callback = nullptr);
+
             /// @brief Configure the datalogger with a configuration received by the server
             /// @param timebase_for_log The timebase used for time logging
             /// @param config_id A configuration ID that will be attached to the acquisition for validation.
@@ -93,6 +104,9 @@ namespace scrutiny
             /// @brief Returns a DataReader object that will iterate through each samples
             inline DataReader *get_reader(void) { return m_encoder.get_reader(); }
 
+            /// @brief Returns the size of the datalogging buffer or storage in bytes
+            inline buffer_size_t get_buffer_size(void) const { return m_buffer_size; }
+
             /// @brief Returns the internal DataEncoder object used to write the samples in the datalogging buffer
             inline DataEncoder *get_encoder(void) { return &m_encoder; }
 
@@ -105,9 +119,39 @@ namespace scrutiny
             /// @brief Returns true if the active configuration is valid. Must be called after a call to "configure"
             inline bool config_valid(void) const { return m_config_valid; }
 
-            /// @brief Returns the number of point after the trigger, indicating the exact position of the trigger point in a acquisition
+            /// @brief Returns the number of point after the trigger, indicating the exact position of the trigger point in a acquisition.
+            /// For a segmented acquisition, relates to the last segment
             inline buffer_size_t log_points_after_trigger(void) const { return m_log_points_after_trigger; }
 
+            /// @brief Returns the number of segments (triggered captures) in the acquisition
+            inline uint16_t get_segment_count(void) const { return m_encoder.get_segment_count(); }
+
+            /// @brief Returns the number of segments completely acquired so far
+            inline uint16_t get_completed_segment_count(void) const { return m_completed_segment_count; }
+
+            /// @brief Gives the details of a segment of the acquisition
+            /// @param segment The segment index
+            /// @param trigger_timestamp The timestamp of the trigger in the timebase used for time logging
+            /// @param entry_count Number of points in the segment
+            /// @param points_after_trigger Number of points in the segment after its trigger point
+            /// @return false if the segment is not acquired
+            bool get_segment_info(uint16_t const segment, timestamp_t *const trigger_timestamp, buffer_size_t *const entry_count, buffer_size_t *const points_after_trigger) const;
+
+            /// @brief Returns the number of time marks of a segment. Always 0 unless the time axis is TimeAxis::Sparse
+            inline uint16_t get_time_mark_count(uint16_t const segment) const { return m_encoder.get_time_mark_count(segment); }
+
+            /// @brief Gives a time mark of a segment, for acquisitions with a sparse time axis.
+            /// The time of the entries between two marks is interpolated by the server
+            /// @param segment The segment index
+            /// @param index Index of the mark, from the oldest to the newest
+            /// @param entry_index Index of the marked entry within the segment
+            /// @param timestamp Time of the marked entry, in the timebase used for time logging
+            /// @return false if there is no such mark
+            inline bool get_time_mark(uint16_t const segment, uint16_t const index, buffer_size_t *const entry_index, timestamp_t *const timestamp) const
+            {
+                return m_encoder.get_time_mark(segment, index, entry_index, timestamp);
+            }
+
             /// @brief Returns the number of bytes that needs to be acquired since trigger so that the acquisition is considered complete
             buffer_size_t get_bytes_to_acquire_from_trigger_to_completion(void) const;
 
@@ -132,7 +176,7 @@ namespace scrutiny
             void write_diff_bits(uint8_t *new_entry, uint8_t *previous_entry);
 
             MainHandler const *m_main_handler;     // A pointer to the main handler
-            buffer_size_t m_buffer_size;           // The datalogging buffer size
+            buffer_size_t m_buffer_size;           // The datalogging buffer (or storage) size
             trigger_callback_t m_trigger_callback; // A function pointer to be called when the trigger trigs. Executed in the owner loop (no thread safety)
 
             Timebase const *m_timebase;              // Pointer to the timebase for internal time tracking
@@ -151,6 +195,13 @@ namespace scrutiny
             uint16_t m_acquisition_id;                // The acquisition ID of the last acquired acquisition
             uint16_t m_config_id;                     // The configuration ID given by the server
             buffer_size_t m_log_points_after_trigger; // Number of log entry counted after the trigger condition was fulfilled.
+            uint16_t m_completed_segment_count;       // Number of segments of the acquisition completely acquired
+
+            struct
+            {
+                timestamp_t trigger_timestamp;               // Trigger time, in the timebase used for time logging
+                buffer_size_t points_after_trigger;          // Number of log entry counted after the trigger condition was fulfilled
+            } m_segments[SCRUTINY_DATALOGGING_MAX_SEGMENTS]; // Details of each segment of the acquisition
 
             struct
             {
@@ -158,6 +209,7 @@ namespace scrutiny
                 timestamp_t rising_edge_timestamp;        // Timestamp at which the condition passed from false to true
                 trigger::ConditionSet conditions;         // All the conditons object in a union
                 trigger::BaseCondition *active_condition; // A pointer to the active condition object.
+                bool wait_release;                        // Condition must go false before it can trig again. Set when re-armed for the next segment
             } m_trigger;                                  // Data related to the graph trigger
         };
     }
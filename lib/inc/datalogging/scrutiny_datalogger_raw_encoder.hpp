@@ -13,6 +13,7 @@
 #include <stdint.h>
 #include "scrutiny_setup.hpp"
 #include "datalogging/scrutiny_datalogging_types.hpp"
+#include "datalogging/scrutiny_datalogging_storage.hpp"
 #include "scrutiny_timebase.hpp"
 
 #if SCRUTINY_ENABLE_DATALOGGING == 0
@@ -33,22 +34,35 @@ namespace scrutiny
         class RawFormatReader
         {
         public:
-            explicit RawFormatReader(RawFormatEncoder const *const encoder) : m_encoder(encoder)
+            explicit RawFormatReader(RawFormatEncoder const *const encoder) : m_encoder(encoder), m_window{nullptr, 0, 0}
             {
             }
             datalogging::buffer_size_t read(uint8_t *const buffer, datalogging::buffer_size_t const max_size);
             inline bool finished(void) const { return m_finished; }
             void reset(void);
+            bool seek(datalogging::buffer_size_t const position);
             inline bool error(void) const;
             inline datalogging::buffer_size_t get_entry_count(void) const;
             datalogging::buffer_size_t get_total_size(void) const;
+            datalogging::buffer_size_t get_remaining_size(void) const;
             inline datalogging::EncodingType get_encoding(void) const;
+            void set_layout(datalogging::ReadLayout const layout);
+            inline datalogging::ReadLayout get_layout(void) const { return m_layout; }
 
         protected:
+            datalogging::buffer_size_t read_rows(uint8_t *const buffer, datalogging::buffer_size_t const max_size);
+            datalogging::buffer_size_t read_columns(uint8_t *const buffer, datalogging::buffer_size_t const max_size);
+            void convert_to_big_endian(uint8_t *const output, datalogging::buffer_size_t const storage_cursor, datalogging::buffer_size_t const size) const;
+
             RawFormatEncoder const *const m_encoder;
-            datalogging::buffer_size_t m_read_cursor = 0;
+            StorageWindow m_window;                                           // Part of the storage being read
+            uint16_t m_segment = 0;                                           // Segment being read
+            datalogging::buffer_size_t m_segment_position = 0;                // Number of bytes already read in the segment being read
+            datalogging::buffer_size_t m_position = 0;                        // Number of bytes already read in the whole acquisition
             bool m_finished = false;
-            bool m_read_started = false;
+            datalogging::ReadLayout m_layout = datalogging::ReadLayout::Rows; // Order in which the data is output
+            uint8_t m_column = 0;                                             // Columns layout: Field being read
+            datalogging::buffer_size_t m_column_position = 0;                 // Columns layout: Number of bytes already read in the field being read
         };
 
         class RawFormatEncoder
@@ -67,7 +81,13 @@ namespace scrutiny
                 datalogging::Configuration const *const config,
                 uint8_t *const buffer,
                 datalogging::buffer_size_t const buffer_size);
+            void init(
+                MainHandler const *const main_handler,
+                Timebase const *const timebase,
+                datalogging::Configuration const *const config,
+                Storage *const storage);
             void encode_next_entry(void);
+            inline void flush(void) { m_storage->flush(); }
             void reset(void);
             inline void reset_write_counter(void) { m_entry_write_counter = 0; }
             inline datalogging::buffer_size_t get_entry_write_counter(void) const { return m_entry_write_counter; }
@@ -76,10 +96,16 @@ namespace scrutiny
             inline datalogging::buffer_size_t get_read_cursor(void) const { return m_first_valid_entry_index * m_entry_size; }
             inline datalogging::buffer_size_t get_write_cursor(void) const { return m_next_entry_write_index * m_entry_size; }
             inline bool error(void) const { return m_error; }
-            inline datalogging::buffer_size_t get_entry_count(void) const { return m_entries_count; }
+            inline datalogging::buffer_size_t get_entry_count(void) const { return m_previous_segments_entries_count + m_entries_count; }
             inline datalogging::buffer_size_t get_buffer_effective_size(void) const { return m_entry_size * m_max_entries; }
             inline bool buffer_full(void) const { return m_full; }
             datalogging::buffer_size_t remaining_bytes_to_full() const;
+            bool next_segment(void);
+            inline uint16_t get_segment_count(void) const { return m_segment_count; }
+            inline uint16_t get_active_segment(void) const { return m_active_segment; }
+            datalogging::buffer_size_t get_segment_entry_count(uint16_t const segment) const;
+            uint16_t get_time_mark_count(uint16_t const segment) const;
+            bool get_time_mark(uint16_t const segment, uint16_t const index, datalogging::buffer_size_t *const entry_index, timestamp_t *const timestamp) const;
 
             RawFormatReader *get_reader(void)
             {
@@ -87,8 +113,43 @@ namespace scrutiny
             };
 
         protected:
-            uint8_t *m_buffer = nullptr;
-            datalogging::buffer_size_t m_buffer_size = 0;
+            /// @brief Where the entries of a completed segment are. The read and write cursors are relative to the segment
+            struct SegmentRecord
+            {
+                datalogging::buffer_size_t first_valid_entry_index; // Index of the oldest entry in the segment
+                datalogging::buffer_size_t entries_count;           // Number of entries in the segment
+                uint32_t entries_written;                           // Number of entries written in the segment, overwritten ones included
+                uint16_t first_time_mark;                           // Position of the oldest time mark in the time marks of the segment
+                uint16_t time_mark_count;                           // Number of time marks recorded for the segment
+                timestamp_t last_timestamp;                         // Time of the newest entry of the segment
+            };
+
+            /// @brief Time of an entry, for acquisitions with a sparse time axis
+            struct TimeMark
+            {
+                uint32_t entry_number; // Number of the entry in the segment, counted from the first entry ever written in it
+                timestamp_t timestamp; // Time of the entry
+            };
+
+            /// @brief Field of an entry. One per item, except for the VARBIT items packed together that share a field
+            struct EntryField
+            {
+                uint16_t offset;   // Position of the field in the entry
+                uint16_t size;     // Size of the field in bytes
+                bool native_order; // Stored in native byte order. The reader outputs it in big endian
+            };
+
+            void add_field(uint16_t const size, bool const native_order);
+            datalogging::buffer_size_t get_entry_storage_position(datalogging::buffer_size_t const entry) const;
+            void get_segment(uint16_t const segment, SegmentRecord *const record) const;
+            uint16_t get_first_valid_time_mark(uint16_t const segment, SegmentRecord const *const record) const;
+            bool get_oldest_entry_time(uint16_t const segment, SegmentRecord const *const record, uint16_t const first_valid, timestamp_t *const timestamp) const;
+            void record_time(void);
+            void add_time_mark(uint32_t const entry_number, timestamp_t const timestamp);
+
+            Storage *m_storage = nullptr;                   // Where the entries are written
+            BufferStorage m_buffer_storage;                 // Storage used when initialized with a RAM buffer
+            StorageWindow m_write_window = {nullptr, 0, 0}; // Part of the storage accessible for writing. Refreshed only when an entry falls outside
             datalogging::Configuration const *m_config = nullptr;
             RawFormatReader m_reader;
             MainHandler const *m_main_handler = nullptr;
@@ -99,9 +160,28 @@ namespace scrutiny
             datalogging::buffer_size_t m_first_valid_entry_index = 0;
             datalogging::buffer_size_t m_entry_write_counter = 0;
             uint16_t m_entry_size = 0;
+            EntryField m_fields[SCRUTINY_DATALOGGING_MAX_SIGNAL]; // Layout of an entry. Converting to big endian is done by the reader to keep it out of the owner loop
+            uint8_t m_field_count = 0;                             // Number of fields in an entry
+            uint8_t m_native_field_count = 0;                      // Number of fields that the reader converts to big endian
             datalogging::buffer_size_t m_entries_count = 0;
             bool m_full = false;
             bool m_error = false;
+
+            // Segmented acquisitions. The storage is split in m_segment_count segments of m_max_entries entries each.
+            // The members above relate to the active segment only.
+            uint16_t m_segment_count = 1;                                          // Number of segments in the acquisition
+            uint16_t m_active_segment = 0;                                         // Segment being written
+            datalogging::buffer_size_t m_previous_segments_entries_count = 0;      // Number of entries in the segments before the active one
+            SegmentRecord m_completed_segments[SCRUTINY_DATALOGGING_MAX_SEGMENTS]; // The segments before the active one
+            uint32_t m_entries_written = 0;                                        // Number of entries written in the active segment, overwritten ones included
+
+            // Sparse time axis. Each segment gets an equal share of m_time_marks, used as a circular buffer
+            uint16_t m_time_marks_per_segment = 0;                      // Number of time marks available to each segment
+            uint16_t m_first_time_mark = 0;                             // Position of the oldest time mark of the active segment
+            uint16_t m_time_mark_count = 0;                             // Number of time marks of the active segment
+            timestamp_t m_last_timestamp = 0;                           // Time of the last entry written
+            timestamp_t m_last_time_step = 0;                           // Time between the last two entries written
+            TimeMark m_time_marks[SCRUTINY_DATALOGGING_MAX_TIME_MARKS]; // Time marks of all segments
         };
 
         datalogging::buffer_size_t RawFormatReader::get_entry_count(void) const { return m_encoder->get_entry_count(); }
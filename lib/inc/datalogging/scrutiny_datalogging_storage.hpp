@@ -0,0 +1,114 @@
+//    scrutiny_datalogging_storage.hpp
+//        Abstraction of the memory that holds the datalogging acquisition. Gives direct access
+//        to contiguous windows of the storage so the encoder can write samples with a pointer.
+//
+//   - License : MIT - See LICENSE file.
+//   - Project : Scrutiny Debugger (github.com/scrutinydebugger/scrutiny-embedded)
+//
+//   Copyright (c) 2021 Scrutiny Debugger
+
+#ifndef ___SCRUTINY_DATALOGGING_STORAGE_H___
+#define ___SCRUTINY_DATALOGGING_STORAGE_H___
+
+#include <stdint.h>
+#include "scrutiny_setup.hpp"
+#include "datalogging/scrutiny_datalogging_types.hpp"
+
+#if SCRUTINY_ENABLE_DATALOGGING == 0
+#error "Not enabled"
+#endif
+
+namespace scrutiny
+{
+    namespace datalogging
+    {
+        /// @brief A contiguous section of a storage, accessible through a pointer
+        struct StorageWindow
+        {
+            uint8_t *data;        // Pointer to the first byte of the window. nullptr when nothing is mapped
+            buffer_size_t offset; // Position of the first byte of the window in the storage
+            buffer_size_t size;   // Number of bytes accessible through data
+
+            /// @brief Returns true if the range [start, start+length) can be accessed through this window
+            inline bool contains(buffer_size_t const start, buffer_size_t const length) const
+            {
+                return data != nullptr && start >= offset && (start - offset) + length <= size;
+            }
+
+            /// @brief Returns a pointer to the byte at position pos in the storage. The window must contain pos
+            inline uint8_t *at(buffer_size_t const pos) const { return &data[pos - offset]; }
+        };
+
+        /// @brief Interface to the memory where the datalogger stores its acquisition.
+        /// The encoder and the reader each hold their own window and only ask the storage for a new one when
+        /// the data they need is outside of it. Every access within a window is a direct pointer access.
+        class Storage
+        {
+        public:
+            virtual ~Storage(void) {}
+
+            /// @brief Returns the size of the storage in bytes
+            virtual buffer_size_t size(void) const = 0;
+
+            /// @brief Makes a range of the storage accessible through a window. The resulting window may be bigger than the requested range.
+            /// What was mapped by the given window before this call is released.
+            /// @param offset Position of the first byte of the range
+            /// @param length Length of the range
+            /// @param window The window to update
+            /// @return true on success. false if the range is outside the storage or cannot be mapped
+            virtual bool map(buffer_size_t const offset, buffer_size_t const length, StorageWindow *const window) = 0;
+
+            /// @brief Releases a window obtained with map()
+            virtual void unmap(StorageWindow *const window)
+            {
+                window->data = nullptr;
+                window->offset = 0;
+                window->size = 0;
+            }
+
+            /// @brief Called when an acquisition is complete. Lets the storage persist the data if needed.
+            /// Called from the loop that owns the datalogger, like map(). Neither may block. Slow work goes in process()
+            virtual void flush(void) {}
+
+            /// @brief Called by every MainHandler::process(), outside of the loops. Place for the slow work, such as persisting the data after flush()
+            virtual void process(void) {}
+        };
+
+        /// @brief Storage in a RAM buffer. The whole buffer is a single window
+        class BufferStorage : public Storage
+        {
+        public:
+            BufferStorage(void) : m_buffer(nullptr), m_size(0) {}
+
+            /// @brief Sets the buffer used as storage
+            /// @param buffer The buffer
+            /// @param buffer_size Size of the buffer
+            void init(uint8_t *const buffer, buffer_size_t const buffer_size)
+            {
+                m_buffer = buffer;
+                m_size = (buffer == nullptr) ? 0 : buffer_size;
+            }
+
+            virtual buffer_size_t size(void) const override { return m_size; }
+
+            virtual bool map(buffer_size_t const offset, buffer_size_t const length, StorageWindow *const window) override
+            {
+                if (m_buffer == nullptr || offset > m_size || length > m_size - offset)
+                {
+                    return false;
+                }
+
+                window->data = m_buffer;
+                window->offset = 0;
+                window->size = m_size;
+                return true;
+            }
+
+        protected:
+            uint8_t *m_buffer;    // The RAM buffer
+            buffer_size_t m_size; // Size of the RAM buffer
+        };
+    }
+}
+
+#endif // ___SCRUTINY_DATALOGGING_STORAGE_H___
@@ -13,12 +13,15 @@
 
 #include "scrutiny_setup.hpp"
 #include "scrutiny_types.hpp"
+#include "scrutiny_tools.hpp"
 
 #if SCRUTINY_ENABLE_DATALOGGING == 0
 #error "Not enabled"
 #endif
 
 static_assert(SCRUTINY_DATALOGGING_MAX_SIGNAL <= 254, "SCRUTINY_DATALOGGING_MAX_SIGNAL is too big");
+static_assert(SCRUTINY_DATALOGGING_MAX_SEGMENTS >= 1 && SCRUTINY_DATALOGGING_MAX_SEGMENTS <= 0xFFFF, "SCRUTINY_DATALOGGING_MAX_SEGMENTS is out of range");
+static_assert(SCRUTINY_DATALOGGING_MAX_TIME_MARKS >= 2 && SCRUTINY_DATALOGGING_MAX_TIME_MARKS <= 0xFFFF, "SCRUTINY_DATALOGGING_MAX_TIME_MARKS is out of range");
 
 namespace scrutiny
 {
@@ -56,6 +59,16 @@ namespace scrutiny
             RPV = 3
         };
 
+        /// @brief Definition of a bitfield in memory. Used by the trigger operands and by the loggable items
+        struct VarBitDefinition
+        {
+            void *addr;
+            VariableType datatype;
+            uint8_t bitoffset;
+            uint8_t bitsize;
+            tools::BitfieldDescriptor descriptor; // Computed by the datalogger when configured. Not transmitted
+        };
+
         union OperandData
         {
             struct
@@ -67,13 +80,7 @@ namespace scrutiny
                 void *addr;
                 VariableType datatype;
             } var;
-            struct
-            {
-                void *addr;
-                VariableType datatype;
-                uint8_t bitoffset;
-                uint8_t bitsize;
-            } varbit;
+            VarBitDefinition varbit;
             struct
             {
                 uint16_t id;
@@ -125,8 +132,25 @@ namespace scrutiny
         {
             MEMORY = 0,
             RPV = 1,
-            TIME = 2
+            TIME = 2,
+            VARBIT = 3 // Consecutive VARBIT items are packed together in the entry, LSB first. The group is padded to the next byte.
         };
+
+        /// @brief How the server gets the time of each entry of an acquisition
+        enum class TimeAxis : uint8_t
+        {
+            Logged = 0,   // Time is logged with TIME items, like any other signal
+            Implicit = 1, // Fixed frequency loops only. Entry N is at N * timestep * decimation. Nothing is stored
+            Sparse = 2    // Time marks are kept beside the entries at a given interval and when the time step changes
+        };
+
+        /// @brief Order in which the acquisition data is read
+        enum class ReadLayout : uint8_t
+        {
+            Rows = 0,   // Entry after entry
+            Columns = 1 // All the samples of a field, then the next field. VARBIT items packed together form a single field
+        };
+
         struct LoggableItem
         {
             LoggableType type;
@@ -144,6 +168,7 @@ namespace scrutiny
                 struct
                 {
                 } time;
+                VarBitDefinition varbit;
             } data;
         };
 
@@ -157,6 +182,10 @@ namespace scrutiny
                 decimation = other->decimation;
                 probe_location = other->probe_location;
                 timeout_100ns = other->timeout_100ns;
+                segment_count = other->segment_count;
+                time_axis = other->time_axis;
+                time_mark_interval = other->time_mark_interval;
+                time_mark_tolerance_100ns = other->time_mark_tolerance_100ns;
                 trigger.copy_from(&other->trigger);
                 if (items_count <= SCRUTINY_DATALOGGING_MAX_SIGNAL)
                 {
@@ -169,11 +198,15 @@ namespace scrutiny
 
             LoggableItem items_to_log[SCRUTINY_DATALOGGING_MAX_SIGNAL]; // Definitions of the items to log
 
-            uint8_t items_count;    // Number of items to logs
-            uint16_t decimation;    // Decimation of the acquisition. Effectively reduce the sampling rate
-            uint8_t probe_location; // A value indicating where the trigger should be located in the acquisition window. 0 means left, 255 means right. 128 = middle
-            uint32_t timeout_100ns; // Time after which an acquisition is considered complete even if the buffer is not full
-            TriggerConfig trigger;  // The trigger configuration
+            uint8_t items_count;                    // Number of items to logs
+            uint16_t decimation;                    // Decimation of the acquisition. Effectively reduce the sampling rate
+            uint8_t probe_location;                 // A value indicating where the trigger should be located in the acquisition window. 0 means left, 255 means right. 128 = middle
+            uint32_t timeout_100ns;                 // Time after which an acquisition is considered complete even if the buffer is not full
+            uint16_t segment_count = 1;             // Number of triggered captures in the acquisition. The buffer is split evenly between them. 1 for a single capture
+            TimeAxis time_axis = TimeAxis::Logged;  // How the time of each entry is known. TIME items are allowed only with TimeAxis::Logged
+            uint16_t time_mark_interval = 0;        // Sparse time axis: a time mark every N entries. 0 for marks on time step changes only
+            uint32_t time_mark_tolerance_100ns = 0; // Sparse time axis: a time mark is added when the time step changes by more than this
+            TriggerConfig trigger;                  // The trigger configuration
         };
 
         /// @brief Datalogging Trigger callback
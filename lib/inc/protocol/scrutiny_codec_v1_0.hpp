@@ -19,6 +19,7 @@
 #if SCRUTINY_ENABLE_DATALOGGING
 #include "datalogging/scrutiny_datalogging_types.hpp"
 #include "datalogging/scrutiny_datalogging_data_encoding.hpp"
+#include "datalogging/scrutiny_datalogger.hpp"
 #endif
 
 namespace scrutiny
@@ -101,6 +102,7 @@ namespace scrutiny
             void init(Response *const response, uint16_t const max_size);
             void write(MemoryBlock const *const memblock);
             inline bool overflow(void) const { return m_overflow; };
+            inline uint16_t data_length(void) const { return m_cursor; };
             void reset(void);
 
         protected:
@@ -196,6 +198,40 @@ namespace scrutiny
             MainHandler const *m_main_handler;
         };
 
+        /// @brief A single write part of a WriteStaged request
+        struct StagedWriteEntry
+        {
+            MemoryControl::StagedWriteType type; // Type of write
+            MemoryBlock block;                   // The block to write. Valid for Memory and MemoryMasked types
+            RuntimePublishedValue rpv;           // The RPV to write. Valid for RPV type
+            AnyType value;                       // The value to write to the RPV. Valid for RPV type
+        };
+
+        class StagedWriteRequestParser
+        {
+        public:
+            void init(Request const *const request, MainHandler const *const main_handler);
+            void init_entries(uint8_t *const entries, uint16_t const entries_length, MainHandler const *const main_handler);
+            void next(StagedWriteEntry *const entry);
+            inline bool finished(void) const { return m_finished; };
+            inline bool is_valid(void) const { return !m_invalid; };
+            inline uint8_t loop_id(void) const { return m_loop_id; }
+            inline uint8_t *entries(void) const { return m_buffer; }
+            inline uint16_t entries_length(void) const { return m_size_limit; }
+            inline uint16_t entry_count(void) const { return m_entry_count; }
+            void reset(void);
+
+        protected:
+            uint8_t *m_buffer;
+            uint16_t m_bytes_read;
+            uint16_t m_size_limit;
+            uint16_t m_entry_count;
+            uint8_t m_loop_id;
+            bool m_finished;
+            bool m_invalid;
+            MainHandler const *m_main_handler;
+        };
+
         namespace ResponseData
         {
             namespace GetInfo
@@ -254,6 +290,11 @@ namespace scrutiny
                     uint8_t loop_name_length;
                     char const *loop_name;
                 };
+
+                struct GetConfigFingerprint
+                {
+                    uint32_t fingerprint;
+                };
             }
 
             namespace CommControl
@@ -276,11 +317,24 @@ namespace scrutiny
                     uint32_t comm_rx_timeout;
                     uint32_t heartbeat_timeout;
                     uint8_t address_size;
+                    bool include_streaming;          // Adds max_streamed_data_size to the response. Only when response streaming is enabled
+                    uint16_t max_streamed_data_size; // Biggest payload of a streamed response
                 };
                 struct Connect
                 {
                     uint8_t magic[sizeof(protocol::CommControl::CONNECT_MAGIC)];
                     uint32_t session_id;
+                    bool include_framing; // Adds the framing to the response. Only when the request asked for one
+                    uint8_t framing;      // Framing used after the response. A CommControl::Framing value
+                };
+            }
+
+            namespace MemoryControl
+            {
+                struct WriteStaged
+                {
+                    uint8_t loop_id;
+                    uint16_t entry_count;
                 };
             }
 
@@ -308,6 +362,8 @@ namespace scrutiny
                     uint32_t number_of_points;
                     uint32_t data_size;
                     uint32_t points_after_trigger;
+                    uint16_t first_segment;                    // First segment to describe. Segments are described only when the acquisition has more than one
+                    datalogging::DataLogger const *datalogger; // Gives the details of each segment
                 };
 
                 struct ReadAcquisition
@@ -317,6 +373,22 @@ namespace scrutiny
                     datalogging::DataReader *reader;
                     uint32_t *crc;
                 };
+
+                struct ReadAcquisitionChunk
+                {
+                    uint16_t acquisition_id;
+                    uint32_t offset;
+                    uint16_t length;
+                    datalogging::DataReader *reader; // Reader already positioned at offset
+                };
+
+                struct GetTimeMarks
+                {
+                    uint16_t acquisition_id;
+                    uint16_t segment;                          // Segment the marks belong to
+                    uint16_t first_mark;                       // First mark to put in the response
+                    datalogging::DataLogger const *datalogger; // Gives the time marks
+                };
             }
 
 #endif
@@ -347,6 +419,11 @@ namespace scrutiny
                 {
                     uint8_t loop_id;
                 };
+
+                struct GetDeviceDescription
+                {
+                    uint32_t cursor; // Index of the first item of the description to send. 0 to start from the beginning
+                };
             }
 
             namespace CommControl
@@ -365,6 +442,8 @@ namespace scrutiny
                 struct Connect
                 {
                     uint8_t magic[sizeof(protocol::CommControl::CONNECT_MAGIC)];
+                    bool framing_requested; // The server asked for a framing. Older servers do not send it
+                    uint8_t framing;        // Requested framing. A CommControl::Framing value
                 };
 
                 struct Disconnect
@@ -383,10 +462,140 @@ namespace scrutiny
                     uint16_t config_id;
                     // Rest is directly written to datalogger config. So not in this struct.
                 };
+
+                struct GetAcquisitionMetadata
+                {
+                    uint16_t first_segment; // First segment to describe in the response
+                };
+
+                struct ReadAcquisition
+                {
+                    datalogging::ReadLayout layout; // Order of the data. Taken when the reading starts
+                };
+
+                struct ReadAcquisitionChunk
+                {
+                    uint16_t acquisition_id;
+                    uint32_t offset;
+                    uint16_t length;
+                };
+
+                struct ReadAcquisitionBurst
+                {
+                    uint8_t frames_per_ack;  // Number of frames sent between acknowledgements. 0 means no flow control
+                    bool acknowledge;        // false when starting the transfer. true when acknowledging received frames
+                    uint8_t rolling_counter; // Rolling counter of the next expected frame. Only valid when acknowledging
+                };
+
+                struct GetTimeMarks
+                {
+                    uint16_t segment;    // Segment the marks belong to
+                    uint16_t first_mark; // First mark to put in the response
+                };
             }
 #endif
         }
 
+        /// @brief Produces the payload of a ReadMemory response straight from the memory while it is transmitted.
+        /// The request must have been validated beforehand, forbidden regions included.
+        class ReadMemoryBlocksResponseStreamer : public ResponseSource
+        {
+        public:
+            void init(Request const *const request);
+            virtual bool read(uint8_t *const buffer, uint16_t const len) override;
+
+        protected:
+            ReadMemoryBlocksRequestParser m_parser;
+            MemoryBlock m_block;                        // Block being output
+            uint8_t m_block_header[sizeof(void *) + 2]; // Address and length of the block being output
+            uint16_t m_cursor;                          // Number of bytes of the block output so far, header included
+        };
+
+        /// @brief Produces the payload of a ReadRPV response while it is transmitted. Each value is read when its turn comes.
+        /// The request must have been validated beforehand.
+        class ReadRPVResponseStreamer : public ResponseSource
+        {
+        public:
+            /// @brief Prepares the response to a request
+            /// @param request The request. Must stay valid until the response is completely read
+            /// @param main_handler The MainHandler that gives access to the RPVs
+            /// @param payload_size Set to the size of the payload
+            /// @return false if the request is invalid or refers to an RPV that does not exist
+            bool init(Request const *const request, MainHandler const *const main_handler, uint32_t *const payload_size);
+            virtual bool read(uint8_t *const buffer, uint16_t const len) override;
+
+        protected:
+            static uint8_t entry_size(VariableType const type);
+
+            ReadRPVRequestParser m_parser;
+            MainHandler const *m_main_handler;
+            uint8_t m_entry[2 + sizeof(AnyType)]; // ID and value of the RPV being output
+            uint8_t m_entry_size;                 // Number of valid bytes in m_entry
+            uint8_t m_cursor;                     // Number of bytes of m_entry output so far
+        };
+
+#if SCRUTINY_ENABLE_DATALOGGING
+        /// @brief Produces the payload of a ReadAcquisition response straight from the datalogger storage while it is transmitted.
+        /// The frame has the same layout as one encoded by CodecV1_0::encode_response_datalogging_read_acquisition()
+        class ReadAcquisitionResponseStreamer : public ResponseSource
+        {
+        public:
+            /// @brief Prepares the next frame of the acquisition
+            /// @param response_data The acquisition to read
+            /// @param max_size Maximum payload size. Must be bigger than the frame overhead
+            /// @param finished Set to true if this frame contains the end of the acquisition
+            /// @return The payload size
+            uint16_t init(ResponseData::DataLogControl::ReadAcquisition const *const response_data, uint16_t const max_size, bool *const finished);
+            virtual bool read(uint8_t *const buffer, uint16_t const len) override;
+
+        protected:
+            datalogging::DataReader *m_reader; // Reader of the acquisition
+            uint32_t *m_crc;                   // CRC of the acquisition, updated as the data goes out
+            uint8_t m_header[4];               // Finished flag, rolling counter and acquisition ID
+            uint8_t m_footer[4];               // CRC of the whole acquisition. Only in the last frame
+            uint16_t m_data_size;              // Number of acquisition bytes in the frame
+            uint16_t m_cursor;                 // Number of payload bytes output so far
+            bool m_finished;                   // This frame ends with the acquisition CRC
+        };
+#endif
+
+        /// @brief Packs the device description in a single GetDeviceDescription response. Each item goes in a record:
+        /// [subfunction][payload length][payload], where the payload is identical to the response of that GetInfo subfunction.
+        /// Consecutive RPVs share a record. The write functions return false when the item does not fit.
+        class DeviceDescriptionResponseEncoder
+        {
+        public:
+            void init(Response *const response, uint16_t const max_size);
+            bool write_protocol_version(ResponseData::GetInfo::GetProtocolVersion const *const data);
+            bool write_software_id(void);
+            bool write_supported_features(ResponseData::GetInfo::GetSupportedFeatures const *const data);
+            bool write_config_fingerprint(ResponseData::GetInfo::GetConfigFingerprint const *const data);
+            bool write_special_memory_region_count(ResponseData::GetInfo::GetSpecialMemoryRegionCount const *const data);
+            bool write_special_memory_region_location(ResponseData::GetInfo::GetSpecialMemoryRegionLocation const *const data);
+            bool write_rpv_count(ResponseData::GetInfo::GetRPVCount const *const data);
+            bool write_rpv(RuntimePublishedValue const *const rpv);
+            bool write_loop_count(ResponseData::GetInfo::GetLoopCount const *const data);
+            bool write_loop_definition(ResponseData::GetInfo::GetLoopDefinition const *const data);
+
+            /// @brief Writes the header of the response
+            /// @param finished True if the last item of the description is in this response
+            /// @param next_cursor The cursor to give in the next request to continue
+            void finish(bool const finished, uint32_t const next_cursor);
+
+            /// @brief Returns true if no record has been written
+            inline bool empty(void) const { return m_cursor == HEADER_SIZE; }
+
+        protected:
+            static constexpr uint16_t HEADER_SIZE = 5; // finished flag + next cursor
+            uint8_t *begin_record(GetInfo::Subfunction const subfunction, uint16_t const payload_size);
+
+            uint8_t *m_buffer;     // The response payload
+            Response *m_response;  // The response being encoded
+            uint16_t m_cursor;     // Number of bytes written in the payload
+            uint16_t m_size_limit; // Maximum payload size
+            uint16_t m_rpv_record; // Position of the record that takes the RPVs. 0 if none yet
+        };
+
         class CodecV1_0
         {
         public:
@@ -398,6 +607,7 @@ namespace scrutiny
             ResponseCode encode_response_get_rpv_count(ResponseData::GetInfo::GetRPVCount const *const response_data, Response *const response);
             ResponseCode encode_response_get_loop_count(ResponseData::GetInfo::GetLoopCount const *const response_data, Response *const response);
             ResponseCode encode_response_get_loop_definition(ResponseData::GetInfo::GetLoopDefinition const *const response_data, Response *const response);
+            ResponseCode encode_response_get_config_fingerprint(ResponseData::GetInfo::GetConfigFingerprint const *const response_data, Response *const response);
 
             ResponseCode encode_response_comm_discover(ResponseData::CommControl::Discover const *const response_data, Response *const response);
             ResponseCode encode_response_comm_heartbeat(ResponseData::CommControl::Heartbeat const *const response_data, Response *const response);
@@ -407,6 +617,7 @@ namespace scrutiny
             ResponseCode decode_request_get_special_memory_region_location(Request const *const request, RequestData::GetInfo::GetSpecialMemoryRegionLocation *const request_data);
             ResponseCode decode_request_get_rpv_definition(Request const *const request, RequestData::GetInfo::GetRPVDefinition *const request_data);
             ResponseCode decode_request_get_loop_definition(Request const *const request, RequestData::GetInfo::GetLoopDefinition *const request_data);
+            ResponseCode decode_request_get_device_description(Request const *const request, RequestData::GetInfo::GetDeviceDescription *const request_data);
 
             ResponseCode decode_request_comm_discover(Request const *const request, RequestData::CommControl::Discover *const request_data);
             ResponseCode decode_request_comm_heartbeat(Request const *const request, RequestData::CommControl::Heartbeat *const request_data);
@@ -420,17 +631,28 @@ namespace scrutiny
             WriteMemoryBlocksResponseEncoder *encode_response_memory_control_write(Response *const response, uint16_t const max_size);
 
             GetRPVDefinitionResponseEncoder *encode_response_get_rpv_definition(Response *const response, uint16_t const max_size);
+            DeviceDescriptionResponseEncoder *encode_response_get_device_description(Response *const response, uint16_t const max_size);
             ReadRPVRequestParser *decode_request_memory_control_read_rpv(Request const *const request);
             ReadRPVResponseEncoder *encode_response_memory_control_read_rpv(Response *const response, uint16_t const max_size);
 
             WriteRPVRequestParser *decode_request_memory_control_write_rpv(Request const *const request, MainHandler *main_handler);
             WriteRPVResponseEncoder *encode_response_memory_control_write_rpv(Response *const response, uint16_t const max_size);
 
+            StagedWriteRequestParser *decode_request_memory_control_write_staged(Request const *const request, MainHandler const *const main_handler);
+            ResponseCode encode_response_memory_control_write_staged(ResponseData::MemoryControl::WriteStaged const *const response_data, Response *const response);
+
 #if SCRUTINY_ENABLE_DATALOGGING
             ResponseCode encode_response_datalogging_get_setup(ResponseData::DataLogControl::GetSetup const *const response_data, Response *const response);
             ResponseCode encode_response_datalogging_status(ResponseData::DataLogControl::GetStatus const *const response_data, Response *const response);
             ResponseCode encode_response_datalogging_get_acquisition_metadata(ResponseData::DataLogControl::GetAcquisitionMetadata const *const response_data, Response *const response);
             ResponseCode encode_response_datalogging_read_acquisition(ResponseData::DataLogControl::ReadAcquisition const *const response_data, Response *const response, bool *const finished);
+            ResponseCode encode_response_datalogging_read_acquisition_chunk(ResponseData::DataLogControl::ReadAcquisitionChunk const *const response_data, Response *const response);
+            ResponseCode encode_response_datalogging_get_time_marks(ResponseData::DataLogControl::GetTimeMarks const *const response_data, Response *const response);
+            ResponseCode decode_datalogging_get_acquisition_metadata_request(Request const *const request, RequestData::DataLogControl::GetAcquisitionMetadata *const request_data);
+            ResponseCode decode_datalogging_read_acquisition_request(Request const *const request, RequestData::DataLogControl::ReadAcquisition *const request_data);
+            ResponseCode decode_datalogging_read_acquisition_chunk_request(Request const *const request, RequestData::DataLogControl::ReadAcquisitionChunk *const request_data);
+            ResponseCode decode_datalogging_read_acquisition_burst_request(Request const *const request, RequestData::DataLogControl::ReadAcquisitionBurst *const request_data);
+            ResponseCode decode_datalogging_get_time_marks_request(Request const *const request, RequestData::DataLogControl::GetTimeMarks *const request_data);
             ResponseCode decode_datalogging_configure_request(
                 Request const *const request,
                 RequestData::DataLogControl::Configure *const request_data,
@@ -444,6 +666,7 @@ namespace scrutiny
                 WriteMemoryBlocksRequestParser m_memory_control_write_request_parser;
                 ReadRPVRequestParser m_memory_control_read_rpv_parser;
                 WriteRPVRequestParser m_memory_control_write_rpv_parser;
+                StagedWriteRequestParser m_memory_control_write_staged_parser;
             } parsers;
 
             union
@@ -451,6 +674,7 @@ namespace scrutiny
                 ReadMemoryBlocksResponseEncoder m_memory_control_read_response_encoder;
                 WriteMemoryBlocksResponseEncoder m_memory_control_write_response_encoder;
                 GetRPVDefinitionResponseEncoder m_get_rpv_definition_response_encoder;
+                DeviceDescriptionResponseEncoder m_device_description_response_encoder;
                 ReadRPVResponseEncoder m_read_rpv_response_encoder;
                 WriteRPVResponseEncoder m_write_rpv_response_encoder;
             } encoders;
@@ -42,7 +42,28 @@ namespace scrutiny
                 Timebase const *const timebase,
                 uint32_t const session_counter_seed = 0);
 
+            /// @brief Switches to a message-oriented transport where each chunk of received data is a complete request
+            /// and each response is read in a single call to pop_data(). To be called after init().
+            /// @param mtu Biggest frame the transport can carry. Responses are limited to mtu minus the frame overhead
+            /// @param check_crc When false, the CRC of the requests is not validated and the responses carry a CRC of 0.
+            /// Only for transports that already guarantee integrity, with a server configured accordingly
+            void set_datagram_mode(uint16_t const mtu, bool const check_crc = true);
+
+            /// @brief Returns true if the CommHandler is in datagram mode
+            inline bool is_datagram_mode(void) const { return m_datagram_mode; }
+
+            /// @brief Selects the framing to use once the next response is completely read with pop_data().
+            /// The response that acknowledges the framing change is sent with the actual framing.
+            /// Goes back to Raw framing when the session ends.
+            /// @param framing The framing to use
+            /// @return false if the framing is not supported on this channel
+            bool set_framing_after_response(CommControl::Framing const framing);
+
+            /// @brief Returns the framing presently used
+            inline CommControl::Framing get_framing(void) const { return m_framing; }
+
             /// @brief Move data from the outside world (received by the server) to the scrutiny lib
+            /// In datagram mode, data must be exactly one frame.
             /// @param data Buffer containing the received data
             /// @param len Number of bytes to read
             void receive_data(uint8_t const *const data, uint16_t const len);
@@ -52,6 +73,24 @@ namespace scrutiny
             /// @return true on success, false on failure
             bool send_response(Response const *const response);
 
+            /// @brief Send a response whose payload is produced by a source as pop_data() is called, instead of being read from the transmission buffer.
+            /// The CRC is computed as the payload goes out. Not available with COBS framing, which needs to look ahead in the frame.
+            /// @param response The response object. Its data_length is the payload length. Its data is not used
+            /// @param source The object that produces the payload. Must stay valid until the response is completely sent
+            /// @return true on success, false on failure
+            bool send_streamed_response(Response const *const response, ResponseSource *const source);
+
+            /// @brief Returns the biggest payload that send_streamed_response() accepts with the actual framing
+            uint16_t max_streamed_data_size(void) const;
+
+            /// @brief Gives a sink that can take the payload of the requests that do not fit in the reception buffer.
+            /// Such requests are only accepted during a session. To be called after init().
+            /// @param sink The sink. nullptr to drop the requests bigger than the reception buffer
+            inline void set_request_sink(RequestSink *const sink) { m_rx_sink = sink; }
+
+            /// @brief Returns true if the received request payload went to the request sink instead of the reception buffer
+            inline bool request_streamed(void) const { return m_request_received && m_rx_streaming; }
+
             /// @brief Reset the communication handler and put it back to an idle state
             void reset(void);
 
@@ -59,6 +98,7 @@ namespace scrutiny
             Response *prepare_response(void);
 
             // Reads data from the scrutiny lib so that it can be sent to the outside world (to the server)
+            // In datagram mode, a response is never split: nothing is read if len cannot hold the whole frame.
             uint16_t pop_data(uint8_t *const buffer, uint16_t len);
 
             /// @brief Returns the number of bytes pending to be sent.
@@ -77,6 +117,10 @@ namespace scrutiny
             /// @return True if the heartbeat was effective. False if it was ignored
             bool heartbeat(uint16_t const challenge);
 
+            /// @brief Resets the watchdog timeout without a heartbeat from the server. Used while the device sends data
+            /// back to back and the server cannot talk. Does nothing if no session is active
+            void keep_alive(void);
+
             /// @brief Periodic process function to call
             void process(void);
 
@@ -133,9 +177,37 @@ namespace scrutiny
             inline uint16_t tx_buffer_size(void) const { return m_tx_buffer_size; }
 
         protected:
+            void receive_stream(uint8_t const *const data, uint16_t const len);
+            void receive_cobs(uint8_t const *const data, uint16_t const len);
+            void receive_datagram(uint8_t const *const data, uint16_t const len);
+            uint8_t tx_frame_byte(uint16_t const position) const;
+            uint16_t pop_data_raw(uint8_t *const buffer, uint16_t len);
+
+            /// @brief State of the COBS encoder used in transmission.
+            struct CobsEncoder
+            {
+                enum class Step : uint8_t
+                {
+                    Code,      // Next output is the code byte of a block
+                    Literals,  // Next output is a literal byte of the block
+                    Delimiter, // Next output is the frame delimiter
+                    Done       // The whole frame has been output
+                };
+
+                uint16_t frame_position; // Position of the next unencoded byte in the frame
+                uint8_t block_length;    // Number of literal bytes in the actual block
+                uint8_t block_sent;      // Number of literal bytes of the actual block output so far
+                bool zero_after_block;   // The block is followed by a zero byte that the code byte implies
+                Step step;               // Next thing to output
+            };
+
+            uint16_t encode_cobs(uint8_t *const buffer, uint16_t const len, CobsEncoder *const encoder) const;
+            bool start_transmission(Response const *const response, ResponseSource *const source);
+            uint32_t header_crc(Response const *const response) const;
             void process_active_request(void);
             bool received_discover_request(void);
             bool received_connect_request(void);
+            bool begin_streamed_request(void);
 
             enum class RxFSMState : uint8_t
             {
@@ -166,6 +238,11 @@ namespace scrutiny
             timestamp_t m_heartbeat_timestamp;   // Timestamp of the last heartbeat gotten
             uint16_t m_last_heartbeat_challenge; // Challenge received by the last heartbeat
             bool m_first_heartbeat_received;     // Flag indicating if the first heartbeat has been received.
+            bool m_datagram_mode;                // One request per call to receive_data and one response per call to pop_data
+            bool m_check_crc;                    // When false, request CRCs are not validated and response CRCs are not computed
+            CommControl::Framing m_framing;      // Framing presently used on the link
+            CommControl::Framing m_next_framing; // Framing to use once the actual response is sent
+            uint16_t m_max_frame_data_size;      // Biggest payload the link can carry in a single frame. Bounds the streamed responses
 
             // Reception
             uint8_t *m_rx_buffer;      // The reception buffer
@@ -183,12 +260,23 @@ namespace scrutiny
                 uint16_t data_bytes_received;  // Number of bytes part of the data payload received up to now
             } m_per_state_data;
             timestamp_t m_last_rx_timestamp; // Timestamp at which the last chunk of data was received
+            RequestSink *m_rx_sink;          // Takes the payload of the requests bigger than the reception buffer. Can be nullptr
+            bool m_rx_streaming;             // The payload of the actual request goes to m_rx_sink
+            uint32_t m_rx_crc;               // CRC of the streamed request computed as it is received
+            struct
+            {
+                uint8_t block_remaining; // Number of literal bytes still expected in the actual COBS block
+                bool pending_zero;       // The actual block implies a zero byte, unless it is the last of the frame
+            } m_cobs_rx;
 
             // Transmission
-            Response m_active_response; // The response being transmitted
-            uint16_t m_nbytes_to_send;  // Number of bytes to send in this response
-            uint16_t m_nbytes_sent;     // Number of bytes sent up to now. Includes headers and CRC
-            TxError m_tx_error;         // Last Transmission error code
+            Response m_active_response;  // The response being transmitted
+            uint16_t m_nbytes_to_send;   // Number of bytes to send in this response
+            uint16_t m_nbytes_sent;      // Number of bytes sent up to now. Includes headers and CRC. Counted after encoding when framing is COBS
+            CobsEncoder m_cobs_tx;       // COBS encoder state of the response being transmitted
+            ResponseSource *m_tx_source; // Produces the payload of a streamed response. nullptr when the payload is in the transmission buffer
+            bool m_tx_source_failed;     // The source of the streamed response failed to produce its payload
+            TxError m_tx_error;          // Last Transmission error code
 
         private:
             static uint32_t s_session_counter; // A counter to generate session ID
@@ -52,6 +52,46 @@ namespace scrutiny
             uint32_t crc;
         };
 
+        /// @brief Produces the payload of a response while it is being transmitted, so that the payload never has
+        /// to fit in the transmission buffer. See CommHandler::send_streamed_response()
+        class ResponseSource
+        {
+        public:
+            /// @brief Writes the next bytes of the payload. Called in order, never past the payload length given to the CommHandler.
+            /// @param buffer Where to write the bytes
+            /// @param len Number of bytes to write
+            /// @return false if the bytes could not be produced. The response then goes out with a bad CRC so that the server drops it
+            virtual bool read(uint8_t *const buffer, uint16_t const len) = 0;
+
+        protected:
+            ~ResponseSource(void) {} // Never destroyed through this interface
+        };
+
+        /// @brief Takes the payload of a request too big for the reception buffer while it is being received.
+        /// The request is processed only if its CRC matches, so the sink must not apply anything before that.
+        /// See CommHandler::set_request_sink()
+        class RequestSink
+        {
+        public:
+            /// @brief Called when the header of a request bigger than the reception buffer is received
+            /// @param command_id The command ID of the request
+            /// @param subfunction_id The subfunction ID of the request
+            /// @param data_length The payload length of the request
+            /// @return true if the sink takes the payload. false to drop the request with an overflow error
+            virtual bool begin(uint8_t const command_id, uint8_t const subfunction_id, uint16_t const data_length) = 0;
+
+            /// @brief Gives the next bytes of the payload, in order.
+            /// @param data The received bytes
+            /// @param len Number of bytes
+            virtual void write(uint8_t const *const data, uint16_t const len) = 0;
+
+            /// @brief Called once the request is done with: processed, corrupted or dropped. The payload can be discarded.
+            virtual void release(void) = 0;
+
+        protected:
+            ~RequestSink(void) {} // Never destroyed through this interface
+        };
+
         enum class CommandId : uint8_t
         {
             GetInfo = 0x01,
@@ -108,7 +148,9 @@ namespace scrutiny
                 GetRuntimePublishedValuesCount = 6,
                 GetRuntimePublishedValuesDefinition = 7,
                 GetLoopCount = 8,
-                GetLoopDefinition = 9
+                GetLoopDefinition = 9,
+                GetConfigFingerprint = 10,
+                GetDeviceDescription = 11
             };
 
             enum class MemoryRegionType : uint8_t
@@ -131,6 +173,13 @@ namespace scrutiny
                 Connect = 4,
                 Disconnect = 5
             };
+
+            /// @brief How frames are delimited on a byte stream. Negotiated by the Connect request
+            enum class Framing : uint8_t
+            {
+                Raw = 0, // Frames are delimited by their length field. Resynchronization relies on the reception timeout
+                COBS = 1 // Each frame is COBS encoded and followed by a 0x00 delimiter. The receiver resynchronizes on the next delimiter
+            };
         }
 
         namespace MemoryControl
@@ -141,7 +190,16 @@ namespace scrutiny
                 Write = 2,
                 WriteMasked = 3,
                 ReadRPV = 4,
-                WriteRPV = 5
+                WriteRPV = 5,
+                WriteStaged = 6
+            };
+
+            /// @brief Type of an entry in a WriteStaged request
+            enum class StagedWriteType : uint8_t
+            {
+                Memory = 0,
+                MemoryMasked = 1,
+                RPV = 2
             };
         }
 
@@ -156,7 +214,10 @@ namespace scrutiny
                 GetStatus = 5,
                 GetAcquisitionMetadata = 6,
                 ReadAcquisition = 7,
-                ResetDatalogger = 8
+                ResetDatalogger = 8,
+                ReadAcquisitionChunk = 9,
+                ReadAcquisitionBurst = 10,
+                GetTimeMarks = 11
             };
         }
 
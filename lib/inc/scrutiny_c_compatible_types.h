@@ -18,6 +18,20 @@ typedef void (*scrutiny_c_user_command_callback_t)(
     uint16_t *response_data_length,
     uint16_t const response_max_data_length);
 
+typedef enum
+{
+    SCRUTINY_C_USER_COMMAND_STATUS_COMPLETED,
+    SCRUTINY_C_USER_COMMAND_STATUS_PENDING
+} scrutiny_c_user_command_status_e;
+
+typedef scrutiny_c_user_command_status_e (*scrutiny_c_async_user_command_callback_t)(
+    uint8_t const subfunction,
+    uint8_t const *request_data,
+    uint16_t const request_data_length,
+    uint8_t *response_data,
+    uint16_t *response_data_length,
+    uint16_t const response_max_data_length);
+
 typedef enum
 {
     SCRUTINY_C_ENDIANNESS_LITTLE,
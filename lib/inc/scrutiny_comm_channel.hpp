@@ -0,0 +1,127 @@
+//    scrutiny_comm_channel.hpp
+//        A communication channel (buffers + session + request state) served by the MainHandler.
+//        Many channels can be attached to a single MainHandler so that multiple servers
+//        (or multiple physical links) can talk to the same device.
+//
+//   - License : MIT - See LICENSE file.
+//   - Project : Scrutiny Debugger (github.com/scrutinydebugger/scrutiny-embedded)
+//
+//   Copyright (c) 2021 Scrutiny Debugger
+
+#ifndef ___SCRUTINY_COMM_CHANNEL_H___
+#define ___SCRUTINY_COMM_CHANNEL_H___
+
+#include <stdint.h>
+
+#include "scrutiny_setup.hpp"
+#include "scrutiny_timebase.hpp"
+#include "protocol/scrutiny_protocol.hpp"
+
+namespace scrutiny
+{
+    class MainHandler;
+    class CommChannel;
+
+    /// @brief Hands the payload of the requests too big for a channel reception buffer to the MainHandler, which stages it.
+    class CommChannelRequestSink : public protocol::RequestSink
+    {
+    public:
+        /// @brief Binds the sink to its MainHandler and channel
+        void init(MainHandler *const main_handler, CommChannel *const channel);
+
+        virtual bool begin(uint8_t const command_id, uint8_t const subfunction_id, uint16_t const data_length) override;
+        virtual void write(uint8_t const *const data, uint16_t const len) override;
+        virtual void release(void) override;
+
+    private:
+        MainHandler *m_main_handler; // The MainHandler that stages the payload
+        CommChannel *m_channel;      // The channel that receives the request
+    };
+
+    /// @brief A communication channel with its own buffers and its own session.
+    /// The MainHandler owns one channel (configured with Config::set_buffers) and can serve additional channels
+    /// given with Config::set_additional_comm_channels. Every channel shares the same configuration, RPVs, loops and datalogger.
+    class CommChannel
+    {
+        friend class MainHandler;
+
+    public:
+        CommChannel(void);
+
+        /// @brief Set the buffers used by this channel.
+        /// @param rx_buffer Reception buffer
+        /// @param rx_buffer_size Reception buffer size
+        /// @param tx_buffer Transmission buffer
+        /// @param tx_buffer_size Transmission buffer size
+        void set_buffers(uint8_t *rx_buffer, uint16_t const rx_buffer_size, uint8_t *tx_buffer, uint16_t const tx_buffer_size);
+
+        /// @brief Makes this channel message-oriented: one request per call to receive_data() and one complete response per call to pop_data().
+        /// Meant for transports that preserve message boundaries, such as UDP.
+        /// @param mtu Biggest frame the transport can carry. 0 to go back to the byte stream mode
+        /// @param check_crc When false, the request CRCs are not validated and the responses carry a CRC of 0.
+        /// Only for transports that already guarantee integrity, with a server configured accordingly
+        void set_datagram_mode(uint16_t const mtu, bool const check_crc = true);
+
+        /// @brief Pass data received from the server to this channel input stream.
+        /// @param data Pointer to the data buffer
+        /// @param len Length of the data
+        inline void receive_data(uint8_t const *const data, uint16_t const len)
+        {
+            m_comm_handler.receive_data(data, len);
+        }
+
+        /// @brief Reads data from this channel output stream so it can be sent to the server
+        /// @param buffer Buffer to write the data into
+        /// @param len Maximum length of the data to read
+        /// @return Number of bytes actually read
+        inline uint16_t pop_data(uint8_t *const buffer, uint16_t const len)
+        {
+            uint16_t const size = m_comm_handler.pop_data(buffer, len);
+            check_finished_sending();
+            return size;
+        }
+
+        /// @brief Tells how much data is available in this channel output stream
+        /// @return Number of bytes available
+        inline uint16_t data_to_send(void) const
+        {
+            return m_comm_handler.data_to_send();
+        }
+
+        /// @brief Returns true if the buffers of this channel were set
+        inline bool is_buffer_set(void) const { return (m_rx_buffer != nullptr) && (m_tx_buffer != nullptr); }
+
+        /// @brief Returns a pointer to the communication handler of this channel
+        inline protocol::CommHandler *comm(void) { return &m_comm_handler; }
+
+    private:
+        void init(Timebase const *const timebase, uint32_t const session_counter_seed);
+        void reset(void);
+        void check_finished_sending(void);
+        bool pending_request_lost(void) const;
+
+        protocol::CommHandler m_comm_handler;        // The communication handler that parses the request and manages the buffers
+        uint8_t *m_rx_buffer;                        // The comm Rx buffer
+        uint16_t m_rx_buffer_size;                   // The comm Rx buffer size
+        uint8_t *m_tx_buffer;                        // The comm Tx buffer
+        uint16_t m_tx_buffer_size;                   // The comm Tx buffer size
+        uint16_t m_datagram_mtu;                     // Biggest frame size in datagram mode. 0 for byte stream mode
+        bool m_datagram_check_crc;                   // Validates and computes the CRCs in datagram mode
+        bool m_processing_request;                   // True when a request is being processed
+        bool m_disconnect_pending;                   // Indicates that a disconnect request has been received and must be processed right away
+        bool m_process_again_timestamp_taken;        // Indicates that a timestamp has been taken on ProcessAgain response code, meaning that the timestamp should not be updated on subsequent ProcessAgain code
+        timestamp_t m_process_again_timestamp;       // Timestamp at which the first ProcessAgain code has been returned to ensure timeout
+        uint32_t m_process_again_session_id;         // Session in which the request answered ProcessAgain was received
+        protocol::ResponseSource *m_response_source; // Produces the payload of the response being prepared when it is streamed. nullptr otherwise
+        CommChannelRequestSink m_request_sink;       // Takes the payload of the requests bigger than the reception buffer
+
+        // A streamed response is produced while the channel transmits, so each channel has its own streamers
+        protocol::ReadMemoryBlocksResponseStreamer m_readmem_streamer; // Streams ReadMemory responses
+        protocol::ReadRPVResponseStreamer m_readrpv_streamer;           // Streams ReadRPV responses
+#if SCRUTINY_ENABLE_DATALOGGING
+        protocol::ReadAcquisitionResponseStreamer m_acquisition_streamer; // Streams ReadAcquisition responses
+#endif
+    };
+}
+
+#endif // ___SCRUTINY_COMM_CHANNEL_H___
@@ -13,6 +13,12 @@
 #include "scrutiny_setup.hpp"
 #include "scrutiny_types.hpp"
 #include "scrutiny_loop_handler.hpp"
+#include "scrutiny_comm_channel.hpp"
+#include "scrutiny_ipc.hpp"
+
+#if SCRUTINY_ENABLE_DATALOGGING
+#include "datalogging/scrutiny_datalogging_storage.hpp"
+#endif
 
 namespace scrutiny
 {
@@ -23,6 +29,14 @@ namespace scrutiny
     public:
         friend class MainHandler;
 
+        /// @brief Maximum number of additional communication channels. The channel count, main channel included, is a uint8_t
+        static constexpr uint8_t MAX_ADDITIONAL_COMM_CHANNELS = 254u;
+
+        /// @brief Longest timeout of a pending asynchronous User Command, in multiple of 100ns. Leaves the time of a request
+        /// to report the failure before the session ends for lack of heartbeat
+        static_assert(SCRUTINY_COMM_HEARTBEAT_TIMEOUT_US > SCRUTINY_REQUEST_MAX_PROCESS_TIME_US, "The heartbeat timeout must be longer than a request");
+        static constexpr timediff_t MAX_USER_COMMAND_TIMEOUT_100NS = (SCRUTINY_COMM_HEARTBEAT_TIMEOUT_US - SCRUTINY_REQUEST_MAX_PROCESS_TIME_US) * 10u;
+
         Config();
 
         /// @brief Clear the configuration content
@@ -35,6 +49,32 @@ namespace scrutiny
         /// @param tx_buffer_size Transmission buffer size
         void set_buffers(uint8_t *rx_buffer, uint16_t const rx_buffer_size, uint8_t *tx_buffer, uint16_t const tx_buffer_size);
 
+        /// @brief Makes the main channel message-oriented. See CommChannel::set_datagram_mode
+        /// @param mtu Biggest frame the transport can carry. 0 for byte stream mode
+        /// @param check_crc When false, the CRCs are neither validated nor computed
+        inline void set_datagram_mode(uint16_t const mtu, bool const check_crc = true)
+        {
+            m_datagram_mtu = mtu;
+            m_datagram_check_crc = check_crc;
+        }
+
+        /// @brief Sets a ring that feeds the main channel. A reception interrupt pushes the bytes in the ring and
+        /// MainHandler::process() gives them to the main channel in bulk, instead of calling MainHandler::receive_data() for every byte.
+        /// Byte stream mode only. The ring does not keep the frame boundaries, so the configuration is rejected with set_datagram_mode().
+        /// @param ring The ring, initialized with its storage. Must outlive the MainHandler
+        inline void set_receive_ring(IPCByteRing *ring)
+        {
+            m_receive_ring = ring;
+        }
+
+        /// @brief Defines some communication channels to be served in addition to the main channel (set by `set_buffers`).
+        /// Each channel has its own buffers and its own session, but all channels share the same configuration, RPVs, loops and datalogger.
+        /// @param channels Arrays of pointer to `scrutiny::CommChannel` with their buffers set.
+        /// This array must be allocated outside of Scrutiny and stay
+        /// allocated forever as no copy will be made
+        /// @param count Number of channels in the array. At most `MAX_ADDITIONAL_COMM_CHANNELS`, otherwise the configuration is rejected
+        void set_additional_comm_channels(CommChannel **channels, uint8_t const count);
+
         /// @brief Define some memory section that are to be left untouched
         /// @param range Array of ranges represented by the `AddressRange` object.
         /// This array must be allocated outside of Scrutiny and stay allocated forever as no copy will be made
@@ -65,6 +105,12 @@ namespace scrutiny
         /// @param loop_count Number of `scrutiny::LoopHandlers`
         void set_loops(LoopHandler **loops, uint8_t loop_count);
 
+        /// @brief Sets the buffer used to hold a staged write transaction (MemoryControl::WriteStaged) until it is applied by a loop.
+        /// The size of the buffer limits the size of a transaction. Staged writes are unsupported if no buffer is given.
+        /// @param buffer The staging buffer
+        /// @param buffer_size The staging buffer size
+        void set_staged_write_buffer(uint8_t *buffer, uint16_t const buffer_size);
+
         /// @brief Sets a callback to be called by Scrutiny after a request to the UserCommand function.
         /// This generic feature allows the integrator to pass down some custom request/data to the application by leveraging the already
         /// existing Scrutiny protocol.
@@ -81,6 +127,45 @@ namespace scrutiny
             return m_user_command_callback;
         };
 
+        /// @brief Sets a callback to be called on a UserCommand request that may take more time than a call to MainHandler::process().
+        /// The callback either writes the response and returns COMPLETED, or returns PENDING and gives the response later with
+        /// MainHandler::complete_user_command(). Takes precedence over the synchronous callback.
+        /// @param callback The callback
+        inline void set_async_user_command_callback(async_user_command_callback_t callback)
+        {
+            m_async_user_command_callback = callback;
+        };
+
+        /// @brief Returns the actual asynchronous user command callback. nullptr if unset
+        /// @return The callback
+        inline async_user_command_callback_t get_async_user_command_callback(void) const
+        {
+            return m_async_user_command_callback;
+        };
+
+        /// @brief Sets the time given to a pending asynchronous User Command to complete before the request is answered with a failure.
+        /// The server sends no heartbeat while it waits for the response, so the session ends after SCRUTINY_COMM_HEARTBEAT_TIMEOUT_US
+        /// anyway. The timeout is limited to `MAX_USER_COMMAND_TIMEOUT_100NS` so that the failure can be reported before that.
+        /// If the session still ends first, the request is dropped and the command is considered running until its completion arrives.
+        /// @param timeout_100ns The timeout, in multiple of 100ns
+        inline void set_user_command_timeout(timediff_t const timeout_100ns)
+        {
+            if (timeout_100ns > MAX_USER_COMMAND_TIMEOUT_100NS)
+            {
+                m_user_command_timeout_100ns = MAX_USER_COMMAND_TIMEOUT_100NS;
+            }
+            else
+            {
+                m_user_command_timeout_100ns = timeout_100ns;
+            }
+        }
+
+        /// @brief Returns the time given to a pending asynchronous User Command to complete, in multiple of 100ns
+        inline timediff_t get_user_command_timeout(void) const
+        {
+            return m_user_command_timeout_100ns;
+        }
+
 #if SCRUTINY_ENABLE_DATALOGGING
 
         /// @brief Sets the buffer used to store data when doing a datalogging acquisition
@@ -88,6 +173,14 @@ namespace scrutiny
         /// @param buffer_size The datalogging buffer size
         void set_datalogging_buffers(uint8_t *buffer, datalogging::buffer_size_t const buffer_size);
 
+        /// @brief Sets an external storage used to store data when doing a datalogging acquisition. Takes precedence over the datalogging buffers.
+        /// The storage must outlive the MainHandler
+        /// @param storage The datalogging storage
+        inline void set_datalogging_storage(datalogging::Storage *storage)
+        {
+            m_datalogger_storage = storage;
+        }
+
         /// @brief Sets a callback to be called by Scrutiny when a datalogging trigger condition is triggered. This callback will be called from the
         /// context of the LoopHandler using the datalogger with no thread safety. This means that if data are to be passed to another task, it is
         /// the integrator responsibility to ensure thread safety
@@ -100,12 +193,15 @@ namespace scrutiny
         /// @brief Returns true if a callback has been set to support the UserCallback service call
         inline bool is_user_command_callback_set(void) const
         {
-            return m_user_command_callback != nullptr;
+            return m_user_command_callback != nullptr || m_async_user_command_callback != nullptr;
         }
 
         /// @brief Returns true if the communication buffers were sets
         inline bool is_buffer_set(void) const { return (m_rx_buffer != nullptr) && (m_tx_buffer != nullptr); }
 
+        /// @brief Returns true if additional communication channels were defined
+        inline bool is_additional_comm_channels_set(void) const { return m_additional_channels != nullptr && m_additional_channel_count > 0; }
+
         /// @brief Returns true if forbidden regions have been defined
         inline bool is_forbidden_address_range_set(void) const { return m_forbidden_address_ranges != nullptr; }
 
@@ -120,12 +216,15 @@ namespace scrutiny
 
         /// @brief Returns true if a list of loops (tasks) were defined
         inline bool is_loop_handlers_configured(void) const { return m_loops != nullptr && m_loop_count > 0; }
+
+        /// @brief Returns true if a staging buffer has been given and at least one loop exists to apply the staged writes
+        inline bool is_staged_write_configured(void) const { return m_staged_write_buffer != nullptr && m_staged_write_buffer_size > 0 && is_loop_handlers_configured(); }
 #if SCRUTINY_ENABLE_DATALOGGING
 
         /// @brief Returns true if the datalogging feature has been configured to a working point.
         inline bool is_datalogging_configured(void) const
         {
-            return (m_datalogger_buffer != nullptr && m_datalogger_buffer_size != 0);
+            return (m_datalogger_buffer != nullptr && m_datalogger_buffer_size != 0) || (m_datalogger_storage != nullptr && m_datalogger_storage->size() != 0);
         };
 
         /// @brief Returns true if at least one loop support datalogging
@@ -171,11 +270,20 @@ namespace scrutiny
         /// @brief When true, memory write are enabled. When false, no memory write is permitted.
         bool memory_write_enable;
 
+        /// @brief When true, the ReadMemory, ReadRPV and ReadAcquisition responses that do not fit in the transmission buffer
+        /// are produced while they are transmitted. Lets a small transmission buffer serve large reads. Not available with COBS framing.
+        bool response_streaming;
+
     private:
         uint8_t *m_rx_buffer;                           // The comm Rx buffer
         uint16_t m_rx_buffer_size;                      // The comm Rx buffer size
         uint8_t *m_tx_buffer;                           // The comm Tx buffer
         uint16_t m_tx_buffer_size;                      // The comm Tx buffer size
+        uint16_t m_datagram_mtu;                        // Biggest frame size when the main channel is in datagram mode. 0 for byte stream mode
+        bool m_datagram_check_crc;                      // Validates and computes the CRCs of the main channel in datagram mode
+        IPCByteRing *m_receive_ring;                    // Bytes received by the main channel, pushed by an interrupt. nullptr if unset
+        CommChannel **m_additional_channels;            // The array of additional communication channels pointers. nullptr if unset
+        uint8_t m_additional_channel_count;             // Number of additional communication channels in the array
         AddressRange const *m_forbidden_address_ranges; // The forbidden address range array pointer. nullptr if unset
         uint8_t m_forbidden_range_count;                // The forbidden address range count
         AddressRange const *m_readonly_address_ranges;  // The read-only address range array pointer. nullptr if unset
@@ -186,13 +294,18 @@ namespace scrutiny
         RpvWriteCallback m_rpv_write_callback;          // The callback to perform write operation on a Runtime Published Value (RPV)
         LoopHandler **m_loops;                          // The array of Loop Handler pointers
         uint8_t m_loop_count;                           // Number of Loop Handler in the array
+        uint8_t *m_staged_write_buffer;                 // Buffer holding a staged write transaction until a loop applies it. nullptr if unset
+        uint16_t m_staged_write_buffer_size;            // Size of the staged write buffer
 
         /// @brief Callback to be called on a User Command request.
-        user_command_callback_t m_user_command_callback; // Callback to call when a User Command service call is requested by the server
+        user_command_callback_t m_user_command_callback;             // Callback to call when a User Command service call is requested by the server
+        async_user_command_callback_t m_async_user_command_callback; // Same as m_user_command_callback, but the response can be given later
+        timediff_t m_user_command_timeout_100ns;                     // Time given to a pending asynchronous User Command to complete
 
 #if SCRUTINY_ENABLE_DATALOGGING
         uint8_t *m_datalogger_buffer;                                  // Buffer that stores the datalogging data
         datalogging::buffer_size_t m_datalogger_buffer_size;           // size of the datalogging buffer
+        datalogging::Storage *m_datalogger_storage;                    // External storage used instead of the datalogging buffer when set
         datalogging::trigger_callback_t m_datalogger_trigger_callback; // Callback to call upon datalogging acquisition triggers
 #endif
     };
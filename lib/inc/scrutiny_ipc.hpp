@@ -11,6 +11,8 @@
 
 #include "scrutiny_setup.hpp"
 
+#include <stdint.h>
+
 #if !SCRUTINY_BUILD_AVR_GCC
 #include <atomic>
 #include <utility>
@@ -131,6 +133,224 @@ namespace scrutiny
         std::atomic<bool> m_written;
     };
 #endif
+
+    /// @brief Gives a piece of work to exactly one of two time domains. The producer issues a new number with each piece of work
+    /// and either side can redeem it. Only the first redeem of the actual number succeeds, so the work is either done by the consumer
+    /// or cancelled by the producer, never both.
+    class IPCTicket
+    {
+    public:
+        IPCTicket() : m_redeemable(0), m_last_issued(0) {}
+
+        /// @brief Issues a new number, which becomes the only one that can be redeemed. Meant to be used by the producer
+        /// @return The number, never 0
+        inline uint16_t issue(void)
+        {
+            m_last_issued = static_cast<uint16_t>(m_last_issued + 1u);
+            if (m_last_issued == 0)
+            {
+                m_last_issued = 1;
+            }
+            store(m_last_issued);
+            return m_last_issued;
+        }
+
+        /// @brief Makes every number issued so far impossible to redeem. Meant to be used by the producer
+        inline void revoke(void)
+        {
+            store(0);
+        }
+
+        /// @brief Tries to take the piece of work identified by a number. Can be used from both sides
+        /// @param number The number given by issue()
+        /// @return true if the caller owns the work. false if it was already redeemed or if a newer number was issued
+        inline bool redeem(uint16_t const number)
+        {
+#if SCRUTINY_BUILD_AVR_GCC
+            uint8_t sreg;
+            __asm__ __volatile__("in %0, __SREG__\n\t"
+                                 "cli"
+                                 : "=r"(sreg)::"memory");
+            bool const success = (number != 0) && (m_redeemable == number);
+            if (success)
+            {
+                m_redeemable = 0;
+            }
+            __asm__ __volatile__("out __SREG__, %0" ::"r"(sreg)
+                                 : "memory");
+            return success;
+#else
+            uint16_t expected = number;
+            return (number != 0) && m_redeemable.compare_exchange_strong(expected, 0);
+#endif
+        }
+
+    protected:
+#if SCRUTINY_BUILD_AVR_GCC
+        inline void store(uint16_t const val)
+        {
+            uint8_t sreg;
+            __asm__ __volatile__("in %0, __SREG__\n\t"
+                                 "cli"
+                                 : "=r"(sreg)::"memory");
+            m_redeemable = val;
+            __asm__ __volatile__("out __SREG__, %0" ::"r"(sreg)
+                                 : "memory");
+        }
+
+        volatile uint16_t m_redeemable; // Number that can be redeemed. 0 if none
+#else
+        inline void store(uint16_t const val) { m_redeemable.store(val); }
+
+        std::atomic<uint16_t> m_redeemable; // Number that can be redeemed. 0 if none
+#endif
+        uint16_t m_last_issued; // Last number given by issue(). Used by the producer only
+    };
+
+    /// @brief Lock-free byte queue between one producer and one consumer in different time domains, typically
+    /// a UART reception interrupt and the task calling MainHandler::process().
+    /// Each index is written by a single side, so no lock is needed. One byte of the buffer is never used to tell a full ring from an empty one.
+    class IPCByteRing
+    {
+    public:
+        IPCByteRing() : m_buffer(nullptr), m_size(0), m_head(0), m_tail(0), m_dropped(0) {}
+
+        /// @brief Sets the storage of the ring and empties it. Must be called before the producer and the consumer start
+        /// @param buffer The storage. Must outlive the ring
+        /// @param size Size of the storage. The ring holds size-1 bytes
+        inline void init(uint8_t *const buffer, uint16_t const size)
+        {
+            m_buffer = buffer;
+            m_size = (buffer == nullptr) ? 0 : size;
+            store_head(0);
+            store_tail(0);
+            store_dropped(0);
+        }
+
+        /// @brief Adds a byte to the ring. Meant to be used by the producer. Safe to call from an interrupt
+        /// @param data The byte
+        /// @return false if the ring is full. The byte is dropped and counted
+        inline bool push(uint8_t const data)
+        {
+            uint16_t const head = load_head();
+            uint16_t const next = (head + 1u >= m_size) ? 0 : static_cast<uint16_t>(head + 1u);
+            if (m_size == 0 || next == load_tail())
+            {
+                store_dropped(static_cast<uint16_t>(load_dropped() + 1u));
+                return false;
+            }
+
+            m_buffer[head] = data;
+            store_head(next); // Publishes the byte
+            return true;
+        }
+
+        /// @brief Adds many bytes to the ring. Meant to be used by the producer. Safe to call from an interrupt
+        /// @param data The bytes
+        /// @param len Number of bytes
+        /// @return The number of bytes added. Those that did not fit are dropped and counted
+        inline uint16_t push(uint8_t const *const data, uint16_t const len)
+        {
+            uint16_t i = 0;
+            while (i < len && push(data[i]))
+            {
+                i++;
+            }
+            if (i < len)
+            {
+                store_dropped(static_cast<uint16_t>(load_dropped() + (len - i - 1u))); // The first one was counted by push()
+            }
+            return i;
+        }
+
+        /// @brief Returns the number of bytes in the ring. Meant to be used by the consumer
+        inline uint16_t available(void) const
+        {
+            uint16_t const head = load_head();
+            uint16_t const tail = load_tail();
+            return (head >= tail) ? static_cast<uint16_t>(head - tail) : static_cast<uint16_t>(m_size - tail + head);
+        }
+
+        /// @brief Gives the oldest bytes of the ring, without copy. Meant to be used by the consumer.
+        /// The bytes stay in the ring until release() is called
+        /// @param data Set to the first byte
+        /// @return Number of consecutive bytes at data. Less than available() when the ring wraps around
+        inline uint16_t peek(uint8_t const **const data) const
+        {
+            uint16_t const head = load_head();
+            uint16_t const tail = load_tail();
+            *data = &m_buffer[tail];
+            return (head >= tail) ? static_cast<uint16_t>(head - tail) : static_cast<uint16_t>(m_size - tail);
+        }
+
+        /// @brief Removes bytes given by peek() from the ring. Meant to be used by the consumer
+        /// @param len Number of bytes to remove. At most the value returned by peek()
+        inline void release(uint16_t const len)
+        {
+            uint16_t const tail = static_cast<uint16_t>(load_tail() + len);
+            store_tail((tail >= m_size) ? static_cast<uint16_t>(tail - m_size) : tail); // Frees the space for the producer
+        }
+
+        /// @brief Returns the number of bytes dropped because the ring was full
+        inline uint16_t dropped_count(void) const
+        {
+            return load_dropped();
+        }
+
+    protected:
+#if SCRUTINY_BUILD_AVR_GCC
+        // 16 bits accesses take 2 instructions on AVR. Interrupts are masked so that the other side never sees half an index.
+        static inline uint16_t atomic_load(volatile uint16_t const *const val)
+        {
+            uint8_t sreg;
+            __asm__ __volatile__("in %0, __SREG__\n\t"
+                                 "cli"
+                                 : "=r"(sreg)::"memory");
+            uint16_t const out = *val;
+            __asm__ __volatile__("out __SREG__, %0" ::"r"(sreg)
+                                 : "memory");
+            return out;
+        }
+
+        static inline void atomic_store(volatile uint16_t *const val, uint16_t const data)
+        {
+            uint8_t sreg;
+            __asm__ __volatile__("in %0, __SREG__\n\t"
+                                 "cli"
+                                 : "=r"(sreg)::"memory");
+            *val = data;
+            __asm__ __volatile__("out __SREG__, %0" ::"r"(sreg)
+                                 : "memory");
+        }
+
+        inline uint16_t load_head(void) const { return atomic_load(&m_head); }
+        inline uint16_t load_tail(void) const { return atomic_load(&m_tail); }
+        inline uint16_t load_dropped(void) const { return atomic_load(&m_dropped); }
+        inline void store_head(uint16_t const val) { atomic_store(&m_head, val); }
+        inline void store_tail(uint16_t const val) { atomic_store(&m_tail, val); }
+        inline void store_dropped(uint16_t const val) { atomic_store(&m_dropped, val); }
+#else
+        // Release on the index written by a side, acquire on the index written by the other side, so that the bytes are visible before the index.
+        inline uint16_t load_head(void) const { return m_head.load(std::memory_order_acquire); }
+        inline uint16_t load_tail(void) const { return m_tail.load(std::memory_order_acquire); }
+        inline uint16_t load_dropped(void) const { return m_dropped.load(std::memory_order_relaxed); }
+        inline void store_head(uint16_t const val) { m_head.store(val, std::memory_order_release); }
+        inline void store_tail(uint16_t const val) { m_tail.store(val, std::memory_order_release); }
+        inline void store_dropped(uint16_t const val) { m_dropped.store(val, std::memory_order_relaxed); }
+#endif
+
+        uint8_t *m_buffer; // Storage
+        uint16_t m_size;   // Size of the storage
+#if SCRUTINY_BUILD_AVR_GCC
+        volatile uint16_t m_head;    // Position of the next byte to write. Written by the producer only
+        volatile uint16_t m_tail;    // Position of the next byte to read. Written by the consumer only
+        volatile uint16_t m_dropped; // Number of bytes dropped because the ring was full. Written by the producer only
+#else
+        std::atomic<uint16_t> m_head;    // Position of the next byte to write. Written by the producer only
+        std::atomic<uint16_t> m_tail;    // Position of the next byte to read. Written by the consumer only
+        std::atomic<uint16_t> m_dropped; // Number of bytes dropped because the ring was full. Written by the producer only
+#endif
+    };
 }
 
 #endif // ___SCRUTINY_IPC_H___
\ No newline at end of file
@@ -37,6 +37,7 @@ namespace scrutiny
     public:
         enum class Main2LoopMessageID : uint8_t
         {
+            APPLY_STAGED_WRITES,
 #if SCRUTINY_ENABLE_DATALOGGING
             RELEASE_DATALOGGER_OWNERSHIP,
             TAKE_DATALOGGER_OWNERSHIP,
@@ -47,6 +48,7 @@ namespace scrutiny
 
         enum class Loop2MainMessageID : uint8_t
         {
+            STAGED_WRITES_APPLIED,
 #if SCRUTINY_ENABLE_DATALOGGING
             DATALOGGER_OWNERSHIP_TAKEN,
             DATALOGGER_OWNERSHIP_RELEASED,
@@ -58,6 +60,15 @@ namespace scrutiny
         struct Main2LoopMessage
         {
             Main2LoopMessageID message_id;
+            union
+            {
+                struct
+                {
+                    uint8_t *entries;        // Staging buffer containing the validated writes
+                    uint16_t entries_length; // Number of bytes in the staging buffer
+                    uint16_t ticket;         // Redeemed before applying the writes. Fails if the Main Handler cancelled the transaction
+                } staged_writes;
+            } data;
         };
 
         struct Loop2MainMessage
@@ -65,6 +76,10 @@ namespace scrutiny
             Loop2MainMessageID message_id;
             union
             {
+                struct
+                {
+                    bool success; // False if at least one write could not be applied
+                } staged_writes_applied;
 #if SCRUTINY_ENABLE_DATALOGGING
                 struct
                 {
@@ -131,6 +146,8 @@ namespace scrutiny
         /// @brief  Atomic message transferred from the Loop Handler to the Main Handler
         scrutiny::IPCMessage<Loop2MainMessage> m_loop2main_msg;
         char const *m_name;
+        /// @brief A pointer to the Main Handler, used to apply the staged writes
+        MainHandler *m_main_handler = nullptr;
 
 #if SCRUTINY_ENABLE_DATALOGGING
         /// @brief A pointer to the datalogger object part of the Main Handler
@@ -14,6 +14,8 @@
 #include "scrutiny_setup.hpp"
 #include "scrutiny_loop_handler.hpp"
 #include "scrutiny_timebase.hpp"
+#include "scrutiny_tools.hpp"
+#include "scrutiny_comm_channel.hpp"
 #include "protocol/scrutiny_protocol.hpp"
 #include "scrutiny_config.hpp"
 
@@ -26,6 +28,9 @@ namespace scrutiny
     // cppcheck-suppress[noConstructor]
     class MainHandler
     {
+        friend class LoopHandler;
+        friend class CommChannelRequestSink;
+
     public:
         MainHandler(void);
 
@@ -53,30 +58,46 @@ namespace scrutiny
         /// @param timestep_100ns The time elapsed since last call to this function, in multiple of 100ns.
         void process(timediff_t const timestep_100ns);
 
+        /// @brief Same as process(), with a bound on the work done by a single call.
+        /// Long operations are split in slices and resumed on the next calls, the same way a request answered with ProcessAgain is.
+        /// Presently, the memory writes of the Write requests are sliced. Other operations are bounded by the size of the communication buffers.
+        /// The WriteRPV requests are not: their cost is in the user callback, unknown to the library, and the number of values is bounded
+        /// by the reception buffer.
+        /// A sliced write cannot be interrupted once started, so the request is refused if the calls it needs at this budget and time step
+        /// exceed SCRUTINY_REQUEST_MAX_PROCESS_TIME_US. Once started, it is not subject to that timeout
+        /// and the Write requests of the other channels are answered Busy until it completes.
+        /// @param timestep_100ns The time elapsed since last call to this function, in multiple of 100ns.
+        /// @param budget Maximum number of bytes copied to memory by this call. 0 means no limit.
+        void process(timediff_t const timestep_100ns, uint32_t const budget);
+
         /// @brief Pass data received from the server to the scrutiny-embedded lib input stream.
+        /// Applies to the main channel only. Additional channels are fed directly through their CommChannel object.
         /// @param data Pointer to the data buffer
         /// @param len Length of the data
         inline void receive_data(uint8_t const *const data, uint16_t const len)
         {
-            m_comm_handler.receive_data(data, len);
+            m_main_channel.receive_data(data, len);
         }
 
         /// @brief Reads data from the scrutiny-embedded lib output stream so it can be sent to the server
+        /// Applies to the main channel only. Additional channels are read directly through their CommChannel object.
         /// @param buffer Buffer to write the data into
         /// @param len Maximum length of the data to read
         /// @return Number of bytes actually read
         inline uint16_t pop_data(uint8_t *const buffer, uint16_t const len)
         {
-            uint16_t const size = m_comm_handler.pop_data(buffer, len);
-            check_finished_sending();
+            uint16_t const size = m_main_channel.pop_data(buffer, len);
+#if SCRUTINY_ENABLE_DATALOGGING
+            process_datalogging_burst(); // Next frame of a burst is made available as soon as the previous one is drained
+#endif
             return size;
         }
 
-        /// @brief Tells how much data is available in the scrutiny-embedded lib output stream
+        /// @brief Tells how much data is available in the scrutiny-embedded lib output stream (main channel)
         /// @return Number of bytes available
         inline uint16_t data_to_send(void) const
         {
-            return m_comm_handler.data_to_send();
+            return m_main_channel.data_to_send();
         }
 
 #if SCRUTINY_ENABLE_DATALOGGING
@@ -131,6 +152,18 @@ namespace scrutiny
             AnyType *const val,
             VariableType *const output_type) const;
 
+        /// @brief Reads a bitfield variable from a memory location using a precomputed extraction descriptor. Ensure the respect of forbidden regions and will not make unaligned memory access
+        /// @param addr Address at which the variable is stored
+        /// @param descriptor The extraction descriptor made with tools::make_bitfield_descriptor
+        /// @param val The output value
+        /// @param output_type The output variable type, taken from the descriptor
+        /// @return true on success, false on failure
+        bool fetch_variable_bitfield(
+            void const *const addr,
+            tools::BitfieldDescriptor const *const descriptor,
+            AnyType *const val,
+            VariableType *const output_type) const;
+
         /// @brief Returns a pointer to the datalogger object
         inline datalogging::DataLogger *datalogger(void) { return &m_datalogging.datalogger; }
 #endif
@@ -140,8 +173,24 @@ namespace scrutiny
             return m_config.get_rpv_read_callback();
         }
 
-        /// @brief Returns a pointer to the communication handler
-        inline protocol::CommHandler *comm(void) { return &m_comm_handler; }
+        /// @brief Returns a pointer to the communication handler of the main channel
+        inline protocol::CommHandler *comm(void) { return m_main_channel.comm(); }
+
+        /// @brief Returns the number of communication channels served, including the main channel.
+        /// Only the main channel is counted when too many additional channels are given, which check_config() rejects.
+        inline uint8_t channel_count(void) const
+        {
+            if (m_config.m_additional_channel_count > Config::MAX_ADDITIONAL_COMM_CHANNELS)
+            {
+                return 1u;
+            }
+            return static_cast<uint8_t>(m_config.m_additional_channel_count + 1u);
+        }
+
+        /// @brief Returns a communication channel by index. Index 0 is the main channel, the following ones are the additional channels in the order they were given to the configuration.
+        /// @param index The channel index
+        /// @return The channel. nullptr if the index is out of range
+        CommChannel *channel(uint8_t const index);
 
         /// @brief Returns a pointer the the given configuration
         inline Config *get_config(void) { return &m_config; }
@@ -149,34 +198,119 @@ namespace scrutiny
         /// @brief Returns a pointer the the given configuration in read-only
         inline Config const *get_config_ro(void) const { return &m_config; }
 
+        /// @brief Returns the hash of everything the server discovers through GetInfo and GetSetup. Computed by init()
+        inline uint32_t get_config_fingerprint(void) const { return m_config_fingerprint; }
+
+        /// @brief Gives the response of an asynchronous User Command whose callback returned PENDING. Can be called from any context.
+        /// The data is copied in the response by the next call to process() and must stay valid until then.
+        /// @param response_data The response payload
+        /// @param response_data_length The response payload size
+        /// @param success false to answer the request with a failure
+        /// @return false if the previous completion has not been processed yet
+        bool complete_user_command(uint8_t const *const response_data, uint16_t const response_data_length, bool const success = true);
+
     private:
         void process_loops(void);
-        void check_finished_sending(void);
+        bool process_channel(CommChannel *const channel);
+        bool cancel_pending_work(CommChannel *const channel);
+        void drop_lost_request(CommChannel *const channel);
         void process_request(protocol::Request const *const request, protocol::Response *const response);
         protocol::ResponseCode process_get_info(protocol::Request const *const request, protocol::Response *const response);
+        void fill_supported_features(protocol::ResponseData::GetInfo::GetSupportedFeatures *const features) const;
+        void fill_loop_definition(uint8_t const loop_id, protocol::ResponseData::GetInfo::GetLoopDefinition *const definition) const;
+        uint32_t device_description_item_count(void) const;
+        bool write_device_description_item(protocol::DeviceDescriptionResponseEncoder *const encoder, uint32_t const item) const;
         protocol::ResponseCode process_comm_control(protocol::Request const *const request, protocol::Response *const response);
         protocol::ResponseCode process_memory_control(protocol::Request const *const request, protocol::Response *const response);
         protocol::ResponseCode process_user_command(protocol::Request const *const request, protocol::Response *const response);
+        protocol::ResponseCode process_async_user_command(protocol::Request const *const request, protocol::Response *const response);
 
 #if SCRUTINY_ENABLE_DATALOGGING
         protocol::ResponseCode process_datalog_control(protocol::Request const *const request, protocol::Response *const response);
         void process_datalogging_loop_msg(LoopHandler *const sender, LoopHandler::Loop2MainMessage *const msg);
         void process_datalogging_logic(void);
+        void process_datalogging_burst(void);
+        void start_datalogging_read(datalogging::ReadLayout const layout = datalogging::ReadLayout::Rows);
+        bool datalogging_read_owned_by_other_channel(void) const;
+        bool datalogging_stream_in_flight(void) const;
+        protocol::ResponseCode encode_datalogging_acquisition_frame(protocol::Response *const response, uint16_t const streamed_max_size = 0);
 #endif
+        uint16_t max_streamed_response_size(void) const;
+        bool apply_staged_writes(uint8_t *const entries, uint16_t const entries_length) const;
+        bool begin_streamed_write(CommChannel *const channel, uint8_t const command_id, uint8_t const subfunction_id, uint16_t const data_length);
+        void receive_streamed_write(CommChannel *const channel, uint8_t const *const data, uint16_t const len);
+        void release_streamed_write(CommChannel *const channel);
+        static void write_memory_block(MemoryBlock const *const block);
+        uint16_t take_budget(uint16_t const length);
+        protocol::ResponseCode start_memory_write(protocol::Request const *const request, bool const masked, protocol::Response *const response);
         bool touches_forbidden_region(MemoryBlock const *const block) const;
         bool touches_forbidden_region(void const *const addr_start, size_t const length) const;
         bool touches_readonly_region(MemoryBlock const *const block) const;
         bool touches_readonly_region(void const *const addr_start, size_t const length) const;
         void check_config(void);
+        void compute_config_fingerprint(void);
+
+        Timebase m_timebase;           // Timebase to keep track of time
+        CommChannel m_main_channel;    // The main communication channel, using the buffers given by Config::set_buffers
+        CommChannel *m_active_channel; // The channel that owns the request presently being processed
+        uint8_t m_next_channel_index;  // Index of the first channel to look at on next call to process(). Used to serve the channels in a round-robin fashion
+        Config m_config;               // The configuration
+        bool m_enabled;                // Indicates that scrutiny is enabled. Will be disabled if the configuration is wrong.
+        uint32_t m_config_fingerprint; // Hash of the device description, so that the server can reuse the one it has in cache
+        uint32_t m_budget;             // Number of bytes the actual call to process() can still copy. Unlimited if m_budget_limited is false
+        bool m_budget_limited;         // The actual call to process() has a budget
+        timediff_t m_timestep_100ns;   // Time step given to the actual call to process()
+
+        enum class StagedWriteState : uint8_t
+        {
+            Idle,     // No transaction in progress
+            Pending,  // Transaction sent to a loop, waiting for it to be applied
+            Completed // Transaction applied by the loop, response not sent yet
+        };
+
+        struct
+        {
+            StagedWriteState state; // State of the staged write transaction
+            CommChannel *owner;     // The channel that requested the transaction
+            uint8_t loop_id;        // The loop that applies the transaction
+            uint16_t entry_count;   // Number of writes in the transaction
+            bool success;           // Result given by the loop once applied
+            IPCTicket ticket;       // Redeemed by the loop before applying, or by the Main Handler to cancel
+            uint16_t ticket_number; // Number of the transaction sent to the loop
+        } m_staged_write;           // The staged write transaction (MemoryControl::WriteStaged)
+
+        struct
+        {
+            CommChannel *owner;          // The channel receiving the write. nullptr when the staging buffer is free
+            bool masked;                 // The request is a WriteMasked
+            uint16_t expected_length;    // Payload length given in the request header
+            uint16_t length;             // Number of payload bytes staged so far
+            uint16_t next_block;         // Position of the next block header to validate
+            protocol::ResponseCode code; // Result of the validation done so far
+        } m_streamed_write;              // A Write request bigger than the reception buffer, staged in the staged write buffer as it is received
+
+        struct
+        {
+            CommChannel *owner;                                 // The channel whose Write request is partially applied. nullptr if none
+            protocol::WriteMemoryBlocksRequestParser parser;    // Position in the request, past the block being written
+            protocol::WriteMemoryBlocksResponseEncoder encoder; // Position in the response
+            MemoryBlock remaining;                              // Part of the block being written that is not written yet
+        } m_sliced_write;                                       // A Write request applied over several calls to process() because of the budget
+
+        struct UserCommandCompletion
+        {
+            uint8_t const *data; // Response payload
+            uint16_t length;     // Response payload size
+            bool success;        // false if the command failed
+        };
+
+        struct
+        {
+            bool pending;                                 // A command returned PENDING and did not complete yet
+            CommChannel *owner;                           // The channel waiting for the response. nullptr once the requester stopped waiting
+            IPCMessage<UserCommandCompletion> completion; // Given by complete_user_command(), possibly from another context
+        } m_user_command;                                 // Asynchronous User Command in progress
 
-        Timebase m_timebase;                   // Timebase to keep track of time
-        protocol::CommHandler m_comm_handler;  // The communication handler that parses the request and manages the buffers
-        bool m_processing_request;             // True when a request is being processed
-        bool m_disconnect_pending;             // INdicates that a disconnect request has been received and must be processed right away
-        Config m_config;                       // The configuration
-        bool m_enabled;                        // Indicates that scrutiny is enabled. Will be disabled if the configuration is wrong.
-        bool m_process_again_timestamp_taken;  // Indicates that a timestamp has been taken on ProcessAgain response code, meaning that the timestamp should not be updated on subsequent ProcessAgain code
-        timestamp_t m_process_again_timestamp; // Timestamp at which the first ProcessAgain code has been returned to ensure timeout
 #if SCRUTINY_ACTUAL_PROTOCOL_VERSION == SCRUTINY_PROTOCOL_VERSION(1, 0)
         protocol::CodecV1_0 m_codec; // Communication protocol Codec
 #else
@@ -211,8 +345,13 @@ namespace scrutiny
             bool request_disarm_trigger;              // Flag indicating that a request has been made to darm the trigger
             bool pending_ownership_release;           // Flag indicating that a request for ownership release is presently being processed
             bool reading_in_progress;                 // Flag indicating that the datalogging data is presently being read by the user.
+            CommChannel *read_channel;                // Channel doing the sequential read. Other channels are answered Busy until it finishes or its session ends
+            CommChannel *streaming_channel;           // Channel transmitting a streamed acquisition frame. nullptr once it is sent
             uint8_t read_acquisition_rolling_counter; // Counter to validate the order of the data packet being read
             uint32_t read_acquisition_crc;            // CRC of the datalogging buffer content
+            CommChannel *burst_channel;               // Channel that receives the acquisition in burst mode. nullptr when no burst is active
+            uint8_t burst_frames_per_ack;             // Number of burst frames sent between two acknowledgements from the server. 0 means no flow control
+            uint8_t burst_frame_counter;              // Number of burst frames sent since the last acknowledgement
         } m_datalogging;                              // All data related to the datalogging feature
 #endif
     };
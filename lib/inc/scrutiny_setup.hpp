@@ -55,6 +55,10 @@
 #error Unsupported protocol version
 #endif
 
+#if SCRUTINY_MEMORY_WRITE_ACCESS_WIDTH != 1 && SCRUTINY_MEMORY_WRITE_ACCESS_WIDTH != 2 && SCRUTINY_MEMORY_WRITE_ACCESS_WIDTH != 4 && SCRUTINY_MEMORY_WRITE_ACCESS_WIDTH != 8
+#error Unsupported memory write access width
+#endif
+
 #if SCRUTINY_BUILD_WINDOWS && SCRUTINY_BUILD_AVR_GCC
 #error Bad detection of build environment
 #endif
@@ -184,6 +184,45 @@ namespace scrutiny
             v.float32 = val;
         }
 #endif
+        /// @brief Writes a block of memory, changing only the bits set in the mask.
+        /// The destination is accessed with aligned words of SCRUTINY_MEMORY_WRITE_ACCESS_WIDTH bytes, with byte access on the unaligned head and tail.
+        /// @param dst Destination buffer
+        /// @param data Data to write. No alignment required
+        /// @param mask Mask of the bits to write. No alignment required
+        /// @param length Number of bytes
+        void write_masked(uint8_t *const dst, uint8_t const *const data, uint8_t const *const mask, uint16_t const length);
+
+        /// @brief Everything needed to extract a bitfield from memory, computed once so that the extraction itself
+        /// does not have to branch on the fetch size, the output size or the signedness.
+        struct BitfieldDescriptor
+        {
+            typedef void (*extract_func_t)(void const *const addr, BitfieldDescriptor const *const descriptor, AnyType *const val);
+
+            extract_func_t extract;   // Extraction function specialized for the fetch size and the output size. nullptr if the bitfield is not supported
+            uint_biggest_t mask;      // Mask of the value bits, applied after the shift
+            uint_biggest_t sign_bit;  // Sign bit of the value used for sign extension. 0 for unsigned types
+            uint8_t bitoffset;        // Number of bits to shift right after the fetch
+            uint8_t fetch_size;       // Number of bytes read from memory
+            VariableType output_type; // Data type of the extracted value
+        };
+
+        /// @brief Computes the extraction descriptor of a bitfield
+        /// @param var_tt Type type of the bitfield (uint, sint, boolean)
+        /// @param bitoffset Offset in bits from the address
+        /// @param bitsize Size in bits of the bitfield
+        /// @param descriptor The descriptor to fill. Its extract function is set to nullptr when the bitfield is not supported
+        /// @return true if the bitfield can be extracted, false otherwise
+        bool make_bitfield_descriptor(VariableTypeType const var_tt, uint_fast8_t const bitoffset, uint_fast8_t const bitsize, BitfieldDescriptor *const descriptor);
+
+        /// @brief Extracts a bitfield from memory with a descriptor made by make_bitfield_descriptor. Does not check for forbidden regions.
+        /// @param addr Address at which the bitfield is stored. No alignment required
+        /// @param descriptor A valid bitfield descriptor
+        /// @param val The output value, of type descriptor->output_type
+        inline void extract_bitfield(void const *const addr, BitfieldDescriptor const *const descriptor, AnyType *const val)
+        {
+            descriptor->extract(addr, descriptor, val);
+        }
+
         /// @brief Custom implementation of non-standard strnlen. Gives the length of a string but doesn't read beyond maxlen
         /// @param s The string
         /// @param maxlen Maximum length to check
@@ -32,6 +32,16 @@ namespace scrutiny
     /// @brief User Command Callback function
     typedef ctypes::scrutiny_c_user_command_callback_t user_command_callback_t;
 
+    /// @brief Status returned by an asynchronous User Command callback
+    enum class UserCommandStatus : uint8_t
+    {
+        COMPLETED = ctypes::SCRUTINY_C_USER_COMMAND_STATUS_COMPLETED, // The response has been written by the callback
+        PENDING = ctypes::SCRUTINY_C_USER_COMMAND_STATUS_PENDING      // The response will be given later with MainHandler::complete_user_command()
+    };
+
+    /// @brief Asynchronous User Command Callback function
+    typedef ctypes::scrutiny_c_async_user_command_callback_t async_user_command_callback_t;
+
     /// @brief Represent a type type, meaning a type without its size. uint8, uin16, int32 all have type type uint.
     enum class VariableTypeType : uint8_t
     {
@@ -21,10 +21,13 @@
 #define SCRUTINY_REQUEST_MAX_PROCESS_TIME_US 100000u
 #define SCRUTINY_COMM_RX_TIMEOUT_US 50000u
 #define SCRUTINY_COMM_HEARTBEAT_TIMEOUT_US 5000000u
+#define SCRUTINY_MEMORY_WRITE_ACCESS_WIDTH 4u
 #define SCRUTINY_ACTUAL_PROTOCOL_VERSION SCRUTINY_PROTOCOL_VERSION(1, 0u)
 
 #if SCRUTINY_ENABLE_DATALOGGING
 #define SCRUTINY_DATALOGGING_MAX_SIGNAL 32u
+#define SCRUTINY_DATALOGGING_MAX_SEGMENTS 16u
+#define SCRUTINY_DATALOGGING_MAX_TIME_MARKS 32u
 #define SCRUTINY_DATALOGGING_ENCODING SCRUTINY_DATALOGGING_ENCODING_RAW
 #define SCRUTINY_DATALOGGING_BUFFER_32BITS 1
 #endif
@@ -21,6 +21,38 @@ namespace scrutiny
 {
     namespace datalogging
     {
+        /// @brief Validates a bitfield definition and computes its extraction descriptor
+        /// @param varbit The bitfield definition
+        /// @param extract_tt The type type used for extraction. Decides if the value is sign extended or not
+        /// @return true if the definition is valid
+        static bool prepare_varbit(VarBitDefinition *const varbit, VariableTypeType const extract_tt)
+        {
+            bool valid = true;
+            // Works with and without 64bits support
+            if (varbit->bitoffset > (sizeof(scrutiny::uint_biggest_t) * 8 - 1) || varbit->bitsize > sizeof(scrutiny::uint_biggest_t) * 8)
+            {
+                valid = false;
+            }
+
+            if (!tools::is_supported_type(varbit->datatype) || tools::is_float_type(varbit->datatype))
+            {
+                valid = false;
+            }
+
+            if (varbit->bitoffset + varbit->bitsize > tools::get_type_size(varbit->datatype) * 8)
+            {
+                valid = false;
+            }
+
+            // Precompute the extraction parameters so that the trigger evaluation and the acquisition do not have to.
+            if (!tools::make_bitfield_descriptor(extract_tt, varbit->bitoffset, varbit->bitsize, &varbit->descriptor))
+            {
+                valid = false;
+            }
+
+            return valid;
+        }
+
         void DataLogger::init(
             MainHandler const *const main_handler,
             Timebase const *const timebase,
@@ -33,18 +65,40 @@ namespace scrutiny
             m_buffer_size = buffer_size;
             m_trigger_callback = trigger_callback;
 
+            m_config.segment_count = 1;
+            m_config.time_axis = TimeAxis::Logged;
             m_encoder.init(main_handler, timebase, &m_config, buffer, buffer_size);
             m_acquisition_id = 0;
 
             reset();
         }
 
+        void DataLogger::init(
+            MainHandler const *const main_handler,
+            Timebase const *const timebase,
+            Storage *const storage,
+            trigger_callback_t trigger_callback)
+        {
+            m_timebase = timebase;
+            m_main_handler = main_handler;
+            m_buffer_size = storage->size();
+            m_trigger_callback = trigger_callback;
+
+            m_config.segment_count = 1;
+            m_config.time_axis = TimeAxis::Logged;
+            m_encoder.init(main_handler, timebase, &m_config, storage);
+            m_acquisition_id = 0;
+
+            reset();
+        }
+
         void DataLogger::reset(void)
         {
             m_state = State::IDLE;
             m_trigger.previous_val = false;
             m_trigger.rising_edge_timestamp = 0;
             m_trigger.active_condition = nullptr;
+            m_trigger.wait_release = false;
 
             m_trigger_cursor_location = 0;
             m_trigger_timestamp = 0;
@@ -54,6 +108,7 @@ namespace scrutiny
 
             m_decimation_counter = 0;
             m_log_points_after_trigger = 0;
+            m_completed_segment_count = 0;
         }
 
         void DataLogger::configure(Timebase *timebase_for_log, uint16_t config_id)
@@ -74,6 +129,16 @@ namespace scrutiny
                 m_config_valid = false;
             }
 
+            if (m_config.segment_count == 0 || m_config.segment_count > SCRUTINY_DATALOGGING_MAX_SEGMENTS)
+            {
+                m_config_valid = false;
+            }
+
+            if (m_config.time_axis != TimeAxis::Logged && m_config.time_axis != TimeAxis::Implicit && m_config.time_axis != TimeAxis::Sparse)
+            {
+                m_config_valid = false;
+            }
+
             switch (m_config.trigger.condition)
             {
             case SupportedTriggerConditions::AlwaysTrue:
@@ -146,18 +211,7 @@ namespace scrutiny
                     }
                     else if (m_config.trigger.operands[i].type == OperandType::VARBIT)
                     {
-                        // Works with and without 64bits support
-                        if (m_config.trigger.operands[i].data.varbit.bitoffset > (sizeof(scrutiny::BiggestUint) * 8 - 1) || m_config.trigger.operands[i].data.varbit.bitsize > sizeof(scrutiny::BiggestUint) * 8)
-                        {
-                            m_config_valid = false;
-                        }
-
-                        if (!tools::is_supported_type(m_config.trigger.operands[i].data.varbit.datatype))
-                        {
-                            m_config_valid = false;
-                        }
-
-                        if (m_config.trigger.operands[i].data.varbit.bitoffset + m_config.trigger.operands[i].data.varbit.bitsize > tools::get_type_size(m_config.trigger.operands[i].data.varbit.datatype))
+                        if (!prepare_varbit(&m_config.trigger.operands[i].data.varbit, tools::get_var_type_type(m_config.trigger.operands[i].data.varbit.datatype)))
                         {
                             m_config_valid = false;
                         }
@@ -188,7 +242,19 @@ namespace scrutiny
                     }
                     else if (m_config.items_to_log[i].type == LoggableType::TIME)
                     {
-                        // Nothing to validate
+                        // Time is given by the time axis when it is not logged
+                        if (m_config.time_axis != TimeAxis::Logged)
+                        {
+                            m_config_valid = false;
+                        }
+                    }
+                    else if (m_config.items_to_log[i].type == LoggableType::VARBIT)
+                    {
+                        // Logged raw. The server does the sign extension.
+                        if (!prepare_varbit(&m_config.items_to_log[i].data.varbit, VariableTypeType::_uint))
+                        {
+                            m_config_valid = false;
+                        }
                     }
                     else
                     {
@@ -214,6 +280,13 @@ namespace scrutiny
         {
             if (m_state == State::CONFIGURED || m_state == State::ACQUISITION_COMPLETED || m_state == State::TRIGGERED)
             {
+                if (m_encoder.get_active_segment() != 0)
+                {
+                    // A segmented acquisition starts over from the first segment
+                    m_encoder.reset();
+                    m_completed_segment_count = 0;
+                }
+                m_trigger.wait_release = false;
                 m_state = State::ARMED;
             }
         }
@@ -264,9 +337,23 @@ namespace scrutiny
                     {
                         if (acquisition_completed())
                         {
-                            m_acquisition_id++;
-                            m_state = State::ACQUISITION_COMPLETED;
                             m_log_points_after_trigger = m_encoder.get_entry_write_counter();
+                            m_segments[m_encoder.get_active_segment()].points_after_trigger = m_log_points_after_trigger;
+                            m_completed_segment_count++;
+
+                            if (m_encoder.next_segment())
+                            {
+                                // Segmented acquisition. Re-armed right away for the next capture, without the server.
+                                // The condition must go false first, otherwise a level condition would fill every segment with the same event.
+                                m_trigger.wait_release = (m_config.trigger.condition != SupportedTriggerConditions::AlwaysTrue);
+                                m_state = State::ARMED;
+                            }
+                            else
+                            {
+                                m_acquisition_id++;
+                                m_state = State::ACQUISITION_COMPLETED;
+                                m_encoder.flush(); // Let the storage persist the acquisition
+                            }
                         }
                     }
                     break;
@@ -278,18 +365,20 @@ namespace scrutiny
         {
             m_trigger_cursor_location = m_encoder.get_write_cursor();
             m_trigger_timestamp = m_timebase->get_timestamp();
+            m_segments[m_encoder.get_active_segment()].trigger_timestamp = m_timebase_for_log->get_timestamp();
             m_encoder.reset_write_counter(); // Completion logic uses that counter directly without processing
 
+            buffer_size_t const segment_size = m_buffer_size / m_encoder.get_segment_count(); // The whole buffer when not segmented
             uint64_t const multiplier = static_cast<uint64_t>((1 << (sizeof(m_config.probe_location) * 8)) - 1 - m_config.probe_location);
-            m_remaining_data_to_write = static_cast<buffer_size_t>((static_cast<uint64_t>(m_buffer_size) * multiplier) >> (sizeof(m_config.probe_location) * 8));
+            m_remaining_data_to_write = static_cast<buffer_size_t>((static_cast<uint64_t>(segment_size) * multiplier) >> (sizeof(m_config.probe_location) * 8));
             if (!m_encoder.buffer_full())
             {
                 m_remaining_data_to_write = SCRUTINY_MAX(m_remaining_data_to_write, m_encoder.remaining_bytes_to_full());
             }
 
-            if (m_remaining_data_to_write > m_buffer_size)
+            if (m_remaining_data_to_write > segment_size)
             {
-                m_remaining_data_to_write = m_buffer_size;
+                m_remaining_data_to_write = segment_size;
             }
         }
 
@@ -324,6 +413,19 @@ namespace scrutiny
             return (m_state == State::TRIGGERED) ? m_remaining_data_to_write : 0;
         }
 
+        bool DataLogger::get_segment_info(uint16_t const segment, timestamp_t *const trigger_timestamp, buffer_size_t *const entry_count, buffer_size_t *const points_after_trigger) const
+        {
+            if (segment >= m_completed_segment_count)
+            {
+                return false;
+            }
+
+            *trigger_timestamp = m_segments[segment].trigger_timestamp;
+            *entry_count = m_encoder.get_segment_entry_count(segment);
+            *points_after_trigger = m_segments[segment].points_after_trigger;
+            return true;
+        }
+
         datalogging::buffer_size_t DataLogger::data_counter_since_trigger(void) const
         {
             // This counter gets reset when trigger happens.
@@ -380,7 +482,11 @@ namespace scrutiny
                     reinterpret_cast<VariableTypeCompare *>(optypes),
                     reinterpret_cast<AnyTypeCompare *>(opvals));
 
-                if (condition_result)
+                if (m_trigger.wait_release)
+                {
+                    m_trigger.wait_release = condition_result;
+                }
+                else if (condition_result)
                 {
                     if (m_trigger.previous_val == false)
                     {
@@ -11,63 +11,224 @@
 #include "datalogging/scrutiny_datalogger_raw_encoder.hpp"
 #include "scrutiny_main_handler.hpp"
 #include "scrutiny_common_codecs.hpp"
+#include "datalogging/scrutiny_datalogging.hpp"
 
 namespace scrutiny
 {
     namespace datalogging
     {
+        /// @brief Writes the LSBs of a value in a packed bit group, LSB first. Bytes are cleared when first touched.
+        /// @param dst Start of the bit group
+        /// @param bitpos Position in the group, in bits
+        /// @param value The value to write. Bits above bitsize are ignored
+        /// @param bitsize Number of bits to write
+        static void write_packed_bits(uint8_t *const dst, uint_fast16_t bitpos, uint_biggest_t value, uint_fast8_t bitsize)
+        {
+            while (bitsize > 0)
+            {
+                uint_fast8_t const shift = bitpos & 0x7;
+                uint_fast8_t const n = SCRUTINY_MIN(static_cast<uint_fast8_t>(8 - shift), bitsize);
+                uint8_t *const byte = &dst[bitpos >> 3];
+                if (shift == 0)
+                {
+                    *byte = 0;
+                }
+                *byte |= static_cast<uint8_t>((static_cast<uint_fast8_t>(value) & ((1u << n) - 1)) << shift);
+                value >>= n;
+                bitpos += n;
+                bitsize -= n;
+            }
+        }
+
+        /// @brief Writes a value stored in native byte order in big endian
+        /// @param src The value in native byte order. Can be unaligned
+        /// @param size Size of the value. 2, 4 or 8
+        /// @param dst Where to write the big endian value
+        static void native_to_big_endian(uint8_t const *const src, uint8_t const size, uint8_t *const dst)
+        {
+            if (size == sizeof(uint16_t))
+            {
+                uint16_t value;
+                memcpy(&value, src, sizeof(value));
+                codecs::encode_16_bits_big_endian(value, dst);
+            }
+            else if (size == sizeof(uint32_t))
+            {
+                uint32_t value;
+                memcpy(&value, src, sizeof(value));
+                codecs::encode_32_bits_big_endian(value, dst);
+            }
+#if SCRUTINY_SUPPORT_64BITS
+            else if (size == sizeof(uint64_t))
+            {
+                uint64_t value;
+                memcpy(&value, src, sizeof(value));
+                codecs::encode_64_bits_big_endian(value, dst);
+            }
+#endif
+        }
+
+        /// @brief Converts the fields stored in native byte order to big endian in a copy of the storage.
+        /// The window must contain the entries touched by the copy entirely since a field can be partly copied.
+        /// @param output The copy of the storage
+        /// @param storage_cursor Position in the storage of the first byte of the copy
+        /// @param size Size of the copy
+        void RawFormatReader::convert_to_big_endian(uint8_t *const output, datalogging::buffer_size_t const storage_cursor, datalogging::buffer_size_t const size) const
+        {
+            uint16_t const entry_size = m_encoder->m_entry_size;
+            datalogging::buffer_size_t const end = storage_cursor + size;
+            for (datalogging::buffer_size_t entry_start = storage_cursor - (storage_cursor % entry_size); entry_start < end; entry_start += entry_size)
+            {
+                for (uint_fast8_t i = 0; i < m_encoder->m_field_count; i++)
+                {
+                    RawFormatEncoder::EntryField const *const field = &m_encoder->m_fields[i];
+                    datalogging::buffer_size_t const field_start = entry_start + field->offset;
+                    if (!field->native_order || field_start + field->size <= storage_cursor || field_start >= end)
+                    {
+                        continue;
+                    }
+
+                    uint8_t big_endian[8];
+                    native_to_big_endian(m_window.at(field_start), field->size, big_endian);
+                    for (uint_fast8_t j = 0; j < field->size; j++)
+                    {
+                        datalogging::buffer_size_t const position = field_start + j;
+                        if (position >= storage_cursor && position < end)
+                        {
+                            output[position - storage_cursor] = big_endian[j];
+                        }
+                    }
+                }
+            }
+        }
+
         /// @brief Reads a chunk of data from the datalogger buffer and copy it to the output buffer
+        /// The segments are read one after the other, each from its oldest entry to its newest.
         /// @param buffer Output buffer
         /// @param max_size Maximum size to copy
         /// @return Number of bytes written
         datalogging::buffer_size_t RawFormatReader::read(uint8_t *const buffer, datalogging::buffer_size_t const max_size)
         {
-            datalogging::buffer_size_t output_size = 0;
             if (error())
             {
                 return 0;
             }
 
-            datalogging::buffer_size_t const write_cursor = m_encoder->get_write_cursor();
-            datalogging::buffer_size_t const buffer_end = m_encoder->get_buffer_effective_size(); // Encoder may not use the full buffer
-            if (m_read_cursor == write_cursor && m_read_started)
+            datalogging::buffer_size_t const output_size = (m_layout == ReadLayout::Columns) ? read_columns(buffer, max_size) : read_rows(buffer, max_size);
+            if (m_position >= get_total_size())
             {
                 m_finished = true;
-                return 0;
             }
 
-            // Will do a maximum of 2 loops only if there is a wrap in the buffer.
-            // This will cause 2 memcpy   start to buffer_end & buffer start to end
-            // Otherwise a 1 loop and 1 memcpy
-            while (output_size < max_size)
+            return output_size;
+        }
+
+        /// @brief Reads the acquisition entry after entry. Entries are contiguous in the storage, except at the wrap point of a segment.
+        datalogging::buffer_size_t RawFormatReader::read_rows(uint8_t *const buffer, datalogging::buffer_size_t const max_size)
+        {
+            datalogging::buffer_size_t output_size = 0;
+            datalogging::buffer_size_t const segment_size = m_encoder->get_buffer_effective_size(); // Encoder may not use the full buffer
+            uint16_t const segment_count = m_encoder->m_active_segment + 1u;                         // Segments after the active one are empty
+
+            // Does a maximum of 2 loops per segment only if there is a wrap in the segment.
+            while (output_size < max_size && m_segment < segment_count)
             {
-                datalogging::buffer_size_t transfer_size;
-                datalogging::buffer_size_t const new_max = max_size - output_size;
-                datalogging::buffer_size_t const right_hand_start_point = (write_cursor > m_read_cursor) ? write_cursor : buffer_end;
-                transfer_size = right_hand_start_point - m_read_cursor;
-                transfer_size = SCRUTINY_MIN(transfer_size, new_max);
-                memcpy(&buffer[output_size], &m_encoder->m_buffer[m_read_cursor], transfer_size);
-                m_read_cursor += transfer_size;
-                m_read_started = true;
+                RawFormatEncoder::SegmentRecord record;
+                m_encoder->get_segment(m_segment, &record);
+                datalogging::buffer_size_t const data_size = record.entries_count * m_encoder->m_entry_size;
+                if (m_segment_position >= data_size)
+                {
+                    m_segment++;
+                    m_segment_position = 0;
+                    continue;
+                }
+
+                datalogging::buffer_size_t read_cursor = record.first_valid_entry_index * m_encoder->m_entry_size + m_segment_position;
+                if (read_cursor >= segment_size)
+                {
+                    read_cursor -= segment_size;
+                }
+
+                datalogging::buffer_size_t transfer_size = SCRUTINY_MIN(segment_size - read_cursor, data_size - m_segment_position);
+                transfer_size = SCRUTINY_MIN(transfer_size, max_size - output_size);
+                datalogging::buffer_size_t const storage_cursor = m_segment * segment_size + read_cursor;
+                // Whole entries are mapped so that the fields cut by the transfer can be converted
+                uint16_t const entry_size = m_encoder->m_entry_size;
+                datalogging::buffer_size_t const map_start = storage_cursor - (storage_cursor % entry_size);
+                datalogging::buffer_size_t const map_end = storage_cursor + transfer_size + ((entry_size - ((storage_cursor + transfer_size) % entry_size)) % entry_size);
+                if (!m_window.contains(map_start, map_end - map_start))
+                {
+                    if (!m_encoder->m_storage->map(map_start, map_end - map_start, &m_window))
+                    {
+                        break; // Storage failure. Nothing more can be read
+                    }
+                }
+                memcpy(&buffer[output_size], m_window.at(storage_cursor), transfer_size);
+                if (m_encoder->m_native_field_count > 0)
+                {
+                    convert_to_big_endian(&buffer[output_size], storage_cursor, transfer_size);
+                }
+                m_segment_position += transfer_size;
+                m_position += transfer_size;
                 output_size += transfer_size;
-                if (m_read_cursor > write_cursor)
+            }
+
+            return output_size;
+        }
+
+        /// @brief Reads the acquisition field after field. Each field is read for every entry, from the oldest to the newest,
+        /// before moving to the next field. Copies at most one field at a time since the fields are scattered in the storage.
+        datalogging::buffer_size_t RawFormatReader::read_columns(uint8_t *const buffer, datalogging::buffer_size_t const max_size)
+        {
+            datalogging::buffer_size_t output_size = 0;
+            datalogging::buffer_size_t const entry_count = m_encoder->get_entry_count();
+            while (output_size < max_size && m_column < m_encoder->m_field_count)
+            {
+                RawFormatEncoder::EntryField const *const field = &m_encoder->m_fields[m_column];
+                if (m_column_position >= entry_count * field->size)
                 {
-                    if (m_read_cursor >= buffer_end)
+                    m_column++;
+                    m_column_position = 0;
+                    continue;
+                }
+
+                datalogging::buffer_size_t const entry = m_column_position / field->size;
+                uint16_t const field_position = static_cast<uint16_t>(m_column_position % field->size);
+                datalogging::buffer_size_t const field_start = m_encoder->get_entry_storage_position(entry) + field->offset;
+                if (!m_window.contains(field_start, field->size))
+                {
+                    if (!m_encoder->m_storage->map(field_start, field->size, &m_window))
                     {
-                        m_read_cursor -= buffer_end;
+                        break; // Storage failure. Nothing more can be read
                     }
                 }
 
-                if (m_read_cursor == write_cursor)
+                datalogging::buffer_size_t const transfer_size = SCRUTINY_MIN(static_cast<datalogging::buffer_size_t>(field->size - field_position), max_size - output_size);
+                if (field->native_order)
                 {
-                    m_finished = true;
-                    break;
+                    uint8_t big_endian[8];
+                    native_to_big_endian(m_window.at(field_start), static_cast<uint8_t>(field->size), big_endian);
+                    memcpy(&buffer[output_size], &big_endian[field_position], transfer_size);
                 }
+                else
+                {
+                    memcpy(&buffer[output_size], m_window.at(field_start + field_position), transfer_size);
+                }
+                m_column_position += transfer_size;
+                m_position += transfer_size;
+                output_size += transfer_size;
             }
 
             return output_size;
         }
 
+        /// @brief Selects the order in which the data is read and restarts the reading from the beginning
+        void RawFormatReader::set_layout(datalogging::ReadLayout const layout)
+        {
+            m_layout = layout;
+            reset();
+        }
+
         /// @brief Returns the total number of bytes that the reader will read
         datalogging::buffer_size_t RawFormatReader::get_total_size(void) const
         {
@@ -76,15 +237,84 @@ namespace scrutiny
                 return 0;
             }
 
-            return m_encoder->m_entries_count * m_encoder->m_entry_size;
+            return m_encoder->get_entry_count() * m_encoder->m_entry_size;
+        }
+
+        /// @brief Returns the number of bytes that the reader has yet to read
+        datalogging::buffer_size_t RawFormatReader::get_remaining_size(void) const
+        {
+            if (error() || m_finished)
+            {
+                return 0;
+            }
+
+            return get_total_size() - m_position;
         }
 
         /// @brief Reset the reader
         void RawFormatReader::reset(void)
         {
-            m_read_started = false;
             m_finished = false;
-            m_read_cursor = m_encoder->get_read_cursor();
+            m_segment = 0;
+            m_segment_position = 0;
+            m_column = 0;
+            m_column_position = 0;
+            m_position = 0;
+            if (m_window.data != nullptr)
+            {
+                m_encoder->m_storage->unmap(&m_window);
+            }
+        }
+
+        /// @brief Moves the reader to a position in the acquisition, as if that many bytes had already been read.
+        /// Makes it possible to read the acquisition in any order.
+        /// @param position Position in bytes from the beginning of the acquisition
+        /// @return true on success. false if the position is beyond the end of the acquisition
+        bool RawFormatReader::seek(datalogging::buffer_size_t const position)
+        {
+            datalogging::buffer_size_t const total_size = get_total_size();
+            if (error() || position > total_size)
+            {
+                return false;
+            }
+
+            // Find the field that holds the position. read() skips to the next field if it lands on the end of one.
+            if (m_layout == ReadLayout::Columns)
+            {
+                datalogging::buffer_size_t const entry_count = m_encoder->get_entry_count();
+                m_column = 0;
+                m_column_position = position;
+                while (m_column < m_encoder->m_field_count)
+                {
+                    datalogging::buffer_size_t const column_size = entry_count * m_encoder->m_fields[m_column].size;
+                    if (m_column_position < column_size)
+                    {
+                        break;
+                    }
+                    m_column_position -= column_size;
+                    m_column++;
+                }
+                m_position = position;
+                m_finished = (position == total_size);
+                return true;
+            }
+
+            // Find the segment that holds the position. read() skips to the next segment if it lands on the end of one.
+            m_segment = 0;
+            m_segment_position = position;
+            while (m_segment < m_encoder->m_active_segment)
+            {
+                datalogging::buffer_size_t const segment_data_size = m_encoder->get_segment_entry_count(m_segment) * m_encoder->m_entry_size;
+                if (m_segment_position < segment_data_size)
+                {
+                    break;
+                }
+                m_segment_position -= segment_data_size;
+                m_segment++;
+            }
+            m_position = position;
+            m_finished = (position == total_size);
+            return true;
         }
 
         /// @brief Takes a snapshot of the data to log and write it into the datalogger buffer
@@ -104,12 +334,30 @@ namespace scrutiny
                 }
             }
 
-            datalogging::buffer_size_t cursor = m_next_entry_write_index * m_entry_size;
+            datalogging::buffer_size_t const entry_start = (m_active_segment * m_max_entries + m_next_entry_write_index) * m_entry_size;
+            if (!m_write_window.contains(entry_start, m_entry_size))
+            {
+                if (!m_storage->map(entry_start, m_entry_size, &m_write_window))
+                {
+                    m_error = true;
+                    return;
+                }
+            }
+
+            uint8_t *const entry = m_write_window.at(entry_start); // Direct access for the whole entry
+            uint_fast16_t cursor = 0;
+            uint_fast16_t packed_bits = 0; // Number of bits in the current group of VARBIT items
             for (uint_fast8_t i = 0; i < m_config->items_count; i++)
             {
+                if (m_config->items_to_log[i].type != datalogging::LoggableType::VARBIT && packed_bits > 0)
+                {
+                    cursor += (packed_bits + 7) >> 3; // End of the group. Move to the next byte
+                    packed_bits = 0;
+                }
+
                 if (m_config->items_to_log[i].type == datalogging::LoggableType::MEMORY)
                 {
-                    m_main_handler->read_memory(&m_buffer[cursor], m_config->items_to_log[i].data.memory.address, m_config->items_to_log[i].data.memory.size);
+                    m_main_handler->read_memory(&entry[cursor], m_config->items_to_log[i].data.memory.address, m_config->items_to_log[i].data.memory.size);
                     cursor += m_config->items_to_log[i].data.memory.size; // We verified that this is not 0 in init
                 }
                 else if (m_config->items_to_log[i].type == datalogging::LoggableType::RPV)
@@ -120,14 +368,31 @@ namespace scrutiny
                     m_main_handler->get_rpv(rpv_id, &rpv);
                     uint8_t const typesize = tools::get_type_size(rpv.type); // Should be supported. We rely on datalogger::configure
                     m_main_handler->get_rpv_read_callback()(rpv, &outval);   // We assume that this is not nullptr. We rely on datalogger::configure
-                    codecs::encode_anytype_big_endian(&outval, typesize, &m_buffer[cursor]);
+                    memcpy(&entry[cursor], &outval, typesize);               // Native byte order. The reader converts to big endian
                     cursor += typesize;
                 }
                 else if (m_config->items_to_log[i].type == datalogging::LoggableType::TIME)
                 {
-                    codecs::encode_32_bits_big_endian(m_timebase_for_log->get_timestamp(), &m_buffer[cursor]);
+                    timestamp_t const timestamp = m_timebase_for_log->get_timestamp();
+                    memcpy(&entry[cursor], &timestamp, sizeof(timestamp)); // Native byte order. The reader converts to big endian
                     cursor += sizeof(scrutiny::timestamp_t);
                 }
+                else if (m_config->items_to_log[i].type == datalogging::LoggableType::VARBIT)
+                {
+                    VarBitDefinition const *const varbit = &m_config->items_to_log[i].data.varbit;
+                    AnyType outval;
+                    VariableType outtype;
+                    // Descriptor is valid and unsigned. We rely on datalogger::configure. Zero is logged if memory is forbidden.
+                    m_main_handler->fetch_variable_bitfield(varbit->addr, &varbit->descriptor, &outval, &outtype);
+                    convert_to_compare_type(&outtype, &outval);
+                    write_packed_bits(&entry[cursor], packed_bits, tools::read_biggest_uint(outval), varbit->bitsize);
+                    packed_bits += varbit->bitsize;
+                }
+            }
+
+            if (m_config->time_axis == datalogging::TimeAxis::Sparse)
+            {
+                record_time();
             }
 
             if (!m_full)
@@ -135,6 +400,7 @@ namespace scrutiny
                 m_entries_count++;
             }
 
+            m_entries_written++;
             m_next_entry_write_index++;
             if (m_next_entry_write_index >= m_max_entries)
             {
@@ -152,12 +418,22 @@ namespace scrutiny
             datalogging::Configuration const *const config,
             uint8_t *const buffer,
             datalogging::buffer_size_t const buffer_size)
+        {
+            m_buffer_storage.init(buffer, buffer_size);
+            init(main_handler, timebase_for_log, config, &m_buffer_storage);
+        }
+
+        /// @brief  Init the encoder with an external storage
+        void RawFormatEncoder::init(
+            MainHandler const *const main_handler,
+            Timebase const *const timebase_for_log,
+            datalogging::Configuration const *const config,
+            Storage *const storage)
         {
             m_main_handler = main_handler;
             m_timebase_for_log = timebase_for_log;
             m_config = config;
-            m_buffer = buffer;
-            m_buffer_size = buffer_size;
+            m_storage = (storage == nullptr) ? &m_buffer_storage : storage;
 
             reset();
         }
@@ -169,21 +445,74 @@ namespace scrutiny
             m_next_entry_write_index = 0;
             m_first_valid_entry_index = 0;
             m_entry_size = 0;
+            m_field_count = 0;
+            m_native_field_count = 0;
             m_entries_count = 0;
             m_full = false;
             m_max_entries = 0;
+            m_active_segment = 0;
+            m_previous_segments_entries_count = 0;
+            m_entries_written = 0;
+            m_first_time_mark = 0;
+            m_time_mark_count = 0;
+            m_last_timestamp = 0;
+            m_last_time_step = 0;
+            m_segment_count = (m_config->segment_count == 0) ? 1u : m_config->segment_count;
+
+            if (m_segment_count > SCRUTINY_DATALOGGING_MAX_SEGMENTS)
+            {
+                m_error = true;
+            }
 
-            if (m_buffer == nullptr || m_buffer_size == 0)
+            m_time_marks_per_segment = 0;
+            if (m_config->time_axis == datalogging::TimeAxis::Sparse)
+            {
+                m_time_marks_per_segment = static_cast<uint16_t>(SCRUTINY_DATALOGGING_MAX_TIME_MARKS / m_segment_count);
+                if (m_time_marks_per_segment < 2)
+                {
+                    m_error = true; // Not enough to follow the time step of a segment
+                }
+            }
+
+            if (m_write_window.data != nullptr)
+            {
+                m_storage->unmap(&m_write_window);
+            }
+
+            if (m_storage->size() == 0)
+            {
+                m_error = true;
+            }
+
+            if (m_config->items_count > SCRUTINY_DATALOGGING_MAX_SIGNAL)
             {
                 m_error = true;
             }
 
+            uint_fast16_t packed_bits = 0;
             for (uint_fast8_t i = 0; i < m_config->items_count; i++)
             {
                 if (m_error)
                 {
                     break;
                 }
+
+                if (m_config->items_to_log[i].type == datalogging::LoggableType::VARBIT)
+                {
+                    if (m_config->items_to_log[i].data.varbit.bitsize == 0)
+                    {
+                        m_error = true;
+                    }
+                    packed_bits += m_config->items_to_log[i].data.varbit.bitsize;
+                    continue; // Size is counted when the group ends
+                }
+
+                if (packed_bits > 0)
+                {
+                    add_field(static_cast<uint16_t>((packed_bits + 7) >> 3), false);
+                    packed_bits = 0;
+                }
+
                 uint_fast8_t elem_size = 0;
                 if (m_config->items_to_log[i].type == datalogging::LoggableType::MEMORY)
                 {
@@ -213,14 +542,23 @@ namespace scrutiny
                 }
                 else
                 {
-                    m_entry_size += elem_size;
+                    bool const native_order = (m_config->items_to_log[i].type == datalogging::LoggableType::RPV) ||
+                                              (m_config->items_to_log[i].type == datalogging::LoggableType::TIME);
+                    add_field(elem_size, native_order);
                 }
             }
+
+            if (packed_bits > 0 && !m_error)
+            {
+                add_field(static_cast<uint16_t>((packed_bits + 7) >> 3), false); // Group of VARBIT items at the end of the entry
+            }
+
             if (m_entry_size > 0)
             {
-                m_max_entries = m_buffer_size / m_entry_size;
+                m_max_entries = (m_storage->size() / m_entry_size) / m_segment_count;
             }
-            else
+
+            if (m_max_entries == 0)
             {
                 m_error = true;
             }
@@ -228,6 +566,22 @@ namespace scrutiny
             m_reader.reset();
         }
 
+        /// @brief Adds a field at the end of the entry layout
+        /// @param size Size of the field in bytes
+        /// @param native_order The field is stored in native byte order and must be converted to big endian when read
+        void RawFormatEncoder::add_field(uint16_t const size, bool const native_order)
+        {
+            m_fields[m_field_count].offset = m_entry_size;
+            m_fields[m_field_count].size = size;
+            m_fields[m_field_count].native_order = native_order && (size > 1);
+            if (m_fields[m_field_count].native_order)
+            {
+                m_native_field_count++;
+            }
+            m_field_count++;
+            m_entry_size += size;
+        }
+
         datalogging::buffer_size_t RawFormatEncoder::remaining_bytes_to_full() const
         {
             if (m_full)
@@ -237,5 +591,304 @@ namespace scrutiny
 
             return get_buffer_effective_size() - get_write_cursor();
         }
+
+        /// @brief Closes the active segment and starts writing in the next one.
+        /// @return false if the active segment is the last one. Nothing changes in that case
+        bool RawFormatEncoder::next_segment(void)
+        {
+            if (m_active_segment + 1u >= m_segment_count)
+            {
+                return false;
+            }
+
+            m_completed_segments[m_active_segment].first_valid_entry_index = m_first_valid_entry_index;
+            m_completed_segments[m_active_segment].entries_count = m_entries_count;
+            m_completed_segments[m_active_segment].entries_written = m_entries_written;
+            m_completed_segments[m_active_segment].first_time_mark = m_first_time_mark;
+            m_completed_segments[m_active_segment].time_mark_count = m_time_mark_count;
+            m_completed_segments[m_active_segment].last_timestamp = m_last_timestamp;
+            m_previous_segments_entries_count += m_entries_count;
+            m_active_segment++;
+
+            m_next_entry_write_index = 0;
+            m_first_valid_entry_index = 0;
+            m_entries_count = 0;
+            m_entries_written = 0;
+            m_first_time_mark = 0;
+            m_time_mark_count = 0;
+            m_full = false;
+            reset_write_counter();
+            return true;
+        }
+
+        /// @brief Returns the position in the storage of an entry, given its index in the order the reader outputs them
+        datalogging::buffer_size_t RawFormatEncoder::get_entry_storage_position(datalogging::buffer_size_t const entry) const
+        {
+            datalogging::buffer_size_t remaining = entry;
+            for (uint16_t segment = 0; segment <= m_active_segment; segment++)
+            {
+                SegmentRecord record;
+                get_segment(segment, &record);
+                if (remaining < record.entries_count)
+                {
+                    datalogging::buffer_size_t index = record.first_valid_entry_index + remaining;
+                    if (index >= m_max_entries)
+                    {
+                        index -= m_max_entries;
+                    }
+                    return (segment * m_max_entries + index) * m_entry_size;
+                }
+                remaining -= record.entries_count;
+            }
+
+            return 0; // Not reached for an entry that exists
+        }
+
+        /// @brief Returns the number of entries in a segment. Segments after the active one are empty
+        datalogging::buffer_size_t RawFormatEncoder::get_segment_entry_count(uint16_t const segment) const
+        {
+            SegmentRecord record;
+            get_segment(segment, &record);
+            return record.entries_count;
+        }
+
+        void RawFormatEncoder::get_segment(uint16_t const segment, SegmentRecord *const record) const
+        {
+            if (segment < m_active_segment)
+            {
+                *record = m_completed_segments[segment];
+            }
+            else if (segment == m_active_segment)
+            {
+                record->first_valid_entry_index = m_first_valid_entry_index;
+                record->entries_count = m_entries_count;
+                record->entries_written = m_entries_written;
+                record->first_time_mark = m_first_time_mark;
+                record->time_mark_count = m_time_mark_count;
+                record->last_timestamp = m_last_timestamp;
+            }
+            else
+            {
+                record->first_valid_entry_index = 0;
+                record->entries_count = 0;
+                record->entries_written = 0;
+                record->first_time_mark = 0;
+                record->time_mark_count = 0;
+                record->last_timestamp = 0;
+            }
+        }
+
+        /// @brief Returns the number of time marks of a segment. A segment that has entries always ends with a mark on its newest entry.
+        /// Once the oldest marks are overwritten, the segment also starts with a mark on its oldest entry.
+        /// Always 0 unless the time axis is TimeAxis::Sparse
+        uint16_t RawFormatEncoder::get_time_mark_count(uint16_t const segment) const
+        {
+            if (m_error || m_time_marks_per_segment == 0 || segment >= m_segment_count)
+            {
+                return 0;
+            }
+
+            SegmentRecord record;
+            get_segment(segment, &record);
+            if (record.entries_count == 0)
+            {
+                return 0;
+            }
+
+            uint16_t const first_valid = get_first_valid_time_mark(segment, &record);
+            uint16_t count = static_cast<uint16_t>(record.time_mark_count - first_valid);
+            bool newest_marked = false;
+            if (count > 0)
+            {
+                uint16_t const newest = static_cast<uint16_t>((record.first_time_mark + record.time_mark_count - 1u) % m_time_marks_per_segment);
+                newest_marked = (m_time_marks[segment * m_time_marks_per_segment + newest].entry_number == record.entries_written - 1);
+            }
+
+            timestamp_t oldest_timestamp;
+            if (get_oldest_entry_time(segment, &record, first_valid, &oldest_timestamp))
+            {
+                count++;
+                newest_marked = newest_marked || record.entries_count == 1; // The oldest entry is also the newest
+            }
+
+            // The newest entry is given from the last timestamp when it has no mark of its own
+            return newest_marked ? count : static_cast<uint16_t>(count + 1u);
+        }
+
+        /// @brief Gives a time mark of a segment. Marks are ordered from the oldest to the newest
+        /// @param segment The segment index
+        /// @param index Index of the mark, from 0 to get_time_mark_count()-1
+        /// @param entry_index Index of the marked entry within the segment, as output by the reader
+        /// @param timestamp Time of the marked entry
+        /// @return false if there is no such mark
+        bool RawFormatEncoder::get_time_mark(
+            uint16_t const segment,
+            uint16_t const index,
+            datalogging::buffer_size_t *const entry_index,
+            timestamp_t *const timestamp) const
+        {
+            if (index >= get_time_mark_count(segment))
+            {
+                return false;
+            }
+
+            SegmentRecord record;
+            get_segment(segment, &record);
+            uint32_t const oldest_entry_number = record.entries_written - record.entries_count;
+            uint16_t const first_valid = get_first_valid_time_mark(segment, &record);
+            uint16_t position = index;
+            if (get_oldest_entry_time(segment, &record, first_valid, timestamp))
+            {
+                if (index == 0)
+                {
+                    *entry_index = 0;
+                    return true;
+                }
+                position--;
+            }
+
+            if (first_valid + position >= record.time_mark_count)
+            {
+                *entry_index = record.entries_count - 1;
+                *timestamp = record.last_timestamp;
+                return true;
+            }
+
+            TimeMark const *const mark = &m_time_marks[segment * m_time_marks_per_segment + (record.first_time_mark + first_valid + position) % m_time_marks_per_segment];
+            *entry_index = static_cast<datalogging::buffer_size_t>(mark->entry_number - oldest_entry_number);
+            *timestamp = mark->timestamp;
+            return true;
+        }
+
+        /// @brief Gives the time of the oldest entry of a segment when it has no mark of its own because its mark was overwritten.
+        /// The time step is constant between the newest overwritten mark and the next mark, otherwise there would be a mark in between,
+        /// so the time is interpolated between the two.
+        /// @param segment The segment index
+        /// @param record The segment record
+        /// @param first_valid Position of the first valid mark, as given by get_first_valid_time_mark()
+        /// @param timestamp Time of the oldest entry
+        /// @return false if the oldest entry needs no extra mark
+        bool RawFormatEncoder::get_oldest_entry_time(
+            uint16_t const segment,
+            SegmentRecord const *const record,
+            uint16_t const first_valid,
+            timestamp_t *const timestamp) const
+        {
+            if (first_valid == 0)
+            {
+                return false; // Nothing was overwritten, or the overwritten marks are gone
+            }
+
+            TimeMark const *const marks = &m_time_marks[segment * m_time_marks_per_segment];
+            uint32_t const oldest_entry_number = record->entries_written - record->entries_count;
+            TimeMark const *const before = &marks[(record->first_time_mark + first_valid - 1u) % m_time_marks_per_segment];
+            TimeMark after;
+            if (first_valid < record->time_mark_count)
+            {
+                after = marks[(record->first_time_mark + first_valid) % m_time_marks_per_segment];
+                if (after.entry_number == oldest_entry_number)
+                {
+                    return false;
+                }
+            }
+            else
+            {
+                after.entry_number = record->entries_written - 1;
+                after.timestamp = record->last_timestamp;
+            }
+
+            uint32_t const steps = oldest_entry_number - before->entry_number;
+            uint32_t const span = after.entry_number - before->entry_number;
+            timestamp_t const elapsed = after.timestamp - before->timestamp;
+            timestamp_t const remainder = elapsed % span;
+            // remainder*steps < span^2 does not overflow for spans up to 16 bits. Longer spans lose the fraction of a step
+            timestamp_t const fraction = (span <= 0xFFFFu) ? (remainder * steps) / span : 0;
+            *timestamp = before->timestamp + (elapsed / span) * steps + fraction;
+            return true;
+        }
+
+        /// @brief Returns the position, relative to the oldest recorded mark, of the first mark whose entry is still in the buffer
+        uint16_t RawFormatEncoder::get_first_valid_time_mark(uint16_t const segment, SegmentRecord const *const record) const
+        {
+            TimeMark const *const marks = &m_time_marks[segment * m_time_marks_per_segment];
+            uint16_t first_valid = 0;
+            while (first_valid < record->time_mark_count)
+            {
+                uint32_t const entry_number = marks[(record->first_time_mark + first_valid) % m_time_marks_per_segment].entry_number;
+                if (record->entries_written - entry_number <= record->entries_count)
+                {
+                    break;
+                }
+                first_valid++;
+            }
+            return first_valid;
+        }
+
+        /// @brief Keeps track of the time of the entry being written and adds a time mark when needed.
+        /// Marks go on the first entry, every time_mark_interval entries, and on both sides of a time step change.
+        void RawFormatEncoder::record_time(void)
+        {
+            uint32_t const entry_number = m_entries_written;
+            timestamp_t const timestamp = m_timebase_for_log->get_timestamp();
+            bool mark = (entry_number == 0);
+            if (m_config->time_mark_interval != 0 && (entry_number % m_config->time_mark_interval) == 0)
+            {
+                mark = true;
+            }
+
+            if (entry_number > 0)
+            {
+                timestamp_t const time_step = timestamp - m_last_timestamp;
+                if (entry_number > 1)
+                {
+                    timestamp_t const deviation = (time_step > m_last_time_step) ? time_step - m_last_time_step : m_last_time_step - time_step;
+                    if (deviation > m_config->time_mark_tolerance_100ns)
+                    {
+                        add_time_mark(entry_number - 1, m_last_timestamp); // Last entry with the previous time step
+                        mark = true;
+                    }
+                }
+                m_last_time_step = time_step;
+            }
+            m_last_timestamp = timestamp;
+
+            if (mark)
+            {
+                add_time_mark(entry_number, timestamp);
+            }
+        }
+
+        /// @brief Adds a time mark to the active segment. Drops the marks of the entries that are overwritten, except the newest of them
+        /// that gives the time of the oldest entry, then the oldest mark if there is no room left.
+        void RawFormatEncoder::add_time_mark(uint32_t const entry_number, timestamp_t const timestamp)
+        {
+            TimeMark *const marks = &m_time_marks[m_active_segment * m_time_marks_per_segment];
+            if (m_time_mark_count > 0)
+            {
+                uint16_t const newest = static_cast<uint16_t>((m_first_time_mark + m_time_mark_count - 1u) % m_time_marks_per_segment);
+                if (marks[newest].entry_number == entry_number)
+                {
+                    return;
+                }
+            }
+
+            while (m_time_mark_count > 0)
+            {
+                uint16_t const next = static_cast<uint16_t>((m_first_time_mark + 1u) % m_time_marks_per_segment);
+                bool const next_overwritten = (m_time_mark_count > 1) && (entry_number - marks[next].entry_number >= m_max_entries);
+                if (m_time_mark_count < m_time_marks_per_segment && !next_overwritten)
+                {
+                    break;
+                }
+
+                m_first_time_mark = static_cast<uint16_t>((m_first_time_mark + 1u) % m_time_marks_per_segment);
+                m_time_mark_count--;
+            }
+
+            uint16_t const position = static_cast<uint16_t>((m_first_time_mark + m_time_mark_count) % m_time_marks_per_segment);
+            marks[position].entry_number = entry_number;
+            marks[position].timestamp = timestamp;
+            m_time_mark_count++;
+        }
     }
 }
\ No newline at end of file
@@ -122,13 +122,20 @@ namespace scrutiny
             }
             else if (operand->type == OperandType::VARBIT)
             {
-                success = main_handler->fetch_variable_bitfield(
-                    operand->data.var.addr,
-                    tools::get_var_type_type(operand->data.var.datatype),
-                    operand->data.varbit.bitoffset,
-                    operand->data.varbit.bitsize,
-                    val,
-                    variable_type);
+                if (operand->data.varbit.descriptor.extract != nullptr)
+                {
+                    success = main_handler->fetch_variable_bitfield(operand->data.varbit.addr, &operand->data.varbit.descriptor, val, variable_type);
+                }
+                else // Descriptor not computed by the datalogger. Compute it on the fly.
+                {
+                    success = main_handler->fetch_variable_bitfield(
+                        operand->data.varbit.addr,
+                        tools::get_var_type_type(operand->data.varbit.datatype),
+                        operand->data.varbit.bitoffset,
+                        operand->data.varbit.bitsize,
+                        val,
+                        variable_type);
+                }
             }
             else
             {
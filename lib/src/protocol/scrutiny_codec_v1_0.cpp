@@ -30,6 +30,7 @@ namespace scrutiny
         {
             constexpr unsigned int addr_size = sizeof(void *);
             uint32_t cursor = 0;
+            uint32_t required_size = 0;
 
             while (true)
             {
@@ -44,7 +45,9 @@ namespace scrutiny
                 length = codecs::decode_16_bits_big_endian(&m_buffer[cursor]);
                 cursor += 2;
 
-                m_required_tx_buffer_size += addr_size + 2 + length;
+                required_size += addr_size + 2 + length;
+                // Saturates instead of wrapping around. No response can be that big anyway
+                m_required_tx_buffer_size = (required_size > 0xFFFFu) ? 0xFFFFu : static_cast<uint16_t>(required_size);
 
                 if (cursor == m_request_datasize)
                 {
@@ -310,6 +313,209 @@ namespace scrutiny
 
         //==============================================================
 
+        /// @brief Encodes the payload of a GetSupportedFeatures response. Single byte
+        static uint8_t encode_supported_features(ResponseData::GetInfo::GetSupportedFeatures const *const data)
+        {
+            uint8_t features = 0x00;
+            if (data->memory_write)
+                features |= 0x80;
+
+            if (data->datalogging)
+                features |= 0x40;
+
+            if (data->user_command)
+                features |= 0x20;
+
+            if (data->_64bits)
+                features |= 0x10;
+
+            return features;
+        }
+
+        void DeviceDescriptionResponseEncoder::init(Response *const response, uint16_t const max_size)
+        {
+            m_size_limit = max_size;
+            m_buffer = response->data;
+            m_response = response;
+            m_cursor = HEADER_SIZE; // Header is written by finish()
+            m_rpv_record = 0;
+        }
+
+        /// @brief Writes the header of a record and returns where its payload goes. nullptr if it does not fit
+        uint8_t *DeviceDescriptionResponseEncoder::begin_record(GetInfo::Subfunction const subfunction, uint16_t const payload_size)
+        {
+            if (m_cursor > m_size_limit || 2u + payload_size > static_cast<uint16_t>(m_size_limit - m_cursor))
+            {
+                return nullptr;
+            }
+
+            m_buffer[m_cursor] = static_cast<uint8_t>(subfunction);
+            m_buffer[m_cursor + 1] = static_cast<uint8_t>(payload_size);
+            uint8_t *const payload = &m_buffer[m_cursor + 2];
+            m_cursor = static_cast<uint16_t>(m_cursor + 2 + payload_size);
+            m_rpv_record = 0; // The next RPV starts a new record
+            return payload;
+        }
+
+        bool DeviceDescriptionResponseEncoder::write_protocol_version(ResponseData::GetInfo::GetProtocolVersion const *const data)
+        {
+            uint8_t *const payload = begin_record(GetInfo::Subfunction::GetprotocolVersion, 2);
+            if (payload == nullptr)
+            {
+                return false;
+            }
+            payload[0] = data->major;
+            payload[1] = data->minor;
+            return true;
+        }
+
+        bool DeviceDescriptionResponseEncoder::write_software_id(void)
+        {
+            uint8_t *const payload = begin_record(GetInfo::Subfunction::GetSoftwareId, sizeof(scrutiny::software_id));
+            if (payload == nullptr)
+            {
+                return false;
+            }
+            memcpy(payload, scrutiny::software_id, sizeof(scrutiny::software_id));
+            return true;
+        }
+
+        bool DeviceDescriptionResponseEncoder::write_supported_features(ResponseData::GetInfo::GetSupportedFeatures const *const data)
+        {
+            uint8_t *const payload = begin_record(GetInfo::Subfunction::GetSupportedFeatures, 1);
+            if (payload == nullptr)
+            {
+                return false;
+            }
+            payload[0] = encode_supported_features(data);
+            return true;
+        }
+
+        bool DeviceDescriptionResponseEncoder::write_config_fingerprint(ResponseData::GetInfo::GetConfigFingerprint const *const data)
+        {
+            uint8_t *const payload = begin_record(GetInfo::Subfunction::GetConfigFingerprint, sizeof(data->fingerprint));
+            if (payload == nullptr)
+            {
+                return false;
+            }
+            codecs::encode_32_bits_big_endian(data->fingerprint, payload);
+            return true;
+        }
+
+        bool DeviceDescriptionResponseEncoder::write_special_memory_region_count(ResponseData::GetInfo::GetSpecialMemoryRegionCount const *const data)
+        {
+            uint8_t *const payload = begin_record(GetInfo::Subfunction::GetSpecialMemoryRegionCount, 2);
+            if (payload == nullptr)
+            {
+                return false;
+            }
+            payload[0] = data->nbr_readonly_region;
+            payload[1] = data->nbr_forbidden_region;
+            return true;
+        }
+
+        bool DeviceDescriptionResponseEncoder::write_special_memory_region_location(ResponseData::GetInfo::GetSpecialMemoryRegionLocation const *const data)
+        {
+            constexpr uint16_t addr_size = sizeof(void *);
+            uint8_t *const payload = begin_record(GetInfo::Subfunction::GetSpecialMemoryLocation, 2 + 2 * addr_size);
+            if (payload == nullptr)
+            {
+                return false;
+            }
+            payload[0] = data->region_type;
+            payload[1] = data->region_index;
+            codecs::encode_address_big_endian(data->start, &payload[2]);
+            codecs::encode_address_big_endian(data->end, &payload[2 + addr_size]);
+            return true;
+        }
+
+        bool DeviceDescriptionResponseEncoder::write_rpv_count(ResponseData::GetInfo::GetRPVCount const *const data)
+        {
+            uint8_t *const payload = begin_record(GetInfo::Subfunction::GetRuntimePublishedValuesCount, sizeof(data->count));
+            if (payload == nullptr)
+            {
+                return false;
+            }
+            codecs::encode_16_bits_big_endian(data->count, payload);
+            return true;
+        }
+
+        bool DeviceDescriptionResponseEncoder::write_rpv(RuntimePublishedValue const *const rpv)
+        {
+            constexpr uint16_t rpv_size = 2 + 1; // id + type
+            uint8_t *payload = nullptr;
+            if (m_rpv_record != 0 && m_buffer[m_rpv_record + 1] <= 0xFF - rpv_size)
+            {
+                // Append to the actual record
+                if (m_cursor > m_size_limit || rpv_size > static_cast<uint16_t>(m_size_limit - m_cursor))
+                {
+                    return false;
+                }
+                payload = &m_buffer[m_cursor];
+                m_buffer[m_rpv_record + 1] = static_cast<uint8_t>(m_buffer[m_rpv_record + 1] + rpv_size);
+                m_cursor += rpv_size;
+            }
+            else
+            {
+                uint16_t const record_start = m_cursor;
+                payload = begin_record(GetInfo::Subfunction::GetRuntimePublishedValuesDefinition, rpv_size);
+                if (payload == nullptr)
+                {
+                    return false;
+                }
+                m_rpv_record = record_start;
+            }
+
+            codecs::encode_16_bits_big_endian(rpv->id, &payload[0]);
+            codecs::encode_8_bits(static_cast<uint8_t>(rpv->type), &payload[2]);
+            return true;
+        }
+
+        bool DeviceDescriptionResponseEncoder::write_loop_count(ResponseData::GetInfo::GetLoopCount const *const data)
+        {
+            uint8_t *const payload = begin_record(GetInfo::Subfunction::GetLoopCount, sizeof(data->count));
+            if (payload == nullptr)
+            {
+                return false;
+            }
+            payload[0] = data->count;
+            return true;
+        }
+
+        bool DeviceDescriptionResponseEncoder::write_loop_definition(ResponseData::GetInfo::GetLoopDefinition const *const data)
+        {
+            bool const fixed_freq = static_cast<scrutiny::LoopType>(data->loop_type) == scrutiny::LoopType::FIXED_FREQ;
+            uint8_t const loop_name_length = (data->loop_name_length > MAX_LOOP_NAME_LENGTH) ? MAX_LOOP_NAME_LENGTH : data->loop_name_length;
+            // id + type + attributes + [timestep] + name length + name
+            uint16_t const payload_size = static_cast<uint16_t>(3 + (fixed_freq ? 4 : 0) + 1 + loop_name_length);
+            uint8_t *const payload = begin_record(GetInfo::Subfunction::GetLoopDefinition, payload_size);
+            if (payload == nullptr)
+            {
+                return false;
+            }
+
+            payload[0] = data->loop_id;
+            payload[1] = data->loop_type;
+            payload[2] = data->support_datalogging ? 0x80 : 0x00;
+            uint16_t cursor = 3;
+            if (fixed_freq)
+            {
+                cursor += codecs::encode_32_bits_big_endian(data->loop_type_specific.fixed_freq.timestep_100ns, &payload[cursor]);
+            }
+            payload[cursor++] = loop_name_length;
+            memcpy(&payload[cursor], data->loop_name, loop_name_length);
+            return true;
+        }
+
+        void DeviceDescriptionResponseEncoder::finish(bool const finished, uint32_t const next_cursor)
+        {
+            m_buffer[0] = finished ? 1 : 0;
+            codecs::encode_32_bits_big_endian(next_cursor, &m_buffer[1]);
+            m_response->data_length = m_cursor;
+        }
+
+        //==============================================================
+
         void ReadRPVResponseEncoder::init(Response *const response, uint16_t const max_size)
         {
             m_size_limit = max_size;
@@ -514,8 +720,372 @@ namespace scrutiny
             m_finished = false;
         }
 
+        // ==================================
+
+        void StagedWriteRequestParser::init(Request const *const request, MainHandler const *const main_handler)
+        {
+            if (request->data_length < 1) // Loop ID is mandatory
+            {
+                init_entries(request->data, 0, main_handler);
+                m_loop_id = 0;
+                m_invalid = true;
+                m_finished = true;
+                return;
+            }
+
+            init_entries(&request->data[1], request->data_length - 1, main_handler);
+            m_loop_id = request->data[0];
+        }
+
+        void StagedWriteRequestParser::init_entries(uint8_t *const entries, uint16_t const entries_length, MainHandler const *const main_handler)
+        {
+            m_buffer = entries;
+            m_size_limit = entries_length;
+            m_main_handler = main_handler;
+            m_loop_id = 0;
+            reset();
+        }
+
+        void StagedWriteRequestParser::next(StagedWriteEntry *const entry)
+        {
+            constexpr unsigned int addr_size = sizeof(void *);
+            if (m_finished || m_invalid)
+            {
+                return;
+            }
+
+            entry->type = static_cast<MemoryControl::StagedWriteType>(m_buffer[m_bytes_read]);
+            m_bytes_read += 1;
+
+            switch (entry->type)
+            {
+            case MemoryControl::StagedWriteType::Memory: // fall through
+            case MemoryControl::StagedWriteType::MemoryMasked:
+            {
+                bool const masked = (entry->type == MemoryControl::StagedWriteType::MemoryMasked);
+                uintptr_t addr;
+                if (addr_size + 2 > static_cast<uint16_t>(m_size_limit - m_bytes_read))
+                {
+                    m_invalid = true;
+                    break;
+                }
+
+                codecs::decode_address_big_endian(&m_buffer[m_bytes_read], &addr);
+                m_bytes_read += addr_size;
+                uint16_t const length = codecs::decode_16_bits_big_endian(&m_buffer[m_bytes_read]);
+                m_bytes_read += 2;
+
+                uint32_t const payload_size = (masked) ? (static_cast<uint32_t>(length) << 1) : static_cast<uint32_t>(length);
+                if (payload_size > static_cast<uint16_t>(m_size_limit - m_bytes_read))
+                {
+                    m_invalid = true;
+                    break;
+                }
+
+                entry->block.start_address = reinterpret_cast<uint8_t *>(addr);
+                entry->block.length = length;
+                entry->block.source_data = &m_buffer[m_bytes_read];
+                m_bytes_read += length;
+                if (masked)
+                {
+                    entry->block.mask = &m_buffer[m_bytes_read];
+                    m_bytes_read += length;
+                }
+                else
+                {
+                    entry->block.mask = nullptr;
+                }
+                break;
+            }
+            case MemoryControl::StagedWriteType::RPV:
+            {
+                if (2u > static_cast<uint16_t>(m_size_limit - m_bytes_read))
+                {
+                    m_invalid = true;
+                    break;
+                }
+
+                uint16_t const id = codecs::decode_16_bits_big_endian(&m_buffer[m_bytes_read]);
+                m_bytes_read += 2;
+
+                // Impossible to know the meaning of the rest of the payload if the RPV does not exist.
+                if (!m_main_handler->get_rpv(id, &entry->rpv))
+                {
+                    m_invalid = true;
+                    break;
+                }
+
+                uint8_t const typesize = tools::get_type_size(entry->rpv.type);
+                if (typesize > static_cast<uint16_t>(m_size_limit - m_bytes_read))
+                {
+                    m_invalid = true;
+                    break;
+                }
+
+                switch (typesize)
+                {
+                case 1:
+                    entry->value.uint8 = m_buffer[m_bytes_read];
+                    break;
+                case 2:
+                    entry->value.uint16 = codecs::decode_16_bits_big_endian(&m_buffer[m_bytes_read]);
+                    break;
+                case 4:
+                    entry->value.uint32 = codecs::decode_32_bits_big_endian(&m_buffer[m_bytes_read]);
+                    break;
+#if SCRUTINY_SUPPORT_64BITS
+                case 8:
+                    entry->value.uint64 = codecs::decode_64_bits_big_endian(&m_buffer[m_bytes_read]);
+                    break;
+#endif
+                default:
+                    m_invalid = true; // A staged write is all or nothing. We do not skip unsupported types
+                    break;
+                }
+                m_bytes_read += typesize;
+                break;
+            }
+            default:
+                m_invalid = true;
+                break;
+            }
+
+            if (m_invalid)
+            {
+                m_finished = true;
+                return;
+            }
+
+            m_entry_count++;
+            if (m_bytes_read == m_size_limit)
+            {
+                m_finished = true;
+            }
+        }
+
+        void StagedWriteRequestParser::reset(void)
+        {
+            m_bytes_read = 0;
+            m_entry_count = 0;
+            m_invalid = false;
+            m_finished = (m_size_limit == 0);
+        }
+
         //==============================================================
 
+        void ReadMemoryBlocksResponseStreamer::init(Request const *const request)
+        {
+            m_parser.init(request);
+            m_block.start_address = nullptr;
+            m_block.length = 0;
+            m_cursor = sizeof(m_block_header); // Empty block. Next read moves to the first block of the request
+        }
+
+        bool ReadMemoryBlocksResponseStreamer::read(uint8_t *const buffer, uint16_t const len)
+        {
+            constexpr uint16_t header_size = sizeof(m_block_header);
+            uint16_t i = 0;
+
+            while (i < len)
+            {
+                if (m_cursor == header_size + m_block.length)
+                {
+                    if (m_parser.finished())
+                    {
+                        return false; // Asked for more than the payload
+                    }
+
+                    m_parser.next(&m_block);
+                    if (!m_parser.is_valid())
+                    {
+                        return false;
+                    }
+
+                    codecs::encode_address_big_endian(m_block.start_address, &m_block_header[0]);
+                    codecs::encode_16_bits_big_endian(m_block.length, &m_block_header[sizeof(void *)]);
+                    m_cursor = 0;
+                }
+
+                if (m_cursor < header_size)
+                {
+                    buffer[i++] = m_block_header[m_cursor++];
+                }
+                else
+                {
+                    uint16_t const offset = m_cursor - header_size;
+                    uint16_t const remaining_in_block = m_block.length - offset;
+                    uint16_t const remaining_in_buffer = len - i;
+                    uint16_t const n = (remaining_in_buffer < remaining_in_block) ? remaining_in_buffer : remaining_in_block;
+                    memcpy(&buffer[i], &m_block.start_address[offset], n);
+                    i += n;
+                    m_cursor += n;
+                }
+            }
+
+            return true;
+        }
+
+        //==============================================================
+
+        bool ReadRPVResponseStreamer::init(Request const *const request, MainHandler const *const main_handler, uint32_t *const payload_size)
+        {
+            m_main_handler = main_handler;
+            m_entry_size = 0;
+            m_cursor = 0;
+
+            *payload_size = 0;
+            m_parser.init(request);
+            while (!m_parser.finished())
+            {
+                uint16_t id;
+                RuntimePublishedValue rpv;
+                if (!m_parser.next(&id))
+                {
+                    return false;
+                }
+
+                if (!main_handler->get_rpv(id, &rpv))
+                {
+                    return false;
+                }
+
+                *payload_size += entry_size(rpv.type);
+            }
+
+            m_parser.reset();
+            return m_parser.is_valid();
+        }
+
+        bool ReadRPVResponseStreamer::read(uint8_t *const buffer, uint16_t const len)
+        {
+            uint16_t i = 0;
+
+            while (i < len)
+            {
+                if (m_cursor == m_entry_size)
+                {
+                    uint16_t id;
+                    RuntimePublishedValue rpv;
+                    AnyType v;
+                    if (!m_parser.next(&id))
+                    {
+                        return false;
+                    }
+
+                    if (!m_main_handler->get_rpv(id, &rpv))
+                    {
+                        return false;
+                    }
+
+                    m_cursor = 0;
+                    m_entry_size = entry_size(rpv.type);
+                    if (m_entry_size == 0)
+                    {
+                        continue; // Skipped, like ReadRPVResponseEncoder does
+                    }
+
+                    if (!m_main_handler->get_config_ro()->get_rpv_read_callback()(rpv, &v))
+                    {
+                        return false;
+                    }
+
+                    uint8_t const id_size = codecs::encode_16_bits_big_endian(id, &m_entry[0]);
+                    codecs::encode_anytype_big_endian(&v, static_cast<uint8_t>(m_entry_size - id_size), &m_entry[id_size]);
+                }
+
+                buffer[i++] = m_entry[m_cursor++];
+            }
+
+            return true;
+        }
+
+        // Size of the ID and value of an RPV in the response. 0 if the type cannot be encoded
+        uint8_t ReadRPVResponseStreamer::entry_size(VariableType const type)
+        {
+            uint8_t const typesize = tools::get_type_size(type);
+            if (typesize == 1u || typesize == 2u || typesize == 4u
+#if SCRUTINY_SUPPORT_64BITS
+                || typesize == 8u
+#endif
+            )
+            {
+                return 2u + typesize;
+            }
+
+            return 0;
+        }
+
+        //==============================================================
+#if SCRUTINY_ENABLE_DATALOGGING
+        uint16_t ReadAcquisitionResponseStreamer::init(
+            ResponseData::DataLogControl::ReadAcquisition const *const response_data,
+            uint16_t const max_size,
+            bool *const finished)
+        {
+            constexpr uint16_t overhead = sizeof(m_header) + sizeof(m_footer);
+            m_reader = response_data->reader;
+            m_crc = response_data->crc;
+            m_cursor = 0;
+
+            datalogging::buffer_size_t const remaining = m_reader->get_remaining_size();
+            if (remaining <= static_cast<datalogging::buffer_size_t>(max_size - overhead))
+            {
+                m_data_size = static_cast<uint16_t>(remaining);
+                m_finished = true;
+            }
+            else
+            {
+                m_data_size = static_cast<uint16_t>(max_size - sizeof(m_header));
+                m_finished = false;
+            }
+
+            m_header[0] = static_cast<uint8_t>(m_finished);
+            m_header[1] = response_data->rolling_counter;
+            codecs::encode_16_bits_big_endian(response_data->acquisition_id, &m_header[2]);
+
+            *finished = m_finished;
+            return static_cast<uint16_t>(sizeof(m_header) + m_data_size + (m_finished ? sizeof(m_footer) : 0));
+        }
+
+        bool ReadAcquisitionResponseStreamer::read(uint8_t *const buffer, uint16_t const len)
+        {
+            constexpr uint16_t header_size = sizeof(m_header);
+            uint16_t const data_end = header_size + m_data_size;
+            uint16_t i = 0;
+
+            while (i < len)
+            {
+                if (m_cursor < header_size)
+                {
+                    buffer[i++] = m_header[m_cursor++];
+                }
+                else if (m_cursor < data_end)
+                {
+                    uint16_t const remaining_in_frame = data_end - m_cursor;
+                    uint16_t const remaining_in_buffer = len - i;
+                    uint16_t const n = (remaining_in_buffer < remaining_in_frame) ? remaining_in_buffer : remaining_in_frame;
+                    uint16_t const nread = static_cast<uint16_t>(m_reader->read(&buffer[i], n));
+                    *m_crc = tools::crc32(&buffer[i], nread, *m_crc);
+                    i += nread;
+                    m_cursor += nread;
+                    if (nread != n)
+                    {
+                        return false; // The acquisition changed since the frame was prepared
+                    }
+                }
+                else
+                {
+                    if (m_cursor == data_end) // The whole acquisition went through the CRC
+                    {
+                        codecs::encode_32_bits_big_endian(*m_crc, m_footer);
+                    }
+                    buffer[i++] = m_footer[m_cursor++ - data_end];
+                }
+            }
+
+            return true;
+        }
+#endif
         //==============================================================
 
         // ===== Encoding =====
@@ -593,19 +1163,7 @@ namespace scrutiny
                 return ResponseCode::Overflow;
             }
 
-            response->data[0] = 0x00;
-            if (response_data->memory_write)
-                response->data[0] |= 0x80;
-
-            if (response_data->datalogging)
-                response->data[0] |= 0x40;
-
-            if (response_data->user_command)
-                response->data[0] |= 0x20;
-
-            if (response_data->_64bits)
-                response->data[0] |= 0x10;
-
+            response->data[0] = encode_supported_features(response_data);
             response->data_length = 1;
             return ResponseCode::OK;
         }
@@ -650,6 +1208,20 @@ namespace scrutiny
             return ResponseCode::OK;
         }
 
+        ResponseCode CodecV1_0::decode_request_get_device_description(Request const *const request, RequestData::GetInfo::GetDeviceDescription *const request_data)
+        {
+            constexpr uint16_t cursor_size = sizeof(request_data->cursor);
+            constexpr uint16_t datalen = cursor_size;
+
+            if (request->data_length != datalen)
+            {
+                return ResponseCode::InvalidRequest;
+            }
+
+            request_data->cursor = codecs::decode_32_bits_big_endian(&request->data[0]);
+            return ResponseCode::OK;
+        }
+
         ResponseCode CodecV1_0::encode_response_get_loop_definition(ResponseData::GetInfo::GetLoopDefinition const *const response_data, Response *const response)
         {
             static_assert(sizeof(timediff_t) == 4, "Unsupported timediff size");
@@ -735,6 +1307,20 @@ namespace scrutiny
             return ResponseCode::OK;
         }
 
+        ResponseCode CodecV1_0::encode_response_get_config_fingerprint(ResponseData::GetInfo::GetConfigFingerprint const *const response_data, Response *const response)
+        {
+            constexpr uint16_t fingerprint_size = sizeof(response_data->fingerprint);
+            constexpr uint16_t datalen = fingerprint_size;
+            if (datalen > MINIMUM_TX_BUFFER_SIZE && datalen > response->data_max_length)
+            {
+                return ResponseCode::Overflow;
+            }
+
+            codecs::encode_32_bits_big_endian(response_data->fingerprint, &response->data[0]);
+            response->data_length = datalen;
+            return ResponseCode::OK;
+        }
+
         // ============================ CommunicationControl ============================
 
         ResponseCode CodecV1_0::encode_response_comm_discover(ResponseData::CommControl::Discover const *const response_data, Response *const response)
@@ -795,7 +1381,9 @@ namespace scrutiny
             constexpr uint16_t heartbeat_timeout_size = sizeof(response_data->heartbeat_timeout);
             constexpr uint16_t comm_rx_timeout_size = sizeof(response_data->comm_rx_timeout);
             constexpr uint16_t address_size_size = sizeof(response_data->address_size);
-            constexpr uint16_t datalen = rx_buffer_size_len + tx_buffer_size_len + max_bitrate_size + heartbeat_timeout_size + comm_rx_timeout_size + address_size_size;
+            constexpr uint16_t max_streamed_data_size_len = sizeof(response_data->max_streamed_data_size);
+            constexpr uint16_t base_datalen = rx_buffer_size_len + tx_buffer_size_len + max_bitrate_size + heartbeat_timeout_size + comm_rx_timeout_size + address_size_size;
+            uint16_t const datalen = base_datalen + (response_data->include_streaming ? max_streamed_data_size_len : 0);
 
             constexpr uint16_t rx_buffer_size_pos = 0;
             constexpr uint16_t tx_buffer_size_pos = rx_buffer_size_pos + rx_buffer_size_len;
@@ -803,6 +1391,7 @@ namespace scrutiny
             constexpr uint16_t heartbeat_timeout_pos = max_bitrate_pos + max_bitrate_size;
             constexpr uint16_t comm_rx_timeout_pos = heartbeat_timeout_pos + heartbeat_timeout_size;
             constexpr uint16_t address_size_pos = comm_rx_timeout_pos + comm_rx_timeout_size;
+            constexpr uint16_t max_streamed_data_size_pos = address_size_pos + address_size_size;
 
             if (datalen > MINIMUM_TX_BUFFER_SIZE && datalen > response->data_max_length)
             {
@@ -817,6 +1406,10 @@ namespace scrutiny
             codecs::encode_32_bits_big_endian(response_data->heartbeat_timeout, &response->data[heartbeat_timeout_pos]);
             codecs::encode_32_bits_big_endian(response_data->comm_rx_timeout, &response->data[comm_rx_timeout_pos]);
             response->data[address_size_pos] = response_data->address_size; // Size in bytes
+            if (response_data->include_streaming)
+            {
+                codecs::encode_16_bits_big_endian(response_data->max_streamed_data_size, &response->data[max_streamed_data_size_pos]);
+            }
 
             return ResponseCode::OK;
         }
@@ -825,7 +1418,8 @@ namespace scrutiny
         {
             constexpr uint16_t magic_size = sizeof(response_data->magic);
             constexpr uint16_t session_id_size = sizeof(response_data->session_id);
-            constexpr uint16_t datalen = magic_size + session_id_size;
+            constexpr uint16_t framing_size = 1;
+            uint16_t const datalen = magic_size + session_id_size + (response_data->include_framing ? framing_size : 0);
 
             static_assert(sizeof(response_data->magic) == sizeof(CommControl::CONNECT_MAGIC), "Mismatch between codec definition and protocol constant.");
             if (datalen > MINIMUM_TX_BUFFER_SIZE && datalen > response->data_max_length)
@@ -836,6 +1430,10 @@ namespace scrutiny
             response->data_length = datalen;
             memcpy(&response->data[0], response_data->magic, magic_size);
             codecs::encode_32_bits_big_endian(response_data->session_id, &response->data[magic_size]);
+            if (response_data->include_framing)
+            {
+                response->data[magic_size + session_id_size] = response_data->framing;
+            }
 
             return ResponseCode::OK;
         }
@@ -880,14 +1478,17 @@ namespace scrutiny
         ResponseCode CodecV1_0::decode_request_comm_connect(Request const *const request, RequestData::CommControl::Connect *const request_data)
         {
             constexpr uint16_t magic_size = sizeof(CommControl::DISCOVER_MAGIC);
-            constexpr uint16_t datalen = magic_size;
+            constexpr uint16_t framing_size = 1;
 
-            if (request->data_length != datalen)
+            // The framing byte is optional so that older servers keep working with the raw framing
+            if (request->data_length != magic_size && request->data_length != magic_size + framing_size)
             {
                 return ResponseCode::InvalidRequest;
             }
 
             memcpy(request_data->magic, request->data, magic_size);
+            request_data->framing_requested = (request->data_length == magic_size + framing_size);
+            request_data->framing = request_data->framing_requested ? request->data[magic_size] : static_cast<uint8_t>(CommControl::Framing::Raw);
 
             return ResponseCode::OK;
         }
@@ -941,6 +1542,13 @@ namespace scrutiny
             return &encoders.m_get_rpv_definition_response_encoder;
         }
 
+        DeviceDescriptionResponseEncoder *CodecV1_0::encode_response_get_device_description(Response *const response, uint16_t const max_size)
+        {
+            response->data_length = 0;
+            encoders.m_device_description_response_encoder.init(response, max_size);
+            return &encoders.m_device_description_response_encoder;
+        }
+
         ReadRPVResponseEncoder *CodecV1_0::encode_response_memory_control_read_rpv(Response *const response, uint16_t const max_size)
         {
             response->data_length = 0;
@@ -967,6 +1575,29 @@ namespace scrutiny
             return &parsers.m_memory_control_write_rpv_parser;
         }
 
+        StagedWriteRequestParser *CodecV1_0::decode_request_memory_control_write_staged(Request const *const request, MainHandler const *const main_handler)
+        {
+            parsers.m_memory_control_write_staged_parser.init(request, main_handler);
+            return &parsers.m_memory_control_write_staged_parser;
+        }
+
+        ResponseCode CodecV1_0::encode_response_memory_control_write_staged(ResponseData::MemoryControl::WriteStaged const *const response_data, Response *const response)
+        {
+            constexpr uint16_t loop_id_size = sizeof(response_data->loop_id);
+            constexpr uint16_t entry_count_size = sizeof(response_data->entry_count);
+            constexpr uint16_t datalen = loop_id_size + entry_count_size;
+
+            if (datalen > MINIMUM_TX_BUFFER_SIZE && datalen > response->data_max_length)
+            {
+                return ResponseCode::Overflow;
+            }
+
+            response->data_length = datalen;
+            codecs::encode_8_bits(response_data->loop_id, &response->data[0]);
+            codecs::encode_16_bits_big_endian(response_data->entry_count, &response->data[loop_id_size]);
+            return ResponseCode::OK;
+        }
+
 #if SCRUTINY_ENABLE_DATALOGGING
         ResponseCode CodecV1_0::encode_response_datalogging_get_setup(
             ResponseData::DataLogControl::GetSetup const *const response_data,
@@ -1034,11 +1665,68 @@ namespace scrutiny
             cursor += codecs::encode_32_bits_big_endian(response_data->number_of_points, &response->data[cursor]);
             cursor += codecs::encode_32_bits_big_endian(response_data->data_size, &response->data[cursor]);
             cursor += codecs::encode_32_bits_big_endian(response_data->points_after_trigger, &response->data[cursor]);
+
+            // Segmented acquisition: [segment_count, first_segment] followed by as many segments as the response can hold.
+            // Each segment is [trigger_timestamp, number_of_points, points_after_trigger]
+            uint16_t const segment_count = response_data->datalogger->get_segment_count();
+            if (segment_count > 1)
+            {
+                constexpr uint16_t segment_header_size = 2 * sizeof(uint16_t);
+                constexpr uint16_t segment_size = 3 * sizeof(uint32_t);
+                if (cursor + segment_header_size > response->data_max_length)
+                {
+                    return ResponseCode::Overflow;
+                }
+
+                cursor += codecs::encode_16_bits_big_endian(segment_count, &response->data[cursor]);
+                cursor += codecs::encode_16_bits_big_endian(response_data->first_segment, &response->data[cursor]);
+
+                timestamp_t trigger_timestamp;
+                datalogging::buffer_size_t number_of_points;
+                datalogging::buffer_size_t points_after_trigger;
+                for (uint16_t segment = response_data->first_segment; segment < segment_count; segment++)
+                {
+                    if (cursor + segment_size > response->data_max_length)
+                    {
+                        break; // The server asks for the next ones
+                    }
+
+                    if (!response_data->datalogger->get_segment_info(segment, &trigger_timestamp, &number_of_points, &points_after_trigger))
+                    {
+                        break;
+                    }
+
+                    cursor += codecs::encode_32_bits_big_endian(trigger_timestamp, &response->data[cursor]);
+                    cursor += codecs::encode_32_bits_big_endian(static_cast<uint32_t>(number_of_points), &response->data[cursor]);
+                    cursor += codecs::encode_32_bits_big_endian(static_cast<uint32_t>(points_after_trigger), &response->data[cursor]);
+                }
+            }
             response->data_length = cursor;
 
             return ResponseCode::OK;
         }
 
+        ResponseCode CodecV1_0::decode_datalogging_get_acquisition_metadata_request(
+            Request const *const request,
+            RequestData::DataLogControl::GetAcquisitionMetadata *const request_data)
+        {
+            // Empty for the first segments. [first_segment] to continue the description of a segmented acquisition
+            if (request->data_length == 0)
+            {
+                request_data->first_segment = 0;
+            }
+            else if (request->data_length == sizeof(request_data->first_segment))
+            {
+                request_data->first_segment = codecs::decode_16_bits_big_endian(&request->data[0]);
+            }
+            else
+            {
+                return ResponseCode::InvalidRequest;
+            }
+
+            return ResponseCode::OK;
+        }
+
         ResponseCode CodecV1_0::encode_response_datalogging_read_acquisition(
             ResponseData::DataLogControl::ReadAcquisition const *const response_data,
             Response *const response,
@@ -1070,6 +1758,150 @@ namespace scrutiny
             return protocol::ResponseCode::OK;
         }
 
+        ResponseCode CodecV1_0::encode_response_datalogging_read_acquisition_chunk(
+            ResponseData::DataLogControl::ReadAcquisitionChunk const *const response_data,
+            Response *const response)
+        {
+            constexpr uint16_t header_size = sizeof(response_data->acquisition_id) + sizeof(response_data->offset);
+            constexpr uint16_t crc_size = 4;
+            if (response->data_max_length <= header_size + crc_size)
+            {
+                return ResponseCode::Overflow;
+            }
+
+            uint16_t const max_chunk_length = response->data_max_length - header_size - crc_size;
+            uint16_t chunk_length = response_data->length;
+            if (chunk_length == 0 || chunk_length > max_chunk_length)
+            {
+                chunk_length = max_chunk_length; // 0 means as much as possible
+            }
+
+            uint16_t cursor = 0;
+            cursor += codecs::encode_16_bits_big_endian(response_data->acquisition_id, &response->data[cursor]);
+            cursor += codecs::encode_32_bits_big_endian(response_data->offset, &response->data[cursor]);
+            uint16_t const nread = static_cast<uint16_t>(response_data->reader->read(&response->data[cursor], chunk_length));
+            uint32_t const crc = tools::crc32(&response->data[cursor], nread);
+            cursor += nread;
+            cursor += codecs::encode_32_bits_big_endian(crc, &response->data[cursor]);
+            response->data_length = cursor;
+
+            return ResponseCode::OK;
+        }
+
+        ResponseCode CodecV1_0::decode_datalogging_read_acquisition_request(
+            Request const *const request,
+            RequestData::DataLogControl::ReadAcquisition *const request_data)
+        {
+            // Empty to read entry after entry. [layout] to choose the order of the data
+            if (request->data_length == 0)
+            {
+                request_data->layout = datalogging::ReadLayout::Rows;
+            }
+            else if (request->data_length == 1)
+            {
+                request_data->layout = static_cast<datalogging::ReadLayout>(request->data[0]);
+                if (request_data->layout != datalogging::ReadLayout::Rows && request_data->layout != datalogging::ReadLayout::Columns)
+                {
+                    return ResponseCode::InvalidRequest;
+                }
+            }
+            else
+            {
+                return ResponseCode::InvalidRequest;
+            }
+
+            return ResponseCode::OK;
+        }
+
+        ResponseCode CodecV1_0::decode_datalogging_read_acquisition_chunk_request(
+            Request const *const request,
+            RequestData::DataLogControl::ReadAcquisitionChunk *const request_data)
+        {
+            constexpr uint16_t datalen = sizeof(request_data->acquisition_id) + sizeof(request_data->offset) + sizeof(request_data->length);
+            if (request->data_length != datalen)
+            {
+                return ResponseCode::InvalidRequest;
+            }
+
+            request_data->acquisition_id = codecs::decode_16_bits_big_endian(&request->data[0]);
+            request_data->offset = codecs::decode_32_bits_big_endian(&request->data[2]);
+            request_data->length = codecs::decode_16_bits_big_endian(&request->data[6]);
+            return ResponseCode::OK;
+        }
+
+        ResponseCode CodecV1_0::decode_datalogging_read_acquisition_burst_request(
+            Request const *const request,
+            RequestData::DataLogControl::ReadAcquisitionBurst *const request_data)
+        {
+            // [frames_per_ack] starts a transfer. [frames_per_ack, rolling_counter] acknowledges the received frames
+            if (request->data_length != 1 && request->data_length != 2)
+            {
+                return ResponseCode::InvalidRequest;
+            }
+
+            request_data->frames_per_ack = request->data[0];
+            request_data->acknowledge = (request->data_length == 2);
+            request_data->rolling_counter = request_data->acknowledge ? request->data[1] : 0;
+            return ResponseCode::OK;
+        }
+
+        ResponseCode CodecV1_0::encode_response_datalogging_get_time_marks(
+            ResponseData::DataLogControl::GetTimeMarks const *const response_data,
+            Response *const response)
+        {
+            // [acquisition_id, segment, mark_count, first_mark] followed by as many marks as the response can hold.
+            // Each mark is [entry_index, timestamp]
+            constexpr uint16_t header_size = 4 * sizeof(uint16_t);
+            constexpr uint16_t mark_size = 2 * sizeof(uint32_t);
+            if (response->data_max_length < header_size)
+            {
+                return ResponseCode::Overflow;
+            }
+
+            uint16_t const mark_count = response_data->datalogger->get_time_mark_count(response_data->segment);
+            uint16_t cursor = 0;
+            cursor += codecs::encode_16_bits_big_endian(response_data->acquisition_id, &response->data[cursor]);
+            cursor += codecs::encode_16_bits_big_endian(response_data->segment, &response->data[cursor]);
+            cursor += codecs::encode_16_bits_big_endian(mark_count, &response->data[cursor]);
+            cursor += codecs::encode_16_bits_big_endian(response_data->first_mark, &response->data[cursor]);
+
+            datalogging::buffer_size_t entry_index;
+            timestamp_t timestamp;
+            for (uint16_t mark = response_data->first_mark; mark < mark_count; mark++)
+            {
+                if (cursor + mark_size > response->data_max_length)
+                {
+                    break; // The server asks for the next ones
+                }
+
+                if (!response_data->datalogger->get_time_mark(response_data->segment, mark, &entry_index, &timestamp))
+                {
+                    break;
+                }
+
+                cursor += codecs::encode_32_bits_big_endian(static_cast<uint32_t>(entry_index), &response->data[cursor]);
+                cursor += codecs::encode_32_bits_big_endian(timestamp, &response->data[cursor]);
+            }
+            response->data_length = cursor;
+
+            return ResponseCode::OK;
+        }
+
+        ResponseCode CodecV1_0::decode_datalogging_get_time_marks_request(
+            Request const *const request,
+            RequestData::DataLogControl::GetTimeMarks *const request_data)
+        {
+            constexpr uint16_t datalen = sizeof(request_data->segment) + sizeof(request_data->first_mark);
+            if (request->data_length != datalen)
+            {
+                return ResponseCode::InvalidRequest;
+            }
+
+            request_data->segment = codecs::decode_16_bits_big_endian(&request->data[0]);
+            request_data->first_mark = codecs::decode_16_bits_big_endian(&request->data[2]);
+            return ResponseCode::OK;
+        }
+
         ResponseCode CodecV1_0::decode_datalogging_configure_request(
             Request const *const request,
             RequestData::DataLogControl::Configure *const request_data,
@@ -1141,7 +1973,7 @@ namespace scrutiny
                 }
                 case datalogging::OperandType::VARBIT:
                 {
-                    if (request->data_length < cursor + sizeof(uint8_t) + sizeof(void *))
+                    if (request->data_length < cursor + sizeof(uint8_t) + sizeof(void *) + 2 * sizeof(uint8_t))
                     {
                         return ResponseCode::InvalidRequest;
                     }
@@ -1207,6 +2039,19 @@ namespace scrutiny
                 {
                     break;
                 }
+                case datalogging::LoggableType::VARBIT:
+                {
+                    if (request->data_length < cursor + sizeof(uint8_t) + sizeof(void *) + 2 * sizeof(uint8_t))
+                    {
+                        return ResponseCode::InvalidRequest;
+                    }
+
+                    config->items_to_log[i].data.varbit.datatype = static_cast<scrutiny::VariableType>(request->data[cursor++]);
+                    cursor += codecs::decode_address_big_endian(&request->data[cursor], reinterpret_cast<uintptr_t *>(&config->items_to_log[i].data.varbit.addr));
+                    config->items_to_log[i].data.varbit.bitoffset = request->data[cursor++];
+                    config->items_to_log[i].data.varbit.bitsize = request->data[cursor++];
+                    break;
+                }
                 default:
                 {
                     return ResponseCode::InvalidRequest;
@@ -1214,6 +2059,29 @@ namespace scrutiny
                 }
             }
 
+            // Optional trailing fields, in order: [segment_count] then [time_axis, time_mark_interval, time_mark_tolerance_100ns]
+            // A single capture with the time logged by TIME items when absent
+            constexpr uint16_t segment_count_size = sizeof(config->segment_count);
+            constexpr uint16_t time_axis_size = sizeof(config->time_axis) + sizeof(config->time_mark_interval) + sizeof(config->time_mark_tolerance_100ns);
+            config->segment_count = 1;
+            config->time_axis = datalogging::TimeAxis::Logged;
+            config->time_mark_interval = 0;
+            config->time_mark_tolerance_100ns = 0;
+            if (request->data_length == cursor + segment_count_size || request->data_length == cursor + segment_count_size + time_axis_size)
+            {
+                config->segment_count = codecs::decode_16_bits_big_endian(&request->data[cursor]);
+                cursor += segment_count_size;
+            }
+
+            if (request->data_length == cursor + time_axis_size)
+            {
+                config->time_axis = static_cast<datalogging::TimeAxis>(request->data[cursor++]); // Validated by the datalogger
+                config->time_mark_interval = codecs::decode_16_bits_big_endian(&request->data[cursor]);
+                cursor += sizeof(config->time_mark_interval);
+                config->time_mark_tolerance_100ns = codecs::decode_32_bits_big_endian(&request->data[cursor]);
+                cursor += sizeof(config->time_mark_tolerance_100ns);
+            }
+
             if (cursor != request->data_length)
             {
                 return ResponseCode::InvalidRequest;
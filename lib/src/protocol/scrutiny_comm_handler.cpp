@@ -12,6 +12,7 @@
 #include "scrutiny_setup.hpp"
 #include "protocol/scrutiny_comm_handler.hpp"
 #include "scrutiny_tools.hpp"
+#include "scrutiny_common_codecs.hpp"
 
 namespace scrutiny
 {
@@ -39,6 +40,13 @@ namespace scrutiny
             m_active_response.data = m_tx_buffer; // Half duplex comm. Share buffer
             m_active_response.data_max_length = m_tx_buffer_size;
             m_enabled = true;
+            m_datagram_mode = false;
+            m_check_crc = true;
+            m_framing = CommControl::Framing::Raw;
+            m_next_framing = CommControl::Framing::Raw;
+            m_max_frame_data_size = MAXIMUM_TX_BUFFER_SIZE;
+            m_rx_sink = nullptr;
+            m_rx_streaming = false;
 
             if (m_rx_buffer_size < MINIMUM_RX_BUFFER_SIZE || m_rx_buffer_size > MAXIMUM_RX_BUFFER_SIZE)
             {
@@ -53,10 +61,47 @@ namespace scrutiny
             reset();
         }
 
-        void CommHandler::receive_data(uint8_t const *const data, uint16_t const len)
+        void CommHandler::set_datagram_mode(uint16_t const mtu, bool const check_crc)
         {
-            uint16_t i = 0;
+            m_datagram_mode = true;
+            m_check_crc = check_crc;
+
+            // A response must fit in a single datagram
+            uint16_t const max_tx_data = (mtu > RESPONSE_OVERHEAD) ? static_cast<uint16_t>(mtu - RESPONSE_OVERHEAD) : 0u;
+            m_max_frame_data_size = (max_tx_data < MAXIMUM_TX_BUFFER_SIZE) ? max_tx_data : static_cast<uint16_t>(MAXIMUM_TX_BUFFER_SIZE);
+            if (m_tx_buffer_size > max_tx_data)
+            {
+                m_tx_buffer_size = max_tx_data;
+                m_active_response.data_max_length = max_tx_data;
+            }
+
+            if (m_tx_buffer_size < MINIMUM_TX_BUFFER_SIZE)
+            {
+                m_enabled = false;
+            }
+
+            reset();
+        }
+
+        bool CommHandler::set_framing_after_response(CommControl::Framing const framing)
+        {
+            if (framing == CommControl::Framing::Raw)
+            {
+                m_next_framing = framing;
+                return true;
+            }
 
+            if (framing == CommControl::Framing::COBS && !m_datagram_mode) // Datagrams are already delimited
+            {
+                m_next_framing = framing;
+                return true;
+            }
+
+            return false;
+        }
+
+        void CommHandler::receive_data(uint8_t const *const data, uint16_t const len)
+        {
             if (m_enabled == false)
             {
                 m_rx_error = RxError::Disabled;
@@ -68,6 +113,12 @@ namespace scrutiny
                 return; // Half duplex comm. Discard data;
             }
 
+            if (m_datagram_mode)
+            {
+                receive_datagram(data, len);
+                return;
+            }
+
             // Handle rx timeouts. Start a new reception if no data for too long
             if (len != 0)
             {
@@ -80,11 +131,77 @@ namespace scrutiny
                 // Update rx timestamp
                 m_last_rx_timestamp = m_timebase->get_timestamp();
 
-                if (m_state == State::Idle)
+                if (m_state == State::Idle && !m_request_received)
                 {
                     m_state = State::Receiving;
                 }
             }
+
+            if (m_framing == CommControl::Framing::COBS)
+            {
+                receive_cobs(data, len);
+            }
+            else
+            {
+                receive_stream(data, len);
+            }
+        }
+
+        // Decodes the COBS byte stuffing and gives the decoded bytes to the stream parser.
+        // A delimiter ends the frame: whatever did not form a valid request is dropped right away, without waiting for the reception timeout.
+        void CommHandler::receive_cobs(uint8_t const *const data, uint16_t const len)
+        {
+            static uint8_t const zero = 0;
+            uint16_t i = 0;
+
+            while (i < len)
+            {
+                if (data[i] == 0)
+                {
+                    i++;
+                    if (m_request_received)
+                    {
+                        m_cobs_rx.block_remaining = 0;
+                        m_cobs_rx.pending_zero = false;
+                    }
+                    else
+                    {
+                        reset_rx(); // Incomplete or corrupted frame. Resync on this delimiter
+                    }
+                }
+                else if (m_cobs_rx.block_remaining == 0) // Code byte
+                {
+                    bool const zero_before = m_cobs_rx.pending_zero;
+                    m_cobs_rx.block_remaining = static_cast<uint8_t>(data[i] - 1u);
+                    m_cobs_rx.pending_zero = (data[i] != 0xFF);
+                    i++;
+
+                    if (zero_before)
+                    {
+                        receive_stream(&zero, 1);
+                    }
+                }
+                else
+                {
+                    uint16_t const available = static_cast<uint16_t>(len - i);
+                    uint16_t const max_run = (available < m_cobs_rx.block_remaining) ? available : m_cobs_rx.block_remaining;
+                    uint16_t run = 0;
+                    while (run < max_run && data[i + run] != 0)
+                    {
+                        run++;
+                    }
+
+                    m_cobs_rx.block_remaining = static_cast<uint8_t>(m_cobs_rx.block_remaining - run);
+                    receive_stream(&data[i], run);
+                    i += run;
+                }
+            }
+        }
+
+        void CommHandler::receive_stream(uint8_t const *const data, uint16_t const len)
+        {
+            uint16_t i = 0;
+
             // Process each bytes
             while (i < len && !m_request_received && m_rx_state != RxFSMState::Error)
             {
@@ -151,6 +268,10 @@ namespace scrutiny
                         }
                         else
                         {
+                            if (m_active_request.data_length > m_rx_buffer_size)
+                            {
+                                begin_streamed_request(); // If refused, WaitForData reports the overflow
+                            }
                             m_per_state_data.data_bytes_received = 0;
                             m_rx_state = RxFSMState::WaitForData;
                         }
@@ -160,7 +281,7 @@ namespace scrutiny
 
                 case RxFSMState::WaitForData:
                 {
-                    if (m_active_request.data_length > m_rx_buffer_size)
+                    if (m_active_request.data_length > m_rx_buffer_size && !m_rx_streaming)
                     {
                         m_rx_error = RxError::Overflow;
                         m_rx_state = RxFSMState::Error; // Timeout will bring it back to wroking state
@@ -171,7 +292,15 @@ namespace scrutiny
                     uint16_t const missing_bytes = m_active_request.data_length - m_per_state_data.data_bytes_received;
                     uint16_t const data_bytes_to_read = (available_bytes >= missing_bytes) ? missing_bytes : available_bytes;
 
-                    memcpy(&m_rx_buffer[m_per_state_data.data_bytes_received], &data[i], data_bytes_to_read);
+                    if (m_rx_streaming)
+                    {
+                        m_rx_sink->write(&data[i], data_bytes_to_read);
+                        m_rx_crc = tools::crc32(&data[i], data_bytes_to_read, m_rx_crc);
+                    }
+                    else
+                    {
+                        memcpy(&m_rx_buffer[m_per_state_data.data_bytes_received], &data[i], data_bytes_to_read);
+                    }
                     m_per_state_data.data_bytes_received += data_bytes_to_read;
                     i += data_bytes_to_read;
 
@@ -203,7 +332,17 @@ namespace scrutiny
                         m_active_request.crc |= static_cast<uint32_t>(data[i]) << 0;
                         m_state = State::Idle;
 
-                        if (check_crc(&m_active_request))
+                        bool crc_valid;
+                        if (m_rx_streaming)
+                        {
+                            crc_valid = (m_rx_crc == m_active_request.crc);
+                        }
+                        else
+                        {
+                            crc_valid = check_crc(&m_active_request);
+                        }
+
+                        if (!m_check_crc || crc_valid)
                         {
                             process_active_request();
                         }
@@ -224,6 +363,94 @@ namespace scrutiny
             }
         }
 
+        // Validates a whole datagram as a single request. The transport preserves the message boundaries,
+        // so there is no byte per byte state machine and no inter-byte timeout.
+        void CommHandler::receive_datagram(uint8_t const *const data, uint16_t const len)
+        {
+            if (len == 0 || m_request_received)
+            {
+                return; // Nothing received or the previous request is still being processed
+            }
+
+            reset_rx();
+
+            if (len < REQUEST_OVERHEAD)
+            {
+                return;
+            }
+
+            if ((data[0] & 0x80) != 0)
+            {
+                m_rx_error = RxError::InvalidCommand;
+                return;
+            }
+
+            uint16_t const data_length = (static_cast<uint16_t>(data[2]) << 8u) | static_cast<uint16_t>(data[3]);
+            if (static_cast<uint32_t>(data_length) + REQUEST_OVERHEAD != len)
+            {
+                if (data_length > m_rx_buffer_size)
+                {
+                    m_rx_error = RxError::Overflow;
+                }
+                return; // Truncated or padded datagram
+            }
+
+            m_active_request.command_id = data[0];
+            m_active_request.subfunction_id = data[1];
+            m_active_request.data_length = data_length;
+            m_active_request.crc = codecs::decode_32_bits_big_endian(&data[4 + data_length]);
+
+            bool crc_valid;
+            if (data_length > m_rx_buffer_size)
+            {
+                if (!begin_streamed_request())
+                {
+                    m_rx_error = RxError::Overflow;
+                    return;
+                }
+                m_rx_sink->write(&data[4], data_length);
+                crc_valid = (tools::crc32(&data[4], data_length, m_rx_crc) == m_active_request.crc);
+            }
+            else
+            {
+                memcpy(m_rx_buffer, &data[4], data_length);
+                crc_valid = check_crc(&m_active_request);
+            }
+
+            if (!m_check_crc || crc_valid)
+            {
+                process_active_request();
+            }
+            else
+            {
+                reset_rx();
+            }
+        }
+
+        // Hands the payload of the actual request to the request sink, if there is one that accepts it.
+        // Only during a session: Discover and Connect requests always fit in the reception buffer.
+        bool CommHandler::begin_streamed_request(void)
+        {
+            if (m_rx_sink == nullptr || !m_session_active)
+            {
+                return false;
+            }
+
+            if (!m_rx_sink->begin(m_active_request.command_id, m_active_request.subfunction_id, m_active_request.data_length))
+            {
+                return false;
+            }
+
+            uint8_t header_data[4];
+            header_data[0] = m_active_request.command_id;
+            header_data[1] = m_active_request.subfunction_id;
+            header_data[2] = (m_active_request.data_length >> 8) & 0xFF;
+            header_data[3] = m_active_request.data_length & 0xFF;
+            m_rx_crc = tools::crc32(header_data, sizeof(header_data));
+            m_rx_streaming = true;
+            return true;
+        }
+
         void CommHandler::process_active_request(void)
         {
             bool must_process = false;
@@ -257,6 +484,27 @@ namespace scrutiny
         }
 
         bool CommHandler::send_response(Response const *const response)
+        {
+            return start_transmission(response, nullptr);
+        }
+
+        bool CommHandler::send_streamed_response(Response const *const response, ResponseSource *const source)
+        {
+            return start_transmission(response, source);
+        }
+
+        uint16_t CommHandler::max_streamed_data_size(void) const
+        {
+            if (m_framing == CommControl::Framing::COBS)
+            {
+                return 0; // The encoder needs random access to the frame
+            }
+
+            return m_max_frame_data_size;
+        }
+
+        // Starts sending a response. The payload comes from the source if there is one, otherwise from response->data
+        bool CommHandler::start_transmission(Response const *const response, ResponseSource *const source)
         {
             m_tx_error = TxError::None;
             if (m_enabled == false)
@@ -271,7 +519,8 @@ namespace scrutiny
                 return false; // Half duplex comm. Discard data;
             }
 
-            if (response->data_length > m_tx_buffer_size)
+            uint16_t const max_data_size = (source == nullptr) ? m_tx_buffer_size : max_streamed_data_size();
+            if (response->data_length > max_data_size)
             {
                 reset_tx();
                 m_tx_error = TxError::Overflow;
@@ -282,13 +531,45 @@ namespace scrutiny
             m_active_response.subfunction_id = response->subfunction_id;
             m_active_response.response_code = response->response_code;
             m_active_response.data_length = response->data_length;
-            m_active_response.data = response->data;
+            m_active_response.data = (source == nullptr) ? response->data : nullptr;
+            m_tx_source = source;
+            m_tx_source_failed = false;
 
-            add_crc(&m_active_response);
+            if (!m_check_crc)
+            {
+                m_active_response.crc = 0;
+            }
+            else if (source != nullptr)
+            {
+                m_active_response.crc = header_crc(&m_active_response); // The payload is added as it is read from the source
+            }
+            else
+            {
+                add_crc(&m_active_response);
+            }
 
             // cmd8 + subfn8 + code8 + len16 + data + crc32
             m_nbytes_to_send = 1 + 1 + 1 + 2 + m_active_response.data_length + 4;
 
+            if (m_framing == CommControl::Framing::COBS)
+            {
+                m_cobs_tx.frame_position = 0;
+                m_cobs_tx.block_length = 0;
+                m_cobs_tx.block_sent = 0;
+                m_cobs_tx.zero_after_block = false;
+                m_cobs_tx.step = CobsEncoder::Step::Code;
+
+                // The encoded size depends on the content. Dry run of the encoder to know it
+                CobsEncoder size_counter = m_cobs_tx;
+                m_nbytes_to_send = encode_cobs(nullptr, 0xFFFF, &size_counter);
+                if (size_counter.step != CobsEncoder::Step::Done)
+                {
+                    reset_tx();
+                    m_tx_error = TxError::Overflow;
+                    return false;
+                }
+            }
+
             m_state = State::Transmitting;
             return true;
         }
@@ -302,6 +583,36 @@ namespace scrutiny
                 return 0u;
             }
 
+            if (m_datagram_mode && len < m_nbytes_to_send - m_nbytes_sent)
+            {
+                return 0u; // A frame is never split across datagrams
+            }
+
+            uint16_t i = 0u;
+            if (m_framing == CommControl::Framing::COBS)
+            {
+                uint16_t const nbytes_to_send = static_cast<uint16_t>(m_nbytes_to_send - m_nbytes_sent);
+                i = encode_cobs(buffer, (len > nbytes_to_send) ? nbytes_to_send : len, &m_cobs_tx);
+                m_nbytes_sent += i;
+            }
+            else
+            {
+                i = pop_data_raw(buffer, len);
+            }
+
+            if (m_nbytes_sent >= m_nbytes_to_send)
+            {
+                reset_tx();
+                wait_next_request();
+                m_framing = m_next_framing;
+            }
+
+            return i;
+        }
+
+        // Copies the response bytes as-is.
+        uint16_t CommHandler::pop_data_raw(uint8_t *const buffer, uint16_t len)
+        {
             uint16_t i = 0u;
 
             uint16_t const nbytes_to_send = static_cast<uint16_t>(m_nbytes_to_send - m_nbytes_sent);
@@ -345,7 +656,28 @@ namespace scrutiny
                     uint16_t const remaining_data_bytes = m_active_response.data_length - (m_nbytes_sent - 5);
                     uint16_t const user_request_remaining = (len - i);
                     uint16_t const data_bytes_to_copy = (user_request_remaining < remaining_data_bytes) ? user_request_remaining : remaining_data_bytes; // Don't read more than available.
-                    memcpy(&buffer[i], &m_active_response.data[m_active_response.data_length - remaining_data_bytes], data_bytes_to_copy);
+                    if (m_tx_source != nullptr)
+                    {
+                        if (!m_tx_source->read(&buffer[i], data_bytes_to_copy))
+                        {
+                            memset(&buffer[i], 0, data_bytes_to_copy);
+                            m_tx_source_failed = true;
+                        }
+
+                        if (m_check_crc)
+                        {
+                            m_active_response.crc = tools::crc32(&buffer[i], data_bytes_to_copy, m_active_response.crc);
+                        }
+
+                        if (m_tx_source_failed && data_bytes_to_copy == remaining_data_bytes)
+                        {
+                            m_active_response.crc = ~m_active_response.crc; // Header is already out. Only a bad CRC can tell the server to drop this response
+                        }
+                    }
+                    else
+                    {
+                        memcpy(&buffer[i], &m_active_response.data[m_active_response.data_length - remaining_data_bytes], data_bytes_to_copy);
+                    }
 
                     i += data_bytes_to_copy;
                     m_nbytes_sent += data_bytes_to_copy;
@@ -379,13 +711,118 @@ namespace scrutiny
                 }
             }
 
-            if (m_nbytes_sent >= m_nbytes_to_send)
+            return i;
+        }
+
+        // Returns the byte at a given position of the unencoded response frame.
+        uint8_t CommHandler::tx_frame_byte(uint16_t const position) const
+        {
+            uint16_t const crc_position = m_active_response.data_length + 5u;
+            if (position == 0u)
             {
-                reset_tx();
-                wait_next_request();
+                return m_active_response.command_id;
+            }
+            else if (position == 1u)
+            {
+                return m_active_response.subfunction_id;
+            }
+            else if (position == 2u)
+            {
+                return m_active_response.response_code;
+            }
+            else if (position == 3u)
+            {
+                return static_cast<uint8_t>((m_active_response.data_length >> 8) & 0xFFu);
+            }
+            else if (position == 4u)
+            {
+                return static_cast<uint8_t>(m_active_response.data_length & 0xFFu);
+            }
+            else if (position < crc_position)
+            {
+                return m_active_response.data[position - 5u];
             }
 
-            return i;
+            uint8_t const shift = static_cast<uint8_t>(24u - 8u * (position - crc_position));
+            return static_cast<uint8_t>((m_active_response.crc >> shift) & 0xFFu);
+        }
+
+        // COBS encodes the response frame followed by its delimiter. Blocks are at most 254 literal bytes.
+        // When buffer is nullptr, nothing is written and only the number of bytes is counted.
+        uint16_t CommHandler::encode_cobs(uint8_t *const buffer, uint16_t const len, CobsEncoder *const encoder) const
+        {
+            uint16_t const frame_size = static_cast<uint16_t>(m_active_response.data_length + RESPONSE_OVERHEAD);
+            uint16_t n = 0;
+
+            while (n < len && encoder->step != CobsEncoder::Step::Done)
+            {
+                switch (encoder->step)
+                {
+                case CobsEncoder::Step::Code:
+                {
+                    uint8_t block_length = 0;
+                    while (block_length < 254u && encoder->frame_position + block_length < frame_size && tx_frame_byte(encoder->frame_position + block_length) != 0)
+                    {
+                        block_length++;
+                    }
+
+                    encoder->block_length = block_length;
+                    encoder->block_sent = 0;
+                    encoder->zero_after_block = (block_length < 254u) && (encoder->frame_position + block_length < frame_size);
+                    if (buffer != nullptr)
+                    {
+                        buffer[n] = static_cast<uint8_t>(block_length + 1u);
+                    }
+                    n++;
+                    encoder->step = CobsEncoder::Step::Literals;
+                    break;
+                }
+
+                case CobsEncoder::Step::Literals:
+                {
+                    while (encoder->block_sent < encoder->block_length && n < len)
+                    {
+                        if (buffer != nullptr)
+                        {
+                            buffer[n] = tx_frame_byte(encoder->frame_position);
+                        }
+                        encoder->frame_position++;
+                        encoder->block_sent++;
+                        n++;
+                    }
+
+                    if (encoder->block_sent >= encoder->block_length)
+                    {
+                        if (encoder->zero_after_block)
+                        {
+                            encoder->frame_position++; // Implied by the code byte
+                            encoder->step = CobsEncoder::Step::Code;
+                        }
+                        else
+                        {
+                            encoder->step = (encoder->frame_position >= frame_size) ? CobsEncoder::Step::Delimiter : CobsEncoder::Step::Code;
+                        }
+                    }
+                    break;
+                }
+
+                case CobsEncoder::Step::Delimiter:
+                {
+                    if (buffer != nullptr)
+                    {
+                        buffer[n] = 0;
+                    }
+                    n++;
+                    encoder->step = CobsEncoder::Step::Done;
+                    break;
+                }
+
+                default:
+                    break;
+                }
+            }
+
+            return n;
         }
 
         // Check if the last request received is a valid "Comm Discover request".
@@ -459,6 +896,14 @@ namespace scrutiny
             return success;
         }
 
+        void CommHandler::keep_alive(void)
+        {
+            if (m_session_active)
+            {
+                m_heartbeat_timestamp = m_timebase->get_timestamp();
+            }
+        }
+
         uint16_t CommHandler::data_to_send(void) const
         {
             if (m_state != State::Transmitting)
@@ -487,6 +932,12 @@ namespace scrutiny
             if (response->data_length > m_tx_buffer_size)
                 return;
 
+            response->crc = tools::crc32(response->data, response->data_length, header_crc(response));
+        }
+
+        // CRC of the response header only. The payload CRC is chained to it.
+        uint32_t CommHandler::header_crc(Response const *const response) const
+        {
             uint8_t header[5];
             header[0] = response->command_id;
             header[1] = response->subfunction_id;
@@ -494,8 +945,7 @@ namespace scrutiny
             header[3] = (response->data_length >> 8) & 0xFF;
             header[4] = response->data_length & 0xFF;
 
-            uint32_t const crc = tools::crc32(header, sizeof(header));
-            response->crc = tools::crc32(response->data, response->data_length, crc);
+            return tools::crc32(header, sizeof(header));
         }
 
         void CommHandler::reset(void)
@@ -506,6 +956,8 @@ namespace scrutiny
             m_first_heartbeat_received = false;
             m_session_id = 0;
             m_session_active = false;
+            m_framing = CommControl::Framing::Raw;
+            m_next_framing = CommControl::Framing::Raw;
 
             reset_rx();
             reset_tx();
@@ -513,8 +965,16 @@ namespace scrutiny
 
         void CommHandler::reset_rx(void)
         {
+            if (m_rx_streaming)
+            {
+                m_rx_streaming = false;
+                m_rx_sink->release();
+            }
+
             m_active_request.reset();
             m_rx_state = RxFSMState::WaitForCommand;
+            m_cobs_rx.block_remaining = 0;
+            m_cobs_rx.pending_zero = false;
             m_request_received = false;
             m_rx_error = RxError::None;
             m_last_rx_timestamp = m_timebase->get_timestamp();
@@ -530,6 +990,8 @@ namespace scrutiny
             m_active_response.reset();
             m_nbytes_to_send = 0;
             m_nbytes_sent = 0;
+            m_tx_source = nullptr;
+            m_tx_source_failed = false;
             m_tx_error = TxError::None;
 
             if (m_state == State::Transmitting)
@@ -552,6 +1014,8 @@ namespace scrutiny
 
             m_session_id = s_session_counter++;
             m_session_active = true;
+            m_framing = CommControl::Framing::Raw;
+            m_next_framing = CommControl::Framing::Raw;
             m_first_heartbeat_received = false;
             m_heartbeat_timestamp = m_timebase->get_timestamp();
             reset_rx();
@@ -563,6 +1027,8 @@ namespace scrutiny
         {
             m_session_id = 0;
             m_session_active = false;
+            m_framing = CommControl::Framing::Raw;
+            m_next_framing = CommControl::Framing::Raw;
             m_first_heartbeat_received = false;
             reset_rx();
             reset_tx();
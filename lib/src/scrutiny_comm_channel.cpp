@@ -0,0 +1,124 @@
+//    scrutiny_comm_channel.cpp
+//        A communication channel (buffers + session + request state) served by the MainHandler.
+//
+//   - License : MIT - See LICENSE file.
+//   - Project : Scrutiny Debugger (github.com/scrutinydebugger/scrutiny-embedded)
+//
+//   Copyright (c) 2021 Scrutiny Debugger
+
+#include "scrutiny_setup.hpp"
+#include "scrutiny_comm_channel.hpp"
+#include "scrutiny_main_handler.hpp"
+
+namespace scrutiny
+{
+    CommChannel::CommChannel(void) : m_comm_handler{},
+                                     m_rx_buffer{nullptr},
+                                     m_rx_buffer_size{0},
+                                     m_tx_buffer{nullptr},
+                                     m_tx_buffer_size{0},
+                                     m_datagram_mtu{0},
+                                     m_datagram_check_crc{true},
+                                     m_processing_request{false},
+                                     m_disconnect_pending{false},
+                                     m_process_again_timestamp_taken{false},
+                                     m_process_again_timestamp{0},
+                                     m_process_again_session_id{0},
+                                     m_response_source{nullptr},
+                                     m_request_sink{}
+    {
+    }
+
+    void CommChannel::set_buffers(uint8_t *rx_buffer, uint16_t const rx_buffer_size, uint8_t *tx_buffer, uint16_t const tx_buffer_size)
+    {
+        m_rx_buffer = rx_buffer;
+        m_rx_buffer_size = rx_buffer_size;
+        m_tx_buffer = tx_buffer;
+        m_tx_buffer_size = tx_buffer_size;
+    }
+
+    void CommChannel::set_datagram_mode(uint16_t const mtu, bool const check_crc)
+    {
+        m_datagram_mtu = mtu;
+        m_datagram_check_crc = check_crc;
+    }
+
+    void CommChannel::init(Timebase const *const timebase, uint32_t const session_counter_seed)
+    {
+        m_processing_request = false;
+        m_disconnect_pending = false;
+        m_process_again_timestamp_taken = false;
+        m_process_again_timestamp = 0;
+        m_process_again_session_id = 0;
+        m_response_source = nullptr;
+
+        m_comm_handler.init(
+            m_rx_buffer, m_rx_buffer_size,
+            m_tx_buffer, m_tx_buffer_size,
+            timebase, session_counter_seed);
+
+        if (m_datagram_mtu != 0)
+        {
+            m_comm_handler.set_datagram_mode(m_datagram_mtu, m_datagram_check_crc);
+        }
+    }
+
+    void CommChannel::reset(void)
+    {
+        m_processing_request = false;
+        m_disconnect_pending = false;
+        m_comm_handler.reset();
+    }
+
+    void CommChannel::check_finished_sending(void)
+    {
+        if (m_processing_request)
+        {
+            if (!m_comm_handler.transmitting()) // Will be false if NoResponseToSend or if finished transmitting
+            {
+                m_comm_handler.wait_next_request(); // Allow reception of next request
+                m_processing_request = false;
+                m_process_again_timestamp_taken = false;
+
+                if (m_disconnect_pending)
+                {
+                    m_comm_handler.disconnect();
+                    m_disconnect_pending = false;
+                }
+            }
+        }
+    }
+
+    /// @brief Tells if the request being answered ProcessAgain disappeared because the session ended or the comm handler was reset
+    /// before a response could be given. What was started for it must then be dropped.
+    bool CommChannel::pending_request_lost(void) const
+    {
+        if (!m_process_again_timestamp_taken)
+        {
+            return false;
+        }
+
+        return !m_comm_handler.request_received() || m_comm_handler.get_session_id() != m_process_again_session_id;
+    }
+
+    void CommChannelRequestSink::init(MainHandler *const main_handler, CommChannel *const channel)
+    {
+        m_main_handler = main_handler;
+        m_channel = channel;
+    }
+
+    bool CommChannelRequestSink::begin(uint8_t const command_id, uint8_t const subfunction_id, uint16_t const data_length)
+    {
+        return m_main_handler->begin_streamed_write(m_channel, command_id, subfunction_id, data_length);
+    }
+
+    void CommChannelRequestSink::write(uint8_t const *const data, uint16_t const len)
+    {
+        m_main_handler->receive_streamed_write(m_channel, data, len);
+    }
+
+    void CommChannelRequestSink::release(void)
+    {
+        m_main_handler->release_streamed_write(m_channel);
+    }
+}
@@ -25,6 +25,11 @@ namespace scrutiny
         m_rx_buffer = nullptr;
         m_rx_buffer_size = 0;
         m_tx_buffer_size = 0;
+        m_datagram_mtu = 0;
+        m_datagram_check_crc = true;
+        m_receive_ring = nullptr;
+        m_additional_channels = nullptr;
+        m_additional_channel_count = 0;
         m_forbidden_address_ranges = nullptr;
         m_forbidden_range_count = 0;
         m_readonly_address_ranges = nullptr;
@@ -36,14 +41,20 @@ namespace scrutiny
         display_name = "";
         max_bitrate = 0;
         m_user_command_callback = nullptr;
+        m_async_user_command_callback = nullptr;
+        m_user_command_timeout_100ns = SCRUTINY_REQUEST_MAX_PROCESS_TIME_US * 10;
         session_counter_seed = 0;
         memory_write_enable = true;
+        response_streaming = false;
         m_loops = nullptr;
         m_loop_count = 0;
+        m_staged_write_buffer = nullptr;
+        m_staged_write_buffer_size = 0;
 
 #if SCRUTINY_ENABLE_DATALOGGING
         m_datalogger_buffer = nullptr;
         m_datalogger_buffer_size = 0;
+        m_datalogger_storage = nullptr;
         m_datalogger_trigger_callback = nullptr;
 #endif
     }
@@ -56,6 +67,16 @@ namespace scrutiny
         m_tx_buffer_size = tx_buffer_size;
     }
 
+    void Config::set_additional_comm_channels(CommChannel **channels, uint8_t const count)
+    {
+        m_additional_channels = channels;
+        m_additional_channel_count = count;
+        if (channels == nullptr)
+        {
+            m_additional_channel_count = 0;
+        }
+    }
+
     void Config::set_forbidden_address_range(AddressRange const *range, uint8_t const count)
     {
         m_forbidden_address_ranges = range;
@@ -82,6 +103,12 @@ namespace scrutiny
         m_loop_count = loop_count;
     }
 
+    void Config::set_staged_write_buffer(uint8_t *buffer, uint16_t const buffer_size)
+    {
+        m_staged_write_buffer = buffer;
+        m_staged_write_buffer_size = buffer_size;
+    }
+
 #if SCRUTINY_ENABLE_DATALOGGING
     void Config::set_datalogging_buffers(uint8_t *buffer, datalogging::buffer_size_t const buffer_size)
     {
@@ -19,12 +19,11 @@ namespace scrutiny
     {
         m_main2loop_msg.clear();
         m_loop2main_msg.clear();
+        m_main_handler = main_handler;
 #if SCRUTINY_ENABLE_DATALOGGING
         m_owns_datalogger = false;
         m_datalogger_data_acquired = false;
         m_datalogger = main_handler->datalogger();
-#else
-        static_cast<void>(main_handler);
 #endif
     }
 
@@ -40,6 +39,16 @@ namespace scrutiny
             Main2LoopMessage msg_in = m_main2loop_msg.pop();
             switch (msg_in.message_id)
             {
+            case Main2LoopMessageID::APPLY_STAGED_WRITES:
+                if (!m_main_handler->m_staged_write.ticket.redeem(msg_in.data.staged_writes.ticket))
+                {
+                    break; // Cancelled because the requester stopped waiting. Nobody expects an answer
+                }
+                // Applied at once, before anything else in this loop, so the application never sees a partial update.
+                msg_out.message_id = Loop2MainMessageID::STAGED_WRITES_APPLIED;
+                msg_out.data.staged_writes_applied.success = m_main_handler->apply_staged_writes(msg_in.data.staged_writes.entries, msg_in.data.staged_writes.entries_length);
+                m_loop2main_msg.send(msg_out);
+                break;
 #if SCRUTINY_ENABLE_DATALOGGING
             case Main2LoopMessageID::TAKE_DATALOGGER_OWNERSHIP:
                 m_owns_datalogger = true;
@@ -16,13 +16,15 @@
 namespace scrutiny
 {
     MainHandler::MainHandler(void) : m_timebase{},
-                                     m_comm_handler{},
-                                     m_processing_request{},
-                                     m_disconnect_pending{},
+                                     m_main_channel{},
+                                     m_active_channel{nullptr},
+                                     m_next_channel_index{0},
                                      m_config{},
                                      m_enabled{},
-                                     m_process_again_timestamp_taken{},
-                                     m_process_again_timestamp{},
+                                     m_staged_write{},
+                                     m_streamed_write{},
+                                     m_sliced_write{},
+                                     m_user_command{},
                                      m_codec{}
 #if SCRUTINY_ENABLE_DATALOGGING
                                      ,
@@ -33,26 +35,60 @@ namespace scrutiny
 
     void MainHandler::init(Config const *const config)
     {
-        m_processing_request = false;
-        m_disconnect_pending = false;
-        m_process_again_timestamp_taken = false;
         m_config = *config;
-
-        m_comm_handler.init(
-            m_config.m_rx_buffer, m_config.m_rx_buffer_size,
-            m_config.m_tx_buffer, m_config.m_tx_buffer_size,
-            &m_timebase, m_config.session_counter_seed);
+        m_active_channel = nullptr;
+        m_next_channel_index = 0;
+        m_staged_write.state = StagedWriteState::Idle;
+        m_staged_write.owner = nullptr;
+        m_staged_write.loop_id = 0;
+        m_staged_write.entry_count = 0;
+        m_staged_write.success = false;
+        m_staged_write.ticket.revoke();
+        m_staged_write.ticket_number = 0;
+        m_streamed_write.owner = nullptr;
+        m_streamed_write.code = protocol::ResponseCode::OK;
+        m_sliced_write.owner = nullptr;
+        m_sliced_write.remaining.length = 0;
+        m_budget = 0;
+        m_budget_limited = false;
+        m_timestep_100ns = 0;
+        m_user_command.pending = false;
+        m_user_command.owner = nullptr;
+        m_user_command.completion.clear();
+
+        m_main_channel.set_buffers(m_config.m_rx_buffer, m_config.m_rx_buffer_size, m_config.m_tx_buffer, m_config.m_tx_buffer_size);
+        m_main_channel.set_datagram_mode(m_config.m_datagram_mtu, m_config.m_datagram_check_crc);
 
         check_config();
-        if (!m_enabled)
+        for (uint8_t i = 0; i < channel_count(); i++)
         {
-            m_comm_handler.disable();
+            CommChannel *const chan = channel(i);
+            if (chan == nullptr)
+            {
+                continue; // Invalid config. Already disabled by check_config()
+            }
+
+            chan->init(&m_timebase, m_config.session_counter_seed);
+            chan->m_request_sink.init(this, chan);
+            chan->m_comm_handler.set_request_sink(&chan->m_request_sink);
+
+            // If there's an init error with a comm handler, we disable as well.
+            if (!chan->m_comm_handler.is_enabled())
+            {
+                m_enabled = false;
+            }
         }
 
-        // If there's an init error with the comm handler, we disable as well.
-        if (!m_comm_handler.is_enabled())
+        if (!m_enabled)
         {
-            m_enabled = false;
+            for (uint8_t i = 0; i < channel_count(); i++)
+            {
+                CommChannel *const chan = channel(i);
+                if (chan != nullptr)
+                {
+                    chan->m_comm_handler.disable();
+                }
+            }
         }
 
         for (uint16_t i = 0; i < m_config.m_loop_count; i++)
@@ -61,7 +97,14 @@ namespace scrutiny
         }
 
 #if SCRUTINY_ENABLE_DATALOGGING
-        m_datalogging.datalogger.init(this, &m_timebase, m_config.m_datalogger_buffer, m_config.m_datalogger_buffer_size, m_config.m_datalogger_trigger_callback);
+        if (m_config.m_datalogger_storage != nullptr)
+        {
+            m_datalogging.datalogger.init(this, &m_timebase, m_config.m_datalogger_storage, m_config.m_datalogger_trigger_callback);
+        }
+        else
+        {
+            m_datalogging.datalogger.init(this, &m_timebase, m_config.m_datalogger_buffer, m_config.m_datalogger_buffer_size, m_config.m_datalogger_trigger_callback);
+        }
         m_datalogging.owner = nullptr;
         m_datalogging.new_owner = nullptr;
         m_datalogging.error = DataloggingError::NoError;
@@ -70,12 +113,95 @@ namespace scrutiny
         m_datalogging.pending_ownership_release = false;
         m_datalogging.request_disarm_trigger = false;
         m_datalogging.reading_in_progress = false;
+        m_datalogging.read_channel = nullptr;
+        m_datalogging.streaming_channel = nullptr;
         m_datalogging.read_acquisition_rolling_counter = 0;
+        m_datalogging.burst_channel = nullptr;
+        m_datalogging.burst_frames_per_ack = 0;
+        m_datalogging.burst_frame_counter = 0;
 
         m_datalogging.threadsafe_data.datalogger_state = m_datalogging.datalogger.get_state();
         m_datalogging.threadsafe_data.bytes_to_acquire_from_trigger_to_completion = 0;
         m_datalogging.threadsafe_data.write_counter_since_trigger = 0;
 #endif
+        compute_config_fingerprint();
+    }
+
+    /// @brief Hashes the device description that the server reads when it connects: software ID, features, buffer sizes,
+    /// memory regions, RPVs, loops and datalogging setup. Fields are hashed in a fixed size, big endian form so that
+    /// the hash does not depend on the memory layout of the configuration.
+    void MainHandler::compute_config_fingerprint(void)
+    {
+        uint8_t buf[2 * sizeof(uintptr_t)];
+        uint32_t crc = tools::crc32(software_id, SCRUTINY_SOFTWARE_ID_LENGTH);
+
+        buf[0] = SCRUTINY_PROTOCOL_VERSION_MAJOR(SCRUTINY_ACTUAL_PROTOCOL_VERSION);
+        buf[1] = SCRUTINY_PROTOCOL_VERSION_MINOR(SCRUTINY_ACTUAL_PROTOCOL_VERSION);
+        buf[2] = static_cast<uint8_t>(sizeof(void *));
+        buf[3] = static_cast<uint8_t>((m_config.memory_write_enable ? 0x01u : 0u) | (m_config.is_user_command_callback_set() ? 0x02u : 0u) |
+                                      (m_config.response_streaming ? 0x04u : 0u) | (SCRUTINY_SUPPORT_64BITS ? 0x08u : 0u));
+        crc = tools::crc32(buf, 4, crc);
+
+        codecs::encode_16_bits_big_endian(m_config.m_rx_buffer_size, &buf[0]);
+        codecs::encode_16_bits_big_endian(m_config.m_tx_buffer_size, &buf[2]);
+        crc = tools::crc32(buf, 4, crc);
+        codecs::encode_32_bits_big_endian(m_config.max_bitrate, &buf[0]);
+        crc = tools::crc32(buf, 4, crc);
+
+        buf[0] = m_config.readonly_ranges_count();
+        buf[1] = m_config.forbidden_ranges_count();
+        crc = tools::crc32(buf, 2, crc);
+        for (uint8_t i = 0; i < m_config.readonly_ranges_count(); i++)
+        {
+            uint8_t size = codecs::encode_address_big_endian(m_config.readonly_ranges()[i].start, &buf[0]);
+            size = static_cast<uint8_t>(size + codecs::encode_address_big_endian(m_config.readonly_ranges()[i].end, &buf[size]));
+            crc = tools::crc32(buf, size, crc);
+        }
+        for (uint8_t i = 0; i < m_config.forbidden_ranges_count(); i++)
+        {
+            uint8_t size = codecs::encode_address_big_endian(m_config.forbidden_ranges()[i].start, &buf[0]);
+            size = static_cast<uint8_t>(size + codecs::encode_address_big_endian(m_config.forbidden_ranges()[i].end, &buf[size]));
+            crc = tools::crc32(buf, size, crc);
+        }
+
+        RuntimePublishedValue const *const rpvs = m_config.get_rpvs_array();
+        codecs::encode_16_bits_big_endian(m_config.get_rpv_count(), &buf[0]);
+        crc = tools::crc32(buf, 2, crc);
+        for (uint16_t i = 0; i < m_config.get_rpv_count(); i++)
+        {
+            codecs::encode_16_bits_big_endian(rpvs[i].id, &buf[0]);
+            buf[2] = static_cast<uint8_t>(rpvs[i].type);
+            crc = tools::crc32(buf, 3, crc);
+        }
+
+        buf[0] = m_config.m_loop_count;
+        crc = tools::crc32(buf, 1, crc);
+        for (uint8_t i = 0; i < m_config.m_loop_count; i++)
+        {
+            LoopHandler const *const loop = m_config.m_loops[i];
+            buf[0] = static_cast<uint8_t>(loop->loop_type());
+#if SCRUTINY_ENABLE_DATALOGGING
+            buf[1] = loop->datalogging_allowed() ? 1 : 0;
+#else
+            buf[1] = 0;
+#endif
+            codecs::encode_32_bits_big_endian((loop->loop_type() == LoopType::FIXED_FREQ) ? loop->get_timestep_100ns() : 0, &buf[2]);
+            crc = tools::crc32(buf, 6, crc);
+            char const *const loop_name = loop->get_name();
+            uint8_t const loop_name_length = static_cast<uint8_t>(tools::strnlen(loop_name, protocol::MAX_LOOP_NAME_LENGTH));
+            buf[0] = loop_name_length;
+            crc = tools::crc32(buf, 1, crc);
+            crc = tools::crc32(reinterpret_cast<uint8_t const *>(loop_name), loop_name_length, crc);
+        }
+
+#if SCRUTINY_ENABLE_DATALOGGING
+        buf[0] = (m_config.is_datalogging_configured() && m_config.has_at_least_one_loop_with_datalogging()) ? 1 : 0;
+        buf[1] = static_cast<uint8_t>(m_datalogging.datalogger.get_encoder()->get_encoding());
+        buf[2] = SCRUTINY_DATALOGGING_MAX_SIGNAL;
+        codecs::encode_32_bits_big_endian(static_cast<uint32_t>(m_datalogging.datalogger.get_buffer_size()), &buf[3]);
+        crc = tools::crc32(buf, 7, crc);
+#endif
+        m_config_fingerprint = crc;
     }
 
     void MainHandler::check_config()
@@ -91,6 +217,32 @@ namespace scrutiny
             m_enabled = false;
         }
 
+        if (m_config.m_additional_channel_count > Config::MAX_ADDITIONAL_COMM_CHANNELS)
+        {
+            m_enabled = false;
+        }
+
+        // The ring is drained in chunks cut wherever the interrupt left it. Datagram boundaries would be lost
+        if (m_config.m_receive_ring != nullptr && m_config.m_datagram_mtu != 0)
+        {
+            m_enabled = false;
+        }
+
+        for (uint8_t i = 1; i < channel_count(); i++)
+        {
+            CommChannel const *const chan = m_config.m_additional_channels[i - 1];
+            if (chan == nullptr || chan == &m_main_channel)
+            {
+                m_enabled = false;
+                break;
+            }
+
+            if (!chan->is_buffer_set() || chan->m_rx_buffer == m_config.m_rx_buffer || chan->m_tx_buffer == m_config.m_tx_buffer)
+            {
+                m_enabled = false;
+            }
+        }
+
         for (uint32_t i = 0; i < m_config.m_rpv_count; i++)
         {
             if (!tools::is_supported_type(m_config.m_rpvs[i].type))
@@ -100,6 +252,21 @@ namespace scrutiny
         }
     }
 
+    CommChannel *MainHandler::channel(uint8_t const index)
+    {
+        if (index == 0)
+        {
+            return &m_main_channel;
+        }
+
+        if (index > m_config.m_additional_channel_count)
+        {
+            return nullptr;
+        }
+
+        return m_config.m_additional_channels[index - 1];
+    }
+
 #if SCRUTINY_ENABLE_DATALOGGING
 
     bool MainHandler::read_memory(void *dst, void const *const src, uint32_t const size) const
@@ -137,139 +304,27 @@ namespace scrutiny
         AnyType *const val,
         VariableType *const output_type) const
     {
-        bool success = true;
-        uint_fast8_t const fetch_required_size = ((bitoffset + bitsize - 1) >> 3) + 1;
-        uint_fast8_t const output_required_size = ((bitsize - 1) >> 3) + 1;
-        VariableTypeSize const fetch_type_size = tools::get_required_type_size(fetch_required_size);
-        VariableTypeSize const output_type_size = tools::get_required_type_size(output_required_size);
-        VariableType const fetch_variable_type = tools::make_type(VariableTypeType::_uint, fetch_type_size);
-        VariableType const output_variable_type = tools::make_type(var_tt, output_type_size);
-
-        if (touches_forbidden_region(addr, tools::get_type_size(fetch_type_size)))
-        {
-            success = false;
-        }
-        else if (bitsize == 0)
-        {
-            success = false;
-        }
-        else if (var_tt == VariableTypeType::_sint || var_tt == VariableTypeType::_uint || var_tt == VariableTypeType::_boolean)
-        {
-            success = fetch_variable(addr, fetch_variable_type, val);
-            if (success)
-            {
-                if (fetch_type_size == VariableTypeSize::_8)
-                {
-                    val->uint8 >>= bitoffset;
-                }
-                else if (fetch_type_size == VariableTypeSize::_16)
-                {
-                    val->uint16 >>= bitoffset;
-                }
-                else if (fetch_type_size == VariableTypeSize::_32)
-                {
-                    val->uint32 >>= bitoffset;
-                }
-#if SCRUTINY_SUPPORT_64BITS
-                else if (fetch_type_size == VariableTypeSize::_64)
-                {
-                    val->uint64 >>= bitoffset;
-                }
-#endif
-                else // Unsupported
-                {
-                    success = false;
-                }
-
-                if (success)
-                {
-                    AnyTypeFast mask;
-                    uint_fast8_t i;
-                    if (output_type_size == VariableTypeSize::_8)
-                    {
-                        mask.uint8 = 1;
-                        for (i = 1; i < bitsize; i++)
-                        {
-                            mask.uint8 |= (static_cast<uint_fast8_t>(1) << i);
-                        }
-                        val->uint8 &= mask.uint8;
-                        if (var_tt == VariableTypeType::_sint)
-                        {
-                            if (val->uint8 >> (bitsize - 1))
-                            {
-                                val->uint8 |= (~mask.uint8);
-                            }
-                        }
-                    }
-                    else if (output_type_size == VariableTypeSize::_16)
-                    {
-                        mask.uint16 = 0x1FF;
-                        for (i = 9; i < bitsize; i++)
-                        {
-                            mask.uint16 |= (static_cast<uint_fast16_t>(1) << i);
-                        }
-                        val->uint16 &= mask.uint16;
-                        if (var_tt == VariableTypeType::_sint)
-                        {
-                            if (val->uint16 >> (bitsize - 1))
-                            {
-                                val->uint16 |= (~mask.uint16);
-                            }
-                        }
-                    }
-                    else if (output_type_size == VariableTypeSize::_32)
-                    {
-                        mask.uint32 = 0x1FFFF;
-                        for (i = 17; i < bitsize; i++)
-                        {
-                            mask.uint32 |= (static_cast<uint_fast32_t>(1) << i);
-                        }
-                        val->uint32 &= mask.uint32;
-                        if (var_tt == VariableTypeType::_sint)
-                        {
-                            if (val->uint32 >> (bitsize - 1))
-                            {
-                                val->uint32 |= (~mask.uint32);
-                            }
-                        }
-                    }
-#if SCRUTINY_SUPPORT_64BITS
-                    else if (output_type_size == VariableTypeSize::_64)
-                    {
-                        mask.uint64 = 0x1FFFFFFFF;
-                        for (i = 33; i < bitsize; i++)
-                        {
-                            mask.uint64 |= (static_cast<uint_fast64_t>(1) << i);
-                        }
-                        val->uint64 &= mask.uint64;
-                        if (var_tt == VariableTypeType::_sint)
-                        {
-                            if (val->uint64 >> (bitsize - 1))
-                            {
-                                val->uint64 |= (~mask.uint64);
-                            }
-                        }
-                    }
-#endif
-                    else // Unsupported
-                    {
-                        success = false;
-                    }
-                }
-            }
-        }
+        tools::BitfieldDescriptor descriptor;
+        tools::make_bitfield_descriptor(var_tt, bitoffset, bitsize, &descriptor);
+        return fetch_variable_bitfield(addr, &descriptor, val, output_type);
+    }
 
-        if (!success)
+    bool MainHandler::fetch_variable_bitfield(
+        void const *const addr,
+        tools::BitfieldDescriptor const *const descriptor,
+        AnyType *const val,
+        VariableType *const output_type) const
+    {
+        if (descriptor->extract == nullptr || touches_forbidden_region(addr, descriptor->fetch_size))
         {
             *output_type = VariableType::unknown;
             memset(val, 0, sizeof(AnyType));
-        }
-        else
-        {
-            *output_type = output_variable_type;
+            return false;
         }
 
-        return success;
+        tools::extract_bitfield(addr, descriptor, val);
+        *output_type = descriptor->output_type;
+        return true;
     }
 
     void MainHandler::process_datalogging_loop_msg(LoopHandler *const sender, LoopHandler::Loop2MainMessage *const msg)
@@ -312,7 +367,7 @@ namespace scrutiny
             break;
         }
     }
-    
+
     void MainHandler::process_datalogging_logic(void)
     {
         if (m_datalogging.error != DataloggingError::NoError)
@@ -368,6 +423,130 @@ namespace scrutiny
         }
     }
 
+    void MainHandler::process_datalogging_burst(void)
+    {
+        CommChannel *const channel = m_datalogging.burst_channel;
+        if (channel == nullptr || channel->m_processing_request) // Nothing to do or previous frame not drained yet
+        {
+            return;
+        }
+
+        protocol::CommHandler *const comm = &channel->m_comm_handler;
+        // A lost session or any other read of the acquisition stops the burst.
+        if (!m_datalogging.reading_in_progress || !datalogging_data_available() || !comm->is_connected())
+        {
+            m_datalogging.burst_channel = nullptr;
+            return;
+        }
+
+        // A heartbeat is answered between two frames. Any other request from the server stops the burst.
+        if (comm->receiving() || comm->request_received())
+        {
+            if (comm->request_received())
+            {
+                protocol::Request const *const request = comm->get_request();
+                bool const heartbeat = (request->command_id == static_cast<uint8_t>(protocol::CommandId::CommControl)) &&
+                                       (request->subfunction_id == static_cast<uint8_t>(protocol::CommControl::Subfunction::Heartbeat));
+                if (!heartbeat)
+                {
+                    m_datalogging.burst_channel = nullptr;
+                }
+            }
+            return;
+        }
+
+        if (m_datalogging.burst_frames_per_ack != 0 && m_datalogging.burst_frame_counter >= m_datalogging.burst_frames_per_ack)
+        {
+            m_datalogging.burst_channel = nullptr; // Wait for the server acknowledgement before continuing.
+            return;
+        }
+
+        m_active_channel = channel;
+        protocol::Response *const response = comm->prepare_response();
+        response->command_id = static_cast<uint8_t>(protocol::CommandId::DataLogControl);
+        response->subfunction_id = static_cast<uint8_t>(protocol::DataLogControl::Subfunction::ReadAcquisitionBurst);
+        protocol::ResponseCode const code = encode_datalogging_acquisition_frame(response);
+        response->response_code = static_cast<uint8_t>(code);
+        if (code != protocol::ResponseCode::OK)
+        {
+            response->data_length = 0;
+        }
+        comm->send_response(response);
+        channel->m_processing_request = true;
+        m_active_channel = nullptr;
+
+        // The server drained the previous frame, so it is alive. Without flow control, it may have no chance to send a heartbeat before the burst ends.
+        comm->keep_alive();
+        m_datalogging.burst_frame_counter++;
+        if (!m_datalogging.reading_in_progress)
+        {
+            m_datalogging.burst_channel = nullptr; // Finished or failed
+        }
+    }
+
+    void MainHandler::start_datalogging_read(datalogging::ReadLayout const layout)
+    {
+        m_datalogging.datalogger.get_reader()->set_layout(layout); // Resets the reader
+        m_datalogging.reading_in_progress = true;
+        m_datalogging.read_channel = m_active_channel;
+        m_datalogging.read_acquisition_rolling_counter = 0;
+        m_datalogging.read_acquisition_crc = 0;
+    }
+
+    /// @brief The reader, its rolling counter and its CRC exist once. A channel reading the acquisition keeps them until the read
+    /// finishes, fails or its session ends, and until its last streamed frame is sent. Returns true if the channel of the request being processed must wait.
+    bool MainHandler::datalogging_read_owned_by_other_channel(void) const
+    {
+        if (datalogging_stream_in_flight())
+        {
+            return true; // Even if that was the last frame, the data is still being read
+        }
+
+        if (!m_datalogging.reading_in_progress || m_datalogging.read_channel == nullptr || m_datalogging.read_channel == m_active_channel)
+        {
+            return false;
+        }
+
+        return m_datalogging.read_channel->m_comm_handler.is_connected();
+    }
+
+    /// @brief A streamed acquisition frame reads the storage and updates the acquisition CRC while it is transmitted, after process_request()
+    /// returned. Returns true if another channel's frame is still in flight, in which case the reader and the datalogger must be left untouched.
+    bool MainHandler::datalogging_stream_in_flight(void) const
+    {
+        return m_datalogging.streaming_channel != nullptr && m_datalogging.streaming_channel != m_active_channel;
+    }
+
+    protocol::ResponseCode MainHandler::encode_datalogging_acquisition_frame(protocol::Response *const response, uint16_t const streamed_max_size)
+    {
+        protocol::ResponseData::DataLogControl::ReadAcquisition response_data;
+        response_data.acquisition_id = m_datalogging.datalogger.get_acquisition_id();
+        response_data.reader = m_datalogging.datalogger.get_reader();
+        response_data.rolling_counter = m_datalogging.read_acquisition_rolling_counter;
+        response_data.crc = &m_datalogging.read_acquisition_crc;
+
+        bool finished = false;
+        protocol::ResponseCode code = protocol::ResponseCode::OK;
+        if (streamed_max_size == 0)
+        {
+            code = m_codec.encode_response_datalogging_read_acquisition(&response_data, response, &finished);
+        }
+        else
+        {
+            response->data_length = m_active_channel->m_acquisition_streamer.init(&response_data, streamed_max_size, &finished);
+            m_active_channel->m_response_source = &m_active_channel->m_acquisition_streamer;
+            m_datalogging.streaming_channel = m_active_channel; // The reader and the CRC are used until the frame is sent
+        }
+        m_datalogging.read_acquisition_rolling_counter++;
+
+        if (code != protocol::ResponseCode::OK || finished)
+        {
+            m_datalogging.reading_in_progress = false;
+        }
+
+        return code;
+    }
+
 #endif
 
     void MainHandler::process_loops(void)
@@ -378,7 +557,15 @@ namespace scrutiny
             if (loop->ipc_loop2main()->has_content())
             {
                 LoopHandler::Loop2MainMessage msg = loop->ipc_loop2main()->pop();
-                static_cast<void>(msg);
+                if (msg.message_id == LoopHandler::Loop2MainMessageID::STAGED_WRITES_APPLIED)
+                {
+                    if (m_staged_write.state == StagedWriteState::Pending)
+                    {
+                        m_staged_write.success = msg.data.staged_writes_applied.success;
+                        m_staged_write.state = StagedWriteState::Completed;
+                    }
+                    continue;
+                }
 #if SCRUTINY_ENABLE_DATALOGGING
                 process_datalogging_loop_msg(loop, &msg);
 #endif
@@ -388,86 +575,215 @@ namespace scrutiny
 
     void MainHandler::process(timediff_t const timestep_100ns)
     {
+        process(timestep_100ns, 0);
+    }
+
+    void MainHandler::process(timediff_t const timestep_100ns, uint32_t const budget)
+    {
+        m_budget = budget;
+        m_budget_limited = (budget != 0);
+        m_timestep_100ns = timestep_100ns;
         if (!m_enabled)
         {
-            m_processing_request = false;
-            m_disconnect_pending = false;
-            m_comm_handler.reset();
+            for (uint8_t i = 0; i < channel_count(); i++)
+            {
+                CommChannel *const chan = channel(i);
+                if (chan != nullptr)
+                {
+                    chan->reset();
+                }
+            }
 #if SCRUTINY_ENABLE_DATALOGGING
             m_datalogging.datalogger.reset();
 #endif
             return;
         }
         m_timebase.step(timestep_100ns);
-        m_comm_handler.process();
+        if (m_config.m_receive_ring != nullptr)
+        {
+            // 2 chunks when the ring wraps around. Bytes pushed in the meantime wait for the next call so that the work stays bounded.
+            for (uint8_t i = 0; i < 2; i++)
+            {
+                uint8_t const *data = nullptr;
+                uint16_t const len = m_config.m_receive_ring->peek(&data);
+                if (len == 0)
+                {
+                    break;
+                }
+                m_main_channel.m_comm_handler.receive_data(data, len);
+                m_config.m_receive_ring->release(len);
+            }
+        }
+
+        uint8_t const nchannels = channel_count();
+        for (uint8_t i = 0; i < nchannels; i++)
+        {
+            CommChannel *const chan = channel(i);
+            chan->m_comm_handler.process();
+            if (chan->pending_request_lost())
+            {
+                drop_lost_request(chan);
+            }
+        }
+
         process_loops();
 #if SCRUTINY_ENABLE_DATALOGGING
         process_datalogging_logic();
+        if (m_config.m_datalogger_storage != nullptr)
+        {
+            m_config.m_datalogger_storage->process();
+        }
 #endif
 
-        if (m_comm_handler.request_received() && !m_processing_request)
+        // Serve a single request per call, starting from the channel next to the one last served so that
+        // a busy channel cannot starve the others.
+        if (m_next_channel_index >= nchannels)
         {
-            protocol::Response *response = m_comm_handler.prepare_response();
-            process_request(m_comm_handler.get_request(), response);
+            m_next_channel_index = 0;
+        }
 
-            if (static_cast<protocol::ResponseCode>(response->response_code) == protocol::ResponseCode::ProcessAgain)
+        for (uint8_t i = 0; i < nchannels; i++)
+        {
+            uint8_t const index = static_cast<uint8_t>((m_next_channel_index + i) % nchannels);
+            if (process_channel(channel(index)))
             {
-                m_processing_request = false;
-                if (!m_process_again_timestamp_taken)
-                {
-                    m_process_again_timestamp = m_timebase.get_timestamp();
-                    m_process_again_timestamp_taken = true;
-                }
-                else
+                m_next_channel_index = static_cast<uint8_t>((index + 1u) % nchannels);
+                break;
+            }
+        }
+
+        for (uint8_t i = 0; i < nchannels; i++)
+        {
+            channel(i)->check_finished_sending();
+        }
+#if SCRUTINY_ENABLE_DATALOGGING
+        if (m_datalogging.streaming_channel != nullptr && !m_datalogging.streaming_channel->m_processing_request)
+        {
+            m_datalogging.streaming_channel = nullptr; // Frame sent, or dropped with the session
+        }
+        process_datalogging_burst();
+#endif
+
+        // Some commands affect loops and datalogging, so we reprocess right away
+        process_loops();
+#if SCRUTINY_ENABLE_DATALOGGING
+        process_datalogging_logic();
+#endif
+    }
+
+    bool MainHandler::process_channel(CommChannel *const channel)
+    {
+        if (!channel->m_comm_handler.request_received() || channel->m_processing_request)
+        {
+            return false;
+        }
+
+        m_active_channel = channel;
+        channel->m_response_source = nullptr;
+        protocol::Response *response = channel->m_comm_handler.prepare_response();
+        process_request(channel->m_comm_handler.get_request(), response);
+
+        if (static_cast<protocol::ResponseCode>(response->response_code) == protocol::ResponseCode::ProcessAgain)
+        {
+            channel->m_processing_request = false;
+            if (!channel->m_process_again_timestamp_taken)
+            {
+                channel->m_process_again_timestamp = m_timebase.get_timestamp();
+                channel->m_process_again_session_id = channel->m_comm_handler.get_session_id();
+                channel->m_process_again_timestamp_taken = true;
+            }
+            else
+            {
+                // A pending User Command has its own timeout, as it can be much longer than any other request.
+                bool const user_command = m_user_command.pending && m_user_command.owner == channel;
+                timediff_t const timeout_100ns = user_command ? m_config.get_user_command_timeout() : SCRUTINY_REQUEST_MAX_PROCESS_TIME_US * 10;
+                // Work that cannot be cancelled anymore completes shortly. The response waits for it so that a failure is never reported for something applied.
+                if (m_timebase.has_expired(channel->m_process_again_timestamp, timeout_100ns) && cancel_pending_work(channel))
                 {
-                    if (m_timebase.has_expired(m_process_again_timestamp, SCRUTINY_REQUEST_MAX_PROCESS_TIME_US * 10))
-                    {
-                        // Set only response code. All other fields are set in process_request()
-                        response->response_code = static_cast<uint8_t>(protocol::ResponseCode::FailureToProceed);
-                        m_comm_handler.send_response(response);
-                        m_processing_request = true;
-                    }
+                    // Set only response code. All other fields are set in process_request()
+                    response->response_code = static_cast<uint8_t>(protocol::ResponseCode::FailureToProceed);
+                    channel->m_comm_handler.send_response(response);
+                    channel->m_processing_request = true;
                 }
-                // comm handler will stay in standby until we process the request. Data in rx buffer is guaranteed to stay valid until then
             }
-            else if (static_cast<protocol::ResponseCode>(response->response_code) == protocol::ResponseCode::NoResponseToSend)
+            // comm handler will stay in standby until we process the request. Data in rx buffer is guaranteed to stay valid until then
+        }
+        else if (static_cast<protocol::ResponseCode>(response->response_code) == protocol::ResponseCode::NoResponseToSend)
+        {
+            channel->m_processing_request = true;
+            // Will not be transmitting, therefore automatically wait for next request below
+        }
+        else
+        {
+            channel->m_processing_request = true;
+            if (channel->m_response_source != nullptr && static_cast<protocol::ResponseCode>(response->response_code) == protocol::ResponseCode::OK)
             {
-                m_processing_request = true;
-                // Will not be transmitting, therefore automatically wait for next request below
+                channel->m_comm_handler.send_streamed_response(response, channel->m_response_source);
             }
             else
             {
-                m_processing_request = true;
-                m_comm_handler.send_response(response);
+                channel->m_comm_handler.send_response(response);
             }
         }
 
-        check_finished_sending();
+        m_active_channel = nullptr;
+        return true;
+    }
 
-        // Some commands affect loops and datalogging, so we reprocess right away
-        process_loops();
-#if SCRUTINY_ENABLE_DATALOGGING
-        process_datalogging_logic();
-#endif
+    // Stops what was started for the request of a channel that is answered ProcessAgain, because the request timed out or disappeared.
+    // Returns false if the work cannot be stopped anymore and completes shortly.
+    bool MainHandler::cancel_pending_work(CommChannel *const channel)
+    {
+        if (m_staged_write.owner == channel)
+        {
+            if (m_staged_write.state == StagedWriteState::Pending && !m_staged_write.ticket.redeem(m_staged_write.ticket_number))
+            {
+                return false; // Taken by the loop, which answers at its next iteration
+            }
+            m_staged_write.state = StagedWriteState::Idle;
+            m_staged_write.owner = nullptr;
+        }
+
+        if (m_sliced_write.owner == channel)
+        {
+            return false; // Partially written. Completes in the next calls
+        }
+
+        if (m_user_command.owner == channel)
+        {
+            m_user_command.owner = nullptr; // The command keeps running. Its completion will be dropped.
+        }
+
+        return true;
     }
 
-    void MainHandler::check_finished_sending(void)
+    // The request answered ProcessAgain is gone because the session ended or the comm handler was reset. Nobody waits for its response anymore.
+    void MainHandler::drop_lost_request(CommChannel *const channel)
     {
-        if (m_processing_request)
+        if (!cancel_pending_work(channel))
         {
-            if (!m_comm_handler.transmitting()) // Will be false if NoResponseToSend or if finished transmitting
+            if (m_staged_write.owner == channel)
             {
-                m_comm_handler.wait_next_request(); // Allow reception of next request
-                m_processing_request = false;
-                m_process_again_timestamp_taken = false;
+                m_staged_write.owner = nullptr; // The loop completes the transaction. Its result is dropped by the next WriteStaged
+            }
 
-                if (m_disconnect_pending)
-                {
-                    m_comm_handler.disconnect();
-                    m_disconnect_pending = false;
-                }
+            if (m_sliced_write.owner == channel)
+            {
+                m_sliced_write.owner = nullptr; // The request data is not valid anymore. The write stays partially applied
             }
         }
+        channel->m_process_again_timestamp_taken = false;
+    }
+
+    // Biggest response payload that can be produced while transmitting on the active channel. 0 if streaming is not possible
+    uint16_t MainHandler::max_streamed_response_size(void) const
+    {
+        if (!m_config.response_streaming)
+        {
+            return 0;
+        }
+
+        return m_active_channel->m_comm_handler.max_streamed_data_size();
     }
 
     bool MainHandler::rpv_exists(uint16_t const id) const
@@ -609,6 +925,18 @@ namespace scrutiny
                 protocol::ResponseData::GetInfo::GetLoopDefinition response_data;
             } get_loop_def;
 
+            struct
+            {
+                protocol::ResponseData::GetInfo::GetConfigFingerprint response_data;
+            } get_config_fingerprint;
+
+            struct
+            {
+                protocol::RequestData::GetInfo::GetDeviceDescription request_data;
+                protocol::DeviceDescriptionResponseEncoder *response_encoder;
+                uint32_t item_count;
+            } get_device_description;
+
         } stack;
 
         protocol::ResponseCode code = protocol::ResponseCode::FailureToProceed;
@@ -633,19 +961,7 @@ namespace scrutiny
             // =========== [GetSupportedFeatures] ==========
         case protocol::GetInfo::Subfunction::GetSupportedFeatures:
         {
-            stack.get_supported_features.response_data.memory_write = m_config.memory_write_enable;
-#if SCRUTINY_ENABLE_DATALOGGING
-            stack.get_supported_features.response_data.datalogging = m_config.is_datalogging_configured() && m_config.has_at_least_one_loop_with_datalogging();
-#else
-            stack.get_supported_features.response_data.datalogging = false;
-#endif
-            stack.get_supported_features.response_data.user_command = m_config.is_user_command_callback_set();
-#if SCRUTINY_SUPPORT_64BITS
-            stack.get_supported_features.response_data._64bits = true;
-#else
-            stack.get_supported_features.response_data._64bits = false;
-#endif
-
+            fill_supported_features(&stack.get_supported_features.response_data);
             code = m_codec.encode_response_supported_features(&stack.get_supported_features.response_data, response);
             break;
         }
@@ -733,7 +1049,7 @@ namespace scrutiny
                 break;
             }
 
-            stack.get_prv_def.response_encoder = m_codec.encode_response_get_rpv_definition(response, m_comm_handler.tx_buffer_size());
+            stack.get_prv_def.response_encoder = m_codec.encode_response_get_rpv_definition(response, m_active_channel->m_comm_handler.tx_buffer_size());
 
             if (stack.get_prv_def.request_data.start_index >= m_config.get_rpv_count())
             {
@@ -779,36 +1095,188 @@ namespace scrutiny
                 break;
             }
 
-            const LoopType loop_type = m_config.m_loops[loop_id]->loop_type();
-            stack.get_loop_def.response_data.loop_id = loop_id;
-            stack.get_loop_def.response_data.loop_type = static_cast<uint8_t>(loop_type);
+            fill_loop_definition(loop_id, &stack.get_loop_def.response_data);
+            code = m_codec.encode_response_get_loop_definition(&stack.get_loop_def.response_data, response);
+            break;
+        }
+
+        case protocol::GetInfo::Subfunction::GetConfigFingerprint:
+        {
+            stack.get_config_fingerprint.response_data.fingerprint = m_config_fingerprint;
+            code = m_codec.encode_response_get_config_fingerprint(&stack.get_config_fingerprint.response_data, response);
+            break;
+        }
+
+        case protocol::GetInfo::Subfunction::GetDeviceDescription:
+        {
+            code = m_codec.decode_request_get_device_description(request, &stack.get_device_description.request_data);
+            if (code != protocol::ResponseCode::OK)
+            {
+                break;
+            }
+
+            stack.get_device_description.item_count = device_description_item_count();
+            uint32_t item = stack.get_device_description.request_data.cursor;
+            if (item >= stack.get_device_description.item_count)
+            {
+                code = protocol::ResponseCode::FailureToProceed;
+                break;
+            }
+
+            stack.get_device_description.response_encoder = m_codec.encode_response_get_device_description(response, m_active_channel->m_comm_handler.tx_buffer_size());
+            // Packs as many items as the transmit buffer can take. The client asks for the rest with the returned cursor
+            while (item < stack.get_device_description.item_count)
+            {
+                if (!write_device_description_item(stack.get_device_description.response_encoder, item))
+                {
+                    break;
+                }
+                item++;
+            }
+
+            if (stack.get_device_description.response_encoder->empty()) // A single item doesn't fit the transmit buffer
+            {
+                code = protocol::ResponseCode::Overflow;
+                break;
+            }
+
+            stack.get_device_description.response_encoder->finish(item == stack.get_device_description.item_count, item);
+            break;
+        }
+
+        default:
+        {
+            code = protocol::ResponseCode::UnsupportedFeature;
+            break;
+        }
+        }
+
+        return code;
+    }
+
+    void MainHandler::fill_supported_features(protocol::ResponseData::GetInfo::GetSupportedFeatures *const features) const
+    {
+        features->memory_write = m_config.memory_write_enable;
 #if SCRUTINY_ENABLE_DATALOGGING
-            stack.get_loop_def.response_data.support_datalogging = m_config.m_loops[loop_id]->datalogging_allowed();
+        features->datalogging = m_config.is_datalogging_configured() && m_config.has_at_least_one_loop_with_datalogging();
 #else
-            stack.get_loop_def.response_data.support_datalogging = false;
+        features->datalogging = false;
 #endif
-            if (loop_type == LoopType::FIXED_FREQ)
-            {
-                stack.get_loop_def.response_data.loop_type_specific.fixed_freq.timestep_100ns = m_config.m_loops[loop_id]->get_timestep_100ns();
-            }
+        features->user_command = m_config.is_user_command_callback_set();
+#if SCRUTINY_SUPPORT_64BITS
+        features->_64bits = true;
+#else
+        features->_64bits = false;
+#endif
+    }
+
+    void MainHandler::fill_loop_definition(uint8_t const loop_id, protocol::ResponseData::GetInfo::GetLoopDefinition *const definition) const
+    {
+        const LoopType loop_type = m_config.m_loops[loop_id]->loop_type();
+        definition->loop_id = loop_id;
+        definition->loop_type = static_cast<uint8_t>(loop_type);
+#if SCRUTINY_ENABLE_DATALOGGING
+        definition->support_datalogging = m_config.m_loops[loop_id]->datalogging_allowed();
+#else
+        definition->support_datalogging = false;
+#endif
+        if (loop_type == LoopType::FIXED_FREQ)
+        {
+            definition->loop_type_specific.fixed_freq.timestep_100ns = m_config.m_loops[loop_id]->get_timestep_100ns();
+        }
+
+        char const *const loop_name = m_config.m_loops[loop_id]->get_name();
+        definition->loop_name_length = static_cast<uint8_t>(tools::strnlen(loop_name, protocol::MAX_LOOP_NAME_LENGTH));
+        definition->loop_name = loop_name;
+    }
+
+    /// @brief Number of items in the device description: version, software id, features, fingerprint, region count,
+    /// each memory region, RPV count, each RPV, loop count, each loop
+    uint32_t MainHandler::device_description_item_count(void) const
+    {
+        return 5u + m_config.readonly_ranges_count() + m_config.forbidden_ranges_count() + 1u + m_config.get_rpv_count() + 1u + m_config.m_loop_count;
+    }
+
+    /// @brief Writes a single item of the device description. Returns false if it doesn't fit the response
+    bool MainHandler::write_device_description_item(protocol::DeviceDescriptionResponseEncoder *const encoder, uint32_t item) const
+    {
+        union
+        {
+            protocol::ResponseData::GetInfo::GetProtocolVersion version;
+            protocol::ResponseData::GetInfo::GetSupportedFeatures features;
+            protocol::ResponseData::GetInfo::GetConfigFingerprint fingerprint;
+            protocol::ResponseData::GetInfo::GetSpecialMemoryRegionCount region_count;
+            protocol::ResponseData::GetInfo::GetSpecialMemoryRegionLocation region_location;
+            protocol::ResponseData::GetInfo::GetRPVCount rpv_count;
+            protocol::ResponseData::GetInfo::GetLoopCount loop_count;
+            protocol::ResponseData::GetInfo::GetLoopDefinition loop_definition;
+        } data;
+
+        switch (item)
+        {
+        case 0:
+            data.version.major = SCRUTINY_PROTOCOL_VERSION_MAJOR(SCRUTINY_ACTUAL_PROTOCOL_VERSION);
+            data.version.minor = SCRUTINY_PROTOCOL_VERSION_MINOR(SCRUTINY_ACTUAL_PROTOCOL_VERSION);
+            return encoder->write_protocol_version(&data.version);
+        case 1:
+            return encoder->write_software_id();
+        case 2:
+            fill_supported_features(&data.features);
+            return encoder->write_supported_features(&data.features);
+        case 3:
+            data.fingerprint.fingerprint = m_config_fingerprint;
+            return encoder->write_config_fingerprint(&data.fingerprint);
+        case 4:
+            data.region_count.nbr_readonly_region = m_config.readonly_ranges_count();
+            data.region_count.nbr_forbidden_region = m_config.forbidden_ranges_count();
+            return encoder->write_special_memory_region_count(&data.region_count);
+        default:
+            break;
+        }
+        item -= 5;
 
-            char const *const loop_name = m_config.m_loops[loop_id]->get_name();
-            uint8_t const loop_name_length = static_cast<uint8_t>(tools::strnlen(loop_name, protocol::MAX_LOOP_NAME_LENGTH));
-            stack.get_loop_def.response_data.loop_name_length = loop_name_length;
-            stack.get_loop_def.response_data.loop_name = loop_name;
+        if (item < m_config.readonly_ranges_count())
+        {
+            data.region_location.region_type = static_cast<uint8_t>(protocol::GetInfo::MemoryRegionType::ReadOnly);
+            data.region_location.region_index = static_cast<uint8_t>(item);
+            data.region_location.start = reinterpret_cast<uintptr_t>(m_config.readonly_ranges()[item].start);
+            data.region_location.end = reinterpret_cast<uintptr_t>(m_config.readonly_ranges()[item].end);
+            return encoder->write_special_memory_region_location(&data.region_location);
+        }
+        item -= m_config.readonly_ranges_count();
 
-            code = m_codec.encode_response_get_loop_definition(&stack.get_loop_def.response_data, response);
-            break;
+        if (item < m_config.forbidden_ranges_count())
+        {
+            data.region_location.region_type = static_cast<uint8_t>(protocol::GetInfo::MemoryRegionType::Forbidden);
+            data.region_location.region_index = static_cast<uint8_t>(item);
+            data.region_location.start = reinterpret_cast<uintptr_t>(m_config.forbidden_ranges()[item].start);
+            data.region_location.end = reinterpret_cast<uintptr_t>(m_config.forbidden_ranges()[item].end);
+            return encoder->write_special_memory_region_location(&data.region_location);
         }
+        item -= m_config.forbidden_ranges_count();
 
-        default:
+        if (item == 0)
         {
-            code = protocol::ResponseCode::UnsupportedFeature;
-            break;
+            data.rpv_count.count = m_config.get_rpv_count();
+            return encoder->write_rpv_count(&data.rpv_count);
         }
+        item -= 1;
+
+        if (item < m_config.get_rpv_count())
+        {
+            return encoder->write_rpv(&m_config.get_rpvs_array()[item]);
         }
+        item -= m_config.get_rpv_count();
 
-        return code;
+        if (item == 0)
+        {
+            data.loop_count.count = m_config.m_loop_count;
+            return encoder->write_loop_count(&data.loop_count);
+        }
+        item -= 1;
+
+        fill_loop_definition(static_cast<uint8_t>(item), &data.loop_definition);
+        return encoder->write_loop_definition(&data.loop_definition);
     }
 
     // ============= [CommControl] ============
@@ -871,20 +1339,20 @@ namespace scrutiny
             if (code != protocol::ResponseCode::OK)
                 break;
 
-            if (stack.heartbeat.request_data.session_id != m_comm_handler.get_session_id())
+            if (stack.heartbeat.request_data.session_id != m_active_channel->m_comm_handler.get_session_id())
             {
                 code = protocol::ResponseCode::InvalidRequest;
                 break;
             }
 
-            bool const success = m_comm_handler.heartbeat(stack.heartbeat.request_data.challenge);
+            bool const success = m_active_channel->m_comm_handler.heartbeat(stack.heartbeat.request_data.challenge);
             if (!success)
             {
                 code = protocol::ResponseCode::InvalidRequest;
                 break;
             }
 
-            stack.heartbeat.response_data.session_id = m_comm_handler.get_session_id();
+            stack.heartbeat.response_data.session_id = m_active_channel->m_comm_handler.get_session_id();
             stack.heartbeat.response_data.challenge_response = ~stack.heartbeat.request_data.challenge;
 
             code = m_codec.encode_response_comm_heartbeat(&stack.heartbeat.response_data, response);
@@ -894,12 +1362,14 @@ namespace scrutiny
             // =========== [GetParams] ==========
         case protocol::CommControl::Subfunction::GetParams:
         {
-            stack.get_params.response_data.data_tx_buffer_size = m_config.m_tx_buffer_size;
-            stack.get_params.response_data.data_rx_buffer_size = m_config.m_rx_buffer_size;
+            stack.get_params.response_data.data_tx_buffer_size = m_active_channel->m_comm_handler.tx_buffer_size(); // Can be smaller than the buffer in datagram mode
+            stack.get_params.response_data.data_rx_buffer_size = m_active_channel->m_rx_buffer_size;
             stack.get_params.response_data.max_bitrate = m_config.max_bitrate;
             stack.get_params.response_data.comm_rx_timeout = SCRUTINY_COMM_RX_TIMEOUT_US;
             stack.get_params.response_data.heartbeat_timeout = SCRUTINY_COMM_HEARTBEAT_TIMEOUT_US;
             stack.get_params.response_data.address_size = sizeof(void *);
+            stack.get_params.response_data.include_streaming = m_config.response_streaming;
+            stack.get_params.response_data.max_streamed_data_size = max_streamed_response_size();
             code = m_codec.encode_response_comm_get_params(&stack.get_params.response_data, response);
             break;
         }
@@ -912,19 +1382,27 @@ namespace scrutiny
                 break;
             }
 
-            if (m_comm_handler.is_connected())
+            if (m_active_channel->m_comm_handler.is_connected())
             {
                 code = protocol::ResponseCode::Busy;
                 break;
             }
 
-            if (m_comm_handler.connect() == false)
+            if (m_active_channel->m_comm_handler.connect() == false)
             {
                 code = protocol::ResponseCode::FailureToProceed;
                 break;
             }
 
-            stack.connect.response_data.session_id = m_comm_handler.get_session_id();
+            // An unsupported framing is not an error. The response tells the server that the raw framing is kept.
+            stack.connect.response_data.framing = static_cast<uint8_t>(protocol::CommControl::Framing::Raw);
+            if (m_active_channel->m_comm_handler.set_framing_after_response(static_cast<protocol::CommControl::Framing>(stack.connect.request_data.framing)))
+            {
+                stack.connect.response_data.framing = stack.connect.request_data.framing;
+            }
+            stack.connect.response_data.include_framing = stack.connect.request_data.framing_requested;
+
+            stack.connect.response_data.session_id = m_active_channel->m_comm_handler.get_session_id();
             memcpy(stack.connect.response_data.magic, protocol::CommControl::CONNECT_MAGIC, sizeof(protocol::CommControl::CONNECT_MAGIC));
             code = m_codec.encode_response_comm_connect(&stack.connect.response_data, response);
             break;
@@ -937,11 +1415,11 @@ namespace scrutiny
             if (code != protocol::ResponseCode::OK)
                 break;
 
-            if (m_comm_handler.is_connected())
+            if (m_active_channel->m_comm_handler.is_connected())
             {
-                if (m_comm_handler.get_session_id() == stack.disconnect.request_data.session_id)
+                if (m_active_channel->m_comm_handler.get_session_id() == stack.disconnect.request_data.session_id)
                 {
-                    m_disconnect_pending = true;
+                    m_active_channel->m_disconnect_pending = true;
                 }
                 else
                 {
@@ -983,8 +1461,8 @@ namespace scrutiny
             struct
             {
                 MemoryBlock block;
-                protocol::WriteMemoryBlocksRequestParser *writemem_parser;
-                protocol::WriteMemoryBlocksResponseEncoder *writemem_encoder;
+                protocol::Request const *request;
+                protocol::Request streamed_request;
             } write_mem;
 
             struct
@@ -1005,6 +1483,14 @@ namespace scrutiny
                 scrutiny::AnyType v;
             } write_rpv;
 
+            struct
+            {
+                protocol::StagedWriteRequestParser *parser;
+                protocol::StagedWriteEntry entry;
+                protocol::ResponseData::MemoryControl::WriteStaged response_data;
+                LoopHandler::Main2LoopMessage msg;
+            } write_staged;
+
         } stack;
 
         switch (static_cast<protocol::MemoryControl::Subfunction>(request->subfunction_id))
@@ -1015,7 +1501,7 @@ namespace scrutiny
             code = protocol::ResponseCode::OK;
 
             stack.read_mem.readmem_parser = m_codec.decode_request_memory_control_read(request);
-            stack.read_mem.readmem_encoder = m_codec.encode_response_memory_control_read(response, m_comm_handler.tx_buffer_size());
+            stack.read_mem.readmem_encoder = m_codec.encode_response_memory_control_read(response, m_active_channel->m_comm_handler.tx_buffer_size());
 
             // We avoid playing in memory unless we are 100% sure the request is good.
             if (!stack.read_mem.readmem_parser->is_valid())
@@ -1024,9 +1510,38 @@ namespace scrutiny
                 break;
             }
 
-            if (stack.read_mem.readmem_parser->required_tx_buffer_size() > m_comm_handler.tx_buffer_size())
+            if (stack.read_mem.readmem_parser->required_tx_buffer_size() > m_active_channel->m_comm_handler.tx_buffer_size())
             {
-                code = protocol::ResponseCode::Overflow;
+                if (stack.read_mem.readmem_parser->required_tx_buffer_size() > max_streamed_response_size())
+                {
+                    code = protocol::ResponseCode::Overflow;
+                    break;
+                }
+
+                // Too big for the transmit buffer. The memory is read while the response is transmitted.
+                while (!stack.read_mem.readmem_parser->finished())
+                {
+                    stack.read_mem.readmem_parser->next(&stack.read_mem.block);
+
+                    if (!stack.read_mem.readmem_parser->is_valid())
+                    {
+                        code = protocol::ResponseCode::InvalidRequest;
+                        break;
+                    }
+
+                    if (touches_forbidden_region(&stack.read_mem.block))
+                    {
+                        code = protocol::ResponseCode::Forbidden;
+                        break;
+                    }
+                }
+
+                if (code == protocol::ResponseCode::OK)
+                {
+                    m_active_channel->m_readmem_streamer.init(request);
+                    m_active_channel->m_response_source = &m_active_channel->m_readmem_streamer;
+                    response->data_length = stack.read_mem.readmem_parser->required_tx_buffer_size();
+                }
                 break;
             }
 
@@ -1070,61 +1585,79 @@ namespace scrutiny
                 break;
             }
 
-            stack.write_mem.writemem_parser = m_codec.decode_request_memory_control_write(request, masked);
-            stack.write_mem.writemem_encoder = m_codec.encode_response_memory_control_write(response, m_comm_handler.tx_buffer_size());
-            if (!stack.write_mem.writemem_parser->is_valid())
+            stack.write_mem.request = request;
+            if (m_active_channel->m_comm_handler.request_streamed())
             {
-                code = protocol::ResponseCode::InvalidRequest;
-                break;
+                // The payload went to the staging buffer while it was received and its block headers were validated on the fly.
+                // Nothing was written yet since the CRC was unknown.
+                if (m_streamed_write.code != protocol::ResponseCode::OK)
+                {
+                    code = m_streamed_write.code;
+                    break;
+                }
+
+                stack.write_mem.streamed_request = *request;
+                stack.write_mem.streamed_request.data = m_config.m_staged_write_buffer;
+                stack.write_mem.streamed_request.data_max_length = m_config.m_staged_write_buffer_size;
+                stack.write_mem.request = &stack.write_mem.streamed_request;
             }
 
-            if (stack.write_mem.writemem_parser->required_tx_buffer_size() > m_comm_handler.tx_buffer_size())
+            if (m_sliced_write.owner != nullptr && m_sliced_write.owner != m_active_channel)
             {
-                code = protocol::ResponseCode::Overflow;
+                code = protocol::ResponseCode::Busy; // Another channel's write is partially applied and cannot be interrupted
                 break;
             }
 
-            while (!stack.write_mem.writemem_parser->finished())
+            // A timestamp is taken on the first ProcessAgain. If taken, this request is being written in slices and resumes where it stopped.
+            if (m_sliced_write.owner != m_active_channel || !m_active_channel->m_process_again_timestamp_taken)
             {
-                stack.write_mem.writemem_parser->next(&stack.write_mem.block);
-
-                if (!stack.write_mem.writemem_parser->is_valid())
+                m_sliced_write.owner = nullptr;
+                code = start_memory_write(stack.write_mem.request, masked, response);
+                if (code != protocol::ResponseCode::OK)
                 {
-                    code = protocol::ResponseCode::InvalidRequest;
                     break;
                 }
+            }
 
-                if (touches_forbidden_region(&stack.write_mem.block))
+            while (true)
+            {
+                MemoryBlock *const remaining = &m_sliced_write.remaining;
+                if (remaining->length == 0)
                 {
-                    code = protocol::ResponseCode::Forbidden;
-                    break;
+                    if (m_sliced_write.parser.finished())
+                    {
+                        break;
+                    }
+                    m_sliced_write.parser.next(remaining);
+                    m_sliced_write.encoder.write(remaining);
+                    // We don't check overflow here as we rely on the request parser to be right on the required buffer size.
                 }
 
-                if (touches_readonly_region(&stack.write_mem.block))
+                stack.write_mem.block = *remaining;
+                stack.write_mem.block.length = take_budget(remaining->length);
+                write_memory_block(&stack.write_mem.block);
+                remaining->start_address += stack.write_mem.block.length;
+                remaining->source_data += stack.write_mem.block.length;
+                if (remaining->mask != nullptr)
                 {
-                    code = protocol::ResponseCode::Forbidden;
-                    break;
+                    remaining->mask += stack.write_mem.block.length;
                 }
+                remaining->length = static_cast<uint16_t>(remaining->length - stack.write_mem.block.length);
 
-                stack.write_mem.writemem_encoder->write(&stack.write_mem.block);
-                // We don't check overflow here as we rely on the request parser to be right on the required buffer size.
-
-                if (!masked)
+                if (remaining->length > 0)
                 {
-                    memcpy(stack.write_mem.block.start_address, stack.write_mem.block.source_data, stack.write_mem.block.length);
-                }
-                else
-                {
-                    for (uint16_t i = 0; i < stack.write_mem.block.length; i++)
-                    {
-                        uint8_t temp;
-                        temp = stack.write_mem.block.start_address[i];
-                        temp |= (stack.write_mem.block.source_data[i] & stack.write_mem.block.mask[i]);    // Bit to 1
-                        temp &= (stack.write_mem.block.source_data[i] | (~stack.write_mem.block.mask[i])); // Bit to 0
-                        stack.write_mem.block.start_address[i] = temp;
-                    }
+                    // Budget exhausted. Continues on the next call.
+                    m_sliced_write.owner = m_active_channel;
+                    code = protocol::ResponseCode::ProcessAgain;
+                    break;
                 }
             }
+
+            if (code == protocol::ResponseCode::OK)
+            {
+                m_sliced_write.owner = nullptr;
+                response->data_length = m_sliced_write.encoder.data_length(); // The last blocks may have been encoded by a previous call
+            }
             break;
         }
 
@@ -1139,7 +1672,7 @@ namespace scrutiny
             }
 
             stack.read_rpv.readrpv_parser = m_codec.decode_request_memory_control_read_rpv(request);
-            stack.read_rpv.readrpv_encoder = m_codec.encode_response_memory_control_read_rpv(response, m_comm_handler.tx_buffer_size());
+            stack.read_rpv.readrpv_encoder = m_codec.encode_response_memory_control_read_rpv(response, m_active_channel->m_comm_handler.tx_buffer_size());
 
             if (!stack.read_rpv.readrpv_parser->is_valid())
             {
@@ -1147,6 +1680,25 @@ namespace scrutiny
                 break;
             }
 
+            if (m_config.response_streaming)
+            {
+                // Too big for the transmit buffer, the values are read while the response is transmitted.
+                // Requests with errors are left to the regular path below so they get the same response code.
+                uint32_t payload_size = 0;
+                if (m_active_channel->m_readrpv_streamer.init(request, this, &payload_size) && payload_size > m_active_channel->m_comm_handler.tx_buffer_size())
+                {
+                    if (payload_size > max_streamed_response_size())
+                    {
+                        code = protocol::ResponseCode::Overflow;
+                        break;
+                    }
+
+                    m_active_channel->m_response_source = &m_active_channel->m_readrpv_streamer;
+                    response->data_length = static_cast<uint16_t>(payload_size);
+                    break;
+                }
+            }
+
             while (!stack.read_rpv.readrpv_parser->finished())
             {
                 bool const ok_to_process = stack.read_rpv.readrpv_parser->next(&stack.read_rpv.id);
@@ -1194,58 +1746,381 @@ namespace scrutiny
                 break;
             }
 
-            stack.write_rpv.writerpv_parser = m_codec.decode_request_memory_control_write_rpv(request, this);
-            stack.write_rpv.writerpv_encoder = m_codec.encode_response_memory_control_write_rpv(response, m_comm_handler.tx_buffer_size());
+            stack.write_rpv.writerpv_parser = m_codec.decode_request_memory_control_write_rpv(request, this);
+            stack.write_rpv.writerpv_encoder = m_codec.encode_response_memory_control_write_rpv(response, m_active_channel->m_comm_handler.tx_buffer_size());
+
+            if (!stack.write_rpv.writerpv_parser->is_valid())
+            {
+                code = protocol::ResponseCode::InvalidRequest;
+                break;
+            }
+
+            while (!stack.write_rpv.writerpv_parser->finished())
+            {
+                bool const ok_to_process = stack.write_rpv.writerpv_parser->next(&stack.write_rpv.rpv, &stack.write_rpv.v);
+
+                if (!stack.write_rpv.writerpv_parser->is_valid())
+                {
+                    code = protocol::ResponseCode::InvalidRequest;
+                    break;
+                }
+
+                if (!ok_to_process)
+                {
+                    continue;
+                }
+
+                bool const write_success = m_config.get_rpv_write_callback()(stack.write_rpv.rpv, &stack.write_rpv.v);
+                if (!write_success)
+                {
+                    code = protocol::ResponseCode::FailureToProceed;
+                    break;
+                }
+
+                stack.write_rpv.writerpv_encoder->write(&stack.write_rpv.rpv);
+
+                if (stack.write_rpv.writerpv_encoder->overflow())
+                {
+                    code = protocol::ResponseCode::Overflow;
+                    break;
+                }
+            }
+
+            break;
+        }
+
+            // =========== [Write Staged] ==========
+        case protocol::MemoryControl::Subfunction::WriteStaged:
+        {
+            code = protocol::ResponseCode::OK;
+            if (!m_config.is_staged_write_configured())
+            {
+                code = protocol::ResponseCode::UnsupportedFeature;
+                break;
+            }
+
+            if (m_streamed_write.owner != nullptr)
+            {
+                code = protocol::ResponseCode::Busy; // The staging buffer holds a streamed Write request
+                break;
+            }
+
+            if (m_staged_write.state != StagedWriteState::Idle)
+            {
+                // A timestamp is taken on the first ProcessAgain. If not taken, this request is a new one.
+                bool const same_request = (m_staged_write.owner == m_active_channel) && m_active_channel->m_process_again_timestamp_taken;
+                if (same_request)
+                {
+                    if (m_staged_write.state == StagedWriteState::Pending)
+                    {
+                        code = protocol::ResponseCode::ProcessAgain; // Waiting for the loop.
+                        break;
+                    }
+
+                    // Completed
+                    m_staged_write.state = StagedWriteState::Idle;
+                    if (!m_staged_write.success)
+                    {
+                        code = protocol::ResponseCode::FailureToProceed;
+                        break;
+                    }
+
+                    stack.write_staged.response_data.loop_id = m_staged_write.loop_id;
+                    stack.write_staged.response_data.entry_count = m_staged_write.entry_count;
+                    code = m_codec.encode_response_memory_control_write_staged(&stack.write_staged.response_data, response);
+                    break;
+                }
+
+                // A completed transaction is left behind when the requester stopped waiting for it (timeout). We can drop it.
+                bool const stale = (m_staged_write.state == StagedWriteState::Completed) &&
+                                   (m_staged_write.owner == nullptr || !m_staged_write.owner->m_process_again_timestamp_taken);
+                if (!stale)
+                {
+                    code = protocol::ResponseCode::Busy;
+                    break;
+                }
+                m_staged_write.state = StagedWriteState::Idle;
+            }
+
+            stack.write_staged.parser = m_codec.decode_request_memory_control_write_staged(request, this);
+            if (!stack.write_staged.parser->is_valid())
+            {
+                code = protocol::ResponseCode::InvalidRequest;
+                break;
+            }
+
+            if (stack.write_staged.parser->loop_id() >= m_config.m_loop_count)
+            {
+                code = protocol::ResponseCode::InvalidRequest;
+                break;
+            }
+
+            if (stack.write_staged.parser->entries_length() > m_config.m_staged_write_buffer_size)
+            {
+                code = protocol::ResponseCode::Overflow;
+                break;
+            }
+
+            // Validate everything before staging. The loop will apply the writes without any further check.
+            while (!stack.write_staged.parser->finished())
+            {
+                stack.write_staged.parser->next(&stack.write_staged.entry);
+                if (!stack.write_staged.parser->is_valid())
+                {
+                    code = protocol::ResponseCode::InvalidRequest;
+                    break;
+                }
+
+                if (stack.write_staged.entry.type == protocol::MemoryControl::StagedWriteType::RPV)
+                {
+                    if (!m_config.is_write_published_values_configured())
+                    {
+                        code = protocol::ResponseCode::UnsupportedFeature;
+                        break;
+                    }
+                }
+                else
+                {
+                    if (m_config.memory_write_enable == false)
+                    {
+                        code = protocol::ResponseCode::Forbidden;
+                        break;
+                    }
+
+                    if (touches_forbidden_region(&stack.write_staged.entry.block) || touches_readonly_region(&stack.write_staged.entry.block))
+                    {
+                        code = protocol::ResponseCode::Forbidden;
+                        break;
+                    }
+                }
+            }
+
+            if (code != protocol::ResponseCode::OK)
+            {
+                break;
+            }
+
+            LoopHandler *const loop = m_config.m_loops[stack.write_staged.parser->loop_id()];
+            if (loop->ipc_main2loop()->has_content())
+            {
+                code = protocol::ResponseCode::ProcessAgain; // IPC is busy. Revalidate and try again later.
+                break;
+            }
+
+            memcpy(m_config.m_staged_write_buffer, stack.write_staged.parser->entries(), stack.write_staged.parser->entries_length());
+            m_staged_write.owner = m_active_channel;
+            m_staged_write.loop_id = stack.write_staged.parser->loop_id();
+            m_staged_write.entry_count = stack.write_staged.parser->entry_count();
+            m_staged_write.success = false;
+            m_staged_write.ticket_number = m_staged_write.ticket.issue();
+            m_staged_write.state = StagedWriteState::Pending;
+
+            stack.write_staged.msg.message_id = LoopHandler::Main2LoopMessageID::APPLY_STAGED_WRITES;
+            stack.write_staged.msg.data.staged_writes.entries = m_config.m_staged_write_buffer;
+            stack.write_staged.msg.data.staged_writes.entries_length = stack.write_staged.parser->entries_length();
+            stack.write_staged.msg.data.staged_writes.ticket = m_staged_write.ticket_number;
+            loop->ipc_main2loop()->send(stack.write_staged.msg);
+
+            code = protocol::ResponseCode::ProcessAgain; // Response will be given once the loop has applied the writes.
+            break;
+        }
+
+            // =================================
+        default:
+        {
+            code = protocol::ResponseCode::UnsupportedFeature;
+            break;
+        }
+        }
+
+        return code;
+    }
+
+    // Returns how many of the given bytes can be copied by the actual call to process() and removes them from the budget.
+    uint16_t MainHandler::take_budget(uint16_t const length)
+    {
+        if (!m_budget_limited)
+        {
+            return length;
+        }
+
+        uint16_t const granted = (m_budget < length) ? static_cast<uint16_t>(m_budget) : length;
+        m_budget -= granted;
+        return granted;
+    }
+
+    // Validates every block of a Write request before anything is written, as the writes may be spread over several calls,
+    // then gets the request parser and the response encoder ready in m_sliced_write. They keep their position between the calls.
+    protocol::ResponseCode MainHandler::start_memory_write(protocol::Request const *const request, bool const masked, protocol::Response *const response)
+    {
+        protocol::WriteMemoryBlocksRequestParser *const parser = m_codec.decode_request_memory_control_write(request, masked);
+        if (!parser->is_valid())
+        {
+            return protocol::ResponseCode::InvalidRequest;
+        }
+
+        if (parser->required_tx_buffer_size() > m_active_channel->m_comm_handler.tx_buffer_size())
+        {
+            return protocol::ResponseCode::Overflow;
+        }
+
+        MemoryBlock block;
+        uint32_t total_length = 0;
+        while (!parser->finished())
+        {
+            parser->next(&block);
+            if (!parser->is_valid())
+            {
+                return protocol::ResponseCode::InvalidRequest;
+            }
+
+            if (touches_forbidden_region(&block) || touches_readonly_region(&block))
+            {
+                return protocol::ResponseCode::Forbidden;
+            }
+            total_length += block.length;
+        }
+
+        // With a budget, the write takes several calls. Refuse it if they cannot fit within the time given to a request,
+        // as it cannot be interrupted once started.
+        if (m_budget_limited && m_budget > 0 && m_timestep_100ns > 0)
+        {
+            uint32_t const extra_calls = (total_length > 0) ? (total_length - 1u) / m_budget : 0;
+            if (extra_calls > (SCRUTINY_REQUEST_MAX_PROCESS_TIME_US * 10u - 1u) / m_timestep_100ns)
+            {
+                return protocol::ResponseCode::FailureToProceed;
+            }
+        }
+
+        m_sliced_write.parser = *m_codec.decode_request_memory_control_write(request, masked); // Restart from the first block
+        m_sliced_write.encoder = *m_codec.encode_response_memory_control_write(response, m_active_channel->m_comm_handler.tx_buffer_size());
+        m_sliced_write.remaining.length = 0;
+        return protocol::ResponseCode::OK;
+    }
+
+    void MainHandler::write_memory_block(MemoryBlock const *const block)
+    {
+        if (block->mask == nullptr)
+        {
+            memcpy(block->start_address, block->source_data, block->length);
+        }
+        else
+        {
+            tools::write_masked(block->start_address, block->source_data, block->mask, block->length);
+        }
+    }
+
+    bool MainHandler::apply_staged_writes(uint8_t *const entries, uint16_t const entries_length) const
+    {
+        // Called from the context of a LoopHandler. Entries were validated by the Main Handler before being staged.
+        // We do not use the codec parser to avoid conflicting with a request being parsed in the Main Handler context.
+        protocol::StagedWriteRequestParser parser;
+        protocol::StagedWriteEntry entry;
+        bool success = true;
+        parser.init_entries(entries, entries_length, this);
 
-            if (!stack.write_rpv.writerpv_parser->is_valid())
+        while (!parser.finished())
+        {
+            parser.next(&entry);
+            if (!parser.is_valid())
             {
-                code = protocol::ResponseCode::InvalidRequest;
-                break;
+                return false;
             }
 
-            while (!stack.write_rpv.writerpv_parser->finished())
+            if (entry.type == protocol::MemoryControl::StagedWriteType::RPV)
             {
-                bool const ok_to_process = stack.write_rpv.writerpv_parser->next(&stack.write_rpv.rpv, &stack.write_rpv.v);
-
-                if (!stack.write_rpv.writerpv_parser->is_valid())
+                if (!m_config.get_rpv_write_callback()(entry.rpv, &entry.value))
                 {
-                    code = protocol::ResponseCode::InvalidRequest;
-                    break;
+                    success = false;
                 }
+            }
+            else
+            {
+                write_memory_block(&entry.block);
+            }
+        }
 
-                if (!ok_to_process)
-                {
-                    continue;
-                }
+        return success;
+    }
 
-                bool const write_success = m_config.get_rpv_write_callback()(stack.write_rpv.rpv, &stack.write_rpv.v);
-                if (!write_success)
-                {
-                    code = protocol::ResponseCode::FailureToProceed;
-                    break;
-                }
+    // Called by a channel when it receives a request too big for its reception buffer.
+    // Only Write requests are taken, in the staged write buffer, when no staged write transaction needs it.
+    bool MainHandler::begin_streamed_write(CommChannel *const channel, uint8_t const command_id, uint8_t const subfunction_id, uint16_t const data_length)
+    {
+        if (static_cast<protocol::CommandId>(command_id) != protocol::CommandId::MemoryControl)
+        {
+            return false;
+        }
 
-                stack.write_rpv.writerpv_encoder->write(&stack.write_rpv.rpv);
+        protocol::MemoryControl::Subfunction const subfunction = static_cast<protocol::MemoryControl::Subfunction>(subfunction_id);
+        if (subfunction != protocol::MemoryControl::Subfunction::Write && subfunction != protocol::MemoryControl::Subfunction::WriteMasked)
+        {
+            return false;
+        }
 
-                if (stack.write_rpv.writerpv_encoder->overflow())
-                {
-                    code = protocol::ResponseCode::Overflow;
-                    break;
-                }
-            }
+        if (m_config.m_staged_write_buffer == nullptr || data_length > m_config.m_staged_write_buffer_size)
+        {
+            return false;
+        }
 
-            break;
+        if (m_streamed_write.owner != nullptr || m_staged_write.state == StagedWriteState::Pending)
+        {
+            return false; // Staging buffer in use
         }
 
-            // =================================
-        default:
+        m_streamed_write.owner = channel;
+        m_streamed_write.masked = (subfunction == protocol::MemoryControl::Subfunction::WriteMasked);
+        m_streamed_write.expected_length = data_length;
+        m_streamed_write.length = 0;
+        m_streamed_write.next_block = 0;
+        m_streamed_write.code = (m_config.memory_write_enable) ? protocol::ResponseCode::OK : protocol::ResponseCode::Forbidden;
+        return true;
+    }
+
+    // Stages the payload and validates each block header as soon as it is complete.
+    // The data is written to memory only once the whole request is received with a valid CRC.
+    void MainHandler::receive_streamed_write(CommChannel *const channel, uint8_t const *const data, uint16_t const len)
+    {
+        constexpr unsigned int addr_size = sizeof(void *);
+
+        if (m_streamed_write.owner != channel || len > m_streamed_write.expected_length - m_streamed_write.length)
         {
-            code = protocol::ResponseCode::UnsupportedFeature;
-            break;
+            return;
         }
+
+        memcpy(&m_config.m_staged_write_buffer[m_streamed_write.length], data, len);
+        m_streamed_write.length += len;
+
+        while (m_streamed_write.code == protocol::ResponseCode::OK && m_streamed_write.next_block + addr_size + 2 <= m_streamed_write.length)
+        {
+            uint8_t const *const header = &m_config.m_staged_write_buffer[m_streamed_write.next_block];
+            uintptr_t addr;
+            codecs::decode_address_big_endian(header, &addr);
+            uint16_t const block_length = codecs::decode_16_bits_big_endian(&header[addr_size]);
+            uint32_t const block_end = static_cast<uint32_t>(m_streamed_write.next_block) + addr_size + 2 + (m_streamed_write.masked ? 2u : 1u) * block_length;
+
+            if (block_end > m_streamed_write.expected_length)
+            {
+                m_streamed_write.code = protocol::ResponseCode::InvalidRequest;
+                break;
+            }
+
+            if (touches_forbidden_region(reinterpret_cast<void *>(addr), block_length) || touches_readonly_region(reinterpret_cast<void *>(addr), block_length))
+            {
+                m_streamed_write.code = protocol::ResponseCode::Forbidden;
+                break;
+            }
+
+            m_streamed_write.next_block = static_cast<uint16_t>(block_end);
         }
+    }
 
-        return code;
+    void MainHandler::release_streamed_write(CommChannel *const channel)
+    {
+        if (m_streamed_write.owner == channel)
+        {
+            m_streamed_write.owner = nullptr;
+        }
     }
 
     bool MainHandler::touches_forbidden_region(MemoryBlock const *const block) const
@@ -1315,12 +2190,16 @@ namespace scrutiny
     {
         protocol::ResponseCode code = protocol::ResponseCode::FailureToProceed;
 
-        if (m_config.is_user_command_callback_set())
+        if (m_config.get_async_user_command_callback() != nullptr)
+        {
+            code = process_async_user_command(request, response);
+        }
+        else if (m_config.is_user_command_callback_set())
         {
             uint16_t response_data_length = 0;
             // Calling user callback;
-            m_config.get_user_command_callback()(request->subfunction_id, request->data, request->data_length, response->data, &response_data_length, m_comm_handler.tx_buffer_size());
-            if (response_data_length > m_comm_handler.tx_buffer_size())
+            m_config.get_user_command_callback()(request->subfunction_id, request->data, request->data_length, response->data, &response_data_length, m_active_channel->m_comm_handler.tx_buffer_size());
+            if (response_data_length > m_active_channel->m_comm_handler.tx_buffer_size())
             {
                 code = protocol::ResponseCode::Overflow;
             }
@@ -1338,6 +2217,98 @@ namespace scrutiny
         return code;
     }
 
+    protocol::ResponseCode MainHandler::process_async_user_command(protocol::Request const *const request, protocol::Response *const response)
+    {
+        protocol::ResponseCode code = protocol::ResponseCode::FailureToProceed;
+        uint16_t const response_max_data_length = m_active_channel->m_comm_handler.tx_buffer_size();
+        bool new_command = true;
+
+        if (m_user_command.pending)
+        {
+            // A timestamp is taken on the first ProcessAgain. If not taken, this request is a new one.
+            bool const same_request = (m_user_command.owner == m_active_channel) && m_active_channel->m_process_again_timestamp_taken;
+            if (!m_user_command.completion.has_content())
+            {
+                new_command = false;
+                if (same_request)
+                {
+                    code = protocol::ResponseCode::ProcessAgain; // Waiting for complete_user_command()
+                }
+                else
+                {
+                    m_user_command.owner = nullptr; // The requester stopped waiting.
+                    code = protocol::ResponseCode::Busy;
+                }
+            }
+            else
+            {
+                UserCommandCompletion const completion = m_user_command.completion.pop();
+                m_user_command.pending = false;
+                m_user_command.owner = nullptr;
+                if (same_request)
+                {
+                    new_command = false;
+                    if (!completion.success)
+                    {
+                        code = protocol::ResponseCode::FailureToProceed;
+                    }
+                    else if (completion.length > response_max_data_length)
+                    {
+                        code = protocol::ResponseCode::Overflow;
+                    }
+                    else
+                    {
+                        memcpy(response->data, completion.data, completion.length);
+                        response->data_length = completion.length;
+                        code = protocol::ResponseCode::OK;
+                    }
+                }
+                // Otherwise, the completion of a command that nobody waits for anymore is dropped and the new request is processed.
+            }
+        }
+
+        if (new_command)
+        {
+            m_user_command.completion.clear(); // Drops a completion given while no command was pending.
+            uint16_t response_data_length = 0;
+            UserCommandStatus const status = static_cast<UserCommandStatus>(
+                m_config.get_async_user_command_callback()(request->subfunction_id, request->data, request->data_length, response->data, &response_data_length, response_max_data_length));
+
+            if (status == UserCommandStatus::PENDING)
+            {
+                m_user_command.pending = true;
+                m_user_command.owner = m_active_channel;
+                code = protocol::ResponseCode::ProcessAgain; // Response will be given once complete_user_command() is called.
+            }
+            else if (response_data_length > response_max_data_length)
+            {
+                code = protocol::ResponseCode::Overflow;
+            }
+            else
+            {
+                response->data_length = response_data_length;
+                code = protocol::ResponseCode::OK;
+            }
+        }
+
+        return code;
+    }
+
+    bool MainHandler::complete_user_command(uint8_t const *const response_data, uint16_t const response_data_length, bool const success)
+    {
+        if (m_user_command.completion.has_content())
+        {
+            return false;
+        }
+
+        UserCommandCompletion completion;
+        completion.data = response_data;
+        completion.length = response_data_length;
+        completion.success = success;
+        m_user_command.completion.send(completion);
+        return true;
+    }
+
 #if SCRUTINY_ENABLE_DATALOGGING
     protocol::ResponseCode MainHandler::process_datalog_control(protocol::Request const *const request, protocol::Response *const response)
     {
@@ -1360,14 +2331,32 @@ namespace scrutiny
 
             struct
             {
+                protocol::RequestData::DataLogControl::GetAcquisitionMetadata request_data;
                 protocol::ResponseData::DataLogControl::GetAcquisitionMetadata response_data;
             } get_acq_metadata;
 
             struct
             {
-                protocol::ResponseData::DataLogControl::ReadAcquisition response_data;
+                protocol::RequestData::DataLogControl::ReadAcquisition request_data;
             } read_acquisition;
 
+            struct
+            {
+                protocol::RequestData::DataLogControl::ReadAcquisitionBurst request_data;
+            } read_acquisition_burst;
+
+            struct
+            {
+                protocol::RequestData::DataLogControl::ReadAcquisitionChunk request_data;
+                protocol::ResponseData::DataLogControl::ReadAcquisitionChunk response_data;
+            } read_acquisition_chunk;
+
+            struct
+            {
+                protocol::RequestData::DataLogControl::GetTimeMarks request_data;
+                protocol::ResponseData::DataLogControl::GetTimeMarks response_data;
+            } get_time_marks;
+
         } stack;
 
         if (!m_config.is_datalogging_configured())
@@ -1381,9 +2370,9 @@ namespace scrutiny
 
         case protocol::DataLogControl::Subfunction::GetSetup:
         {
-            static_assert(sizeof(stack.get_setup.response_data.buffer_size) >= sizeof(m_config.m_datalogger_buffer_size), "Data won't fit in protocol");
+            static_assert(sizeof(stack.get_setup.response_data.buffer_size) >= sizeof(datalogging::buffer_size_t), "Data won't fit in protocol");
 
-            stack.get_setup.response_data.buffer_size = static_cast<uint32_t>(m_config.m_datalogger_buffer_size);
+            stack.get_setup.response_data.buffer_size = static_cast<uint32_t>(m_datalogging.datalogger.get_buffer_size());
             stack.get_setup.response_data.data_encoding = static_cast<uint8_t>(m_datalogging.datalogger.get_encoder()->get_encoding());
             stack.get_setup.response_data.max_signal_count = SCRUTINY_DATALOGGING_MAX_SIGNAL;
             code = m_codec.encode_response_datalogging_get_setup(&stack.get_setup.response_data, response);
@@ -1391,6 +2380,12 @@ namespace scrutiny
         }
         case protocol::DataLogControl::Subfunction::ConfigureDatalog:
         {
+            if (datalogging_stream_in_flight())
+            {
+                code = protocol::ResponseCode::Busy;
+                break;
+            }
+
             m_datalogging.reading_in_progress = false; // Make sure to update this quickly because we can.
 
             // Make sure the datalogger is released before writing the config object to avoid race conditions.
@@ -1422,6 +2417,14 @@ namespace scrutiny
                 break;
             }
 
+            // The time of each entry can be deduced from its index only if the loop runs at a fixed frequency
+            if (m_datalogging.datalogger.config()->time_axis == datalogging::TimeAxis::Implicit &&
+                m_config.m_loops[stack.configure.request_data.loop_id]->loop_type() != LoopType::FIXED_FREQ)
+            {
+                code = protocol::ResponseCode::FailureToProceed;
+                break;
+            }
+
             const datalogging::Configuration *const config = m_datalogging.datalogger.config();
 
             for (uint_fast8_t i = 0; i < config->trigger.operand_count; i++)
@@ -1465,6 +2468,16 @@ namespace scrutiny
                         break;
                     }
                 }
+                else if (config->items_to_log[i].type == datalogging::LoggableType::VARBIT)
+                {
+                    if (touches_forbidden_region(
+                            config->items_to_log[i].data.varbit.addr,
+                            ((config->items_to_log[i].data.varbit.bitoffset + config->items_to_log[i].data.varbit.bitsize + 7) >> 3)))
+                    {
+                        code = protocol::ResponseCode::Forbidden;
+                        break;
+                    }
+                }
                 else if (config->items_to_log[i].type == datalogging::LoggableType::RPV)
                 {
                     if (!m_config.is_read_published_values_configured() || !rpv_exists(config->items_to_log[i].data.rpv.id))
@@ -1496,6 +2509,11 @@ namespace scrutiny
 
         case protocol::DataLogControl::Subfunction::ArmTrigger:
         {
+            if (datalogging_stream_in_flight())
+            {
+                code = protocol::ResponseCode::Busy; // The acquisition would be overwritten while it is sent
+                break;
+            }
 
             if (m_datalogging.owner == nullptr || m_datalogging.pending_ownership_release)
             {
@@ -1543,6 +2561,12 @@ namespace scrutiny
             static_assert(sizeof(stack.get_acq_metadata.response_data.data_size) >= sizeof(datalogging::buffer_size_t), "Data won't fit in protocol");
             static_assert(sizeof(stack.get_acq_metadata.response_data.points_after_trigger) >= sizeof(datalogging::buffer_size_t), "Data won't fit in protocol");
 
+            code = m_codec.decode_datalogging_get_acquisition_metadata_request(request, &stack.get_acq_metadata.request_data);
+            if (code != protocol::ResponseCode::OK)
+            {
+                break;
+            }
+
             if (!datalogging_data_available())
             {
                 code = protocol::ResponseCode::FailureToProceed;
@@ -1555,61 +2579,184 @@ namespace scrutiny
             stack.get_acq_metadata.response_data.number_of_points = reader->get_entry_count();
             stack.get_acq_metadata.response_data.data_size = reader->get_total_size();
             stack.get_acq_metadata.response_data.points_after_trigger = m_datalogging.datalogger.log_points_after_trigger();
+            stack.get_acq_metadata.response_data.first_segment = stack.get_acq_metadata.request_data.first_segment;
+            stack.get_acq_metadata.response_data.datalogger = &m_datalogging.datalogger;
             code = m_codec.encode_response_datalogging_get_acquisition_metadata(&stack.get_acq_metadata.response_data, response);
             break;
         }
         case protocol::DataLogControl::Subfunction::ReadAcquisition:
         {
+            if (datalogging_read_owned_by_other_channel())
+            {
+                code = protocol::ResponseCode::Busy;
+                break;
+            }
+
             if (m_datalogging.owner == nullptr) // no owner
             {
                 code = protocol::ResponseCode::FailureToProceed;
                 break;
             }
 
+            code = m_codec.decode_datalogging_read_acquisition_request(request, &stack.read_acquisition.request_data);
+            if (code != protocol::ResponseCode::OK)
+            {
+                break;
+            }
+
+            m_datalogging.burst_channel = nullptr; // The reader is shared. Only one reading at a time.
             if (datalogging_data_available())
             {
-                datalogging::DataReader *const reader = m_datalogging.datalogger.get_reader();
-                if (m_datalogging.reading_in_progress == false)
+                if (m_datalogging.reading_in_progress == false || m_datalogging.read_channel != m_active_channel)
                 {
-                    reader->reset();
-                    m_datalogging.reading_in_progress = true;
-                    m_datalogging.read_acquisition_rolling_counter = 0;
-                    m_datalogging.read_acquisition_crc = 0;
+                    start_datalogging_read(stack.read_acquisition.request_data.layout); // Layout is taken when the reading starts only
                 }
 
-                stack.read_acquisition.response_data.acquisition_id = m_datalogging.datalogger.get_acquisition_id();
-                stack.read_acquisition.response_data.reader = reader;
-                stack.read_acquisition.response_data.rolling_counter = m_datalogging.read_acquisition_rolling_counter;
-                stack.read_acquisition.response_data.crc = &m_datalogging.read_acquisition_crc;
+                // Frames that do not fit in the transmit buffer are read from the storage while they are transmitted
+                uint16_t const tx_buffer_size = m_active_channel->m_comm_handler.tx_buffer_size();
+                uint16_t const streamed_max_size = max_streamed_response_size();
+                constexpr uint16_t frame_overhead = 8; // Header + acquisition CRC
+                bool const stream = (streamed_max_size > tx_buffer_size) &&
+                                    (m_datalogging.datalogger.get_reader()->get_remaining_size() > static_cast<datalogging::buffer_size_t>(tx_buffer_size - frame_overhead));
 
-                bool finished = false;
-                code = m_codec.encode_response_datalogging_read_acquisition(&stack.read_acquisition.response_data, response, &finished);
-                m_datalogging.read_acquisition_rolling_counter++;
+                code = encode_datalogging_acquisition_frame(response, stream ? streamed_max_size : 0);
+                break;
+            }
+            else
+            {
+                code = protocol::ResponseCode::FailureToProceed;
+                m_datalogging.reading_in_progress = false;
+                break;
+            }
+            break;
+        }
 
-                if (code != protocol::ResponseCode::OK)
+        case protocol::DataLogControl::Subfunction::ReadAcquisitionChunk:
+        {
+            // Random access read. Chunks can be requested in any order and retried individually.
+            if (datalogging_read_owned_by_other_channel())
+            {
+                code = protocol::ResponseCode::Busy;
+                break;
+            }
+
+            if (m_datalogging.owner == nullptr || !datalogging_data_available())
+            {
+                code = protocol::ResponseCode::FailureToProceed;
+                break;
+            }
+
+            code = m_codec.decode_datalogging_read_acquisition_chunk_request(request, &stack.read_acquisition_chunk.request_data);
+            if (code != protocol::ResponseCode::OK)
+            {
+                break;
+            }
+
+            if (stack.read_acquisition_chunk.request_data.acquisition_id != m_datalogging.datalogger.get_acquisition_id())
+            {
+                code = protocol::ResponseCode::FailureToProceed; // The server asks for an acquisition that does not exist anymore.
+                break;
+            }
+
+            // The reader is shared with the sequential read. Next ReadAcquisition restarts from the beginning.
+            m_datalogging.reading_in_progress = false;
+            datalogging::DataReader *const reader = m_datalogging.datalogger.get_reader();
+            reader->set_layout(datalogging::ReadLayout::Rows);
+            if (stack.read_acquisition_chunk.request_data.offset > static_cast<datalogging::buffer_size_t>(-1) ||
+                !reader->seek(static_cast<datalogging::buffer_size_t>(stack.read_acquisition_chunk.request_data.offset)))
+            {
+                code = protocol::ResponseCode::Overflow;
+                break;
+            }
+
+            stack.read_acquisition_chunk.response_data.acquisition_id = stack.read_acquisition_chunk.request_data.acquisition_id;
+            stack.read_acquisition_chunk.response_data.offset = stack.read_acquisition_chunk.request_data.offset;
+            stack.read_acquisition_chunk.response_data.length = stack.read_acquisition_chunk.request_data.length;
+            stack.read_acquisition_chunk.response_data.reader = reader;
+            code = m_codec.encode_response_datalogging_read_acquisition_chunk(&stack.read_acquisition_chunk.response_data, response);
+            break;
+        }
+
+        case protocol::DataLogControl::Subfunction::ReadAcquisitionBurst:
+        {
+            // One request starts the transfer, then frames are sent back to back without request until the reader finishes.
+            // When flow control is used, the server acknowledges every burst_frames_per_ack frames with the rolling counter of the next frame it expects.
+            if (datalogging_read_owned_by_other_channel())
+            {
+                code = protocol::ResponseCode::Busy;
+                break;
+            }
+
+            m_datalogging.burst_channel = nullptr;
+            if (m_datalogging.owner == nullptr || !datalogging_data_available())
+            {
+                m_datalogging.reading_in_progress = false;
+                code = protocol::ResponseCode::FailureToProceed;
+                break;
+            }
+
+            code = m_codec.decode_datalogging_read_acquisition_burst_request(request, &stack.read_acquisition_burst.request_data);
+            if (code != protocol::ResponseCode::OK)
+            {
+                break;
+            }
+
+            if (stack.read_acquisition_burst.request_data.acknowledge)
+            {
+                if (!m_datalogging.reading_in_progress || m_datalogging.read_channel != m_active_channel ||
+                    stack.read_acquisition_burst.request_data.rolling_counter != m_datalogging.read_acquisition_rolling_counter)
                 {
-                    m_datalogging.reading_in_progress = false;
+                    m_datalogging.reading_in_progress = false; // Frames were lost. The server must start over or read the missing chunks.
+                    code = protocol::ResponseCode::FailureToProceed;
                     break;
                 }
+            }
+            else
+            {
+                start_datalogging_read();
+            }
 
-                if (finished)
-                {
-                    m_datalogging.reading_in_progress = false;
-                }
+            code = encode_datalogging_acquisition_frame(response);
+            if (code == protocol::ResponseCode::OK && m_datalogging.reading_in_progress)
+            {
+                m_datalogging.burst_channel = m_active_channel;
+                m_datalogging.burst_frames_per_ack = stack.read_acquisition_burst.request_data.frames_per_ack;
+                m_datalogging.burst_frame_counter = 1;
+            }
+            break;
+        }
 
+        case protocol::DataLogControl::Subfunction::GetTimeMarks:
+        {
+            // Time of some entries of an acquisition made with a sparse time axis. The server interpolates the others
+            code = m_codec.decode_datalogging_get_time_marks_request(request, &stack.get_time_marks.request_data);
+            if (code != protocol::ResponseCode::OK)
+            {
                 break;
             }
-            else
+
+            if (!datalogging_data_available() || stack.get_time_marks.request_data.segment >= m_datalogging.datalogger.get_completed_segment_count())
             {
                 code = protocol::ResponseCode::FailureToProceed;
-                m_datalogging.reading_in_progress = false;
                 break;
             }
+
+            stack.get_time_marks.response_data.acquisition_id = m_datalogging.datalogger.get_acquisition_id();
+            stack.get_time_marks.response_data.segment = stack.get_time_marks.request_data.segment;
+            stack.get_time_marks.response_data.first_mark = stack.get_time_marks.request_data.first_mark;
+            stack.get_time_marks.response_data.datalogger = &m_datalogging.datalogger;
+            code = m_codec.encode_response_datalogging_get_time_marks(&stack.get_time_marks.response_data, response);
             break;
         }
 
         case protocol::DataLogControl::Subfunction::ResetDatalogger:
         {
+            if (datalogging_stream_in_flight())
+            {
+                code = protocol::ResponseCode::Busy;
+                break;
+            }
+
             if (m_datalogging.owner != nullptr)
             {
                 if (!m_datalogging.pending_ownership_release)
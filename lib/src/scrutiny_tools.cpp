@@ -7,6 +7,7 @@
 //   Copyright (c) 2021 Scrutiny Debugger
 
 #include <stdint.h>
+#include <string.h>
 #include "scrutiny_setup.hpp"
 #include "scrutiny_types.hpp"
 #include "scrutiny_tools.hpp"
@@ -15,6 +16,150 @@ namespace scrutiny
 {
     namespace tools
     {
+#if SCRUTINY_MEMORY_WRITE_ACCESS_WIDTH == 8
+        typedef uint64_t memory_access_word_t;
+#elif SCRUTINY_MEMORY_WRITE_ACCESS_WIDTH == 4
+        typedef uint32_t memory_access_word_t;
+#elif SCRUTINY_MEMORY_WRITE_ACCESS_WIDTH == 2
+        typedef uint16_t memory_access_word_t;
+#else
+        typedef uint8_t memory_access_word_t;
+#endif
+
+        /// @brief Read-Modify-Write of a single element. Destination must be aligned.
+        template <class T>
+        static inline void write_masked_element(uint8_t *const dst, uint8_t const *const data, uint8_t const *const mask)
+        {
+            T d;
+            T m;
+            // Data and mask come from a request buffer and may not be aligned.
+            memcpy(&d, data, sizeof(T));
+            memcpy(&m, mask, sizeof(T));
+            // Volatile to guarantee a single access of the requested width (no split or merge by the compiler)
+            T volatile *const p = reinterpret_cast<T volatile *>(dst);
+            *p = static_cast<T>((*p & static_cast<T>(~m)) | (d & m));
+        }
+
+        void write_masked(uint8_t *const dst, uint8_t const *const data, uint8_t const *const mask, uint16_t const length)
+        {
+            constexpr uint16_t word_size = sizeof(memory_access_word_t);
+            uint16_t i = 0;
+
+            // Head. Byte access up to the first aligned word
+            while (i < length && (reinterpret_cast<uintptr_t>(&dst[i]) % word_size) != 0)
+            {
+                write_masked_element<uint8_t>(&dst[i], &data[i], &mask[i]);
+                i++;
+            }
+
+            // Body. Aligned words
+            while (static_cast<uint16_t>(length - i) >= word_size)
+            {
+                write_masked_element<memory_access_word_t>(&dst[i], &data[i], &mask[i]);
+                i += word_size;
+            }
+
+            // Tail
+            while (i < length)
+            {
+                write_masked_element<uint8_t>(&dst[i], &data[i], &mask[i]);
+                i++;
+            }
+        }
+
+        /// @brief Extracts a bitfield with a fetch of type TFetch and an output of type TOut. No branch involved.
+        /// Sign extension is done with (v ^ sign_bit) - sign_bit, which is a no-op for unsigned types (sign_bit = 0)
+        template <class TFetch, class TOut>
+        static void extract_bitfield_element(void const *const addr, BitfieldDescriptor const *const descriptor, AnyType *const val)
+        {
+            TFetch raw;
+            memcpy(&raw, addr, sizeof(TFetch)); // No unaligned access
+            TFetch const mask = static_cast<TFetch>(descriptor->mask);
+            TFetch const sign_bit = static_cast<TFetch>(descriptor->sign_bit);
+            TFetch v = static_cast<TFetch>(static_cast<TFetch>(raw >> descriptor->bitoffset) & mask);
+            v = static_cast<TFetch>(static_cast<TFetch>(v ^ sign_bit) - sign_bit);
+            TOut const out = static_cast<TOut>(v);
+            memcpy(val, &out, sizeof(TOut)); // All AnyType members start at offset 0
+        }
+
+        /// @brief Returns the extraction function for a given fetch size and output size. Output size is never bigger than the fetch size
+        static BitfieldDescriptor::extract_func_t get_bitfield_extract_func(uint8_t const fetch_size, uint8_t const output_size)
+        {
+            switch (fetch_size)
+            {
+            case 1:
+                return &extract_bitfield_element<uint8_t, uint8_t>;
+            case 2:
+                return (output_size == 1) ? &extract_bitfield_element<uint16_t, uint8_t> : &extract_bitfield_element<uint16_t, uint16_t>;
+            case 4:
+                switch (output_size)
+                {
+                case 1:
+                    return &extract_bitfield_element<uint32_t, uint8_t>;
+                case 2:
+                    return &extract_bitfield_element<uint32_t, uint16_t>;
+                default:
+                    return &extract_bitfield_element<uint32_t, uint32_t>;
+                }
+#if SCRUTINY_SUPPORT_64BITS
+            case 8:
+                switch (output_size)
+                {
+                case 1:
+                    return &extract_bitfield_element<uint64_t, uint8_t>;
+                case 2:
+                    return &extract_bitfield_element<uint64_t, uint16_t>;
+                case 4:
+                    return &extract_bitfield_element<uint64_t, uint32_t>;
+                default:
+                    return &extract_bitfield_element<uint64_t, uint64_t>;
+                }
+#endif
+            default:
+                return nullptr;
+            }
+        }
+
+        bool make_bitfield_descriptor(VariableTypeType const var_tt, uint_fast8_t const bitoffset, uint_fast8_t const bitsize, BitfieldDescriptor *const descriptor)
+        {
+            descriptor->extract = nullptr;
+            descriptor->mask = 0;
+            descriptor->sign_bit = 0;
+            descriptor->bitoffset = 0;
+            descriptor->fetch_size = 0;
+            descriptor->output_type = VariableType::unknown;
+
+            if (bitsize == 0 || bitsize > sizeof(uint_biggest_t) * 8)
+            {
+                return false;
+            }
+
+            if (var_tt != VariableTypeType::_sint && var_tt != VariableTypeType::_uint && var_tt != VariableTypeType::_boolean)
+            {
+                return false;
+            }
+
+            unsigned int const fetch_required_size = ((static_cast<unsigned int>(bitoffset) + bitsize - 1) >> 3) + 1;
+            unsigned int const output_required_size = ((static_cast<unsigned int>(bitsize) - 1) >> 3) + 1;
+            uint8_t const fetch_size = get_type_size(get_required_type_size(static_cast<uint_fast8_t>(fetch_required_size)));
+            VariableTypeSize const output_type_size = get_required_type_size(static_cast<uint_fast8_t>(output_required_size));
+            VariableType const output_type = make_type(var_tt, output_type_size);
+
+            if (fetch_size == 0 || fetch_size > sizeof(uint_biggest_t) || output_type == VariableType::unknown)
+            {
+                return false;
+            }
+
+            descriptor->extract = get_bitfield_extract_func(fetch_size, get_type_size(output_type_size));
+            descriptor->mask = static_cast<uint_biggest_t>(~static_cast<uint_biggest_t>(0)) >> (sizeof(uint_biggest_t) * 8 - bitsize);
+            descriptor->sign_bit = (var_tt == VariableTypeType::_sint) ? (static_cast<uint_biggest_t>(1) << (bitsize - 1)) : 0;
+            descriptor->bitoffset = static_cast<uint8_t>(bitoffset);
+            descriptor->fetch_size = fetch_size;
+            descriptor->output_type = output_type;
+
+            return descriptor->extract != nullptr;
+        }
+
         VariableTypeSize get_required_type_size(uint_fast8_t const newsize)
         {
             if (newsize <= 1)
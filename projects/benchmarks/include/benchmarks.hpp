@@ -0,0 +1,41 @@
+//    benchmarks.hpp
+//        Micro benchmarks of the hot paths of the embedded library. Meant to be run on a host to compare implementations.
+//
+//   - License : MIT - See LICENSE file.
+//   - Project : Scrutiny Debugger (github.com/scrutinydebugger/scrutiny-embedded)
+//
+//   Copyright (c) 2021 Scrutiny Debugger
+
+#ifndef ___BENCHMARKS_H___
+#define ___BENCHMARKS_H___
+
+#include <stdint.h>
+#include <chrono>
+#include "scrutiny.hpp"
+
+/// @brief Helper that measures the average time of an operation repeated many times
+class BenchmarkTimer
+{
+public:
+    BenchmarkTimer(void) : m_start(std::chrono::steady_clock::now()) {}
+
+    /// @brief Returns the average time per iteration in nanoseconds since the timer was created
+    double ns_per_iteration(uint32_t const iterations) const
+    {
+        std::chrono::duration<double, std::nano> const elapsed = std::chrono::steady_clock::now() - m_start;
+        return elapsed.count() / static_cast<double>(iterations);
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_start;
+};
+
+#if SCRUTINY_ENABLE_DATALOGGING
+void benchmark_bitfield(uint32_t const iterations);
+#endif
+
+#if SCRUTINY_BENCHMARK_DECODER
+void benchmark_raw_decoder(uint32_t const iterations);
+#endif
+
+#endif // ___BENCHMARKS_H___
@@ -0,0 +1,203 @@
+//    bench_bitfield.cpp
+//        Compares the bitfield extraction with a descriptor computed on every call and with a precomputed descriptor
+//        against the former extraction, that builds its mask bit by bit and sign extends conditionally
+//
+//   - License : MIT - See LICENSE file.
+//   - Project : Scrutiny Debugger (github.com/scrutinydebugger/scrutiny-embedded)
+//
+//   Copyright (c) 2021 Scrutiny Debugger
+
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include "benchmarks.hpp"
+
+struct BitfieldCase
+{
+    char const *name;
+    scrutiny::VariableTypeType var_tt;
+    uint8_t bitoffset;
+    uint8_t bitsize;
+};
+
+static BitfieldCase const g_cases[] = {
+    {"uint8  off=2 size=3", scrutiny::VariableTypeType::_uint, 2, 3},
+    {"sint16 off=3 size=11", scrutiny::VariableTypeType::_sint, 3, 11},
+    {"sint32 off=7 size=18", scrutiny::VariableTypeType::_sint, 7, 18},
+#if SCRUTINY_SUPPORT_64BITS
+    {"sint64 off=7 size=37", scrutiny::VariableTypeType::_sint, 7, 37},
+#endif
+};
+
+// Former extraction, also kept by the unit tests as a reference. Unlike the library functions, the compiler may inline it in the
+// benchmark loop, which can only favor the baseline
+static bool baseline_fetch_variable_bitfield(
+    void const *const addr,
+    scrutiny::VariableTypeType const var_tt,
+    uint_fast8_t const bitoffset,
+    uint_fast8_t const bitsize,
+    scrutiny::AnyType *const val,
+    scrutiny::VariableType *const output_type)
+{
+    using scrutiny::VariableTypeSize;
+    using scrutiny::VariableTypeType;
+    namespace tools = scrutiny::tools;
+
+    bool success = true;
+    uint_fast8_t const fetch_required_size = ((bitoffset + bitsize - 1) >> 3) + 1;
+    uint_fast8_t const output_required_size = ((bitsize - 1) >> 3) + 1;
+    VariableTypeSize const fetch_type_size = tools::get_required_type_size(fetch_required_size);
+    VariableTypeSize const output_type_size = tools::get_required_type_size(output_required_size);
+    scrutiny::VariableType const output_variable_type = tools::make_type(var_tt, output_type_size);
+    uint8_t const fetch_size = tools::get_type_size(fetch_type_size);
+
+    if (bitsize == 0 || fetch_size == 0 || fetch_size > sizeof(scrutiny::uint_biggest_t))
+    {
+        success = false;
+    }
+    else if (var_tt == VariableTypeType::_sint || var_tt == VariableTypeType::_uint || var_tt == VariableTypeType::_boolean)
+    {
+        memcpy(val, addr, fetch_size);
+        if (fetch_type_size == VariableTypeSize::_8)
+        {
+            val->uint8 >>= bitoffset;
+        }
+        else if (fetch_type_size == VariableTypeSize::_16)
+        {
+            val->uint16 >>= bitoffset;
+        }
+        else if (fetch_type_size == VariableTypeSize::_32)
+        {
+            val->uint32 >>= bitoffset;
+        }
+#if SCRUTINY_SUPPORT_64BITS
+        else if (fetch_type_size == VariableTypeSize::_64)
+        {
+            val->uint64 >>= bitoffset;
+        }
+#endif
+
+        if (output_type_size == VariableTypeSize::_8)
+        {
+            uint8_t mask = 1;
+            for (uint_fast8_t i = 1; i < bitsize; i++)
+            {
+                mask |= static_cast<uint8_t>(1u << i);
+            }
+            val->uint8 &= mask;
+            if (var_tt == VariableTypeType::_sint && (val->uint8 >> (bitsize - 1)))
+            {
+                val->uint8 |= static_cast<uint8_t>(~mask);
+            }
+        }
+        else if (output_type_size == VariableTypeSize::_16)
+        {
+            uint16_t mask = 0x1FF;
+            for (uint_fast8_t i = 9; i < bitsize; i++)
+            {
+                mask |= static_cast<uint16_t>(1u << i);
+            }
+            val->uint16 &= mask;
+            if (var_tt == VariableTypeType::_sint && (val->uint16 >> (bitsize - 1)))
+            {
+                val->uint16 |= static_cast<uint16_t>(~mask);
+            }
+        }
+        else if (output_type_size == VariableTypeSize::_32)
+        {
+            uint32_t mask = 0x1FFFF;
+            for (uint_fast8_t i = 17; i < bitsize; i++)
+            {
+                mask |= (static_cast<uint32_t>(1) << i);
+            }
+            val->uint32 &= mask;
+            if (var_tt == VariableTypeType::_sint && (val->uint32 >> (bitsize - 1)))
+            {
+                val->uint32 |= ~mask;
+            }
+        }
+#if SCRUTINY_SUPPORT_64BITS
+        else if (output_type_size == VariableTypeSize::_64)
+        {
+            uint64_t mask = 0x1FFFFFFFF;
+            for (uint_fast8_t i = 33; i < bitsize; i++)
+            {
+                mask |= (static_cast<uint64_t>(1) << i);
+            }
+            val->uint64 &= mask;
+            if (var_tt == VariableTypeType::_sint && (val->uint64 >> (bitsize - 1)))
+            {
+                val->uint64 |= ~mask;
+            }
+        }
+#endif
+        else
+        {
+            success = false;
+        }
+    }
+    else
+    {
+        success = false;
+    }
+
+    *output_type = success ? output_variable_type : scrutiny::VariableType::unknown;
+    return success;
+}
+
+void benchmark_bitfield(uint32_t const iterations)
+{
+    scrutiny::MainHandler scrutiny_handler;
+    scrutiny::Config config;
+    uint8_t rx_buffer[64];
+    uint8_t tx_buffer[64];
+    uint8_t memory[16];
+
+    config.set_buffers(rx_buffer, sizeof(rx_buffer), tx_buffer, sizeof(tx_buffer));
+    scrutiny_handler.init(&config);
+    for (unsigned int i = 0; i < sizeof(memory); i++)
+    {
+        memory[i] = static_cast<uint8_t>(0x5A + i * 37);
+    }
+
+    std::cout << "Bitfield extraction (" << iterations << " iterations)" << std::endl;
+    for (unsigned int c = 0; c < sizeof(g_cases) / sizeof(g_cases[0]); c++)
+    {
+        BitfieldCase const *const bcase = &g_cases[c];
+        scrutiny::AnyType val;
+        scrutiny::VariableType outtype;
+        uint32_t checksum = 0;
+
+        BenchmarkTimer baseline_timer;
+        for (uint32_t i = 0; i < iterations; i++)
+        {
+            baseline_fetch_variable_bitfield(&memory[i & 7], bcase->var_tt, bcase->bitoffset, bcase->bitsize, &val, &outtype);
+            checksum += val.uint8;
+        }
+        double const baseline_ns = baseline_timer.ns_per_iteration(iterations);
+
+        BenchmarkTimer on_the_fly_timer;
+        for (uint32_t i = 0; i < iterations; i++)
+        {
+            scrutiny_handler.fetch_variable_bitfield(&memory[i & 7], bcase->var_tt, bcase->bitoffset, bcase->bitsize, &val, &outtype);
+            checksum += val.uint8;
+        }
+        double const on_the_fly_ns = on_the_fly_timer.ns_per_iteration(iterations);
+
+        scrutiny::tools::BitfieldDescriptor descriptor;
+        scrutiny::tools::make_bitfield_descriptor(bcase->var_tt, bcase->bitoffset, bcase->bitsize, &descriptor);
+        BenchmarkTimer precomputed_timer;
+        for (uint32_t i = 0; i < iterations; i++)
+        {
+            scrutiny_handler.fetch_variable_bitfield(&memory[i & 7], &descriptor, &val, &outtype);
+            checksum += val.uint8;
+        }
+        double const precomputed_ns = precomputed_timer.ns_per_iteration(iterations);
+
+        std::cout << "  " << std::left << std::setw(22) << bcase->name
+                  << " baseline: " << std::fixed << std::setprecision(2) << baseline_ns << " ns"
+                  << "  on the fly: " << on_the_fly_ns << " ns (x" << baseline_ns / on_the_fly_ns << ")"
+                  << "  precomputed: " << precomputed_ns << " ns (x" << baseline_ns / precomputed_ns << ")"
+                  << "  (checksum " << checksum << ")" << std::endl;
+    }
+}
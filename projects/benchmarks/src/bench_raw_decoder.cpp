@@ -0,0 +1,221 @@
+//    bench_raw_decoder.cpp
+//        Compares the throughput of the host side decoder of the datalogging acquisitions against a scalar
+//        decoder that converts one value at a time, for both read layouts. A mix of every kind of item, then
+//        numeric items only, whose Columns layout is byte swapped in bulk
+//
+//   - License : MIT - See LICENSE file.
+//   - Project : Scrutiny Debugger (github.com/scrutinydebugger/scrutiny-embedded)
+//
+//   Copyright (c) 2021 Scrutiny Debugger
+
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include "benchmarks.hpp"
+#include "scrutiny_raw_format_decoder.hpp"
+
+static uint32_t const ACQUISITION_SIZE = 4 * 1024 * 1024;
+
+static scrutiny::RuntimePublishedValue const g_rpvs[] = {
+    {0x1000, scrutiny::VariableType::float32},
+    {0x1001, scrutiny::VariableType::sint16},
+    {0x1002, scrutiny::VariableType::uint8},
+#if SCRUTINY_SUPPORT_64BITS
+    {0x1003, scrutiny::VariableType::float64},
+#endif
+};
+
+/// @brief A mix of every kind of item, like a typical acquisition. Only the TIME and the RPV items if numeric_only is set
+static void make_config(scrutiny::datalogging::Configuration *const config, bool const numeric_only)
+{
+    uint16_t n = 0;
+    config->items_to_log[n++].type = scrutiny::datalogging::LoggableType::TIME;
+    for (unsigned int i = 0; i < sizeof(g_rpvs) / sizeof(g_rpvs[0]); i++)
+    {
+        config->items_to_log[n].type = scrutiny::datalogging::LoggableType::RPV;
+        config->items_to_log[n++].data.rpv.id = g_rpvs[i].id;
+    }
+    if (numeric_only)
+    {
+        config->items_count = static_cast<uint8_t>(n);
+        return;
+    }
+    config->items_to_log[n].type = scrutiny::datalogging::LoggableType::MEMORY;
+    config->items_to_log[n].data.memory.address = nullptr; // Not used by the decoder
+    config->items_to_log[n++].data.memory.size = 4;
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        config->items_to_log[n].type = scrutiny::datalogging::LoggableType::VARBIT;
+        config->items_to_log[n++].data.varbit.bitsize = static_cast<uint8_t>(3 + i * 4);
+    }
+    config->items_count = static_cast<uint8_t>(n);
+}
+
+/// @brief A field of the entry, as seen by the scalar baseline
+struct BaselineField
+{
+    uint16_t offset;       // Position in the entry
+    uint16_t size;         // Number of bytes
+    uint16_t first_signal; // First signal stored in the field
+    uint16_t signal_count; // Number of signals stored in the field. More than 1 for a VARBIT group only
+};
+
+/// @brief Rebuilds the layout of the entry from the signals of a configured decoder
+static void make_baseline_fields(scrutiny::decoder::RawFormatDecoder const *const decoder, std::vector<BaselineField> *const fields)
+{
+    uint16_t offset = 0;
+    fields->clear();
+    for (uint16_t i = 0; i < decoder->signal_count(); i++)
+    {
+        scrutiny::decoder::Signal const *const signal = decoder->signal(i);
+        bool const varbit = signal->item_type() == scrutiny::datalogging::LoggableType::VARBIT;
+        if (varbit && signal->bitoffset() > 0)
+        {
+            BaselineField *const group = &fields->back();
+            group->size = static_cast<uint16_t>((signal->bitoffset() + signal->bitsize() + 7) / 8);
+            group->signal_count++;
+            offset = static_cast<uint16_t>(group->offset + group->size);
+            continue;
+        }
+
+        BaselineField field;
+        field.offset = offset;
+        field.size = varbit ? static_cast<uint16_t>((signal->bitsize() + 7) / 8) : signal->element_size();
+        field.first_signal = i;
+        field.signal_count = 1;
+        fields->push_back(field);
+        offset = static_cast<uint16_t>(offset + field.size);
+    }
+}
+
+/// @brief Decodes a single value the straightforward way: byte by byte, then the bits of a VARBIT item
+static uint64_t baseline_decode_value(scrutiny::decoder::Signal const *const signal, uint8_t const *const src, uint16_t const field_size)
+{
+    uint64_t value = 0;
+    if (signal->item_type() == scrutiny::datalogging::LoggableType::VARBIT)
+    {
+        for (uint16_t i = field_size; i > 0; i--)
+        {
+            value = (value << 8) | src[i - 1]; // VARBIT groups are packed LSB first
+        }
+        value >>= signal->bitoffset();
+        return (signal->bitsize() >= 64) ? value : value & ((static_cast<uint64_t>(1) << signal->bitsize()) - 1);
+    }
+
+    for (uint16_t i = 0; i < field_size; i++)
+    {
+        value = (value << 8) | src[i];
+    }
+    return value;
+}
+
+/// @brief Decodes the whole acquisition one value at a time, several times, and returns the throughput in MB/s
+static double baseline_throughput(scrutiny::decoder::RawFormatDecoder const *const decoder,
+                                  std::vector<uint8_t> const &data,
+                                  uint32_t const entry_count,
+                                  scrutiny::datalogging::ReadLayout const layout,
+                                  uint32_t const passes)
+{
+    std::vector<BaselineField> fields;
+    std::vector<std::vector<uint64_t> > values(decoder->signal_count());
+    make_baseline_fields(decoder, &fields);
+
+    BenchmarkTimer timer;
+    for (uint32_t pass = 0; pass < passes; pass++)
+    {
+        for (size_t i = 0; i < values.size(); i++)
+        {
+            values[i].resize(entry_count);
+        }
+
+        uint32_t column_start = 0;
+        for (size_t f = 0; f < fields.size(); f++)
+        {
+            BaselineField const *const field = &fields[f];
+            for (uint32_t entry = 0; entry < entry_count; entry++)
+            {
+                uint8_t const *const src = (layout == scrutiny::datalogging::ReadLayout::Columns)
+                                               ? &data[column_start + entry * field->size]
+                                               : &data[entry * decoder->entry_size() + field->offset];
+                for (uint16_t i = 0; i < field->signal_count; i++)
+                {
+                    uint16_t const index = static_cast<uint16_t>(field->first_signal + i);
+                    values[index][entry] = baseline_decode_value(decoder->signal(index), src, field->size);
+                }
+            }
+            column_start += entry_count * field->size;
+        }
+    }
+    double const ns_per_pass = timer.ns_per_iteration(passes);
+    return static_cast<double>(data.size()) / ns_per_pass * 1e9 / (1024.0 * 1024.0);
+}
+
+/// @brief Decodes the whole acquisition several times and returns the throughput in MB/s
+static double decode_throughput(scrutiny::decoder::RawFormatDecoder *const decoder,
+                                std::vector<uint8_t> const &data,
+                                uint32_t const entry_count,
+                                scrutiny::datalogging::ReadLayout const layout,
+                                uint32_t const chunk_size,
+                                uint32_t const passes)
+{
+    BenchmarkTimer timer;
+    for (uint32_t pass = 0; pass < passes; pass++)
+    {
+        decoder->start(layout, entry_count);
+        for (uint32_t cursor = 0; cursor < data.size(); cursor += chunk_size)
+        {
+            uint32_t const len = SCRUTINY_MIN(chunk_size, static_cast<uint32_t>(data.size()) - cursor);
+            decoder->feed(&data[cursor], len);
+        }
+    }
+    double const ns_per_pass = timer.ns_per_iteration(passes);
+    return static_cast<double>(data.size()) / ns_per_pass * 1e9 / (1024.0 * 1024.0);
+}
+
+static void benchmark_config(char const *const name, bool const numeric_only, uint32_t const iterations)
+{
+    scrutiny::datalogging::Configuration config;
+    scrutiny::decoder::RawFormatDecoder decoder;
+    make_config(&config, numeric_only);
+    if (!decoder.configure(&config, g_rpvs, sizeof(g_rpvs) / sizeof(g_rpvs[0])))
+    {
+        std::cerr << "Cannot configure the decoder" << std::endl;
+        return;
+    }
+
+    // The content does not matter. Only the size of the entries does.
+    uint32_t const entry_count = ACQUISITION_SIZE / decoder.entry_size();
+    std::vector<uint8_t> data(entry_count * decoder.entry_size());
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        data[i] = static_cast<uint8_t>(i * 37 + (i >> 8));
+    }
+
+    uint32_t const passes = SCRUTINY_MAX(iterations / 100000, static_cast<uint32_t>(1));
+    uint32_t const chunk_sizes[] = {256, 4096, static_cast<uint32_t>(data.size())};
+    std::cout << "RawFormat decoder, " << name << " (" << data.size() << " bytes, " << entry_count << " entries of " << decoder.entry_size() << " bytes, "
+              << passes << " passes)" << std::endl;
+
+    // Reference: one value at a time, byte by byte, over the whole buffer
+    double const baseline_rows = baseline_throughput(&decoder, data, entry_count, scrutiny::datalogging::ReadLayout::Rows, passes);
+    double const baseline_columns = baseline_throughput(&decoder, data, entry_count, scrutiny::datalogging::ReadLayout::Columns, passes);
+    std::cout << "  scalar baseline    "
+              << " rows: " << std::fixed << std::setprecision(1) << baseline_rows << " MB/s"
+              << "  columns: " << baseline_columns << " MB/s" << std::endl;
+
+    for (unsigned int i = 0; i < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); i++)
+    {
+        double const rows = decode_throughput(&decoder, data, entry_count, scrutiny::datalogging::ReadLayout::Rows, chunk_sizes[i], passes);
+        double const columns = decode_throughput(&decoder, data, entry_count, scrutiny::datalogging::ReadLayout::Columns, chunk_sizes[i], passes);
+        std::cout << "  chunks of " << std::left << std::setw(8) << chunk_sizes[i]
+                  << " rows: " << std::fixed << std::setprecision(1) << rows << " MB/s (x" << std::setprecision(2) << rows / baseline_rows << ")"
+                  << "  columns: " << std::setprecision(1) << columns << " MB/s (x" << std::setprecision(2) << columns / baseline_columns << ")"
+                  << "  (" << decoder.entry_count() << " entries decoded)" << std::endl;
+    }
+}
+
+void benchmark_raw_decoder(uint32_t const iterations)
+{
+    benchmark_config("all item types", false, iterations);
+    benchmark_config("numeric items only", true, iterations);
+}
@@ -0,0 +1,36 @@
+//    main.cpp
+//        Entry point of the benchmark application
+//
+//   - License : MIT - See LICENSE file.
+//   - Project : Scrutiny Debugger (github.com/scrutinydebugger/scrutiny-embedded)
+//
+//   Copyright (c) 2021 Scrutiny Debugger
+
+#include <cstdlib>
+#include <iostream>
+#include "benchmarks.hpp"
+
+int main(int argc, char *argv[])
+{
+    uint32_t iterations = 1000000;
+    if (argc > 1)
+    {
+        iterations = static_cast<uint32_t>(strtoul(argv[1], nullptr, 10));
+    }
+
+    if (iterations == 0)
+    {
+        std::cerr << "Usage: " << argv[0] << " [iterations]" << std::endl;
+        return -1;
+    }
+
+#if SCRUTINY_ENABLE_DATALOGGING
+    benchmark_bitfield(iterations);
+#endif
+
+#if SCRUTINY_BENCHMARK_DECODER
+    benchmark_raw_decoder(iterations);
+#endif
+
+    return 0;
+}
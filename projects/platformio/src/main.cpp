@@ -29,6 +29,7 @@ void setup()
     config.set_buffers(scrutiny_rx_buffer, sizeof(scrutiny_rx_buffer), scrutiny_tx_buffer, sizeof(scrutiny_tx_buffer));
     config.max_bitrate = 100000;
     config.display_name = "Arduino";
+    config.response_streaming = true; // Large reads do not need to fit in the small tx buffer
 
     scrutiny_handler.init(&config);
     printf("Scrutiny rdy\n");
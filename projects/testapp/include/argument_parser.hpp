@@ -32,6 +32,27 @@ struct SerialConfig
     uint32_t baudrate;
 };
 
+struct UdpConfig
+{
+    unsigned int batch_size; // Number of datagrams moved per system call. 1 for no batching
+    int busy_poll_us;        // SO_BUSY_POLL value. 0 to keep the system default
+    int rcvbuf_size;         // SO_RCVBUF value. 0 to keep the system default
+    bool datagram_framing;   // One Scrutiny frame per datagram instead of a byte stream
+};
+
+struct DataloggingFileConfig
+{
+    std::string filename; // Empty when the datalogging buffer in RAM must be used
+    uint32_t size;
+};
+
+struct LoopThreadsConfig
+{
+    bool enabled;      // Runs each loop handler in its own thread
+    int first_cpu;     // Loop thread N is pinned to core first_cpu+N. -1 for no pinning
+    int fifo_priority; // SCHED_FIFO priority of the loop threads. -1 to keep the default scheduler
+};
+
 class ArgumentParser
 {
 public:
@@ -46,19 +67,30 @@ public:
     void next_memory_region(MemoryRegion *region);
     bool has_another_memory_region();
     inline uint16_t udp_port() { return m_udp_port; }
+    inline const UdpConfig &udp_config() { return m_udp_config; }
     inline const SerialConfig &serial_config() { return m_serial_config; }
+    inline const DataloggingFileConfig &datalogging_file_config() { return m_datalogging_file_config; }
+    inline bool use_sleep_loop() { return m_use_sleep_loop; }
+    inline const LoopThreadsConfig &loop_threads_config() { return m_loop_threads_config; }
     inline TestAppCommand command() { return m_command; }
     inline bool is_valid() { return m_valid; }
     std::string error_message() { return m_last_error; }
 
 protected:
+    bool parse_listen_option(int32_t *i, bool *arg_error);
+    bool parse_udp_option(int32_t *i, bool *arg_error);
+
     bool m_valid;
     TestAppCommand m_command;
     unsigned int m_region_index;
     unsigned int m_argc;
     char **m_argv;
     uint16_t m_udp_port;
+    UdpConfig m_udp_config;
     SerialConfig m_serial_config;
+    DataloggingFileConfig m_datalogging_file_config;
+    bool m_use_sleep_loop;
+    LoopThreadsConfig m_loop_threads_config;
     std::string m_last_error;
 };
 
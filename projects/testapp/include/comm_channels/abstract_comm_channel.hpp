@@ -20,6 +20,10 @@ public:
     virtual void stop() = 0;
     virtual void send(uint8_t const *buffer, int len) = 0;
     virtual int receive(uint8_t *buffer, int len) = 0;
+    virtual int get_fd() const { return -1; } // File descriptor that becomes readable when data arrives. -1 if the channel can only be polled
+    virtual void flush() {}                   // Sends what a channel may have queued by send()
+    virtual void report_stats() {}            // Prints and resets the channel statistics, if any
+    virtual uint16_t datagram_mtu() const { return 0; } // Biggest frame when each send/receive carries exactly one frame. 0 for a byte stream
 };
 
 #endif // ___ABSTRACT_COMM_CHANNEL_H___
\ No newline at end of file
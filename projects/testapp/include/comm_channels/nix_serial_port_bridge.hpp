@@ -31,6 +31,7 @@ public:
     virtual void start();
     virtual int receive(uint8_t *buffer, int len);
     virtual void send(uint8_t const *buffer, int len);
+    virtual int get_fd() const { return m_fd; }
 
     static void throw_system_error(const std::string &msg);
 
@@ -10,6 +10,7 @@
 #define ___UDP_BRIDGE_H___
 
 #include <system_error>
+#include <vector>
 
 #if SCRUTINY_BUILD_WINDOWS
 #include <winsock2.h>
@@ -19,6 +20,12 @@
 #include <unistd.h>
 #endif
 
+#if defined(__linux__)
+#define UDP_BRIDGE_HAS_MMSG 1 // recvmmsg/sendmmsg are available
+#else
+#define UDP_BRIDGE_HAS_MMSG 0
+#endif
+
 #if SCRUTINY_BUILD_WINDOWS
 #define ISVALIDSOCKET(s) ((s) != INVALID_SOCKET)
 #define CLOSESOCKET(s) closesocket(s)
@@ -35,9 +42,23 @@ typedef sockaddr SOCKADDR;
 
 #include "abstract_comm_channel.hpp"
 
+// Count of datagrams moved per system call
+struct UdpBatchStats
+{
+    uint32_t rx_calls;     // Number of receive system calls that returned data
+    uint32_t rx_datagrams; // Number of datagrams received
+    uint32_t rx_max_batch; // Biggest number of datagrams received by a single call
+    uint32_t tx_calls;     // Number of send system calls
+    uint32_t tx_datagrams; // Number of datagrams sent
+    uint32_t tx_max_batch; // Biggest number of datagrams sent by a single call
+};
+
 class UdpBridge : public AbstractCommChannel
 {
 public:
+    static constexpr unsigned int MAX_BATCHED_DATAGRAM_SIZE = 2048; // Bigger datagrams are truncated on reception and sent alone on transmission
+    static constexpr uint16_t DATAGRAM_MTU = 1472;                  // Biggest UDP payload that fits an Ethernet frame without fragmentation
+
     UdpBridge(uint16_t port);
 
     static void global_init();
@@ -50,14 +71,54 @@ public:
     virtual void stop();
     virtual void send(uint8_t const *buffer, int len) { send(buffer, len, 0); }
     virtual int receive(uint8_t *buffer, int len) { return receive(buffer, len, 0); }
+#if !SCRUTINY_BUILD_WINDOWS
+    virtual int get_fd() const { return m_sock; }
+#endif
+    virtual void flush();
+    virtual void report_stats();
+    virtual uint16_t datagram_mtu() const { return m_datagram_framing ? DATAGRAM_MTU : 0; }
+
+    // Tuning, to be set before start()
+    void set_batch_size(unsigned int batch_size);
+    inline void set_busy_poll(int busy_poll_us) { m_busy_poll_us = busy_poll_us; }
+    inline void set_receive_buffer_size(int size) { m_rcvbuf_size = size; }
+    inline void set_datagram_framing(bool enabled) { m_datagram_framing = enabled; }
 
     void set_nonblocking();
     static void throw_system_error(char const *msg);
 
 private:
+    void apply_socket_options();
+#if UDP_BRIDGE_HAS_MMSG
+    int receive_batched(uint8_t *buffer, int len, int flags);
+    void queue_send(uint8_t const *buffer, int len, int flags);
+#endif
+    void reset_stats();
+
     uint16_t m_port;
     SOCKET m_sock;               // SOCKET = int for linux, SOCKET for windows
     SOCKADDR m_last_packet_addr; // SOCKADDR = sockaddr for linux, SOCKADDR for windows
+    unsigned int m_batch_size;   // Max number of datagrams per system call. 1 disables batching
+    int m_busy_poll_us;          // SO_BUSY_POLL value. 0 to leave untouched
+    int m_rcvbuf_size;           // SO_RCVBUF value. 0 to leave untouched
+    bool m_datagram_framing;     // One Scrutiny frame per datagram
+    UdpBatchStats m_stats;
+
+#if UDP_BRIDGE_HAS_MMSG
+    // One slot of MAX_BATCHED_DATAGRAM_SIZE per datagram in each direction
+    std::vector<uint8_t> m_rx_storage;
+    std::vector<uint8_t> m_tx_storage;
+    std::vector<mmsghdr> m_rx_msgs;
+    std::vector<mmsghdr> m_tx_msgs;
+    std::vector<iovec> m_rx_iovecs;
+    std::vector<iovec> m_tx_iovecs;
+    std::vector<sockaddr> m_rx_addrs; // Sender of each received datagram
+    std::vector<sockaddr> m_tx_addrs; // Destination of each queued datagram
+    unsigned int m_rx_count;          // Number of datagrams in the current received batch
+    unsigned int m_rx_index;          // Next datagram of the received batch to give to receive()
+    unsigned int m_tx_count;          // Number of queued datagrams
+    int m_tx_flags;                   // Flags given to send() for the queued datagrams
+#endif
 
 #if SCRUTINY_BUILD_WINDOWS
     static WSAData wsa_data;
@@ -0,0 +1,46 @@
+//    epoll_event_loop.hpp
+//        Linux event loop based on epoll and timerfd. Wakes the Testapp when data arrives on the
+//        communication channel or when a loop handler is due, instead of polling.
+//
+//   - License : MIT - See LICENSE file.
+//   - Project : Scrutiny Debugger (github.com/scrutinydebugger/scrutiny-embedded)
+//
+//   Copyright (c) 2021 Scrutiny Debugger
+
+#ifndef ___EPOLL_EVENT_LOOP_H___
+#define ___EPOLL_EVENT_LOOP_H___
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+class EpollEventLoop
+{
+public:
+    typedef std::function<void()> callback_t;
+
+    EpollEventLoop();
+    ~EpollEventLoop();
+
+    void add_readable(int fd, callback_t callback);
+    void add_periodic_timer(uint32_t period_us, callback_t callback);
+    void run_once(int timeout_ms = -1);
+
+    static void throw_system_error(const std::string &msg);
+
+private:
+    struct Source
+    {
+        int fd;
+        bool is_timer;
+        callback_t callback;
+    };
+
+    void add_source(int fd, bool is_timer, callback_t callback);
+
+    int m_epoll_fd;
+    std::vector<Source> m_sources;
+};
+
+#endif // ___EPOLL_EVENT_LOOP_H___
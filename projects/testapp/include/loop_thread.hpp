@@ -0,0 +1,58 @@
+//    loop_thread.hpp
+//        Runs a loop handler of the Testapp in its own thread on an absolute-deadline schedule,
+//        optionally pinned to a core with SCHED_FIFO, and measures its wake-up jitter.
+//
+//   - License : MIT - See LICENSE file.
+//   - Project : Scrutiny Debugger (github.com/scrutinydebugger/scrutiny-embedded)
+//
+//   Copyright (c) 2021 Scrutiny Debugger
+
+#ifndef ___LOOP_THREAD_H___
+#define ___LOOP_THREAD_H___
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+struct JitterStats
+{
+    uint32_t count;        // Number of wake-ups measured
+    int64_t min_ns;        // Smallest lateness of a wake-up compared to its deadline
+    int64_t max_ns;        // Biggest lateness of a wake-up compared to its deadline
+    int64_t sum_ns;        // Sum of the lateness, to compute the average
+    uint32_t overruns;     // Number of periods where the body finished after the next deadline
+};
+
+class LoopThread
+{
+public:
+    typedef std::function<void(uint32_t timestep_us)> body_t;
+
+    LoopThread(const std::string &name, uint32_t period_us, body_t body, int cpu = -1, int fifo_priority = -1);
+    ~LoopThread();
+
+    void start();
+    void stop();
+    JitterStats pop_stats();
+    inline const std::string &name() const { return m_name; }
+
+private:
+    void run();
+    void configure_thread();
+    void reset_stats();
+
+    std::string m_name;
+    uint32_t m_period_us;
+    body_t m_body;
+    int m_cpu;
+    int m_fifo_priority;
+    std::atomic<bool> m_running;
+    std::thread m_thread;
+    std::mutex m_stats_mutex;
+    JitterStats m_stats;
+};
+
+#endif // ___LOOP_THREAD_H___
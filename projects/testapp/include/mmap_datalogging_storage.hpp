@@ -0,0 +1,55 @@
+//    mmap_datalogging_storage.hpp
+//        Datalogging storage backed by a memory-mapped file, so that the Testapp can log more data
+//        than what fits in RAM and keep the last acquisition on disk.
+//
+//   - License : MIT - See LICENSE file.
+//   - Project : Scrutiny Debugger (github.com/scrutinydebugger/scrutiny-embedded)
+//
+//   Copyright (c) 2021 Scrutiny Debugger
+
+#ifndef ___MMAP_DATALOGGING_STORAGE_H___
+#define ___MMAP_DATALOGGING_STORAGE_H___
+
+#include "scrutiny_setup.hpp"
+
+#if SCRUTINY_BUILD_WINDOWS
+#error "This file cannot be compiled under Windows"
+#endif
+
+#if SCRUTINY_ENABLE_DATALOGGING == 0
+#error "Not enabled"
+#endif
+
+#include "scrutiny.hpp"
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+
+/// @brief The whole file is mapped once by open(). The datalogger gets windows in that mapping without any system call,
+/// and the file is synchronized by process(), outside of the real-time loops.
+class MmapDataloggingStorage : public scrutiny::datalogging::Storage
+{
+public:
+    MmapDataloggingStorage(const std::string &filename, scrutiny::datalogging::buffer_size_t size);
+    ~MmapDataloggingStorage();
+
+    void open();
+    void close();
+
+    virtual scrutiny::datalogging::buffer_size_t size(void) const override;
+    virtual bool map(scrutiny::datalogging::buffer_size_t const offset, scrutiny::datalogging::buffer_size_t const length, scrutiny::datalogging::StorageWindow *const window) override;
+    virtual void flush(void) override;
+    virtual void process(void) override;
+
+    static void throw_system_error(const std::string &msg);
+
+private:
+    std::string m_filename;
+    scrutiny::datalogging::buffer_size_t m_size;
+    int m_fd;
+    uint8_t *m_data;                     // The whole file, mapped
+    std::atomic<bool> m_flush_requested; // Set by flush() in the loop context, served by process()
+};
+
+#endif // ___MMAP_DATALOGGING_STORAGE_H___
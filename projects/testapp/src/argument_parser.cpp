@@ -21,7 +21,15 @@ ArgumentParser::ArgumentParser() :
     m_argv(nullptr),
     m_last_error()
 {
-
+    m_datalogging_file_config.size = 0x100000;
+    m_use_sleep_loop = false;
+    m_udp_config.batch_size = 1;
+    m_udp_config.busy_poll_us = 0;
+    m_udp_config.rcvbuf_size = 0;
+    m_udp_config.datagram_framing = false;
+    m_loop_threads_config.enabled = false;
+    m_loop_threads_config.first_cpu = -1;
+    m_loop_threads_config.fifo_priority = -1;
 }
 
 void ArgumentParser::parse(int argc, char* argv[])
@@ -60,7 +68,15 @@ void ArgumentParser::parse(int argc, char* argv[])
             if (port > 0 && port <0x10000)
             {
                 m_udp_port = static_cast<uint16_t>(port);
-                m_valid = true;
+                bool arg_error = false;
+                for (int32_t i=3; i<argc && !arg_error; i++)
+                {
+                    if (!parse_udp_option(&i, &arg_error))
+                    {
+                        parse_listen_option(&i, &arg_error);
+                    }
+                }
+                m_valid = !arg_error;
             }
             else
             {
@@ -103,6 +119,10 @@ void ArgumentParser::parse(int argc, char* argv[])
                     }
                     m_serial_config.baudrate = static_cast<uint32_t>(baudrate);
                 }
+                else if (!parse_listen_option(&i, &arg_error) && arg_error)
+                {
+                    break;
+                }
             }
 
             if (!arg_error)
@@ -121,6 +141,115 @@ void ArgumentParser::parse(int argc, char* argv[])
     }
 }
 
+// Parse the options common to the listen commands.
+// Returns true if the argument at index *i was a known option and moves *i to its last consumed argument.
+bool ArgumentParser::parse_listen_option(int32_t *i, bool *arg_error)
+{
+    std::string arg(m_argv[*i]);
+    if (arg == "--sleep-loop")
+    {
+        m_use_sleep_loop = true; // Portable polling loop instead of the event loop
+        return true;
+    }
+
+    if (arg == "--loop-threads")
+    {
+        m_loop_threads_config.enabled = true;
+        return true;
+    }
+
+    if (arg != "--dl-file" && arg != "--dl-file-size" && arg != "--cpu" && arg != "--sched-fifo")
+    {
+        return false;
+    }
+
+    if (*i+1 >= static_cast<int32_t>(m_argc))
+    {
+        m_last_error = std::string("Missing value for ") + arg;
+        *arg_error = true;
+        return true;
+    }
+
+    if (arg == "--dl-file")
+    {
+        m_datalogging_file_config.filename = m_argv[*i+1];
+    }
+    else if (arg == "--cpu" || arg == "--sched-fifo")
+    {
+        int value = atoi(m_argv[*i+1]);
+        if (value < 0 || (arg == "--sched-fifo" && (value < 1 || value > 99)))
+        {
+            m_last_error = std::string("Invalid value for ") + arg;
+            *arg_error = true;
+            return true;
+        }
+        int *const dst = (arg == "--cpu") ? &m_loop_threads_config.first_cpu : &m_loop_threads_config.fifo_priority;
+        *dst = value;
+    }
+    else
+    {
+        long long size = strtoll(m_argv[*i+1], NULL, 0);
+        if (size <= 0 || size > 0x7FFFFFFF)
+        {
+            m_last_error = "Invalid datalogging file size";
+            *arg_error = true;
+            return true;
+        }
+        m_datalogging_file_config.size = static_cast<uint32_t>(size);
+    }
+
+    *i += 1;
+    return true;
+}
+
+// Parse the options specific to udp-listen.
+// Returns true if the argument at index *i was a known option and moves *i to its last consumed argument.
+bool ArgumentParser::parse_udp_option(int32_t *i, bool *arg_error)
+{
+    std::string arg(m_argv[*i]);
+    if (arg == "--datagram")
+    {
+        m_udp_config.datagram_framing = true;
+        return true;
+    }
+
+    if (arg != "--udp-batch" && arg != "--busy-poll" && arg != "--rcvbuf")
+    {
+        return false;
+    }
+
+    if (*i+1 >= static_cast<int32_t>(m_argc))
+    {
+        m_last_error = std::string("Missing value for ") + arg;
+        *arg_error = true;
+        return true;
+    }
+
+    int value = atoi(m_argv[*i+1]);
+    if (value < 0 || (arg == "--udp-batch" && (value < 1 || value > 1024)))
+    {
+        m_last_error = std::string("Invalid value for ") + arg;
+        *arg_error = true;
+        return true;
+    }
+
+    if (arg == "--udp-batch")
+    {
+        m_udp_config.batch_size = static_cast<unsigned int>(value);
+    }
+    else if (arg == "--busy-poll")
+    {
+        m_udp_config.busy_poll_us = value;
+    }
+    else
+    {
+        m_udp_config.rcvbuf_size = value;
+    }
+
+    *i += 1;
+    return true;
+}
+
 bool ArgumentParser::has_another_memory_region()
 {
     if (m_argc < 2)
@@ -12,6 +12,8 @@
 #include <chrono>
 #include <cstdlib>
 #include <cstdint>
+#include <cstring>
+#include <iostream>
 
 #if SCRUTINY_BUILD_WINDOWS
 #include <windows.h>
@@ -21,8 +23,40 @@ WSAData UdpBridge::wsa_data;
 #endif
 
 UdpBridge::UdpBridge(uint16_t port) : m_port(port),
-                                      m_sock(INVALID_SOCKET)
+                                      m_sock(INVALID_SOCKET),
+                                      m_batch_size(1),
+                                      m_busy_poll_us(0),
+                                      m_rcvbuf_size(0),
+                                      m_datagram_framing(false)
 {
+#if UDP_BRIDGE_HAS_MMSG
+    m_rx_count = 0;
+    m_rx_index = 0;
+    m_tx_count = 0;
+    m_tx_flags = 0;
+#endif
+    reset_stats();
+}
+
+void UdpBridge::set_batch_size(unsigned int batch_size)
+{
+#if UDP_BRIDGE_HAS_MMSG
+    m_batch_size = (batch_size == 0) ? 1 : batch_size;
+    m_rx_storage.assign(m_batch_size * MAX_BATCHED_DATAGRAM_SIZE, 0);
+    m_tx_storage.assign(m_batch_size * MAX_BATCHED_DATAGRAM_SIZE, 0);
+    m_rx_msgs.assign(m_batch_size, mmsghdr());
+    m_tx_msgs.assign(m_batch_size, mmsghdr());
+    m_rx_iovecs.assign(m_batch_size, iovec());
+    m_tx_iovecs.assign(m_batch_size, iovec());
+    m_rx_addrs.assign(m_batch_size, sockaddr());
+    m_tx_addrs.assign(m_batch_size, sockaddr());
+    m_rx_count = 0;
+    m_rx_index = 0;
+    m_tx_count = 0;
+#else
+    (void)batch_size;
+    m_batch_size = 1; // No batched system calls on this platform
+#endif
 }
 
 void UdpBridge::global_init()
@@ -54,6 +88,7 @@ void UdpBridge::start()
     }
 
     set_nonblocking(); // Set m_sock non blocking
+    apply_socket_options();
 
     sockaddr_in addr;
     addr.sin_family = AF_INET;
@@ -68,6 +103,29 @@ void UdpBridge::start()
     }
 }
 
+void UdpBridge::apply_socket_options()
+{
+    if (m_rcvbuf_size > 0)
+    {
+        if (setsockopt(m_sock, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<char const *>(&m_rcvbuf_size), sizeof(m_rcvbuf_size)) != 0)
+        {
+            throw_system_error("Cannot set SO_RCVBUF");
+        }
+    }
+
+    if (m_busy_poll_us > 0)
+    {
+#if defined(SO_BUSY_POLL)
+        if (setsockopt(m_sock, SOL_SOCKET, SO_BUSY_POLL, reinterpret_cast<char const *>(&m_busy_poll_us), sizeof(m_busy_poll_us)) != 0)
+        {
+            throw_system_error("Cannot set SO_BUSY_POLL");
+        }
+#else
+        std::cerr << "SO_BUSY_POLL is not supported on this platform" << std::endl;
+#endif
+    }
+}
+
 void UdpBridge::set_nonblocking()
 {
 #if SCRUTINY_BUILD_WINDOWS
@@ -107,6 +165,13 @@ void UdpBridge::stop()
 
 int UdpBridge::receive(uint8_t *buffer, int len, int flags)
 {
+#if UDP_BRIDGE_HAS_MMSG
+    if (m_batch_size > 1)
+    {
+        return receive_batched(buffer, len, flags);
+    }
+#endif
+
 #if SCRUTINY_BUILD_WINDOWS
     int size = sizeof(m_last_packet_addr);
 #else
@@ -131,11 +196,30 @@ int UdpBridge::receive(uint8_t *buffer, int len, int flags)
         }
     }
 
+    if (ret > 0)
+    {
+        m_stats.rx_calls++;
+        m_stats.rx_datagrams++;
+        m_stats.rx_max_batch = 1;
+    }
+
     return ret;
 }
 
 void UdpBridge::send(uint8_t const *buffer, int len, int flags)
 {
+#if UDP_BRIDGE_HAS_MMSG
+    if (m_batch_size > 1 && len <= static_cast<int>(MAX_BATCHED_DATAGRAM_SIZE))
+    {
+        queue_send(buffer, len, flags);
+        return;
+    }
+    flush(); // Keeps the datagrams in order
+#endif
+
+    m_stats.tx_calls++;
+    m_stats.tx_datagrams++;
+    m_stats.tx_max_batch = (m_stats.tx_max_batch > 1) ? m_stats.tx_max_batch : 1;
     int ret = sendto(m_sock, reinterpret_cast<char const *>(buffer), len, flags, &m_last_packet_addr, sizeof(m_last_packet_addr));
 
     if (ret < 0)
@@ -143,3 +227,121 @@ void UdpBridge::send(uint8_t const *buffer, int len, int flags)
         throw_system_error("sendto failed");
     }
 }
+
+void UdpBridge::flush()
+{
+#if UDP_BRIDGE_HAS_MMSG
+    unsigned int sent = 0;
+    while (sent < m_tx_count)
+    {
+        int const ret = sendmmsg(m_sock, &m_tx_msgs[sent], m_tx_count - sent, m_tx_flags);
+        if (ret < 0)
+        {
+            m_tx_count = 0;
+            throw_system_error("sendmmsg failed");
+        }
+
+        m_stats.tx_calls++;
+        m_stats.tx_datagrams += static_cast<uint32_t>(ret);
+        m_stats.tx_max_batch = (static_cast<uint32_t>(ret) > m_stats.tx_max_batch) ? static_cast<uint32_t>(ret) : m_stats.tx_max_batch;
+        sent += static_cast<unsigned int>(ret);
+    }
+    m_tx_count = 0;
+#endif
+}
+
+void UdpBridge::report_stats()
+{
+    if (m_stats.rx_calls > 0 || m_stats.tx_calls > 0)
+    {
+        std::cout << std::dec << "UDP batches: rx " << m_stats.rx_datagrams << " datagrams in " << m_stats.rx_calls << " calls (max " << m_stats.rx_max_batch << "), "
+                  << "tx " << m_stats.tx_datagrams << " datagrams in " << m_stats.tx_calls << " calls (max " << m_stats.tx_max_batch << ")" << std::endl;
+    }
+    reset_stats();
+}
+
+void UdpBridge::reset_stats()
+{
+    memset(&m_stats, 0, sizeof(m_stats));
+}
+
+#if UDP_BRIDGE_HAS_MMSG
+// Gives the datagrams one by one from a batch read with a single recvmmsg.
+// Each reply goes to the sender of the datagram last given by this function.
+int UdpBridge::receive_batched(uint8_t *buffer, int len, int flags)
+{
+    if (m_rx_index >= m_rx_count)
+    {
+        m_rx_index = 0;
+        m_rx_count = 0;
+        for (unsigned int i = 0; i < m_batch_size; i++)
+        {
+            m_rx_iovecs[i].iov_base = &m_rx_storage[i * MAX_BATCHED_DATAGRAM_SIZE];
+            m_rx_iovecs[i].iov_len = MAX_BATCHED_DATAGRAM_SIZE;
+            memset(&m_rx_msgs[i], 0, sizeof(m_rx_msgs[i]));
+            m_rx_msgs[i].msg_hdr.msg_iov = &m_rx_iovecs[i];
+            m_rx_msgs[i].msg_hdr.msg_iovlen = 1;
+            m_rx_msgs[i].msg_hdr.msg_name = &m_rx_addrs[i];
+            m_rx_msgs[i].msg_hdr.msg_namelen = sizeof(m_rx_addrs[i]);
+        }
+
+        int const ret = recvmmsg(m_sock, m_rx_msgs.data(), m_batch_size, flags | MSG_DONTWAIT, nullptr);
+        if (ret < 0)
+        {
+            int const errorcode = GETSOCKETERRNO();
+            if (errorcode == EWOULDBLOCK || errorcode == EAGAIN) // Need to check both as per unix manual
+            {
+                return 0;
+            }
+            throw_system_error("recvmmsg failed");
+        }
+
+        m_rx_count = static_cast<unsigned int>(ret);
+        if (m_rx_count > 0)
+        {
+            m_stats.rx_calls++;
+            m_stats.rx_datagrams += m_rx_count;
+            m_stats.rx_max_batch = (m_rx_count > m_stats.rx_max_batch) ? m_rx_count : m_stats.rx_max_batch;
+        }
+    }
+
+    if (m_rx_index >= m_rx_count)
+    {
+        return 0;
+    }
+
+    unsigned int const index = m_rx_index++;
+    unsigned int const datagram_len = m_rx_msgs[index].msg_len;
+    unsigned int const copy_len = (datagram_len < static_cast<unsigned int>(len)) ? datagram_len : static_cast<unsigned int>(len);
+    memcpy(buffer, &m_rx_storage[index * MAX_BATCHED_DATAGRAM_SIZE], copy_len);
+    m_last_packet_addr = m_rx_addrs[index];
+    return static_cast<int>(copy_len);
+}
+
+// Copies a datagram in the transmit batch. The batch is sent by flush() or when it is full.
+void UdpBridge::queue_send(uint8_t const *buffer, int len, int flags)
+{
+    if (m_tx_count > 0 && flags != m_tx_flags)
+    {
+        flush();
+    }
+
+    unsigned int const index = m_tx_count++;
+    uint8_t *const slot = &m_tx_storage[index * MAX_BATCHED_DATAGRAM_SIZE];
+    memcpy(slot, buffer, static_cast<size_t>(len));
+    m_tx_addrs[index] = m_last_packet_addr;
+    m_tx_iovecs[index].iov_base = slot;
+    m_tx_iovecs[index].iov_len = static_cast<size_t>(len);
+    memset(&m_tx_msgs[index], 0, sizeof(m_tx_msgs[index]));
+    m_tx_msgs[index].msg_hdr.msg_iov = &m_tx_iovecs[index];
+    m_tx_msgs[index].msg_hdr.msg_iovlen = 1;
+    m_tx_msgs[index].msg_hdr.msg_name = &m_tx_addrs[index];
+    m_tx_msgs[index].msg_hdr.msg_namelen = sizeof(m_tx_addrs[index]);
+    m_tx_flags = flags;
+
+    if (m_tx_count >= m_batch_size)
+    {
+        flush();
+    }
+}
+#endif
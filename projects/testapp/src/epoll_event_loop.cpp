@@ -0,0 +1,113 @@
+//    epoll_event_loop.cpp
+//        Linux event loop based on epoll and timerfd. Wakes the Testapp when data arrives on the
+//        communication channel or when a loop handler is due, instead of polling.
+//
+//   - License : MIT - See LICENSE file.
+//   - Project : Scrutiny Debugger (github.com/scrutinydebugger/scrutiny-embedded)
+//
+//   Copyright (c) 2021 Scrutiny Debugger
+
+#include "epoll_event_loop.hpp"
+#include <cstdint>
+#include <string>
+#include <system_error>
+
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+EpollEventLoop::EpollEventLoop() : m_epoll_fd(-1),
+                                   m_sources()
+{
+    m_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (m_epoll_fd < 0)
+    {
+        throw_system_error("epoll_create1 failed");
+    }
+}
+
+EpollEventLoop::~EpollEventLoop()
+{
+    for (size_t i = 0; i < m_sources.size(); i++)
+    {
+        if (m_sources[i].is_timer)
+        {
+            close(m_sources[i].fd); // Timers belong to the loop. Other fds belong to the caller
+        }
+    }
+    close(m_epoll_fd);
+}
+
+void EpollEventLoop::add_readable(int fd, callback_t callback)
+{
+    add_source(fd, false, callback);
+}
+
+void EpollEventLoop::add_periodic_timer(uint32_t period_us, callback_t callback)
+{
+    int const fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0)
+    {
+        throw_system_error("timerfd_create failed");
+    }
+
+    itimerspec spec;
+    spec.it_interval.tv_sec = period_us / 1000000u;
+    spec.it_interval.tv_nsec = static_cast<long>(period_us % 1000000u) * 1000;
+    spec.it_value = spec.it_interval; // First expiration one period from now
+    if (timerfd_settime(fd, 0, &spec, nullptr) != 0)
+    {
+        close(fd);
+        throw_system_error("timerfd_settime failed");
+    }
+
+    add_source(fd, true, callback);
+}
+
+void EpollEventLoop::add_source(int fd, bool is_timer, callback_t callback)
+{
+    m_sources.push_back({fd, is_timer, callback});
+
+    epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.u64 = m_sources.size() - 1;
+    if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0)
+    {
+        throw_system_error("epoll_ctl failed");
+    }
+}
+
+void EpollEventLoop::run_once(int timeout_ms)
+{
+    epoll_event events[8];
+    int const n = epoll_wait(m_epoll_fd, events, sizeof(events) / sizeof(events[0]), timeout_ms);
+    if (n < 0)
+    {
+        if (errno == EINTR)
+        {
+            return;
+        }
+        throw_system_error("epoll_wait failed");
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        Source &source = m_sources[events[i].data.u64];
+        if (source.is_timer)
+        {
+            // Acknowledge the expiration. If we were late, the missed periods are dropped rather than run in a burst
+            uint64_t expirations;
+            if (read(source.fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+            {
+                continue;
+            }
+        }
+        source.callback();
+    }
+}
+
+void EpollEventLoop::throw_system_error(const std::string &msg)
+{
+    throw std::system_error(errno, std::system_category(), msg.c_str());
+}
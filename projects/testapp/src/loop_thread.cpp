@@ -0,0 +1,163 @@
+//    loop_thread.cpp
+//        Runs a loop handler of the Testapp in its own thread on an absolute-deadline schedule,
+//        optionally pinned to a core with SCHED_FIFO, and measures its wake-up jitter.
+//
+//   - License : MIT - See LICENSE file.
+//   - Project : Scrutiny Debugger (github.com/scrutinydebugger/scrutiny-embedded)
+//
+//   Copyright (c) 2021 Scrutiny Debugger
+
+#include "loop_thread.hpp"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+static constexpr int64_t NSEC_PER_SEC = 1000000000;
+
+static int64_t timespec_to_ns(timespec const &ts)
+{
+    return static_cast<int64_t>(ts.tv_sec) * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static timespec ns_to_timespec(int64_t ns)
+{
+    timespec ts;
+    ts.tv_sec = static_cast<time_t>(ns / NSEC_PER_SEC);
+    ts.tv_nsec = static_cast<long>(ns % NSEC_PER_SEC);
+    return ts;
+}
+
+LoopThread::LoopThread(const std::string &name, uint32_t period_us, body_t body, int cpu, int fifo_priority) : m_name(name),
+                                                                                                                m_period_us(period_us),
+                                                                                                                m_body(body),
+                                                                                                                m_cpu(cpu),
+                                                                                                                m_fifo_priority(fifo_priority),
+                                                                                                                m_running(false),
+                                                                                                                m_thread(),
+                                                                                                                m_stats_mutex(),
+                                                                                                                m_stats()
+{
+    reset_stats();
+}
+
+LoopThread::~LoopThread()
+{
+    stop();
+}
+
+void LoopThread::start()
+{
+    m_running = true;
+    m_thread = std::thread(&LoopThread::run, this);
+}
+
+void LoopThread::stop()
+{
+    m_running = false;
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+}
+
+JitterStats LoopThread::pop_stats()
+{
+    std::lock_guard<std::mutex> lock(m_stats_mutex);
+    JitterStats const stats = m_stats;
+    reset_stats();
+    return stats;
+}
+
+void LoopThread::reset_stats()
+{
+    m_stats.count = 0;
+    m_stats.min_ns = std::numeric_limits<int64_t>::max();
+    m_stats.max_ns = 0;
+    m_stats.sum_ns = 0;
+    m_stats.overruns = 0;
+}
+
+void LoopThread::configure_thread()
+{
+    // Failures are reported but not fatal. SCHED_FIFO usually requires privileges.
+    if (m_cpu >= 0)
+    {
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(m_cpu, &cpuset);
+        int const err = pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+        if (err != 0)
+        {
+            std::cerr << m_name << ": Cannot pin to CPU " << m_cpu << ". " << strerror(err) << std::endl;
+        }
+    }
+
+    if (m_fifo_priority >= 0)
+    {
+        sched_param param;
+        param.sched_priority = m_fifo_priority;
+        int const err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (err != 0)
+        {
+            std::cerr << m_name << ": Cannot use SCHED_FIFO. " << strerror(err) << std::endl;
+        }
+    }
+}
+
+void LoopThread::run()
+{
+    configure_thread();
+
+    int64_t const period_ns = static_cast<int64_t>(m_period_us) * 1000;
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    int64_t deadline_ns = timespec_to_ns(now);
+    int64_t last_wakeup_ns = deadline_ns;
+
+    while (m_running)
+    {
+        // Absolute deadlines do not accumulate the drift of the loop body and the sleep overhead.
+        deadline_ns += period_ns;
+        timespec const deadline = ns_to_timespec(deadline_ns);
+        int err = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr);
+        while (err == EINTR) // Interrupted by a signal. The deadline is absolute, so we can simply sleep again
+        {
+            err = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr);
+        }
+
+        if (err != 0)
+        {
+            std::cerr << m_name << ": Cannot sleep until the next period. " << strerror(err) << ". Loop stopped." << std::endl;
+            m_running = false;
+            break;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        int64_t const wakeup_ns = timespec_to_ns(now);
+        int64_t const lateness_ns = wakeup_ns - deadline_ns;
+
+        m_body(static_cast<uint32_t>((wakeup_ns - last_wakeup_ns) / 1000));
+        last_wakeup_ns = wakeup_ns;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        bool const overrun = timespec_to_ns(now) > deadline_ns + period_ns;
+        {
+            std::lock_guard<std::mutex> lock(m_stats_mutex);
+            m_stats.count++;
+            m_stats.min_ns = (lateness_ns < m_stats.min_ns) ? lateness_ns : m_stats.min_ns;
+            m_stats.max_ns = (lateness_ns > m_stats.max_ns) ? lateness_ns : m_stats.max_ns;
+            m_stats.sum_ns += lateness_ns;
+            m_stats.overruns += overrun ? 1 : 0;
+        }
+
+        if (overrun)
+        {
+            deadline_ns = timespec_to_ns(now); // Skip the missed periods rather than running them back to back
+        }
+    }
+}
@@ -21,6 +21,19 @@ using SerialPortBridge = WinSerialPortBridge;
 #else
 #include "nix_serial_port_bridge.hpp"
 using SerialPortBridge = NixSerialPortBridge;
+#if SCRUTINY_ENABLE_DATALOGGING
+#include "mmap_datalogging_storage.hpp"
+#endif
+#endif
+
+#if TESTAPP_HAS_EPOLL
+#include "epoll_event_loop.hpp"
+#endif
+
+#if TESTAPP_HAS_LOOP_THREADS
+#include "loop_thread.hpp"
+#include <memory>
+#include <vector>
 #endif
 
 #include <iostream>
@@ -373,7 +386,7 @@ void my_user_command(
     }
 }
 
-void process_scrutiny_lib(AbstractCommChannel *channel)
+void process_scrutiny_lib(AbstractCommChannel *channel, DataloggingFileConfig const &dl_file_config, bool use_sleep_loop, LoopThreadsConfig const &loop_threads_config)
 {
     uint8_t buffer[1024];
     static_assert(sizeof(buffer) <= 0xFFFF, "Scrutiny expect a buffer smaller than 16 bits");
@@ -391,33 +404,84 @@ void process_scrutiny_lib(AbstractCommChannel *channel)
     static uint8_t datalogging_buffer[4096];
     config.set_datalogging_trigger_callback(datalogging_callback);
     config.set_datalogging_buffers(datalogging_buffer, sizeof(datalogging_buffer));
+#if !SCRUTINY_BUILD_WINDOWS
+    // The storage size cannot exceed what the datalogging buffer size type can hold (see SCRUTINY_DATALOGGING_BUFFER_32BITS)
+    scrutiny::datalogging::buffer_size_t const max_dl_file_size = static_cast<scrutiny::datalogging::buffer_size_t>(-1);
+    MmapDataloggingStorage datalogging_storage(dl_file_config.filename, static_cast<scrutiny::datalogging::buffer_size_t>(min<uint32_t>(dl_file_config.size, max_dl_file_size)));
+    if (!dl_file_config.filename.empty())
+    {
+        config.set_datalogging_storage(&datalogging_storage); // Only mapped once logging starts. The file is opened below
+    }
+#else
+    (void)dl_file_config;
+#endif
+#else
+    (void)dl_file_config;
 #endif
 
     config.max_bitrate = 100000;
     config.display_name = "TestApp Executable";
     config.session_counter_seed = 0xdeadbeef;
+    config.set_datagram_mode(channel->datagram_mtu());
     scrutiny_handler.init(&config);
 
-    chrono::time_point<chrono::steady_clock> start_timestamp, last_timestamp, now_timestamp;
-    start_timestamp = chrono::steady_clock::now();
-    last_timestamp = chrono::steady_clock::now();
-    now_timestamp = chrono::steady_clock::now();
+    chrono::time_point<chrono::steady_clock> const start_timestamp = chrono::steady_clock::now();
+    chrono::time_point<chrono::steady_clock> last_main_timestamp = start_timestamp;
+    chrono::time_point<chrono::steady_clock> last_vf_loop_timestamp = start_timestamp;
 
-    try
+    // Returns the time elapsed since the given timestamp in microseconds and moves it to now.
+    auto step_timestamp = [](chrono::time_point<chrono::steady_clock> &timestamp) -> uint32_t
     {
-        channel->start();
-        int len_received = 0;
-        while (true)
+        chrono::time_point<chrono::steady_clock> const now_timestamp = chrono::steady_clock::now();
+        uint32_t const timestep_us = static_cast<uint32_t>(chrono::duration_cast<chrono::microseconds>(now_timestamp - timestamp).count());
+        timestamp = now_timestamp;
+        return timestep_us;
+    };
+
+    auto time_since_start_us = [&start_timestamp]() -> uint32_t
+    {
+        return static_cast<uint32_t>(chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start_timestamp).count());
+    };
+
+    // Runs the scrutiny lib and gives everything it has to say to the channel.
+    auto process_and_send = [&]()
+    {
+        scrutiny_handler.process(step_timestamp(last_main_timestamp) * 10);
+
+        uint16_t data_to_send = scrutiny_handler.data_to_send();
+        while (data_to_send > 0)
         {
-            process_interactive_data();
-            len_received = channel->receive(buffer, sizeof(buffer)); // Non-blocking. Can return 0
-            now_timestamp = chrono::steady_clock::now();
-            uint32_t time_since_start_us = static_cast<uint32_t>(chrono::duration_cast<chrono::microseconds>(now_timestamp - start_timestamp).count());
-            uint32_t timestep_us = static_cast<uint32_t>(chrono::duration_cast<chrono::microseconds>(now_timestamp - last_timestamp).count());
+            data_to_send = min(data_to_send, static_cast<uint16_t>(sizeof(buffer)));
+            scrutiny_handler.pop_data(buffer, data_to_send);
+            channel->send(buffer, data_to_send);
+
+            cout << dec << setw(0) << time_since_start_us() << "  out: (" << setw(2) << setfill(' ') << data_to_send << ")  ";
+            for (unsigned int i = 0; i < data_to_send; i++)
+            {
+                cout << hex << setw(2) << setfill('0') << static_cast<uint32_t>(buffer[i]);
+            }
+            cout << endl;
+            data_to_send = scrutiny_handler.data_to_send();
+        }
+    };
 
+    auto process_main = [&]()
+    {
+        process_and_send();
+        channel->flush();
+    };
+
+    // Reads until the channel is empty. A batched channel can hold several requests; each one is
+    // processed before the next one is given to the lib and all the responses are sent together.
+    auto receive_and_process = [&]()
+    {
+        int len_received;
+        do
+        {
+            len_received = channel->receive(buffer, sizeof(buffer)); // Non-blocking. Can return 0
             if (len_received > 0)
             {
-                cout << dec << setw(0) << time_since_start_us << "  in:  (" << setw(2) << setfill(' ') << len_received << ")  ";
+                cout << dec << setw(0) << time_since_start_us() << "  in:  (" << setw(2) << setfill(' ') << len_received << ")  ";
                 for (int i = 0; i < len_received; i++)
                 {
                     cout << hex << setw(2) << setfill('0') << static_cast<uint32_t>(buffer[i]);
@@ -426,33 +490,135 @@ void process_scrutiny_lib(AbstractCommChannel *channel)
             }
 
             scrutiny_handler.receive_data(buffer, static_cast<uint16_t>(len_received));
+            process_and_send();
+        } while (len_received > 0);
+        channel->flush();
+    };
 
-            scrutiny_handler.process(timestep_us * 10);
+    auto process_vf_loop = [&]()
+    {
+        vf_loop.process(step_timestamp(last_vf_loop_timestamp) * 10);
+    };
 
-            uint16_t data_to_send = scrutiny_handler.data_to_send();
-            data_to_send = min(data_to_send, static_cast<uint16_t>(sizeof(buffer)));
+    // When the loop handlers have their own thread, the main loop only serves the communication.
+    bool loops_in_main_thread = true;
+    auto process_loops = [&]()
+    {
+        if (loops_in_main_thread)
+        {
+            process_vf_loop();
+            ff_loop.process();
+        }
+    };
 
-            if (data_to_send > 0)
-            {
-                scrutiny_handler.pop_data(buffer, data_to_send);
-                channel->send(buffer, data_to_send);
+    constexpr uint32_t stats_report_period_us = 5000000;
+    uint32_t last_stats_report_us = 0;
+#if TESTAPP_HAS_LOOP_THREADS
+    std::vector<std::unique_ptr<LoopThread>> loop_threads;
 
-                cout << dec << setw(0) << time_since_start_us << "  out: (" << setw(2) << setfill(' ') << data_to_send << ")  ";
-                for (unsigned int i = 0; i < data_to_send; i++)
-                {
-                    cout << hex << setw(2) << setfill('0') << static_cast<uint32_t>(buffer[i]);
-                }
-                cout << endl;
+    auto report_jitter = [&]()
+    {
+        for (std::unique_ptr<LoopThread> const &loop_thread : loop_threads)
+        {
+            JitterStats const stats = loop_thread->pop_stats();
+            if (stats.count == 0)
+            {
+                continue;
             }
+            cout << dec << setw(0) << "Jitter " << loop_thread->name() << ": " << stats.count << " periods, min=" << stats.min_ns / 1000
+                 << "us, max=" << stats.max_ns / 1000 << "us, mean=" << stats.sum_ns / stats.count / 1000 << "us, overruns=" << stats.overruns << endl;
+        }
+    };
 
-            vf_loop.process(timestep_us * 10);
-            ff_loop.process();
+    if (loop_threads_config.enabled)
+    {
+        int const first_cpu = loop_threads_config.first_cpu;
+        loop_threads.emplace_back(new LoopThread(ff_loop.get_name(), ff_loop.get_timestep_100ns() / 10, [&ff_loop](uint32_t)
+                                                 { ff_loop.process(); },
+                                                 first_cpu, loop_threads_config.fifo_priority));
+        loop_threads.emplace_back(new LoopThread(vf_loop.get_name(), 1000, [&vf_loop](uint32_t timestep_us)
+                                                 { vf_loop.process(timestep_us * 10); },
+                                                 (first_cpu < 0) ? -1 : first_cpu + 1, loop_threads_config.fifo_priority));
+        loops_in_main_thread = false;
+    }
+#else
+    auto report_jitter = []() {};
+    if (loop_threads_config.enabled)
+    {
+        cerr << "Loop threads are not supported on this platform" << endl;
+    }
+#endif
+
+    auto report_stats = [&]()
+    {
+        uint32_t const now_us = time_since_start_us();
+        if (now_us - last_stats_report_us < stats_report_period_us)
+        {
+            return;
+        }
+        last_stats_report_us = now_us;
+        report_jitter();
+        channel->report_stats();
+    };
+
+    try
+    {
+#if SCRUTINY_ENABLE_DATALOGGING && !SCRUTINY_BUILD_WINDOWS
+        if (!dl_file_config.filename.empty())
+        {
+            datalogging_storage.open();
+            cout << "Datalogging in " << dl_file_config.filename << " (" << datalogging_storage.size() << " bytes)" << endl;
+        }
+#endif
+        channel->start();
+#if TESTAPP_HAS_LOOP_THREADS
+        for (std::unique_ptr<LoopThread> &loop_thread : loop_threads)
+        {
+            loop_thread->start();
+        }
+#endif
+#if TESTAPP_HAS_EPOLL
+        if (!use_sleep_loop && channel->get_fd() >= 0)
+        {
+            // Requests are handled as soon as data arrives and each loop handler runs on its own timer.
+            constexpr uint32_t vf_loop_period_us = 1000;
+            EpollEventLoop event_loop;
+            event_loop.add_readable(channel->get_fd(), receive_and_process);
+            if (loops_in_main_thread)
+            {
+                event_loop.add_periodic_timer(ff_loop.get_timestep_100ns() / 10, [&]()
+                                              {
+                                                  ff_loop.process();
+                                                  process_main(); });
+            }
+            event_loop.add_periodic_timer(vf_loop_period_us, [&]()
+                                          {
+                                              process_interactive_data();
+                                              if (loops_in_main_thread)
+                                              {
+                                                  process_vf_loop();
+                                              }
+                                              process_main();
+                                              report_stats(); });
+            while (true)
+            {
+                event_loop.run_once();
+            }
+        }
+#else
+        (void)use_sleep_loop; // Only the sleep loop is available on this platform
+#endif
+        while (true)
+        {
+            process_interactive_data();
+            receive_and_process();
+            process_loops();
+            report_stats();
 #if SCRUTINY_BUILD_WINDOWS
             Sleep(10);
 #else
             this_thread ::sleep_for(chrono::milliseconds(10));
 #endif
-            last_timestamp = now_timestamp;
         }
     }
     catch (std::exception const &e)
@@ -460,6 +626,12 @@ void process_scrutiny_lib(AbstractCommChannel *channel)
         cerr << e.what() << endl;
     }
 
+#if TESTAPP_HAS_LOOP_THREADS
+    for (std::unique_ptr<LoopThread> &loop_thread : loop_threads)
+    {
+        loop_thread->stop();
+    }
+#endif
     channel->stop();
 }
 
@@ -509,8 +681,13 @@ int main(int argc, char *argv[])
 
             UdpBridge::global_init();
             UdpBridge udp_bridge(parser.udp_port());
+            UdpConfig const &udp_config = parser.udp_config();
+            udp_bridge.set_batch_size(udp_config.batch_size);
+            udp_bridge.set_busy_poll(udp_config.busy_poll_us);
+            udp_bridge.set_receive_buffer_size(udp_config.rcvbuf_size);
+            udp_bridge.set_datagram_framing(udp_config.datagram_framing);
 
-            process_scrutiny_lib(&udp_bridge);
+            process_scrutiny_lib(&udp_bridge, parser.datalogging_file_config(), parser.use_sleep_loop(), parser.loop_threads_config());
 
             UdpBridge::global_close();
         }
@@ -520,7 +697,7 @@ int main(int argc, char *argv[])
             SerialPortBridge serial(serial_config.port_name, serial_config.baudrate);
             cout << "Serial comm on " << serial_config.port_name << " @" << serial_config.baudrate << " baud" << endl;
 
-            process_scrutiny_lib(&serial);
+            process_scrutiny_lib(&serial, parser.datalogging_file_config(), parser.use_sleep_loop(), parser.loop_threads_config());
         }
     }
 
@@ -0,0 +1,124 @@
+//    mmap_datalogging_storage.cpp
+//        Datalogging storage backed by a memory-mapped file, so that the Testapp can log more data
+//        than what fits in RAM and keep the last acquisition on disk.
+//
+//   - License : MIT - See LICENSE file.
+//   - Project : Scrutiny Debugger (github.com/scrutinydebugger/scrutiny-embedded)
+//
+//   Copyright (c) 2021 Scrutiny Debugger
+
+#include "scrutiny_setup.hpp"
+
+#if SCRUTINY_BUILD_WINDOWS
+#error "This file cannot be compiled under Windows"
+#endif
+
+#if SCRUTINY_ENABLE_DATALOGGING == 0
+#error "Not enabled"
+#endif
+
+#include "mmap_datalogging_storage.hpp"
+#include <cstdint>
+#include <string>
+#include <system_error>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using scrutiny::datalogging::buffer_size_t;
+using scrutiny::datalogging::StorageWindow;
+
+MmapDataloggingStorage::MmapDataloggingStorage(const std::string &filename, buffer_size_t size) : m_filename(filename),
+                                                                                                 m_size(size),
+                                                                                                 m_fd(-1),
+                                                                                                 m_data(nullptr),
+                                                                                                 m_flush_requested(false)
+{
+}
+
+MmapDataloggingStorage::~MmapDataloggingStorage()
+{
+    close();
+}
+
+void MmapDataloggingStorage::open()
+{
+    m_fd = ::open(m_filename.c_str(), O_RDWR | O_CREAT, 0644);
+    if (m_fd < 0)
+    {
+        throw_system_error(std::string("Cannot open datalogging file ") + m_filename);
+    }
+
+    if (ftruncate(m_fd, static_cast<off_t>(m_size)) != 0)
+    {
+        close();
+        throw_system_error(std::string("Cannot resize datalogging file ") + m_filename);
+    }
+
+    // Mapped once, with the pages loaded ahead, so that the datalogger never waits on the kernel while logging
+    int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+    flags |= MAP_POPULATE;
+#endif
+    void *const data = mmap(nullptr, static_cast<size_t>(m_size), PROT_READ | PROT_WRITE, flags, m_fd, 0);
+    if (data == MAP_FAILED)
+    {
+        close();
+        throw_system_error(std::string("Cannot map datalogging file ") + m_filename);
+    }
+    m_data = static_cast<uint8_t *>(data);
+}
+
+void MmapDataloggingStorage::close()
+{
+    if (m_data != nullptr)
+    {
+        munmap(m_data, static_cast<size_t>(m_size));
+    }
+    m_data = nullptr;
+
+    if (m_fd >= 0)
+    {
+        ::close(m_fd);
+    }
+    m_fd = -1;
+}
+
+buffer_size_t MmapDataloggingStorage::size(void) const
+{
+    return m_size;
+}
+
+bool MmapDataloggingStorage::map(buffer_size_t const offset, buffer_size_t const length, StorageWindow *const window)
+{
+    unmap(window);
+    if (m_data == nullptr || offset > m_size || length > m_size - offset)
+    {
+        return false;
+    }
+
+    window->data = m_data;
+    window->offset = 0;
+    window->size = m_size;
+    return true;
+}
+
+void MmapDataloggingStorage::flush(void)
+{
+    m_flush_requested.store(true); // Called by the loop owning the datalogger. Synchronized by process()
+}
+
+void MmapDataloggingStorage::process(void)
+{
+    if (m_flush_requested.exchange(false) && m_data != nullptr)
+    {
+        msync(m_data, static_cast<size_t>(m_size), MS_SYNC); // Writes the dirty mapped pages to the file
+    }
+}
+
+void MmapDataloggingStorage::throw_system_error(const std::string &msg)
+{
+    throw std::system_error(errno, std::system_category(), msg.c_str());
+}
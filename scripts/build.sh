@@ -18,6 +18,7 @@ SCRUTINY_ENABLE_DATALOGGING=${SCRUTINY_ENABLE_DATALOGGING:-ON}
 SCRUTINY_SUPPORT_64BITS=${SCRUTINY_SUPPORT_64BITS:-ON}
 SCRUTINY_DATALOGGING_BUFFER_32BITS=${SCRUTINY_DATALOGGING_BUFFER_32BITS:-OFF}
 SCRUTINY_BUILD_CWRAPPER=${SCRUTINY_BUILD_CWRAPPER:-ON}
+SCRUTINY_BUILD_DECODER=${SCRUTINY_BUILD_DECODER:-OFF}
 SCRUTINY_BUILD_TEST=${SCRUTINY_BUILD_TEST:-OFF}
 SCRUTINY_BUILD_TESTAPP=${SCRUTINY_BUILD_TESTAPP:-OFF}
 CMAKE_BUILD_TYPE=${CMAKE_BUILD_TYPE:-Release}
@@ -27,6 +28,7 @@ cmake -GNinja \
         -DSCRUTINY_BUILD_TEST=$SCRUTINY_BUILD_TEST \
         -DSCRUTINY_BUILD_TESTAPP=$SCRUTINY_BUILD_TESTAPP \
         -DSCRUTINY_BUILD_CWRAPPER=$SCRUTINY_BUILD_CWRAPPER \
+        -DSCRUTINY_BUILD_DECODER=$SCRUTINY_BUILD_DECODER \
         -DSCRUTINY_ENABLE_DATALOGGING=$SCRUTINY_ENABLE_DATALOGGING \
         -DSCRUTINY_SUPPORT_64BITS=$SCRUTINY_SUPPORT_64BITS \
         -DSCRUTINY_DATALOGGING_BUFFER_32BITS=$SCRUTINY_DATALOGGING_BUFFER_32BITS \
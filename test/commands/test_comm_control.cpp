@@ -81,6 +81,77 @@ TEST_F(TestCommControl, TestDiscover)
     ASSERT_BUF_EQ(tx_buffer, expected_response, sizeof(expected_response));
 }
 
+TEST_F(TestCommControl, TestDiscoverThroughReceiveRing)
+{
+    // The bytes are pushed by an interrupt routine and given to the main channel by process()
+    uint8_t ring_buffer[16];
+    scrutiny::IPCByteRing ring;
+    ring.init(ring_buffer, sizeof(ring_buffer));
+    config.set_receive_ring(&ring);
+    scrutiny_handler.init(&config);
+
+    uint8_t request_data[8 + 4] = {2, 1, 0, 4};
+    std::memcpy(&request_data[4], scrutiny::protocol::CommControl::DISCOVER_MAGIC, sizeof(scrutiny::protocol::CommControl::DISCOVER_MAGIC));
+    add_crc(request_data, sizeof(request_data) - 4);
+
+    // Wraps around the ring between 2 calls to process()
+    for (uint16_t i = 0; i < 10; i++)
+    {
+        ASSERT_TRUE(ring.push(request_data[i]));
+    }
+    scrutiny_handler.process(0);
+    EXPECT_EQ(ring.available(), 0u);
+    EXPECT_EQ(scrutiny_handler.data_to_send(), 0u);
+
+    for (uint16_t i = 10; i < sizeof(request_data); i++)
+    {
+        ASSERT_TRUE(ring.push(request_data[i]));
+    }
+    scrutiny_handler.process(0);
+    EXPECT_EQ(ring.available(), 0u);
+    EXPECT_EQ(ring.dropped_count(), 0u);
+
+    uint8_t tx_buffer[64];
+    uint16_t const n_to_read = scrutiny_handler.data_to_send();
+    ASSERT_GT(n_to_read, 9u);
+    ASSERT_LT(n_to_read, sizeof(tx_buffer));
+    scrutiny_handler.pop_data(tx_buffer, n_to_read);
+    EXPECT_EQ(tx_buffer[0], 0x82);
+    EXPECT_EQ(tx_buffer[1], 1u);
+    EXPECT_EQ(tx_buffer[2], 0u);
+    EXPECT_EQ(tx_buffer[3], 0u); // Success
+}
+
+TEST_F(TestCommControl, TestReceiveRingRejectedInDatagramMode)
+{
+    uint8_t ring_buffer[16];
+    scrutiny::IPCByteRing ring;
+    ring.init(ring_buffer, sizeof(ring_buffer));
+
+    uint8_t request_data[8 + 4] = {2, 1, 0, 4};
+    std::memcpy(&request_data[4], scrutiny::protocol::CommControl::DISCOVER_MAGIC, sizeof(scrutiny::protocol::CommControl::DISCOVER_MAGIC));
+    add_crc(request_data, sizeof(request_data) - 4);
+
+    // Datagram mode alone works
+    config.set_datagram_mode(64);
+    scrutiny_handler.init(&config);
+    scrutiny_handler.receive_data(request_data, sizeof(request_data));
+    scrutiny_handler.process(0);
+    uint8_t tx_buffer[64];
+    uint16_t const n_to_read = scrutiny_handler.data_to_send();
+    ASSERT_GT(n_to_read, 9u);
+    ASSERT_LT(n_to_read, sizeof(tx_buffer));
+    scrutiny_handler.pop_data(tx_buffer, n_to_read);
+    EXPECT_EQ(tx_buffer[3], 0u); // Success
+
+    // The ring would cut the datagrams anywhere. The configuration is rejected
+    config.set_receive_ring(&ring);
+    scrutiny_handler.init(&config);
+    scrutiny_handler.receive_data(request_data, sizeof(request_data));
+    scrutiny_handler.process(0);
+    EXPECT_EQ(scrutiny_handler.data_to_send(), 0u);
+}
+
 TEST_F(TestCommControl, TestDiscoverWrongMagic)
 {
     ASSERT_EQ(sizeof(scrutiny::protocol::CommControl::DISCOVER_MAGIC), 4u);
@@ -210,6 +281,28 @@ TEST_F(TestCommControl, TestGetParams)
     ASSERT_BUF_EQ(tx_buffer, expected_response, sizeof(expected_response));
 }
 
+TEST_F(TestCommControl, TestGetParamsWithStreaming)
+{
+    // The size limit of the streamed responses is appended when streaming is enabled
+    uint8_t tx_buffer[64];
+    uint8_t request_data[8] = {2, 3, 0, 0};
+    add_crc(request_data, sizeof(request_data) - 4);
+    constexpr uint16_t datalen = 2 + 2 + 4 + 4 + 4 + 1 + 2;
+
+    config.response_streaming = true;
+    scrutiny_handler.init(&config);
+    scrutiny_handler.comm()->connect();
+    scrutiny_handler.receive_data(request_data, sizeof(request_data));
+    scrutiny_handler.process(0);
+    uint16_t n_to_read = scrutiny_handler.data_to_send();
+    ASSERT_EQ(n_to_read, 9u + datalen);
+    scrutiny_handler.pop_data(tx_buffer, n_to_read);
+
+    ASSERT_TRUE(IS_PROTOCOL_RESPONSE(tx_buffer, scrutiny::protocol::CommandId::CommControl, 3, scrutiny::protocol::ResponseCode::OK));
+    EXPECT_EQ(scrutiny::codecs::decode_16_bits_big_endian(&tx_buffer[7]), sizeof(_tx_buffer)); // Unchanged
+    EXPECT_EQ(scrutiny::codecs::decode_16_bits_big_endian(&tx_buffer[5 + datalen - 2]), scrutiny::protocol::MAXIMUM_TX_BUFFER_SIZE);
+}
+
 TEST_F(TestCommControl, TestConnect)
 {
     ASSERT_EQ(sizeof(scrutiny::protocol::CommControl::CONNECT_MAGIC), 4u);
@@ -246,6 +339,61 @@ TEST_F(TestCommControl, TestConnect)
     ASSERT_TRUE(scrutiny_handler.comm()->is_connected());
 }
 
+TEST_F(TestCommControl, TestConnectNegotiatesFraming)
+{
+    uint8_t request_data[8 + 5] = {2, 4, 0, 5};
+    std::memcpy(&request_data[4], scrutiny::protocol::CommControl::CONNECT_MAGIC, sizeof(scrutiny::protocol::CommControl::CONNECT_MAGIC));
+    request_data[8] = static_cast<uint8_t>(scrutiny::protocol::CommControl::Framing::COBS);
+    add_crc(request_data, sizeof(request_data) - 4);
+
+    uint8_t tx_buffer[64];
+    uint8_t decoded[64];
+
+    // The Connect response is sent with the raw framing and tells which framing comes next
+    scrutiny_handler.receive_data(request_data, sizeof(request_data));
+    scrutiny_handler.process(0);
+    uint16_t n_to_read = scrutiny_handler.data_to_send();
+    ASSERT_EQ(n_to_read, 9u + 4u + 4u + 1u);
+    scrutiny_handler.pop_data(tx_buffer, n_to_read);
+    ASSERT_TRUE(IS_PROTOCOL_RESPONSE(tx_buffer, scrutiny::protocol::CommandId::CommControl, 4, scrutiny::protocol::ResponseCode::OK));
+    EXPECT_EQ(tx_buffer[4], 9);
+    EXPECT_EQ(tx_buffer[13], static_cast<uint8_t>(scrutiny::protocol::CommControl::Framing::COBS));
+    scrutiny_handler.process(0);
+
+    // Following requests and responses are COBS encoded
+    uint8_t get_params[8] = {2, 3, 0, 0};
+    add_crc(get_params, 4);
+    uint8_t encoded[16];
+    uint32_t const encoded_size = cobs_encode(get_params, sizeof(get_params), encoded);
+    scrutiny_handler.receive_data(encoded, static_cast<uint16_t>(encoded_size));
+    scrutiny_handler.process(0);
+    n_to_read = scrutiny_handler.data_to_send();
+    ASSERT_GT(n_to_read, 0u);
+    ASSERT_LT(n_to_read, sizeof(tx_buffer));
+    scrutiny_handler.pop_data(tx_buffer, n_to_read);
+    EXPECT_EQ(tx_buffer[n_to_read - 1], 0);
+    ASSERT_GT(cobs_decode(tx_buffer, n_to_read, decoded), 9u);
+    EXPECT_TRUE(IS_PROTOCOL_RESPONSE(decoded, scrutiny::protocol::CommandId::CommControl, 3, scrutiny::protocol::ResponseCode::OK));
+}
+
+TEST_F(TestCommControl, TestConnectUnsupportedFramingKeepsRaw)
+{
+    uint8_t request_data[8 + 5] = {2, 4, 0, 5};
+    std::memcpy(&request_data[4], scrutiny::protocol::CommControl::CONNECT_MAGIC, sizeof(scrutiny::protocol::CommControl::CONNECT_MAGIC));
+    request_data[8] = 0x7F;
+    add_crc(request_data, sizeof(request_data) - 4);
+    uint8_t tx_buffer[32];
+
+    scrutiny_handler.receive_data(request_data, sizeof(request_data));
+    scrutiny_handler.process(0);
+    uint16_t const n_to_read = scrutiny_handler.data_to_send();
+    ASSERT_EQ(n_to_read, 9u + 4u + 4u + 1u);
+    scrutiny_handler.pop_data(tx_buffer, n_to_read);
+    ASSERT_TRUE(IS_PROTOCOL_RESPONSE(tx_buffer, scrutiny::protocol::CommandId::CommControl, 4, scrutiny::protocol::ResponseCode::OK));
+    EXPECT_EQ(tx_buffer[13], static_cast<uint8_t>(scrutiny::protocol::CommControl::Framing::Raw));
+    EXPECT_EQ(scrutiny_handler.comm()->get_framing(), scrutiny::protocol::CommControl::Framing::Raw);
+}
+
 TEST_F(TestCommControl, TestDisconnect)
 {
     scrutiny_handler.comm()->connect();
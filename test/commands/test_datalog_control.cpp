@@ -221,7 +221,39 @@ uint16_t TestDatalogControl::encode_datalogger_config(uint8_t loop_id, uint16_t
             }
             cursor += codecs::encode_16_bits_big_endian(dlconfig->items_to_log[i].data.rpv.id, &buffer[cursor]);
             break;
+        case datalogging::LoggableType::VARBIT:
+            if (cursor + 1 + 1 + 1 + sizeof(void *) > max_size)
+            {
+                return 0;
+            }
+            cursor += codecs::encode_8_bits(static_cast<uint8_t>(dlconfig->items_to_log[i].data.varbit.datatype), &buffer[cursor]);
+            cursor += codecs::encode_address_big_endian(dlconfig->items_to_log[i].data.varbit.addr, &buffer[cursor]);
+            cursor += codecs::encode_8_bits(static_cast<uint8_t>(dlconfig->items_to_log[i].data.varbit.bitoffset), &buffer[cursor]);
+            cursor += codecs::encode_8_bits(static_cast<uint8_t>(dlconfig->items_to_log[i].data.varbit.bitsize), &buffer[cursor]);
+            break;
+        }
+    }
+
+    // Optional fields. Only encoded when not default so that the other tests use the shortest request
+    bool const time_axis = (dlconfig->time_axis != datalogging::TimeAxis::Logged);
+    if (dlconfig->segment_count != 1 || time_axis)
+    {
+        if (cursor + 2 > max_size)
+        {
+            return 0;
+        }
+        cursor += codecs::encode_16_bits_big_endian(dlconfig->segment_count, &buffer[cursor]);
+    }
+
+    if (time_axis)
+    {
+        if (cursor + 1 + 2 + 4 > max_size)
+        {
+            return 0;
         }
+        cursor += codecs::encode_8_bits(static_cast<uint8_t>(dlconfig->time_axis), &buffer[cursor]);
+        cursor += codecs::encode_16_bits_big_endian(dlconfig->time_mark_interval, &buffer[cursor]);
+        cursor += codecs::encode_32_bits_big_endian(dlconfig->time_mark_tolerance_100ns, &buffer[cursor]);
     }
 
     return cursor;
@@ -448,6 +480,37 @@ TEST_F(TestDatalogControl, TestConfigureLoggableBadRPV)
     test_configure(loop_id, 0, refconfig, protocol::ResponseCode::FailureToProceed);
 }
 
+TEST_F(TestDatalogControl, TestConfigureLoggableVarBit)
+{
+    constexpr uint8_t loop_id = 1;
+    datalogging::Configuration refconfig = get_valid_reference_configuration();
+    refconfig.items_count = 4;
+    refconfig.items_to_log[3].type = datalogging::LoggableType::VARBIT;
+    refconfig.items_to_log[3].data.varbit.addr = &m_some_var_logged1;
+    refconfig.items_to_log[3].data.varbit.datatype = VariableType::uint32;
+    refconfig.items_to_log[3].data.varbit.bitoffset = 5;
+    refconfig.items_to_log[3].data.varbit.bitsize = 3;
+
+    test_configure(loop_id, 0, refconfig, protocol::ResponseCode::OK);
+
+    const datalogging::Configuration *dlconfig = scrutiny_handler.datalogger()->config();
+    ASSERT_EQ(dlconfig->items_count, 4);
+    EXPECT_EQ(dlconfig->items_to_log[3].type, datalogging::LoggableType::VARBIT);
+    EXPECT_EQ(dlconfig->items_to_log[3].data.varbit.addr, &m_some_var_logged1);
+    EXPECT_EQ(dlconfig->items_to_log[3].data.varbit.datatype, VariableType::uint32);
+    EXPECT_EQ(dlconfig->items_to_log[3].data.varbit.bitoffset, 5);
+    EXPECT_EQ(dlconfig->items_to_log[3].data.varbit.bitsize, 3);
+
+    // Bitfield that does not fit in its declared type
+    refconfig.items_to_log[3].data.varbit.bitoffset = 30;
+    test_configure(loop_id, 0, refconfig, protocol::ResponseCode::InvalidRequest);
+
+    // Floats cannot be bitfields
+    refconfig.items_to_log[3].data.varbit.bitoffset = 0;
+    refconfig.items_to_log[3].data.varbit.datatype = VariableType::float32;
+    test_configure(loop_id, 0, refconfig, protocol::ResponseCode::InvalidRequest);
+}
+
 TEST_F(TestDatalogControl, TestOwnerMechanism)
 {
     ASSERT_FALSE(fixed_freq_loop.owns_datalogger());
@@ -764,6 +827,212 @@ TEST_F(TestDatalogControl, TestGetAcquisitionMetadata)
     EXPECT_BUF_EQ(tx_buffer, expected_response, sizeof(expected_response));
 }
 
+TEST_F(TestDatalogControl, TestGetAcquisitionMetadataSegmented)
+{
+    uint8_t tx_buffer[128]{0};
+    uint16_t n_to_read{0};
+    constexpr uint16_t SEGMENT_COUNT = 3;
+
+    datalogging::Configuration refconfig = get_valid_reference_configuration();
+    refconfig.decimation = 1;
+    refconfig.segment_count = SEGMENT_COUNT;
+    test_configure(0, 0xabcd, refconfig, protocol::ResponseCode::OK); // Assign to Loop 0 (Fixed freq)
+    fixed_freq_loop.process();                                        // Accept ownership
+    scrutiny_handler.process(0);
+    EXPECT_EQ(scrutiny_handler.datalogger()->get_segment_count(), SEGMENT_COUNT);
+
+    // Each segment is captured after a manual trigger. The logger goes back to armed between segments.
+    scrutiny_handler.datalogger()->arm_trigger();
+    for (uint16_t segment = 0; segment < SEGMENT_COUNT; segment++)
+    {
+        EXPECT_EQ(scrutiny_handler.datalogger()->get_completed_segment_count(), segment);
+        scrutiny_handler.datalogger()->force_trigger();
+        for (uint32_t i = 0; i < sizeof(dlbuffer) / 4; i++)
+        {
+            fixed_freq_loop.process();
+            scrutiny_handler.process(1);
+            if (scrutiny_handler.datalogger()->get_completed_segment_count() > segment)
+            {
+                break;
+            }
+        }
+    }
+    EXPECT_TRUE(scrutiny_handler.datalogger()->data_acquired());
+    fixed_freq_loop.process();
+    scrutiny_handler.process(1);
+
+    datalogging::DataReader *reader = scrutiny_handler.datalogger()->get_reader();
+    reader->reset();
+
+    // First request without payload starts at segment 0. Second one starts at the given segment.
+    uint16_t const first_segments[2] = {0, 2};
+    for (unsigned int n = 0; n < 2; n++)
+    {
+        uint16_t const first_segment = first_segments[n];
+        uint8_t request_data[10] = {5, 6, 0, 0};
+        uint16_t request_size = 8;
+        if (first_segment != 0)
+        {
+            request_data[3] = 2;
+            codecs::encode_16_bits_big_endian(first_segment, &request_data[4]);
+            request_size += 2;
+        }
+        add_crc(request_data, request_size - 4);
+
+        scrutiny_handler.receive_data(request_data, request_size);
+        scrutiny_handler.process(0);
+        n_to_read = scrutiny_handler.data_to_send();
+        ASSERT_GT(n_to_read, 0);
+        ASSERT_LT(n_to_read, sizeof(tx_buffer));
+        scrutiny_handler.pop_data(tx_buffer, n_to_read);
+        scrutiny_handler.process(0);
+
+        ASSERT_TRUE(IS_PROTOCOL_RESPONSE(tx_buffer, protocol::CommandId::DataLogControl, 6, protocol::ResponseCode::OK));
+        uint16_t const segments_in_response = SEGMENT_COUNT - first_segment;
+        uint16_t const payload_size = 16 + 4 + 12 * segments_in_response;
+        ASSERT_EQ(n_to_read, 9 + payload_size);
+
+        uint8_t expected_response[9 + 16 + 4 + 12 * SEGMENT_COUNT] = {0x85, 6, 0};
+        uint16_t cursor = 3;
+        cursor += codecs::encode_16_bits_big_endian(payload_size, &expected_response[cursor]);
+        cursor += codecs::encode_16_bits_big_endian(scrutiny_handler.datalogger()->get_acquisition_id(), &expected_response[cursor]);
+        cursor += codecs::encode_16_bits_big_endian((uint16_t)0xabcd, &expected_response[cursor]);
+        cursor += codecs::encode_32_bits_big_endian((uint32_t)reader->get_entry_count(), &expected_response[cursor]);
+        cursor += codecs::encode_32_bits_big_endian((uint32_t)reader->get_total_size(), &expected_response[cursor]);
+        cursor += codecs::encode_32_bits_big_endian((uint32_t)scrutiny_handler.datalogger()->log_points_after_trigger(), &expected_response[cursor]);
+        cursor += codecs::encode_16_bits_big_endian(SEGMENT_COUNT, &expected_response[cursor]);
+        cursor += codecs::encode_16_bits_big_endian(first_segment, &expected_response[cursor]);
+        for (uint16_t segment = first_segment; segment < SEGMENT_COUNT; segment++)
+        {
+            timestamp_t trigger_timestamp;
+            datalogging::buffer_size_t entry_count;
+            datalogging::buffer_size_t points_after_trigger;
+            ASSERT_TRUE(scrutiny_handler.datalogger()->get_segment_info(segment, &trigger_timestamp, &entry_count, &points_after_trigger));
+            EXPECT_GT(entry_count, 0u);
+            cursor += codecs::encode_32_bits_big_endian(trigger_timestamp, &expected_response[cursor]);
+            cursor += codecs::encode_32_bits_big_endian((uint32_t)entry_count, &expected_response[cursor]);
+            cursor += codecs::encode_32_bits_big_endian((uint32_t)points_after_trigger, &expected_response[cursor]);
+        }
+        add_crc(expected_response, cursor);
+
+        EXPECT_BUF_EQ(tx_buffer, expected_response, cursor + 4);
+    }
+}
+
+TEST_F(TestDatalogControl, TestConfigureTimeAxis)
+{
+    // The loops never take the ownership, so the datalogger can be reconfigured right away
+    datalogging::Configuration refconfig = get_valid_reference_configuration();
+    refconfig.items_to_log[0].type = datalogging::LoggableType::MEMORY; // Replaces the TIME item
+    refconfig.items_to_log[0].data.memory.address = &m_some_var_logged1;
+    refconfig.items_to_log[0].data.memory.size = sizeof(m_some_var_logged1);
+
+    refconfig.time_axis = datalogging::TimeAxis::Implicit;
+    test_configure(0, 0, refconfig, protocol::ResponseCode::OK, true, "Implicit time on fixed frequency loop");
+    EXPECT_EQ(scrutiny_handler.datalogger()->config()->time_axis, datalogging::TimeAxis::Implicit);
+    test_configure(1, 0, refconfig, protocol::ResponseCode::FailureToProceed, true, "Implicit time on variable frequency loop");
+
+    refconfig.time_axis = datalogging::TimeAxis::Sparse;
+    refconfig.time_mark_interval = 0x1234;
+    refconfig.time_mark_tolerance_100ns = 0x55667788;
+    test_configure(1, 0, refconfig, protocol::ResponseCode::OK, true, "Sparse time on variable frequency loop");
+    EXPECT_EQ(scrutiny_handler.datalogger()->config()->time_axis, datalogging::TimeAxis::Sparse);
+    EXPECT_EQ(scrutiny_handler.datalogger()->config()->time_mark_interval, 0x1234u);
+    EXPECT_EQ(scrutiny_handler.datalogger()->config()->time_mark_tolerance_100ns, 0x55667788u);
+
+    refconfig.items_to_log[0].type = datalogging::LoggableType::TIME;
+    test_configure(1, 0, refconfig, protocol::ResponseCode::InvalidRequest, true, "TIME item with sparse time");
+}
+
+TEST_F(TestDatalogControl, TestGetTimeMarks)
+{
+    uint8_t tx_buffer[128]{0};
+    uint16_t n_to_read{0};
+
+    datalogging::Configuration refconfig = get_valid_reference_configuration();
+    refconfig.items_to_log[0].type = datalogging::LoggableType::MEMORY; // Replaces the TIME item
+    refconfig.items_to_log[0].data.memory.address = &m_some_var_logged1;
+    refconfig.items_to_log[0].data.memory.size = sizeof(m_some_var_logged1);
+    refconfig.decimation = 1;
+    refconfig.time_axis = datalogging::TimeAxis::Sparse;
+    refconfig.time_mark_interval = 4;
+    refconfig.time_mark_tolerance_100ns = 5;
+    test_configure(1, 0xabcd, refconfig, protocol::ResponseCode::OK); // Assign to Loop 1 (Variable freq)
+    variable_freq_loop.process(10);                                   // Accept ownership
+    scrutiny_handler.process(0);
+
+    // Request before the acquisition is done
+    uint8_t request_data[12] = {5, 11, 0, 4, 0, 0, 0, 0};
+    add_crc(request_data, 8);
+    scrutiny_handler.receive_data(request_data, 12);
+    scrutiny_handler.process(0);
+    n_to_read = scrutiny_handler.data_to_send();
+    ASSERT_GT(n_to_read, 0);
+    ASSERT_LT(n_to_read, sizeof(tx_buffer));
+    scrutiny_handler.pop_data(tx_buffer, n_to_read);
+    scrutiny_handler.process(0);
+    EXPECT_TRUE(IS_PROTOCOL_RESPONSE(tx_buffer, protocol::CommandId::DataLogControl, 11, protocol::ResponseCode::FailureToProceed));
+
+    // Time step changes every 10 cycles
+    scrutiny_handler.datalogger()->arm_trigger();
+    scrutiny_handler.datalogger()->force_trigger();
+    for (uint32_t i = 0; i < sizeof(dlbuffer); i++)
+    {
+        variable_freq_loop.process((i / 10) % 2 == 0 ? 100 : 200);
+        scrutiny_handler.process(1);
+        if (scrutiny_handler.datalogger()->data_acquired())
+        {
+            break;
+        }
+    }
+    ASSERT_TRUE(scrutiny_handler.datalogger()->data_acquired());
+    variable_freq_loop.process(100);
+    scrutiny_handler.process(1);
+
+    uint16_t const mark_count = scrutiny_handler.datalogger()->get_time_mark_count(0);
+    ASSERT_GT(mark_count, 3u);
+
+    // Ask for all the marks, then from the 3rd one.
+    uint16_t const first_marks[2] = {0, 2};
+    for (unsigned int n = 0; n < 2; n++)
+    {
+        uint16_t const first_mark = first_marks[n];
+        codecs::encode_16_bits_big_endian(first_mark, &request_data[6]);
+        add_crc(request_data, 8);
+        scrutiny_handler.receive_data(request_data, 12);
+        scrutiny_handler.process(0);
+        n_to_read = scrutiny_handler.data_to_send();
+        ASSERT_GT(n_to_read, 0);
+        ASSERT_LT(n_to_read, sizeof(tx_buffer));
+        scrutiny_handler.pop_data(tx_buffer, n_to_read);
+        scrutiny_handler.process(0);
+        ASSERT_TRUE(IS_PROTOCOL_RESPONSE(tx_buffer, protocol::CommandId::DataLogControl, 11, protocol::ResponseCode::OK));
+
+        uint16_t const marks_in_response = static_cast<uint16_t>(SCRUTINY_MIN(mark_count - first_mark, static_cast<int>((sizeof(tx_buffer) - 9 - 8) / 8)));
+        uint16_t const payload_size = 8 + 8 * marks_in_response;
+        ASSERT_EQ(n_to_read, 9 + payload_size);
+
+        uint8_t expected_response[sizeof(tx_buffer)] = {0x85, 11, 0};
+        uint16_t cursor = 3;
+        cursor += codecs::encode_16_bits_big_endian(payload_size, &expected_response[cursor]);
+        cursor += codecs::encode_16_bits_big_endian(scrutiny_handler.datalogger()->get_acquisition_id(), &expected_response[cursor]);
+        cursor += codecs::encode_16_bits_big_endian((uint16_t)0, &expected_response[cursor]);
+        cursor += codecs::encode_16_bits_big_endian(mark_count, &expected_response[cursor]);
+        cursor += codecs::encode_16_bits_big_endian(first_mark, &expected_response[cursor]);
+        for (uint16_t i = 0; i < marks_in_response; i++)
+        {
+            datalogging::buffer_size_t entry_index;
+            timestamp_t timestamp;
+            ASSERT_TRUE(scrutiny_handler.datalogger()->get_time_mark(0, first_mark + i, &entry_index, &timestamp));
+            cursor += codecs::encode_32_bits_big_endian((uint32_t)entry_index, &expected_response[cursor]);
+            cursor += codecs::encode_32_bits_big_endian(timestamp, &expected_response[cursor]);
+        }
+        add_crc(expected_response, cursor);
+
+        EXPECT_BUF_EQ(tx_buffer, expected_response, cursor + 4);
+    }
+}
+
 TEST_F(TestDatalogControl, TestReadAcquisitionNoDataAvailable)
 {
     uint8_t tx_buffer[32]{0};
@@ -846,6 +1115,74 @@ TEST_F(TestDatalogControl, TestReadAcquisitionOneTransfer)
     EXPECT_EQ(gotten_crc, expected_crc);
 }
 
+TEST_F(TestDatalogControl, TestReadAcquisitionColumns)
+{
+    uint8_t tx_buffer[1024]{};
+    uint16_t n_to_read{};
+
+    datalogging::Configuration refconfig = get_valid_reference_configuration();
+    refconfig.decimation = 1;
+    test_configure(0, 0xabcd, refconfig, protocol::ResponseCode::OK); // Assign to Loop 0 (Fixed freq)
+    fixed_freq_loop.process();                                        // Accept ownership
+    scrutiny_handler.process(0);
+
+    scrutiny_handler.datalogger()->arm_trigger();
+    scrutiny_handler.datalogger()->force_trigger();
+    for (uint32_t i = 0; i < sizeof(dlbuffer) / 4; i++)
+    {
+        fixed_freq_loop.process();
+        scrutiny_handler.process(1);
+        if (scrutiny_handler.datalogger()->data_acquired())
+        {
+            break;
+        }
+    }
+    ASSERT_TRUE(scrutiny_handler.datalogger()->data_acquired());
+    fixed_freq_loop.process();
+    scrutiny_handler.process(1);
+
+    // Unknown layout
+    uint8_t bad_request[9] = {5, 7, 0, 1, 2};
+    add_crc(bad_request, sizeof(bad_request) - 4);
+    scrutiny_handler.receive_data(bad_request, sizeof(bad_request));
+    scrutiny_handler.process(0);
+    n_to_read = scrutiny_handler.data_to_send();
+    ASSERT_GT(n_to_read, 0);
+    ASSERT_LT(n_to_read, sizeof(tx_buffer));
+    scrutiny_handler.pop_data(tx_buffer, n_to_read);
+    scrutiny_handler.process(0);
+    EXPECT_TRUE(IS_PROTOCOL_RESPONSE(tx_buffer, protocol::CommandId::DataLogControl, 7, protocol::ResponseCode::InvalidRequest));
+
+    uint8_t request_data[9] = {5, 7, 0, 1, static_cast<uint8_t>(datalogging::ReadLayout::Columns)};
+    add_crc(request_data, sizeof(request_data) - 4);
+    scrutiny_handler.receive_data(request_data, sizeof(request_data));
+    scrutiny_handler.process(0);
+    n_to_read = scrutiny_handler.data_to_send();
+    ASSERT_GT(n_to_read, 0);
+    ASSERT_LT(n_to_read, sizeof(tx_buffer));
+    scrutiny_handler.pop_data(tx_buffer, n_to_read);
+    ASSERT_TRUE(IS_PROTOCOL_RESPONSE(tx_buffer, protocol::CommandId::DataLogControl, 7, protocol::ResponseCode::OK));
+    EXPECT_EQ(tx_buffer[5], 1); // finished
+    uint32_t payload_length = codecs::decode_16_bits_big_endian(&tx_buffer[3]);
+
+    // Same data as a local reading done column after column, which differs from the rows
+    datalogging::DataReader *reader = scrutiny_handler.datalogger()->get_reader();
+    uint8_t row_data[sizeof(dlbuffer)];
+    uint8_t column_data[sizeof(dlbuffer)];
+    reader->set_layout(datalogging::ReadLayout::Rows);
+    uint32_t const row_count = reader->read(row_data, sizeof(row_data));
+    reader->set_layout(datalogging::ReadLayout::Columns);
+    uint32_t const column_count = reader->read(column_data, sizeof(column_data));
+    ASSERT_EQ(row_count, column_count);
+    ASSERT_EQ(column_count, payload_length - 8); // header=4. Crc=4
+    EXPECT_FALSE(COMPARE_BUF(row_data, column_data, column_count));
+    EXPECT_BUF_EQ(&tx_buffer[9], column_data, column_count);
+
+    uint32_t expected_crc = tools::crc32(column_data, column_count);
+    uint32_t gotten_crc = codecs::decode_32_bits_big_endian(&tx_buffer[n_to_read - 8]);
+    EXPECT_EQ(gotten_crc, expected_crc);
+}
+
 TEST_F(TestDatalogControl, TestReadAcquisitionMultipleTransfer)
 {
     uint8_t small_tx_buffer[32]{0};
@@ -942,6 +1279,612 @@ TEST_F(TestDatalogControl, TestReadAcquisitionMultipleTransfer)
     }
 }
 
+TEST_F(TestDatalogControl, TestReadAcquisitionStreamed)
+{
+    // With response streaming, the frames are as big as the link allows, whatever the transmission buffer size
+    constexpr uint16_t mtu = 1000;
+    uint8_t small_tx_buffer[32]{0};
+    uint8_t big_dlbuffer[10000]{0};
+
+    config.set_buffers(_rx_buffer, sizeof(_rx_buffer), small_tx_buffer, sizeof(small_tx_buffer));
+    config.set_datalogging_buffers(big_dlbuffer, sizeof(big_dlbuffer));
+    config.set_datagram_mode(mtu);
+    config.response_streaming = true;
+    scrutiny_handler.init(&config);
+    scrutiny_handler.comm()->connect();
+
+    datalogging::Configuration refconfig = get_valid_reference_configuration();
+    refconfig.decimation = 1;
+    test_configure(0, 0xabcd, refconfig, protocol::ResponseCode::OK); // Assign to Loop 0 (Fixed freq)
+    fixed_freq_loop.process();                                        // Accept ownership
+    scrutiny_handler.process(0);
+
+    scrutiny_handler.datalogger()->arm_trigger();
+    scrutiny_handler.datalogger()->force_trigger();
+    for (uint32_t i = 0; i < sizeof(big_dlbuffer) / 4; i++)
+    {
+        fixed_freq_loop.process();
+        scrutiny_handler.process(1);
+        if (scrutiny_handler.datalogger()->data_acquired())
+        {
+            break;
+        }
+    }
+    EXPECT_TRUE(scrutiny_handler.datalogger()->data_acquired());
+    fixed_freq_loop.process();
+    scrutiny_handler.process(1);
+
+    uint8_t read_data[sizeof(big_dlbuffer)];
+    uint8_t reference_data[sizeof(big_dlbuffer)];
+    datalogging::DataReader *reader = scrutiny_handler.datalogger()->get_reader();
+    reader->reset();
+    uint32_t const total_data_length = reader->read(reference_data, sizeof(reference_data));
+    uint32_t const expected_crc = tools::crc32(reference_data, total_data_length);
+
+    uint32_t read_cursor = 0;
+    bool finished = false;
+    uint16_t frame_count = 0;
+    while (!finished && frame_count < 20)
+    {
+        std::string error_msg = std::string("frame=") + std::to_string(frame_count);
+        uint8_t frame[mtu];
+        uint8_t request_data[8] = {5, 7, 0, 0};
+        add_crc(request_data, sizeof(request_data) - 4);
+        scrutiny_handler.receive_data(request_data, sizeof(request_data));
+        scrutiny_handler.process(0);
+        uint16_t const frame_size = scrutiny_handler.data_to_send();
+        ASSERT_GT(frame_size, sizeof(small_tx_buffer)) << error_msg;
+        ASSERT_LE(frame_size, mtu) << error_msg;
+        ASSERT_EQ(scrutiny_handler.pop_data(frame, sizeof(frame)), frame_size) << error_msg;
+        scrutiny_handler.process(0);
+
+        ASSERT_TRUE(IS_PROTOCOL_RESPONSE(frame, protocol::CommandId::DataLogControl, 7, protocol::ResponseCode::OK)) << error_msg;
+        EXPECT_EQ(codecs::decode_32_bits_big_endian(&frame[frame_size - 4]), tools::crc32(frame, frame_size - 4u)) << error_msg;
+        finished = static_cast<bool>(frame[5]);
+        EXPECT_EQ(frame[6], frame_count) << error_msg; // Rolling counter
+
+        uint16_t const payload_length = codecs::decode_16_bits_big_endian(&frame[3]);
+        uint16_t const qty_to_read = payload_length - 4 - (finished ? 4 : 0);
+        ASSERT_LE(read_cursor + qty_to_read, sizeof(read_data)) << error_msg;
+        std::memcpy(&read_data[read_cursor], &frame[9], qty_to_read);
+        read_cursor += qty_to_read;
+        if (finished)
+        {
+            EXPECT_EQ(codecs::decode_32_bits_big_endian(&frame[9 + qty_to_read]), expected_crc);
+        }
+        frame_count++;
+    }
+
+    EXPECT_TRUE(finished);
+    EXPECT_GT(frame_count, 1u);
+    ASSERT_EQ(read_cursor, total_data_length);
+    EXPECT_BUF_EQ(read_data, reference_data, total_data_length);
+}
+
+TEST_F(TestDatalogControl, TestReadAcquisitionChunkRandomAccess)
+{
+    uint8_t small_tx_buffer[64]{0};
+    uint8_t big_dlbuffer[2000]{0};
+
+    config.set_buffers(_rx_buffer, sizeof(_rx_buffer), small_tx_buffer, sizeof(small_tx_buffer));
+    config.set_datalogging_buffers(big_dlbuffer, sizeof(big_dlbuffer));
+    scrutiny_handler.init(&config);
+    scrutiny_handler.comm()->connect();
+
+    datalogging::Configuration refconfig = get_valid_reference_configuration();
+    refconfig.decimation = 1;
+    refconfig.probe_location = 64; // Makes the acquisition wrap in the buffer
+    test_configure(0, 0xabcd, refconfig, protocol::ResponseCode::OK);
+    fixed_freq_loop.process(); // Accept ownership
+    scrutiny_handler.process(0);
+
+    scrutiny_handler.datalogger()->arm_trigger();
+    for (uint32_t i = 0; i < sizeof(big_dlbuffer); i++)
+    {
+        if (i == sizeof(big_dlbuffer) / 4)
+        {
+            scrutiny_handler.datalogger()->force_trigger();
+        }
+        fixed_freq_loop.process();
+        scrutiny_handler.process(1);
+        if (scrutiny_handler.datalogger()->data_acquired())
+        {
+            break;
+        }
+    }
+    ASSERT_TRUE(scrutiny_handler.datalogger()->data_acquired());
+    fixed_freq_loop.process();
+    scrutiny_handler.process(1);
+
+    uint8_t reference_data[sizeof(big_dlbuffer)];
+    uint8_t read_data[sizeof(big_dlbuffer)];
+    datalogging::DataReader *reader = scrutiny_handler.datalogger()->get_reader();
+    reader->reset();
+    uint32_t const total_data_length = reader->read(reference_data, sizeof(reference_data));
+    ASSERT_TRUE(reader->finished());
+    uint16_t const acquisition_id = scrutiny_handler.datalogger()->get_acquisition_id();
+
+    // Request chunks from the end to the beginning, like a server retrying lost chunks would do.
+    constexpr uint16_t chunk_size = 37;
+    memset(read_data, 0, sizeof(read_data));
+    uint32_t offset = (total_data_length / chunk_size) * chunk_size;
+    while (true)
+    {
+        std::string error_msg = std::string("offset=") + std::to_string(offset);
+        uint8_t request[16] = {5, 9, 0, 8};
+        codecs::encode_16_bits_big_endian(acquisition_id, &request[4]);
+        codecs::encode_32_bits_big_endian(offset, &request[6]);
+        codecs::encode_16_bits_big_endian(chunk_size, &request[10]);
+        add_crc(request, 12);
+
+        uint8_t response[128];
+        scrutiny_handler.receive_data(request, 16);
+        scrutiny_handler.process(0);
+        uint16_t n_to_read = scrutiny_handler.data_to_send();
+        ASSERT_GT(n_to_read, 0) << error_msg;
+        ASSERT_LT(n_to_read, sizeof(response)) << error_msg;
+        scrutiny_handler.pop_data(response, n_to_read);
+        scrutiny_handler.process(0);
+
+        ASSERT_TRUE(IS_PROTOCOL_RESPONSE(response, protocol::CommandId::DataLogControl, 9, protocol::ResponseCode::OK)) << error_msg;
+        uint16_t const payload_length = codecs::decode_16_bits_big_endian(&response[3]);
+        ASSERT_GE(payload_length, 10) << error_msg;
+        uint16_t const chunk_length = payload_length - 10;
+        EXPECT_EQ(chunk_length, std::min<uint32_t>(chunk_size, total_data_length - offset)) << error_msg;
+        EXPECT_EQ(codecs::decode_16_bits_big_endian(&response[5]), acquisition_id) << error_msg;
+        EXPECT_EQ(codecs::decode_32_bits_big_endian(&response[7]), offset) << error_msg;
+        EXPECT_EQ(codecs::decode_32_bits_big_endian(&response[11 + chunk_length]), tools::crc32(&response[11], chunk_length)) << error_msg;
+        memcpy(&read_data[offset], &response[11], chunk_length);
+
+        if (offset == 0)
+        {
+            break;
+        }
+        offset -= chunk_size;
+    }
+    EXPECT_BUF_EQ(read_data, reference_data, total_data_length);
+
+    // Length of 0 means as much as the tx buffer can hold.
+    uint8_t request_max[16] = {5, 9, 0, 8};
+    codecs::encode_16_bits_big_endian(acquisition_id, &request_max[4]);
+    codecs::encode_32_bits_big_endian(static_cast<uint32_t>(100), &request_max[6]);
+    add_crc(request_max, 12);
+    uint8_t response[128];
+    scrutiny_handler.receive_data(request_max, 16);
+    scrutiny_handler.process(0);
+    uint16_t n_to_read = scrutiny_handler.data_to_send();
+    ASSERT_EQ(n_to_read, sizeof(small_tx_buffer) + 9);
+    scrutiny_handler.pop_data(response, n_to_read);
+    scrutiny_handler.process(0);
+    ASSERT_TRUE(IS_PROTOCOL_RESPONSE(response, protocol::CommandId::DataLogControl, 9, protocol::ResponseCode::OK));
+    EXPECT_BUF_EQ(&response[11], &reference_data[100], sizeof(small_tx_buffer) - 10);
+
+    // Bad offset and bad acquisition ID
+    const struct
+    {
+        uint16_t acquisition_id;
+        uint32_t offset;
+        protocol::ResponseCode expected_code;
+    } bad_requests[] = {
+        {acquisition_id, total_data_length + 1, protocol::ResponseCode::Overflow},
+        {static_cast<uint16_t>(acquisition_id + 1), 0, protocol::ResponseCode::FailureToProceed},
+    };
+
+    for (unsigned int i = 0; i < sizeof(bad_requests) / sizeof(bad_requests[0]); i++)
+    {
+        uint8_t request[16] = {5, 9, 0, 8};
+        codecs::encode_16_bits_big_endian(bad_requests[i].acquisition_id, &request[4]);
+        codecs::encode_32_bits_big_endian(bad_requests[i].offset, &request[6]);
+        add_crc(request, 12);
+        scrutiny_handler.receive_data(request, 16);
+        scrutiny_handler.process(0);
+        n_to_read = scrutiny_handler.data_to_send();
+        ASSERT_GT(n_to_read, 0) << "i=" << i;
+        ASSERT_LT(n_to_read, sizeof(response)) << "i=" << i;
+        scrutiny_handler.pop_data(response, n_to_read);
+        scrutiny_handler.process(0);
+        EXPECT_TRUE(IS_PROTOCOL_RESPONSE(response, protocol::CommandId::DataLogControl, 9, bad_requests[i].expected_code)) << "i=" << i;
+    }
+}
+
+TEST_F(TestDatalogControl, TestReadAcquisitionBurst)
+{
+    uint8_t small_tx_buffer[64]{0};
+    uint8_t big_dlbuffer[3000]{0};
+
+    config.set_buffers(_rx_buffer, sizeof(_rx_buffer), small_tx_buffer, sizeof(small_tx_buffer));
+    config.set_datalogging_buffers(big_dlbuffer, sizeof(big_dlbuffer));
+    scrutiny_handler.init(&config);
+    scrutiny_handler.comm()->connect();
+
+    datalogging::Configuration refconfig = get_valid_reference_configuration();
+    refconfig.decimation = 1;
+    test_configure(0, 0xabcd, refconfig, protocol::ResponseCode::OK);
+    fixed_freq_loop.process(); // Accept ownership
+    scrutiny_handler.process(0);
+
+    scrutiny_handler.datalogger()->arm_trigger();
+    scrutiny_handler.datalogger()->force_trigger();
+    for (uint32_t i = 0; i < sizeof(big_dlbuffer) / 4; i++)
+    {
+        fixed_freq_loop.process();
+        scrutiny_handler.process(1);
+        if (scrutiny_handler.datalogger()->data_acquired())
+        {
+            break;
+        }
+    }
+    ASSERT_TRUE(scrutiny_handler.datalogger()->data_acquired());
+    fixed_freq_loop.process();
+    scrutiny_handler.process(1);
+
+    uint8_t reference_data[sizeof(big_dlbuffer)];
+    datalogging::DataReader *reader = scrutiny_handler.datalogger()->get_reader();
+    reader->reset();
+    uint32_t const total_data_length = reader->read(reference_data, sizeof(reference_data));
+    uint32_t const expected_crc = tools::crc32(reference_data, total_data_length);
+    uint16_t const acquisition_id = scrutiny_handler.datalogger()->get_acquisition_id();
+
+    for (uint8_t frames_per_ack : {0, 1, 4})
+    {
+        std::string error_msg = std::string("frames_per_ack=") + std::to_string(frames_per_ack);
+        uint8_t read_data[sizeof(big_dlbuffer)];
+        uint32_t read_cursor = 0;
+        uint8_t expected_rolling_counter = 0;
+        uint16_t request_count = 1;
+
+        uint8_t start_request[9] = {5, 10, 0, 1, frames_per_ack};
+        add_crc(start_request, 5);
+        scrutiny_handler.receive_data(start_request, sizeof(start_request));
+        scrutiny_handler.process(0);
+
+        bool finished = false;
+        uint8_t frames_since_ack = 0;
+        while (!finished)
+        {
+            uint8_t frame[sizeof(small_tx_buffer) + 9];
+            uint16_t n_to_read = scrutiny_handler.data_to_send();
+            if (n_to_read == 0)
+            {
+                // Waiting for an acknowledgement.
+                scrutiny_handler.process(0);
+                ASSERT_EQ(scrutiny_handler.data_to_send(), 0u) << error_msg;
+                ASSERT_NE(frames_per_ack, 0) << error_msg;
+                ASSERT_EQ(frames_since_ack, frames_per_ack) << error_msg;
+                uint8_t ack[10] = {5, 10, 0, 2, frames_per_ack, expected_rolling_counter};
+                add_crc(ack, 6);
+                scrutiny_handler.receive_data(ack, sizeof(ack));
+                scrutiny_handler.process(0);
+                request_count++;
+                frames_since_ack = 0;
+                continue;
+            }
+
+            ASSERT_LE(n_to_read, sizeof(frame)) << error_msg;
+            scrutiny_handler.pop_data(frame, n_to_read); // The next frame is produced right away, without a call to process()
+            frames_since_ack++;
+
+            ASSERT_TRUE(IS_PROTOCOL_RESPONSE(frame, protocol::CommandId::DataLogControl, 10, protocol::ResponseCode::OK)) << error_msg;
+            finished = static_cast<bool>(frame[5]);
+            EXPECT_EQ(frame[6], expected_rolling_counter) << error_msg;
+            EXPECT_EQ(codecs::decode_16_bits_big_endian(&frame[7]), acquisition_id) << error_msg;
+            expected_rolling_counter++;
+
+            uint16_t const payload_length = codecs::decode_16_bits_big_endian(&frame[3]);
+            uint16_t const qty_to_read = finished ? payload_length - 8 : payload_length - 4;
+            ASSERT_LE(read_cursor + qty_to_read, sizeof(read_data)) << error_msg;
+            memcpy(&read_data[read_cursor], &frame[9], qty_to_read);
+            read_cursor += qty_to_read;
+            if (finished)
+            {
+                EXPECT_EQ(codecs::decode_32_bits_big_endian(&frame[9 + qty_to_read]), expected_crc) << error_msg;
+            }
+        }
+
+        scrutiny_handler.process(0);
+        EXPECT_EQ(scrutiny_handler.data_to_send(), 0u) << error_msg;
+        ASSERT_EQ(read_cursor, total_data_length) << error_msg;
+        EXPECT_BUF_EQ(read_data, reference_data, total_data_length) << error_msg;
+        uint16_t const expected_request_count = (frames_per_ack == 0) ? 1 : static_cast<uint16_t>((expected_rolling_counter + frames_per_ack - 1) / frames_per_ack);
+        EXPECT_EQ(request_count, expected_request_count) << error_msg;
+    }
+
+    // An acknowledgement that does not match the next frame stops the transfer
+    uint8_t start_request[9] = {5, 10, 0, 1, 2};
+    add_crc(start_request, 5);
+    scrutiny_handler.receive_data(start_request, sizeof(start_request));
+    scrutiny_handler.process(0);
+    uint8_t frame[sizeof(small_tx_buffer) + 9];
+    for (unsigned int i = 0; i < 2; i++)
+    {
+        ASSERT_GT(scrutiny_handler.data_to_send(), 0u);
+        scrutiny_handler.pop_data(frame, scrutiny_handler.data_to_send());
+    }
+    scrutiny_handler.process(0);
+    ASSERT_EQ(scrutiny_handler.data_to_send(), 0u);
+    uint8_t bad_ack[10] = {5, 10, 0, 2, 2, 3};
+    add_crc(bad_ack, 6);
+    scrutiny_handler.receive_data(bad_ack, sizeof(bad_ack));
+    scrutiny_handler.process(0);
+    uint16_t n_to_read = scrutiny_handler.data_to_send();
+    ASSERT_GT(n_to_read, 0u);
+    scrutiny_handler.pop_data(frame, n_to_read);
+    EXPECT_TRUE(IS_PROTOCOL_RESPONSE(frame, protocol::CommandId::DataLogControl, 10, protocol::ResponseCode::FailureToProceed));
+    scrutiny_handler.process(0);
+    EXPECT_EQ(scrutiny_handler.data_to_send(), 0u);
+}
+
+TEST_F(TestDatalogControl, TestReadAcquisitionBurstLongerThanHeartbeat)
+{
+    // Without flow control, the server cannot send heartbeats. The session stays alive as long as the frames are drained.
+    uint8_t small_tx_buffer[64]{0};
+    uint8_t big_dlbuffer[3000]{0};
+
+    config.set_buffers(_rx_buffer, sizeof(_rx_buffer), small_tx_buffer, sizeof(small_tx_buffer));
+    config.set_datalogging_buffers(big_dlbuffer, sizeof(big_dlbuffer));
+    scrutiny_handler.init(&config);
+    scrutiny_handler.comm()->connect();
+
+    datalogging::Configuration refconfig = get_valid_reference_configuration();
+    refconfig.decimation = 1;
+    test_configure(0, 0xabcd, refconfig, protocol::ResponseCode::OK);
+    fixed_freq_loop.process(); // Accept ownership
+    scrutiny_handler.process(0);
+
+    scrutiny_handler.datalogger()->arm_trigger();
+    scrutiny_handler.datalogger()->force_trigger();
+    for (uint32_t i = 0; i < sizeof(big_dlbuffer) / 4; i++)
+    {
+        fixed_freq_loop.process();
+        scrutiny_handler.process(1);
+        if (scrutiny_handler.datalogger()->data_acquired())
+        {
+            break;
+        }
+    }
+    ASSERT_TRUE(scrutiny_handler.datalogger()->data_acquired());
+    fixed_freq_loop.process();
+    scrutiny_handler.process(1);
+
+    constexpr uint32_t third_heartbeat_timeout = SCRUTINY_COMM_HEARTBEAT_TIMEOUT_US * 10 / 3;
+    uint8_t start_request[9] = {5, 10, 0, 1, 0};
+    add_crc(start_request, 5);
+    scrutiny_handler.receive_data(start_request, sizeof(start_request));
+    scrutiny_handler.process(0);
+
+    bool finished = false;
+    uint32_t frame_count = 0;
+    uint8_t frame[sizeof(small_tx_buffer) + 9];
+    while (!finished)
+    {
+        uint16_t const n_to_read = scrutiny_handler.data_to_send();
+        ASSERT_GT(n_to_read, 0u) << "frame_count=" << frame_count;
+        ASSERT_LE(n_to_read, sizeof(frame));
+        scrutiny_handler.pop_data(frame, n_to_read);
+        ASSERT_TRUE(IS_PROTOCOL_RESPONSE(frame, protocol::CommandId::DataLogControl, 10, protocol::ResponseCode::OK)) << "frame_count=" << frame_count;
+        finished = static_cast<bool>(frame[5]);
+        frame_count++;
+        scrutiny_handler.process(third_heartbeat_timeout);
+    }
+    EXPECT_GT(frame_count * third_heartbeat_timeout, static_cast<uint32_t>(SCRUTINY_COMM_HEARTBEAT_TIMEOUT_US * 10 * 4));
+    EXPECT_TRUE(scrutiny_handler.comm()->is_connected());
+
+    // A server that stops draining the frames loses its session like any server that stops sending heartbeats
+    scrutiny_handler.receive_data(start_request, sizeof(start_request));
+    scrutiny_handler.process(0);
+    ASSERT_GT(scrutiny_handler.data_to_send(), 0u);
+    scrutiny_handler.pop_data(frame, scrutiny_handler.data_to_send());
+    scrutiny_handler.process(third_heartbeat_timeout);
+    scrutiny_handler.process(third_heartbeat_timeout);
+    EXPECT_TRUE(scrutiny_handler.comm()->is_connected());
+    scrutiny_handler.process(third_heartbeat_timeout + 10);
+    EXPECT_FALSE(scrutiny_handler.comm()->is_connected());
+}
+
+TEST_F(TestDatalogControl, TestReadAcquisitionOneChannelAtATime)
+{
+    // The reader is shared by all the channels. A second channel must wait for the first one to finish its read.
+    uint8_t small_tx_buffer[32]{0};
+    uint8_t big_dlbuffer[1000]{0};
+    uint8_t rx_buffer2[64]{0};
+    uint8_t tx_buffer2[32]{0};
+    CommChannel channel2;
+    CommChannel *channels[1] = {&channel2};
+    channel2.set_buffers(rx_buffer2, sizeof(rx_buffer2), tx_buffer2, sizeof(tx_buffer2));
+
+    config.set_buffers(_rx_buffer, sizeof(_rx_buffer), small_tx_buffer, sizeof(small_tx_buffer));
+    config.set_datalogging_buffers(big_dlbuffer, sizeof(big_dlbuffer));
+    config.set_additional_comm_channels(channels, 1);
+    scrutiny_handler.init(&config);
+    scrutiny_handler.comm()->connect();
+    channel2.comm()->connect();
+
+    datalogging::Configuration refconfig = get_valid_reference_configuration();
+    refconfig.decimation = 1;
+    test_configure(0, 0xabcd, refconfig, protocol::ResponseCode::OK);
+    fixed_freq_loop.process(); // Accept ownership
+    scrutiny_handler.process(0);
+
+    scrutiny_handler.datalogger()->arm_trigger();
+    scrutiny_handler.datalogger()->force_trigger();
+    for (uint32_t i = 0; i < sizeof(big_dlbuffer); i++)
+    {
+        fixed_freq_loop.process();
+        scrutiny_handler.process(1);
+        if (scrutiny_handler.datalogger()->data_acquired())
+        {
+            break;
+        }
+    }
+    ASSERT_TRUE(scrutiny_handler.datalogger()->data_acquired());
+    fixed_freq_loop.process();
+    scrutiny_handler.process(1);
+
+    uint8_t read_request[8] = {5, 7, 0, 0};
+    add_crc(read_request, 4);
+    uint8_t chunk_request[16] = {5, 9, 0, 8};
+    codecs::encode_16_bits_big_endian(scrutiny_handler.datalogger()->get_acquisition_id(), &chunk_request[4]);
+    codecs::encode_32_bits_big_endian(static_cast<uint32_t>(0), &chunk_request[6]);
+    codecs::encode_16_bits_big_endian(static_cast<uint16_t>(8), &chunk_request[10]);
+    add_crc(chunk_request, 12);
+    uint8_t response[64];
+
+    // The main channel starts reading. The acquisition needs many frames
+    scrutiny_handler.receive_data(read_request, sizeof(read_request));
+    scrutiny_handler.process(0);
+    uint16_t n_to_read = scrutiny_handler.data_to_send();
+    ASSERT_GT(n_to_read, 0u);
+    ASSERT_LE(n_to_read, sizeof(response));
+    scrutiny_handler.pop_data(response, n_to_read);
+    scrutiny_handler.process(0);
+    ASSERT_TRUE(IS_PROTOCOL_RESPONSE(response, protocol::CommandId::DataLogControl, 7, protocol::ResponseCode::OK));
+    ASSERT_EQ(response[5], 0u); // Not finished
+    ASSERT_EQ(response[6], 0u); // Rolling counter
+
+    // The other channel cannot touch the reader, sequentially or by chunk
+    channel2.receive_data(read_request, sizeof(read_request));
+    scrutiny_handler.process(0);
+    n_to_read = channel2.data_to_send();
+    ASSERT_GT(n_to_read, 0u);
+    ASSERT_LE(n_to_read, sizeof(response));
+    channel2.pop_data(response, n_to_read);
+    scrutiny_handler.process(0);
+    EXPECT_TRUE(IS_PROTOCOL_RESPONSE(response, protocol::CommandId::DataLogControl, 7, protocol::ResponseCode::Busy));
+
+    channel2.receive_data(chunk_request, sizeof(chunk_request));
+    scrutiny_handler.process(0);
+    n_to_read = channel2.data_to_send();
+    ASSERT_GT(n_to_read, 0u);
+    ASSERT_LE(n_to_read, sizeof(response));
+    channel2.pop_data(response, n_to_read);
+    scrutiny_handler.process(0);
+    EXPECT_TRUE(IS_PROTOCOL_RESPONSE(response, protocol::CommandId::DataLogControl, 9, protocol::ResponseCode::Busy));
+
+    // The main channel continues its read undisturbed
+    scrutiny_handler.receive_data(read_request, sizeof(read_request));
+    scrutiny_handler.process(0);
+    n_to_read = scrutiny_handler.data_to_send();
+    ASSERT_GT(n_to_read, 0u);
+    ASSERT_LE(n_to_read, sizeof(response));
+    scrutiny_handler.pop_data(response, n_to_read);
+    scrutiny_handler.process(0);
+    ASSERT_TRUE(IS_PROTOCOL_RESPONSE(response, protocol::CommandId::DataLogControl, 7, protocol::ResponseCode::OK));
+    EXPECT_EQ(response[6], 1u);
+
+    // Once the session of the reader ends, the other channel can read from the beginning
+    scrutiny_handler.comm()->disconnect();
+    channel2.receive_data(read_request, sizeof(read_request));
+    scrutiny_handler.process(0);
+    n_to_read = channel2.data_to_send();
+    ASSERT_GT(n_to_read, 0u);
+    ASSERT_LE(n_to_read, sizeof(response));
+    channel2.pop_data(response, n_to_read);
+    scrutiny_handler.process(0);
+    EXPECT_TRUE(IS_PROTOCOL_RESPONSE(response, protocol::CommandId::DataLogControl, 7, protocol::ResponseCode::OK));
+    EXPECT_EQ(response[6], 0u);
+}
+
+TEST_F(TestDatalogControl, TestReadAcquisitionStreamedFrameKeepsReader)
+{
+    // A streamed frame reads the storage while it is transmitted. The other channels must not touch the reader or the datalogger
+    // until it is sent, even if it is the last frame of the acquisition
+    uint8_t small_tx_buffer[32]{0};
+    uint8_t big_dlbuffer[1000]{0};
+    uint8_t rx_buffer2[64]{0};
+    uint8_t tx_buffer2[32]{0};
+    CommChannel channel2;
+    CommChannel *channels[1] = {&channel2};
+    channel2.set_buffers(rx_buffer2, sizeof(rx_buffer2), tx_buffer2, sizeof(tx_buffer2));
+
+    config.set_buffers(_rx_buffer, sizeof(_rx_buffer), small_tx_buffer, sizeof(small_tx_buffer));
+    config.set_datalogging_buffers(big_dlbuffer, sizeof(big_dlbuffer));
+    config.set_additional_comm_channels(channels, 1);
+    config.response_streaming = true;
+    scrutiny_handler.init(&config);
+    scrutiny_handler.comm()->connect();
+    channel2.comm()->connect();
+
+    datalogging::Configuration refconfig = get_valid_reference_configuration();
+    refconfig.decimation = 1;
+    test_configure(0, 0xabcd, refconfig, protocol::ResponseCode::OK);
+    fixed_freq_loop.process(); // Accept ownership
+    scrutiny_handler.process(0);
+
+    scrutiny_handler.datalogger()->arm_trigger();
+    scrutiny_handler.datalogger()->force_trigger();
+    for (uint32_t i = 0; i < sizeof(big_dlbuffer); i++)
+    {
+        fixed_freq_loop.process();
+        scrutiny_handler.process(1);
+        if (scrutiny_handler.datalogger()->data_acquired())
+        {
+            break;
+        }
+    }
+    ASSERT_TRUE(scrutiny_handler.datalogger()->data_acquired());
+    fixed_freq_loop.process();
+    scrutiny_handler.process(1);
+
+    uint8_t reference_data[sizeof(big_dlbuffer)];
+    datalogging::DataReader *reader = scrutiny_handler.datalogger()->get_reader();
+    reader->reset();
+    uint32_t const total_data_length = reader->read(reference_data, sizeof(reference_data));
+    uint32_t const expected_crc = tools::crc32(reference_data, total_data_length);
+
+    uint8_t read_request[8] = {5, 7, 0, 0};
+    add_crc(read_request, 4);
+    uint8_t arm_request[8] = {5, 3, 0, 0};
+    add_crc(arm_request, 4);
+    uint8_t reset_request[8] = {5, 8, 0, 0};
+    add_crc(reset_request, 4);
+    uint8_t response[32];
+
+    // The whole acquisition fits in a single streamed frame. Its beginning is sent, the rest is still read from the storage
+    scrutiny_handler.receive_data(read_request, sizeof(read_request));
+    scrutiny_handler.process(0);
+    uint16_t const frame_size = scrutiny_handler.data_to_send();
+    ASSERT_EQ(frame_size, 9u + total_data_length + 4u + 4u);
+    uint8_t frame[sizeof(big_dlbuffer) + 32];
+    ASSERT_LE(frame_size, sizeof(frame));
+    ASSERT_EQ(scrutiny_handler.pop_data(frame, 16), 16u);
+    scrutiny_handler.process(0);
+    ASSERT_TRUE(IS_PROTOCOL_RESPONSE(frame, protocol::CommandId::DataLogControl, 7, protocol::ResponseCode::OK));
+    ASSERT_EQ(frame[5], 1u); // Finished
+
+    uint8_t *const requests[3] = {read_request, arm_request, reset_request};
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        std::string error_msg = std::string("request=") + std::to_string(i);
+        channel2.receive_data(requests[i], 8);
+        scrutiny_handler.process(0);
+        uint16_t const n_to_read = channel2.data_to_send();
+        ASSERT_GT(n_to_read, 0u) << error_msg;
+        ASSERT_LE(n_to_read, sizeof(response)) << error_msg;
+        channel2.pop_data(response, n_to_read);
+        scrutiny_handler.process(0);
+        EXPECT_TRUE(IS_PROTOCOL_RESPONSE(response, protocol::CommandId::DataLogControl, requests[i][1], protocol::ResponseCode::Busy))
+            << error_msg;
+    }
+
+    // The frame finishes with the data and the CRC of the acquisition, as if nothing happened
+    ASSERT_EQ(scrutiny_handler.pop_data(&frame[16], frame_size - 16u), frame_size - 16u);
+    scrutiny_handler.process(0);
+    EXPECT_EQ(codecs::decode_32_bits_big_endian(&frame[frame_size - 4]), tools::crc32(frame, frame_size - 4u));
+    EXPECT_BUF_EQ(&frame[9], reference_data, total_data_length);
+    EXPECT_EQ(codecs::decode_32_bits_big_endian(&frame[9 + total_data_length]), expected_crc);
+    EXPECT_TRUE(scrutiny_handler.datalogger()->data_acquired());
+
+    // Once sent, the other channel can read from the beginning
+    channel2.receive_data(read_request, sizeof(read_request));
+    scrutiny_handler.process(0);
+    ASSERT_EQ(channel2.data_to_send(), frame_size);
+    ASSERT_EQ(channel2.pop_data(frame, frame_size), frame_size);
+    scrutiny_handler.process(0);
+    EXPECT_TRUE(IS_PROTOCOL_RESPONSE(frame, protocol::CommandId::DataLogControl, 7, protocol::ResponseCode::OK));
+    EXPECT_BUF_EQ(&frame[9], reference_data, total_data_length);
+    EXPECT_EQ(codecs::decode_32_bits_big_endian(&frame[9 + total_data_length]), expected_crc);
+}
+
 TEST_F(TestDatalogControl, TestResetDatalogger)
 {
     uint8_t tx_buffer[32]{0};
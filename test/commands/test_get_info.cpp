@@ -633,3 +633,154 @@ TEST_F(TestGetInfo, TestGetLoopDefinitionVariableFreq)
     scrutiny_handler.pop_data(tx_buffer, n_to_read);
     EXPECT_BUF_EQ(tx_buffer, expected_response, sizeof(expected_response));
 }
+
+/*
+    Reads the hash of the device description
+*/
+
+TEST_F(TestGetInfo, TestGetConfigFingerprint)
+{
+    uint8_t tx_buffer[32];
+    scrutiny::RuntimePublishedValue rpvs[2] = {
+        {0x1122, scrutiny::VariableType::uint32},
+        {0x3344, scrutiny::VariableType::float32}};
+
+    config.set_published_values(rpvs, 2, rpv_read_callback, rpv_write_callback);
+    scrutiny_handler.init(&config);
+    scrutiny_handler.comm()->connect();
+    uint32_t const fingerprint = scrutiny_handler.get_config_fingerprint();
+
+    uint8_t request_data[8] = {1, 10, 0, 0};
+    add_crc(request_data, sizeof(request_data) - 4);
+    uint8_t expected_response[9 + 4] = {0x81, 10, 0, 0, 4};
+    scrutiny::codecs::encode_32_bits_big_endian(fingerprint, &expected_response[5]);
+    add_crc(expected_response, sizeof(expected_response) - 4);
+
+    scrutiny_handler.receive_data(request_data, sizeof(request_data));
+    scrutiny_handler.process(0);
+    uint16_t n_to_read = scrutiny_handler.data_to_send();
+    ASSERT_LT(n_to_read, sizeof(tx_buffer));
+    EXPECT_EQ(n_to_read, sizeof(expected_response));
+    uint16_t nread = scrutiny_handler.pop_data(tx_buffer, n_to_read);
+    EXPECT_EQ(nread, n_to_read);
+    ASSERT_BUF_EQ(tx_buffer, expected_response, sizeof(expected_response));
+
+    // Same description, same hash. Even from another instance
+    scrutiny::MainHandler other_handler;
+    other_handler.init(&config);
+    EXPECT_EQ(other_handler.get_config_fingerprint(), fingerprint);
+
+    // Any change to what the server discovers changes the hash
+    rpvs[1].type = scrutiny::VariableType::sint32;
+    scrutiny_handler.init(&config);
+    EXPECT_NE(scrutiny_handler.get_config_fingerprint(), fingerprint);
+    rpvs[1].type = scrutiny::VariableType::float32;
+    scrutiny_handler.init(&config);
+    EXPECT_EQ(scrutiny_handler.get_config_fingerprint(), fingerprint);
+
+    config.set_loops(loops, 2);
+    scrutiny_handler.init(&config);
+    EXPECT_NE(scrutiny_handler.get_config_fingerprint(), fingerprint);
+    config.set_loops(loops, sizeof(loops) / sizeof(loops[0]));
+
+    scrutiny::AddressRange readonly_ranges[] = {scrutiny::tools::make_address_range(0x1000, 0x1FFF)};
+    config.set_readonly_address_range(readonly_ranges, 1);
+    scrutiny_handler.init(&config);
+    EXPECT_NE(scrutiny_handler.get_config_fingerprint(), fingerprint);
+}
+
+/*
+    Reads the whole device description in as few responses as the transmit buffer allows
+*/
+
+TEST_F(TestGetInfo, TestGetDeviceDescription)
+{
+    uint8_t tx_buffer[256];
+    uint8_t request_data[8 + 4] = {1, 11, 0, 4};
+    uint8_t const u16 = static_cast<uint8_t>(scrutiny::VariableType::uint16);
+    scrutiny::RuntimePublishedValue rpvs[30];
+    for (uint16_t i = 0; i < 30; i++)
+    {
+        rpvs[i].id = static_cast<uint16_t>(0x1000 + i);
+        rpvs[i].type = scrutiny::VariableType::uint16;
+    }
+
+    config.set_published_values(rpvs, 30, rpv_read_callback, rpv_write_callback);
+    scrutiny_handler.init(&config);
+    scrutiny_handler.comm()->connect();
+
+    // First response. Version, software id, features, fingerprint, region count, RPV count, then the 27 RPVs that fit in the 128 bytes
+    scrutiny::codecs::encode_32_bits_big_endian(static_cast<uint32_t>(0), &request_data[4]);
+    add_crc(request_data, sizeof(request_data) - 4);
+    scrutiny_handler.receive_data(request_data, sizeof(request_data));
+    scrutiny_handler.process(0);
+    uint16_t n_to_read = scrutiny_handler.data_to_send();
+    ASSERT_EQ(n_to_read, 9 + 127);
+    scrutiny_handler.pop_data(tx_buffer, n_to_read);
+    ASSERT_TRUE(IS_PROTOCOL_RESPONSE(tx_buffer, scrutiny::protocol::CommandId::GetInfo, 11, scrutiny::protocol::ResponseCode::OK));
+
+    uint8_t *data = &tx_buffer[5];
+    uint8_t const header1[] = {0, 0, 0, 0, 33};                             // Not finished, next cursor = 33
+    uint8_t const version_record[] = {1, 2, 1, 0};                          // Version 1.0
+    uint8_t const region_count_record[] = {4, 2, 0, 0};                     // No region
+    uint8_t const rpv_count_record[] = {6, 2, 0, 30};                       // 30 RPVs
+    uint8_t const rpv_record1[] = {7, 27 * 3, 0x10, 0x00, u16, 0x10, 0x01}; // One record for all the RPVs
+    EXPECT_BUF_EQ(&data[0], header1, sizeof(header1));
+    EXPECT_BUF_EQ(&data[5], version_record, sizeof(version_record));
+    EXPECT_EQ(data[9], 2);
+    EXPECT_EQ(data[10], SCRUTINY_SOFTWARE_ID_LENGTH);
+    EXPECT_BUF_EQ(&data[11], scrutiny::software_id, SCRUTINY_SOFTWARE_ID_LENGTH);
+    EXPECT_EQ(data[27], 3);
+    EXPECT_EQ(data[28], 1);
+    EXPECT_EQ(data[30], 10);
+    EXPECT_EQ(data[31], 4);
+    EXPECT_EQ(scrutiny::codecs::decode_32_bits_big_endian(&data[32]), scrutiny_handler.get_config_fingerprint());
+    EXPECT_BUF_EQ(&data[36], region_count_record, sizeof(region_count_record));
+    EXPECT_BUF_EQ(&data[40], rpv_count_record, sizeof(rpv_count_record));
+    EXPECT_BUF_EQ(&data[44], rpv_record1, sizeof(rpv_record1));
+    EXPECT_EQ(scrutiny::codecs::decode_16_bits_big_endian(&data[46 + 26 * 3]), 0x101A);
+
+    // Second response. Last 3 RPVs, loop count and the 3 loops
+    scrutiny::codecs::encode_32_bits_big_endian(static_cast<uint32_t>(33), &request_data[4]);
+    add_crc(request_data, sizeof(request_data) - 4);
+    scrutiny_handler.receive_data(request_data, sizeof(request_data));
+    scrutiny_handler.process(0);
+    n_to_read = scrutiny_handler.data_to_send();
+    ASSERT_EQ(n_to_read, 9 + 60);
+    scrutiny_handler.pop_data(tx_buffer, n_to_read);
+    ASSERT_TRUE(IS_PROTOCOL_RESPONSE(tx_buffer, scrutiny::protocol::CommandId::GetInfo, 11, scrutiny::protocol::ResponseCode::OK));
+
+#if SCRUTINY_ENABLE_DATALOGGING
+    uint8_t const dl_attribute = 0x80;
+#else
+    uint8_t const dl_attribute = 0x00;
+#endif
+    uint8_t const expected_data2[60] = {
+        1, 0, 0, 0, 40,                                                                // Finished, next cursor = end
+        7, 9, 0x10, 0x1B, u16, 0x10, 0x1C, u16, 0x10, 0x1D, u16,                       // RPVs
+        8, 1, 3,                                                                       // Loop count
+        9, 13, 0, 0, dl_attribute, 0x12, 0x34, 0x56, 0x78, 5, 'L', 'o', 'o', 'p', '1', // Loop1
+        9, 9, 1, 1, dl_attribute, 5, 'L', 'o', 'o', 'p', '2',                          // Loop2
+        9, 13, 2, 0, 0, 0x00, 0x00, 0x00, 100, 5, 'L', 'o', 'o', 'p', '3'};            // Loop3
+    EXPECT_BUF_EQ(&tx_buffer[5], expected_data2, sizeof(expected_data2));
+
+    // Cursor past the end
+    scrutiny::codecs::encode_32_bits_big_endian(static_cast<uint32_t>(40), &request_data[4]);
+    add_crc(request_data, sizeof(request_data) - 4);
+    scrutiny_handler.receive_data(request_data, sizeof(request_data));
+    scrutiny_handler.process(0);
+    n_to_read = scrutiny_handler.data_to_send();
+    ASSERT_GT(n_to_read, 0);
+    scrutiny_handler.pop_data(tx_buffer, n_to_read);
+    EXPECT_TRUE(IS_PROTOCOL_RESPONSE(tx_buffer, scrutiny::protocol::CommandId::GetInfo, 11, scrutiny::protocol::ResponseCode::FailureToProceed));
+
+    // Cursor missing
+    uint8_t bad_request[8] = {1, 11, 0, 0};
+    add_crc(bad_request, sizeof(bad_request) - 4);
+    scrutiny_handler.receive_data(bad_request, sizeof(bad_request));
+    scrutiny_handler.process(0);
+    n_to_read = scrutiny_handler.data_to_send();
+    ASSERT_GT(n_to_read, 0);
+    scrutiny_handler.pop_data(tx_buffer, n_to_read);
+    EXPECT_TRUE(IS_PROTOCOL_RESPONSE(tx_buffer, scrutiny::protocol::CommandId::GetInfo, 11, scrutiny::protocol::ResponseCode::InvalidRequest));
+}
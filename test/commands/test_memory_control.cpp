@@ -350,6 +350,69 @@ TEST_F(TestMemoryControl, TestReadReadonlyAddress)
     }
 }
 
+/*
+    With response streaming, a read much bigger than the transmission buffer is served by copying the memory
+    while the response is transmitted. Forbidden regions are still checked before anything goes out.
+*/
+TEST_F(TestMemoryControl, TestReadStreamedBeyondTxBuffer)
+{
+    uint8_t small_tx_buffer[32];
+    uint8_t data_buf[300];
+    fill_buffer_incremental(data_buf, sizeof(data_buf));
+    config.set_buffers(_rx_buffer, sizeof(_rx_buffer), small_tx_buffer, sizeof(small_tx_buffer));
+    config.response_streaming = true;
+    scrutiny_handler.init(&config);
+    scrutiny_handler.comm()->connect();
+
+    // Building request
+    constexpr uint32_t addr_size = sizeof(std::uintptr_t);
+    constexpr uint16_t data_size = sizeof(data_buf);
+    uint8_t request_data[8 + addr_size + 2] = {3, 1, 0, addr_size + 2};
+    unsigned int index = 4;
+    index += encode_addr(&request_data[index], data_buf);
+    request_data[index++] = (data_size >> 8) & 0xFF;
+    request_data[index++] = (data_size >> 0) & 0xFF;
+    add_crc(request_data, sizeof(request_data) - 4);
+
+    // Building expected response
+    constexpr uint16_t datalen = addr_size + 2 + data_size;
+    uint8_t expected_response[9 + datalen] = {0x83, 1, 0, datalen >> 8, datalen & 0xFF};
+    index = 5;
+    index += encode_addr(&expected_response[index], data_buf);
+    expected_response[index++] = (data_size >> 8) & 0xFF;
+    expected_response[index++] = (data_size >> 0) & 0xFF;
+    std::memcpy(&expected_response[index], data_buf, data_size);
+    add_crc(expected_response, sizeof(expected_response) - 4);
+
+    // Process
+    scrutiny_handler.receive_data(request_data, sizeof(request_data));
+    scrutiny_handler.process(0);
+
+    uint8_t tx_buffer[sizeof(expected_response)];
+    EXPECT_EQ(scrutiny_handler.data_to_send(), sizeof(expected_response));
+    uint16_t nread = 0;
+    while (scrutiny_handler.data_to_send() > 0)
+    {
+        nread += scrutiny_handler.pop_data(&tx_buffer[nread], 13);
+    }
+    ASSERT_EQ(nread, sizeof(expected_response));
+    ASSERT_BUF_EQ(tx_buffer, expected_response, sizeof(expected_response));
+    scrutiny_handler.process(0);
+
+    // Forbidden region at the end of the read
+    uintptr_t const forbidden_start = reinterpret_cast<uintptr_t>(data_buf) + sizeof(data_buf) - 4;
+    scrutiny::AddressRange forbidden_ranges[] = {
+        scrutiny::tools::make_address_range(forbidden_start, forbidden_start + 8)};
+    config.set_forbidden_address_range(forbidden_ranges, 1);
+    scrutiny_handler.init(&config);
+    scrutiny_handler.comm()->connect();
+    scrutiny_handler.receive_data(request_data, sizeof(request_data));
+    scrutiny_handler.process(0);
+    ASSERT_EQ(scrutiny_handler.data_to_send(), 9u);
+    scrutiny_handler.pop_data(tx_buffer, 9u);
+    EXPECT_TRUE(IS_PROTOCOL_RESPONSE(tx_buffer, scrutiny::protocol::CommandId::MemoryControl, 1, scrutiny::protocol::ResponseCode::Forbidden));
+}
+
 // ================================= Write =================================
 
 /*
@@ -806,3 +869,245 @@ TEST_F(TestMemoryControl, TestWriteMemoryInvalidRequest)
         scrutiny_handler.process(0);
     }
 }
+
+/*
+    Write a request much bigger than the reception buffer. The payload is staged as it is received and
+    applied only once the CRC is validated.
+*/
+TEST_F(TestMemoryControl, TestWriteStreamedBeyondRxBuffer)
+{
+    uint8_t small_rx_buffer[64];
+    uint8_t staging_buffer[4096];
+    config.set_buffers(small_rx_buffer, sizeof(small_rx_buffer), _tx_buffer, sizeof(_tx_buffer));
+    config.set_staged_write_buffer(staging_buffer, sizeof(staging_buffer));
+    scrutiny_handler.init(&config);
+    scrutiny_handler.comm()->connect();
+
+    uint8_t buf1[1000] = {0};
+    uint8_t buf2[1000] = {0};
+    uint8_t data1[sizeof(buf1)];
+    uint8_t data2[sizeof(buf2)];
+    fill_buffer_incremental(data1, sizeof(data1));
+    fill_buffer_incremental(data2, sizeof(data2));
+    data2[0] = 0xAA;
+
+    // Building request
+    constexpr uint32_t addr_size = sizeof(std::uintptr_t);
+    constexpr uint16_t datalen = 2 * (addr_size + 2) + sizeof(buf1) + sizeof(buf2);
+    uint8_t request_data[8 + datalen] = {3, 2, datalen >> 8, datalen & 0xFF};
+    unsigned int index = 4;
+    index += encode_addr(&request_data[index], buf1);
+    request_data[index++] = (sizeof(buf1) >> 8) & 0xFF;
+    request_data[index++] = (sizeof(buf1) >> 0) & 0xFF;
+    std::memcpy(&request_data[index], data1, sizeof(data1));
+    index += sizeof(data1);
+    index += encode_addr(&request_data[index], buf2);
+    request_data[index++] = (sizeof(buf2) >> 8) & 0xFF;
+    request_data[index++] = (sizeof(buf2) >> 0) & 0xFF;
+    std::memcpy(&request_data[index], data2, sizeof(data2));
+    add_crc(request_data, sizeof(request_data) - 4);
+
+    // Building expected response
+    constexpr uint16_t response_datalen = 2 * (addr_size + 2);
+    uint8_t expected_response[9 + response_datalen] = {0x83, 2, 0, 0, response_datalen};
+    index = 5;
+    index += encode_addr(&expected_response[index], buf1);
+    expected_response[index++] = (sizeof(buf1) >> 8) & 0xFF;
+    expected_response[index++] = (sizeof(buf1) >> 0) & 0xFF;
+    index += encode_addr(&expected_response[index], buf2);
+    expected_response[index++] = (sizeof(buf2) >> 8) & 0xFF;
+    expected_response[index++] = (sizeof(buf2) >> 0) & 0xFF;
+    add_crc(expected_response, sizeof(expected_response) - 4);
+
+    // Corrupted request. Nothing must be written
+    uint8_t tx_buffer[sizeof(expected_response)];
+    request_data[sizeof(request_data) - 1] ^= 0xFF;
+    for (uint16_t i = 0; i < sizeof(request_data); i += 64)
+    {
+        uint16_t const remaining = static_cast<uint16_t>(sizeof(request_data) - i);
+        scrutiny_handler.receive_data(&request_data[i], (remaining < 64) ? remaining : 64);
+        scrutiny_handler.process(0);
+    }
+    EXPECT_EQ(scrutiny_handler.data_to_send(), 0u);
+    EXPECT_BUF_SET(buf1, 0, sizeof(buf1));
+    EXPECT_BUF_SET(buf2, 0, sizeof(buf2));
+    request_data[sizeof(request_data) - 1] ^= 0xFF;
+
+    // Valid request
+    for (uint16_t i = 0; i < sizeof(request_data); i += 64)
+    {
+        uint16_t const remaining = static_cast<uint16_t>(sizeof(request_data) - i);
+        scrutiny_handler.receive_data(&request_data[i], (remaining < 64) ? remaining : 64);
+        scrutiny_handler.process(0);
+    }
+    ASSERT_EQ(scrutiny_handler.data_to_send(), sizeof(expected_response));
+    scrutiny_handler.pop_data(tx_buffer, sizeof(tx_buffer));
+    EXPECT_BUF_EQ(tx_buffer, expected_response, sizeof(expected_response));
+    EXPECT_BUF_EQ(buf1, data1, sizeof(buf1));
+    EXPECT_BUF_EQ(buf2, data2, sizeof(buf2));
+    scrutiny_handler.process(0);
+
+    // Read-only second block. Refused as a whole
+    std::memset(buf1, 0, sizeof(buf1));
+    uintptr_t const readonly_start = reinterpret_cast<uintptr_t>(buf2) + 10;
+    scrutiny::AddressRange readonly_ranges[] = {
+        scrutiny::tools::make_address_range(readonly_start, readonly_start + sizeof(buf2))};
+    config.set_readonly_address_range(readonly_ranges, 1);
+    scrutiny_handler.init(&config);
+    scrutiny_handler.comm()->connect();
+    scrutiny_handler.receive_data(request_data, sizeof(request_data));
+    scrutiny_handler.process(0);
+    ASSERT_EQ(scrutiny_handler.data_to_send(), 9u);
+    scrutiny_handler.pop_data(tx_buffer, 9u);
+    EXPECT_TRUE(IS_PROTOCOL_RESPONSE(tx_buffer, scrutiny::protocol::CommandId::MemoryControl, 2, scrutiny::protocol::ResponseCode::Forbidden));
+    EXPECT_BUF_SET(buf1, 0, sizeof(buf1));
+    scrutiny_handler.process(0);
+
+    // Too big for the staging buffer
+    config.set_staged_write_buffer(staging_buffer, datalen - 1);
+    scrutiny_handler.init(&config);
+    scrutiny_handler.comm()->connect();
+    scrutiny_handler.receive_data(request_data, sizeof(request_data));
+    scrutiny_handler.process(0);
+    EXPECT_EQ(scrutiny_handler.data_to_send(), 0u);
+    EXPECT_BUF_SET(buf1, 0, sizeof(buf1));
+}
+
+/*
+    Write 2 memory blocks with a budget smaller than the data. The writes are spread over several calls to process()
+*/
+TEST_F(TestMemoryControl, TestWriteWithBudget)
+{
+    uint8_t buf1[40] = {0};
+    uint8_t buf2[40] = {0};
+    uint8_t data1[sizeof(buf1)];
+    uint8_t data2[sizeof(buf2)];
+    fill_buffer_incremental(data1, sizeof(data1));
+    fill_buffer_incremental(data2, sizeof(data2));
+    data2[0] = 0xAA;
+
+    // Building request
+    constexpr uint32_t addr_size = sizeof(std::uintptr_t);
+    constexpr uint16_t datalen = 2 * (addr_size + 2) + sizeof(buf1) + sizeof(buf2);
+    uint8_t request_data[8 + datalen] = {3, 2, 0, datalen};
+    unsigned int index = 4;
+    index += encode_addr(&request_data[index], buf1);
+    request_data[index++] = 0;
+    request_data[index++] = sizeof(buf1);
+    std::memcpy(&request_data[index], data1, sizeof(data1));
+    index += sizeof(data1);
+    index += encode_addr(&request_data[index], buf2);
+    request_data[index++] = 0;
+    request_data[index++] = sizeof(buf2);
+    std::memcpy(&request_data[index], data2, sizeof(data2));
+    add_crc(request_data, sizeof(request_data) - 4);
+
+    // Building expected response
+    constexpr uint16_t response_datalen = 2 * (addr_size + 2);
+    uint8_t expected_response[9 + response_datalen] = {0x83, 2, 0, 0, response_datalen};
+    index = 5;
+    index += encode_addr(&expected_response[index], buf1);
+    expected_response[index++] = 0;
+    expected_response[index++] = sizeof(buf1);
+    index += encode_addr(&expected_response[index], buf2);
+    expected_response[index++] = 0;
+    expected_response[index++] = sizeof(buf2);
+    add_crc(expected_response, sizeof(expected_response) - 4);
+
+    // First slice
+    scrutiny_handler.receive_data(request_data, sizeof(request_data));
+    scrutiny_handler.process(0, 15);
+    EXPECT_EQ(scrutiny_handler.data_to_send(), 0u);
+    EXPECT_BUF_EQ(buf1, data1, 15);
+    EXPECT_BUF_SET(&buf1[15], 0, sizeof(buf1) - 15);
+    EXPECT_BUF_SET(buf2, 0, sizeof(buf2));
+
+    // 80 bytes to write. 6 slices of 15 bytes
+    uint32_t call_count = 1;
+    while (scrutiny_handler.data_to_send() == 0 && call_count < 100)
+    {
+        scrutiny_handler.process(0, 15);
+        call_count++;
+    }
+    EXPECT_EQ(call_count, 6u);
+
+    uint8_t tx_buffer[sizeof(expected_response)];
+    ASSERT_EQ(scrutiny_handler.data_to_send(), sizeof(expected_response));
+    scrutiny_handler.pop_data(tx_buffer, sizeof(tx_buffer));
+    EXPECT_BUF_EQ(tx_buffer, expected_response, sizeof(expected_response));
+    EXPECT_BUF_EQ(buf1, data1, sizeof(buf1));
+    EXPECT_BUF_EQ(buf2, data2, sizeof(buf2));
+}
+
+/*
+    Write with a budget and a non-zero time step. The write is refused if the slices cannot complete within the time given to a request,
+    and is never failed once started since it cannot be undone.
+*/
+TEST_F(TestMemoryControl, TestWriteWithBudgetTimeStep)
+{
+    const scrutiny::protocol::CommandId cmd = scrutiny::protocol::CommandId::MemoryControl;
+    uint8_t const subfn = static_cast<uint8_t>(scrutiny::protocol::MemoryControl::Subfunction::Write);
+    constexpr scrutiny::timediff_t request_timeout = SCRUTINY_REQUEST_MAX_PROCESS_TIME_US * 10;
+    uint8_t buf[80] = {0};
+    uint8_t data[sizeof(buf)];
+    fill_buffer_incremental(data, sizeof(data));
+
+    constexpr uint32_t addr_size = sizeof(std::uintptr_t);
+    constexpr uint16_t datalen = addr_size + 2 + sizeof(buf);
+    uint8_t request_data[8 + datalen] = {3, 2, 0, datalen};
+    unsigned int index = 4;
+    index += encode_addr(&request_data[index], buf);
+    request_data[index++] = 0;
+    request_data[index++] = sizeof(buf);
+    std::memcpy(&request_data[index], data, sizeof(data));
+    add_crc(request_data, sizeof(request_data) - 4);
+
+    uint8_t tx_buffer[32];
+    uint16_t n_to_read;
+
+    // 5 slices of 16 bytes. The last one would come a full request timeout after the first
+    scrutiny_handler.receive_data(request_data, sizeof(request_data));
+    scrutiny_handler.process(request_timeout / 4, 16);
+    n_to_read = scrutiny_handler.data_to_send();
+    ASSERT_GT(n_to_read, 0u);
+    ASSERT_LE(n_to_read, sizeof(tx_buffer));
+    scrutiny_handler.pop_data(tx_buffer, n_to_read);
+    EXPECT_TRUE(IS_PROTOCOL_RESPONSE(tx_buffer, cmd, subfn, scrutiny::protocol::ResponseCode::FailureToProceed));
+    EXPECT_BUF_SET(buf, 0, sizeof(buf));
+    scrutiny_handler.process(0);
+
+    // Fits in time. Started, it completes even when the time step grows past the request timeout
+    scrutiny_handler.receive_data(request_data, sizeof(request_data));
+    scrutiny_handler.process(request_timeout / 5, 16);
+    EXPECT_EQ(scrutiny_handler.data_to_send(), 0u);
+    EXPECT_BUF_EQ(buf, data, 16);
+    uint32_t call_count = 1;
+    while (scrutiny_handler.data_to_send() == 0 && call_count < 100)
+    {
+        scrutiny_handler.process(request_timeout / 2, 16);
+        call_count++;
+    }
+    EXPECT_EQ(call_count, 5u);
+    n_to_read = scrutiny_handler.data_to_send();
+    ASSERT_GT(n_to_read, 0u);
+    ASSERT_LE(n_to_read, sizeof(tx_buffer));
+    scrutiny_handler.pop_data(tx_buffer, n_to_read);
+    EXPECT_TRUE(IS_PROTOCOL_RESPONSE(tx_buffer, cmd, subfn, scrutiny::protocol::ResponseCode::OK));
+    EXPECT_BUF_EQ(buf, data, sizeof(buf));
+    scrutiny_handler.process(0);
+
+    // Session lost in the middle of a write. The same request in a new session starts over
+    std::memset(buf, 0, sizeof(buf));
+    scrutiny_handler.receive_data(request_data, sizeof(request_data));
+    scrutiny_handler.process(0, 16);
+    scrutiny_handler.process(0, 16);
+    EXPECT_BUF_EQ(buf, data, 32);
+    scrutiny_handler.comm()->reset();
+    scrutiny_handler.process(0, 16);
+    std::memset(buf, 0, sizeof(buf));
+    scrutiny_handler.comm()->connect();
+    scrutiny_handler.receive_data(request_data, sizeof(request_data));
+    scrutiny_handler.process(0, 16);
+    EXPECT_BUF_EQ(buf, data, 16);
+    EXPECT_BUF_SET(&buf[16], 0, sizeof(buf) - 16);
+}
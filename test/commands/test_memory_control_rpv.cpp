@@ -491,6 +491,49 @@ TEST_F(TestMemoryControlRPV, TestReadRPVResponseOverflow)
     scrutiny_handler.process(0);
 }
 
+/*
+    With response streaming, a ReadRPV response bigger than the transmission buffer is produced while it is transmitted.
+*/
+TEST_F(TestMemoryControlRPV, TestReadRPVStreamed)
+{
+    scrutiny::RuntimePublishedValue rpvs[3] = {
+        {0x1122, scrutiny::VariableType::uint32},
+        {0x3344, scrutiny::VariableType::float32},
+        {0x5566, scrutiny::VariableType::uint16}};
+
+    config.set_published_values(rpvs, sizeof(rpvs) / sizeof(rpvs[0]), rpv_read_callback);
+    config.response_streaming = true;
+    scrutiny_handler.init(&config);
+    scrutiny_handler.comm()->connect();
+
+    constexpr uint16_t nbrpv = 40; // 40 x 6 bytes. Does not fit in the transmission buffer
+    uint8_t request_data[8 + nbrpv * 2] = {3, 4, 0, nbrpv * 2};
+    constexpr uint16_t datalen = nbrpv * 6;
+    uint8_t expected_response[9 + datalen] = {0x83, 4, 0, datalen >> 8, datalen & 0xFF};
+    for (uint16_t i = 0; i < nbrpv; i++)
+    {
+        request_data[4 + 2 * i] = 0x11;
+        request_data[4 + 2 * i + 1] = 0x22;
+        uint8_t const entry[6] = {0x11, 0x22, 0x12, 0x34, 0x56, 0x78};
+        std::memcpy(&expected_response[5 + 6 * i], entry, sizeof(entry));
+    }
+    add_crc(request_data, sizeof(request_data) - 4);
+    add_crc(expected_response, sizeof(expected_response) - 4);
+
+    scrutiny_handler.receive_data(request_data, sizeof(request_data));
+    scrutiny_handler.process(0);
+
+    uint8_t tx_buffer[sizeof(expected_response)];
+    ASSERT_EQ(scrutiny_handler.data_to_send(), sizeof(expected_response));
+    uint16_t nread = 0;
+    while (scrutiny_handler.data_to_send() > 0)
+    {
+        nread += scrutiny_handler.pop_data(&tx_buffer[nread], 5);
+    }
+    ASSERT_EQ(nread, sizeof(expected_response));
+    EXPECT_BUF_EQ(tx_buffer, expected_response, sizeof(expected_response));
+}
+
 //=================================================
 //==================  WRITE  ======================
 //=================================================
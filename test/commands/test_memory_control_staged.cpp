@@ -0,0 +1,290 @@
+//    test_memory_control_staged.cpp
+//        Test the staged write transaction of the memory control command. Writes applied by a loop
+//
+//   - License : MIT - See LICENSE file.
+//   - Project : Scrutiny Debugger (github.com/scrutinydebugger/scrutiny-embedded)
+//
+//   Copyright (c) 2021 Scrutiny Debugger
+
+#include <gtest/gtest.h>
+#include "scrutiny.hpp"
+#include "scrutiny_test.hpp"
+#include <cstring>
+#include <vector>
+
+static uint32_t g_rpv_1000_value = 0;
+static bool g_rpv_write_success = true;
+
+static bool rpv_read_callback(scrutiny::RuntimePublishedValue rpv, scrutiny::AnyType *outval)
+{
+    if (rpv.id == 0x1000)
+    {
+        outval->uint32 = g_rpv_1000_value;
+        return true;
+    }
+    return false;
+}
+
+static bool rpv_write_callback(scrutiny::RuntimePublishedValue rpv, scrutiny::AnyType const *inval)
+{
+    if (rpv.id == 0x1000)
+    {
+        g_rpv_1000_value = inval->uint32;
+        return g_rpv_write_success;
+    }
+    return false;
+}
+
+class TestMemoryControlStaged : public ScrutinyTest
+{
+protected:
+    scrutiny::MainHandler scrutiny_handler;
+    scrutiny::Config config;
+    scrutiny::FixedFrequencyLoopHandler loop;
+    scrutiny::LoopHandler *loops[1];
+
+    scrutiny::RuntimePublishedValue rpvs[1] = {
+        {0x1000, scrutiny::VariableType::uint32}};
+
+    uint8_t _rx_buffer[128];
+    uint8_t _tx_buffer[128];
+    uint8_t _staging_buffer[64];
+
+    TestMemoryControlStaged() : ScrutinyTest(),
+                                scrutiny_handler{},
+                                config{},
+                                loop(1000, "loop"),
+                                loops{&loop},
+                                _rx_buffer{0},
+                                _tx_buffer{0},
+                                _staging_buffer{0}
+    {
+    }
+
+    virtual void SetUp()
+    {
+        g_rpv_1000_value = 0;
+        g_rpv_write_success = true;
+        config.set_buffers(_rx_buffer, sizeof(_rx_buffer), _tx_buffer, sizeof(_tx_buffer));
+        config.set_loops(loops, sizeof(loops) / sizeof(loops[0]));
+        config.set_published_values(rpvs, sizeof(rpvs) / sizeof(rpvs[0]), rpv_read_callback, rpv_write_callback);
+        config.set_staged_write_buffer(_staging_buffer, sizeof(_staging_buffer));
+        scrutiny_handler.init(&config);
+        scrutiny_handler.comm()->connect();
+    }
+
+    void send_request(std::vector<uint8_t> const &payload)
+    {
+        std::vector<uint8_t> request = {3, 6, static_cast<uint8_t>(payload.size() >> 8), static_cast<uint8_t>(payload.size())};
+        request.insert(request.end(), payload.begin(), payload.end());
+        request.resize(request.size() + 4);
+        add_crc(request.data(), static_cast<uint16_t>(request.size() - 4));
+        scrutiny_handler.receive_data(request.data(), static_cast<uint16_t>(request.size()));
+    }
+
+    void add_memory_entry(std::vector<uint8_t> *payload, void *addr, std::vector<uint8_t> const &data, std::vector<uint8_t> const &mask = {})
+    {
+        uint8_t addr_buf[sizeof(void *)];
+        payload->push_back(mask.size() == 0 ? 0 : 1);
+        encode_addr(addr_buf, addr);
+        payload->insert(payload->end(), addr_buf, addr_buf + sizeof(addr_buf));
+        payload->push_back(static_cast<uint8_t>(data.size() >> 8));
+        payload->push_back(static_cast<uint8_t>(data.size()));
+        payload->insert(payload->end(), data.begin(), data.end());
+        payload->insert(payload->end(), mask.begin(), mask.end());
+    }
+};
+
+TEST_F(TestMemoryControlStaged, TestWritesAppliedByLoop)
+{
+    uint8_t buf1[4] = {0};
+    uint8_t buf2[2] = {0xF0, 0x0F};
+    std::vector<uint8_t> payload = {0}; // Loop ID
+    add_memory_entry(&payload, buf1, {1, 2, 3, 4});
+    add_memory_entry(&payload, buf2, {0xFF, 0xFF}, {0x0F, 0xF0});
+    payload.insert(payload.end(), {2, 0x10, 0x00, 0x12, 0x34, 0x56, 0x78}); // RPV 0x1000
+
+    uint8_t tx_buffer[32];
+    uint8_t expected_response[9 + 3] = {0x83, 6, 0, 0, 3, 0, 0, 3};
+    add_crc(expected_response, sizeof(expected_response) - 4);
+
+    send_request(payload);
+    for (unsigned int i = 0; i < 5; i++)
+    {
+        scrutiny_handler.process(0);
+        EXPECT_EQ(scrutiny_handler.data_to_send(), 0u); // Waiting for the loop
+    }
+
+    // Nothing written until the loop runs
+    uint8_t const zeros[4] = {0};
+    EXPECT_BUF_EQ(buf1, zeros, sizeof(buf1));
+    EXPECT_EQ(g_rpv_1000_value, 0u);
+
+    loop.process();
+    uint8_t const expected_buf1[4] = {1, 2, 3, 4};
+    uint8_t const expected_buf2[2] = {0xFF, 0xFF};
+    EXPECT_BUF_EQ(buf1, expected_buf1, sizeof(buf1));
+    EXPECT_BUF_EQ(buf2, expected_buf2, sizeof(buf2));
+    EXPECT_EQ(g_rpv_1000_value, 0x12345678u);
+
+    scrutiny_handler.process(0);
+    uint16_t n_to_read = scrutiny_handler.data_to_send();
+    ASSERT_EQ(n_to_read, sizeof(expected_response));
+    scrutiny_handler.pop_data(tx_buffer, n_to_read);
+    EXPECT_BUF_EQ(tx_buffer, expected_response, sizeof(expected_response));
+}
+
+TEST_F(TestMemoryControlStaged, TestInvalidRequestNotStaged)
+{
+    uint8_t buf1[4] = {0};
+    uint8_t tx_buffer[32];
+
+    // Bad loop ID
+    std::vector<uint8_t> payload = {1};
+    add_memory_entry(&payload, buf1, {1, 2, 3, 4});
+    send_request(payload);
+    scrutiny_handler.process(0);
+    ASSERT_GT(scrutiny_handler.data_to_send(), 0u);
+    scrutiny_handler.pop_data(tx_buffer, scrutiny_handler.data_to_send());
+    EXPECT_TRUE(IS_PROTOCOL_RESPONSE(tx_buffer, scrutiny::protocol::CommandId::MemoryControl, 6, scrutiny::protocol::ResponseCode::InvalidRequest));
+
+    // Unknown RPV after a valid memory entry. Nothing must be written
+    payload = {0};
+    add_memory_entry(&payload, buf1, {1, 2, 3, 4});
+    payload.insert(payload.end(), {2, 0x20, 0x00, 0x12, 0x34, 0x56, 0x78});
+    send_request(payload);
+    scrutiny_handler.process(0);
+    ASSERT_GT(scrutiny_handler.data_to_send(), 0u);
+    scrutiny_handler.pop_data(tx_buffer, scrutiny_handler.data_to_send());
+    EXPECT_TRUE(IS_PROTOCOL_RESPONSE(tx_buffer, scrutiny::protocol::CommandId::MemoryControl, 6, scrutiny::protocol::ResponseCode::InvalidRequest));
+
+    // Unknown entry type
+    payload = {0, 0x55};
+    send_request(payload);
+    scrutiny_handler.process(0);
+    ASSERT_GT(scrutiny_handler.data_to_send(), 0u);
+    scrutiny_handler.pop_data(tx_buffer, scrutiny_handler.data_to_send());
+    EXPECT_TRUE(IS_PROTOCOL_RESPONSE(tx_buffer, scrutiny::protocol::CommandId::MemoryControl, 6, scrutiny::protocol::ResponseCode::InvalidRequest));
+
+    // Bigger than the staging buffer
+    payload = {0};
+    add_memory_entry(&payload, buf1, std::vector<uint8_t>(sizeof(_staging_buffer), 0xAA));
+    send_request(payload);
+    scrutiny_handler.process(0);
+    ASSERT_GT(scrutiny_handler.data_to_send(), 0u);
+    scrutiny_handler.pop_data(tx_buffer, scrutiny_handler.data_to_send());
+    EXPECT_TRUE(IS_PROTOCOL_RESPONSE(tx_buffer, scrutiny::protocol::CommandId::MemoryControl, 6, scrutiny::protocol::ResponseCode::Overflow));
+
+    loop.process();
+    uint8_t const zeros[4] = {0};
+    EXPECT_BUF_EQ(buf1, zeros, sizeof(buf1));
+}
+
+TEST_F(TestMemoryControlStaged, TestForbiddenRegion)
+{
+    uint8_t buf1[4] = {0};
+    uint8_t tx_buffer[32];
+    scrutiny::AddressRange forbidden_range[] = {scrutiny::tools::make_address_range(&buf1[2], 8)};
+    config.set_forbidden_address_range(forbidden_range, 1);
+    scrutiny_handler.init(&config);
+    scrutiny_handler.comm()->connect();
+
+    std::vector<uint8_t> payload = {0};
+    add_memory_entry(&payload, buf1, {1, 2, 3, 4});
+    send_request(payload);
+    scrutiny_handler.process(0);
+    ASSERT_GT(scrutiny_handler.data_to_send(), 0u);
+    scrutiny_handler.pop_data(tx_buffer, scrutiny_handler.data_to_send());
+    EXPECT_TRUE(IS_PROTOCOL_RESPONSE(tx_buffer, scrutiny::protocol::CommandId::MemoryControl, 6, scrutiny::protocol::ResponseCode::Forbidden));
+}
+
+TEST_F(TestMemoryControlStaged, TestUnsupportedWithoutBuffer)
+{
+    uint8_t tx_buffer[32];
+    config.set_staged_write_buffer(nullptr, 0);
+    scrutiny_handler.init(&config);
+    scrutiny_handler.comm()->connect();
+
+    send_request({0});
+    scrutiny_handler.process(0);
+    ASSERT_GT(scrutiny_handler.data_to_send(), 0u);
+    scrutiny_handler.pop_data(tx_buffer, scrutiny_handler.data_to_send());
+    EXPECT_TRUE(IS_PROTOCOL_RESPONSE(tx_buffer, scrutiny::protocol::CommandId::MemoryControl, 6, scrutiny::protocol::ResponseCode::UnsupportedFeature));
+}
+
+TEST_F(TestMemoryControlStaged, TestRPVWriteFailure)
+{
+    uint8_t tx_buffer[32];
+    g_rpv_write_success = false;
+    send_request({0, 2, 0x10, 0x00, 0x12, 0x34, 0x56, 0x78});
+    scrutiny_handler.process(0);
+    loop.process();
+    scrutiny_handler.process(0);
+    ASSERT_GT(scrutiny_handler.data_to_send(), 0u);
+    scrutiny_handler.pop_data(tx_buffer, scrutiny_handler.data_to_send());
+    EXPECT_TRUE(IS_PROTOCOL_RESPONSE(tx_buffer, scrutiny::protocol::CommandId::MemoryControl, 6, scrutiny::protocol::ResponseCode::FailureToProceed));
+}
+
+TEST_F(TestMemoryControlStaged, TestTimeoutCancelsTransaction)
+{
+    uint8_t buf1[2] = {0};
+    uint8_t tx_buffer[32];
+    std::vector<uint8_t> payload = {0};
+    add_memory_entry(&payload, buf1, {0x55, 0xAA});
+
+    send_request(payload);
+    scrutiny_handler.process(0);
+    scrutiny_handler.process(SCRUTINY_REQUEST_MAX_PROCESS_TIME_US * 10 + 1);
+    ASSERT_GT(scrutiny_handler.data_to_send(), 0u);
+    scrutiny_handler.pop_data(tx_buffer, scrutiny_handler.data_to_send());
+    EXPECT_TRUE(IS_PROTOCOL_RESPONSE(tx_buffer, scrutiny::protocol::CommandId::MemoryControl, 6, scrutiny::protocol::ResponseCode::FailureToProceed));
+
+    // A failure was reported. The loop must not apply the transaction anymore
+    loop.process();
+    uint8_t const zeros[2] = {0};
+    EXPECT_BUF_EQ(buf1, zeros, sizeof(buf1));
+
+    // A new transaction is accepted right away
+    send_request(payload);
+    scrutiny_handler.process(0);
+    EXPECT_EQ(scrutiny_handler.data_to_send(), 0u);
+    loop.process();
+    scrutiny_handler.process(0);
+    ASSERT_GT(scrutiny_handler.data_to_send(), 0u);
+    scrutiny_handler.pop_data(tx_buffer, scrutiny_handler.data_to_send());
+    EXPECT_TRUE(IS_PROTOCOL_RESPONSE(tx_buffer, scrutiny::protocol::CommandId::MemoryControl, 6, scrutiny::protocol::ResponseCode::OK));
+    uint8_t const expected_buf1[2] = {0x55, 0xAA};
+    EXPECT_BUF_EQ(buf1, expected_buf1, sizeof(buf1));
+}
+
+TEST_F(TestMemoryControlStaged, TestLoopStoppedThenSessionLost)
+{
+    // The loop never runs. The transaction is cancelled when the session ends and does not lock the next session.
+    uint8_t buf1[2] = {0};
+    uint8_t tx_buffer[32];
+    std::vector<uint8_t> payload = {0};
+    add_memory_entry(&payload, buf1, {0x55, 0xAA});
+
+    send_request(payload);
+    scrutiny_handler.process(0);
+    EXPECT_EQ(scrutiny_handler.data_to_send(), 0u);
+    scrutiny_handler.comm()->disconnect();
+    scrutiny_handler.process(0);
+    EXPECT_EQ(scrutiny_handler.data_to_send(), 0u);
+
+    ASSERT_TRUE(scrutiny_handler.comm()->connect());
+    loop.process(); // Drops the cancelled transaction
+    uint8_t const zeros[2] = {0};
+    EXPECT_BUF_EQ(buf1, zeros, sizeof(buf1));
+
+    send_request(payload);
+    scrutiny_handler.process(0);
+    EXPECT_EQ(scrutiny_handler.data_to_send(), 0u); // Not Busy. Waits for the loop
+    loop.process();
+    scrutiny_handler.process(0);
+    ASSERT_GT(scrutiny_handler.data_to_send(), 0u);
+    scrutiny_handler.pop_data(tx_buffer, scrutiny_handler.data_to_send());
+    EXPECT_TRUE(IS_PROTOCOL_RESPONSE(tx_buffer, scrutiny::protocol::CommandId::MemoryControl, 6, scrutiny::protocol::ResponseCode::OK));
+    uint8_t const expected_buf1[2] = {0x55, 0xAA};
+    EXPECT_BUF_EQ(buf1, expected_buf1, sizeof(buf1));
+}
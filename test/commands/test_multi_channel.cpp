@@ -0,0 +1,246 @@
+//    test_multi_channel.cpp
+//        Test the behaviour of the embedded module when serving multiple communication channels
+//
+//   - License : MIT - See LICENSE file.
+//   - Project : Scrutiny Debugger (github.com/scrutinydebugger/scrutiny-embedded)
+//
+//   Copyright (c) 2021 Scrutiny Debugger
+
+#include <gtest/gtest.h>
+#include <cstring>
+
+#include "scrutiny.hpp"
+#include "scrutiny_test.hpp"
+
+class TestMultiChannel : public ScrutinyTest
+{
+protected:
+    scrutiny::MainHandler scrutiny_handler;
+    scrutiny::Config config;
+    scrutiny::CommChannel channel2;
+    scrutiny::CommChannel *channels[1];
+
+    uint8_t _rx_buffer[128];
+    uint8_t _tx_buffer[128];
+    uint8_t _rx_buffer2[64];
+    uint8_t _tx_buffer2[96];
+
+    TestMultiChannel() : ScrutinyTest(),
+                         scrutiny_handler{},
+                         config{},
+                         channel2{},
+                         channels{&channel2},
+                         _rx_buffer{0},
+                         _tx_buffer{0},
+                         _rx_buffer2{0},
+                         _tx_buffer2{0}
+    {
+    }
+
+    virtual void SetUp()
+    {
+        config.set_buffers(_rx_buffer, sizeof(_rx_buffer), _tx_buffer, sizeof(_tx_buffer));
+        channel2.set_buffers(_rx_buffer2, sizeof(_rx_buffer2), _tx_buffer2, sizeof(_tx_buffer2));
+        config.set_additional_comm_channels(channels, sizeof(channels) / sizeof(channels[0]));
+        scrutiny_handler.init(&config);
+    }
+
+    /// @brief Builds a Write request of a single memory block. Returns the request size
+    uint16_t make_write_request(uint8_t *const request_data, void *const addr, uint8_t const *const data, uint8_t const length)
+    {
+        uint16_t const datalen = static_cast<uint16_t>(sizeof(std::uintptr_t) + 2 + length);
+        request_data[0] = 3;
+        request_data[1] = 2;
+        request_data[2] = 0;
+        request_data[3] = static_cast<uint8_t>(datalen);
+        unsigned int index = 4;
+        index += encode_addr(&request_data[index], addr);
+        request_data[index++] = 0;
+        request_data[index++] = length;
+        std::memcpy(&request_data[index], data, length);
+        add_crc(request_data, static_cast<uint16_t>(datalen + 4));
+        return static_cast<uint16_t>(datalen + 8);
+    }
+};
+
+TEST_F(TestMultiChannel, TestChannelAccess)
+{
+    ASSERT_EQ(scrutiny_handler.channel_count(), 2u);
+    EXPECT_EQ(scrutiny_handler.channel(0)->comm(), scrutiny_handler.comm());
+    EXPECT_EQ(scrutiny_handler.channel(1), &channel2);
+    EXPECT_EQ(scrutiny_handler.channel(2), nullptr);
+}
+
+TEST_F(TestMultiChannel, TestIndependentSessions)
+{
+    ASSERT_TRUE(scrutiny_handler.comm()->connect());
+    EXPECT_FALSE(channel2.comm()->is_connected());
+    ASSERT_TRUE(channel2.comm()->connect());
+
+    EXPECT_TRUE(scrutiny_handler.comm()->is_connected());
+    EXPECT_TRUE(channel2.comm()->is_connected());
+    EXPECT_NE(scrutiny_handler.comm()->get_session_id(), channel2.comm()->get_session_id());
+
+    channel2.comm()->disconnect();
+    EXPECT_TRUE(scrutiny_handler.comm()->is_connected());
+    EXPECT_FALSE(channel2.comm()->is_connected());
+}
+
+TEST_F(TestMultiChannel, TestGetParamsReportChannelBuffers)
+{
+    uint8_t request_data[8] = {2, 3, 0, 0};
+    add_crc(request_data, sizeof(request_data) - 4);
+    uint8_t tx_buffer[32];
+
+    scrutiny_handler.comm()->connect();
+    channel2.comm()->connect();
+
+    scrutiny_handler.receive_data(request_data, sizeof(request_data));
+    channel2.receive_data(request_data, sizeof(request_data));
+    scrutiny_handler.process(0);
+    scrutiny_handler.process(0);
+
+    uint16_t n_to_read = scrutiny_handler.data_to_send();
+    ASSERT_GT(n_to_read, 0u);
+    ASSERT_LT(n_to_read, sizeof(tx_buffer));
+    scrutiny_handler.pop_data(tx_buffer, n_to_read);
+    ASSERT_TRUE(IS_PROTOCOL_RESPONSE(tx_buffer, scrutiny::protocol::CommandId::CommControl, 3, scrutiny::protocol::ResponseCode::OK));
+    EXPECT_EQ(tx_buffer[5], (sizeof(_rx_buffer) >> 8) & 0xFF);
+    EXPECT_EQ(tx_buffer[6], sizeof(_rx_buffer) & 0xFF);
+    EXPECT_EQ(tx_buffer[7], (sizeof(_tx_buffer) >> 8) & 0xFF);
+    EXPECT_EQ(tx_buffer[8], sizeof(_tx_buffer) & 0xFF);
+
+    n_to_read = channel2.data_to_send();
+    ASSERT_GT(n_to_read, 0u);
+    ASSERT_LT(n_to_read, sizeof(tx_buffer));
+    channel2.pop_data(tx_buffer, n_to_read);
+    ASSERT_TRUE(IS_PROTOCOL_RESPONSE(tx_buffer, scrutiny::protocol::CommandId::CommControl, 3, scrutiny::protocol::ResponseCode::OK));
+    EXPECT_EQ(tx_buffer[5], (sizeof(_rx_buffer2) >> 8) & 0xFF);
+    EXPECT_EQ(tx_buffer[6], sizeof(_rx_buffer2) & 0xFF);
+    EXPECT_EQ(tx_buffer[7], (sizeof(_tx_buffer2) >> 8) & 0xFF);
+    EXPECT_EQ(tx_buffer[8], sizeof(_tx_buffer2) & 0xFF);
+}
+
+TEST_F(TestMultiChannel, TestFairProcessing)
+{
+    // A channel that always has a request pending must not starve the other one.
+    uint8_t request_data[8] = {2, 3, 0, 0};
+    add_crc(request_data, sizeof(request_data) - 4);
+    uint8_t tx_buffer[32];
+
+    scrutiny_handler.comm()->connect();
+    channel2.comm()->connect();
+
+    scrutiny_handler.receive_data(request_data, sizeof(request_data));
+    channel2.receive_data(request_data, sizeof(request_data));
+    scrutiny_handler.process(0);
+
+    // Exactly one channel is served per call
+    ASSERT_NE(scrutiny_handler.data_to_send() > 0, channel2.data_to_send() > 0);
+    scrutiny::CommChannel *served = (scrutiny_handler.data_to_send() > 0) ? scrutiny_handler.channel(0) : &channel2;
+    scrutiny::CommChannel *waiting = (served == &channel2) ? scrutiny_handler.channel(0) : &channel2;
+
+    for (unsigned int i = 0; i < 4; i++)
+    {
+        // The served channel gets a new request right away. The waiting one must still go first.
+        served->pop_data(tx_buffer, served->data_to_send());
+        served->receive_data(request_data, sizeof(request_data));
+        scrutiny_handler.process(0);
+
+        EXPECT_EQ(served->data_to_send(), 0u) << "i=" << i;
+        ASSERT_GT(waiting->data_to_send(), 0u) << "i=" << i;
+
+        scrutiny::CommChannel *temp = served;
+        served = waiting;
+        waiting = temp;
+    }
+}
+
+TEST_F(TestMultiChannel, TestInvalidChannelDisables)
+{
+    scrutiny::CommChannel shared_buffers;
+    scrutiny::CommChannel *bad_channels[1] = {&shared_buffers};
+    shared_buffers.set_buffers(_rx_buffer, sizeof(_rx_buffer), _tx_buffer2, sizeof(_tx_buffer2));
+    config.set_additional_comm_channels(bad_channels, 1);
+    scrutiny_handler.init(&config);
+    EXPECT_FALSE(scrutiny_handler.comm()->is_enabled());
+
+    scrutiny::CommChannel no_buffers;
+    bad_channels[0] = &no_buffers;
+    scrutiny_handler.init(&config);
+    EXPECT_FALSE(scrutiny_handler.comm()->is_enabled());
+
+    bad_channels[0] = nullptr;
+    scrutiny_handler.init(&config);
+    EXPECT_FALSE(scrutiny_handler.comm()->is_enabled());
+    scrutiny_handler.process(0); // Must not crash
+
+    // The channel count, main channel included, would not fit in a uint8_t
+    bad_channels[0] = &channel2;
+    config.set_additional_comm_channels(bad_channels, 255);
+    scrutiny_handler.init(&config);
+    EXPECT_EQ(scrutiny_handler.channel_count(), 1u);
+    EXPECT_FALSE(scrutiny_handler.comm()->is_enabled());
+    scrutiny_handler.process(0); // Must not crash
+}
+
+TEST_F(TestMultiChannel, TestBudgetedWriteNotInterrupted)
+{
+    // A write applied in slices cannot be interrupted. The Write requests of the other channels get Busy until it completes
+    uint8_t buf1[40] = {0};
+    uint8_t buf2[8] = {0};
+    uint8_t data1[sizeof(buf1)];
+    uint8_t data2[sizeof(buf2)];
+    fill_buffer_incremental(data1, sizeof(data1));
+    fill_buffer_incremental(data2, sizeof(data2));
+    data2[0] = 0xAA;
+
+    uint8_t request1[64];
+    uint8_t request2[32];
+    uint16_t const request1_size = make_write_request(request1, buf1, data1, sizeof(data1));
+    uint16_t const request2_size = make_write_request(request2, buf2, data2, sizeof(data2));
+    uint8_t tx_buffer[32];
+
+    scrutiny_handler.comm()->connect();
+    channel2.comm()->connect();
+
+    scrutiny_handler.receive_data(request1, request1_size);
+    scrutiny_handler.process(0, 16);
+    EXPECT_EQ(scrutiny_handler.data_to_send(), 0u);
+    EXPECT_BUF_EQ(buf1, data1, 16);
+
+    channel2.receive_data(request2, request2_size);
+    scrutiny_handler.process(0, 16);
+    uint16_t n_to_read = channel2.data_to_send();
+    ASSERT_GT(n_to_read, 0u);
+    ASSERT_LT(n_to_read, sizeof(tx_buffer));
+    channel2.pop_data(tx_buffer, n_to_read);
+    EXPECT_TRUE(IS_PROTOCOL_RESPONSE(tx_buffer, scrutiny::protocol::CommandId::MemoryControl, 2, scrutiny::protocol::ResponseCode::Busy));
+    EXPECT_BUF_SET(buf2, 0, sizeof(buf2));
+
+    // The first write resumes where it stopped
+    uint32_t call_count = 0;
+    while (scrutiny_handler.data_to_send() == 0 && call_count < 100)
+    {
+        scrutiny_handler.process(0, 16);
+        call_count++;
+    }
+    EXPECT_EQ(call_count, 2u);
+    n_to_read = scrutiny_handler.data_to_send();
+    ASSERT_GT(n_to_read, 0u);
+    ASSERT_LT(n_to_read, sizeof(tx_buffer));
+    scrutiny_handler.pop_data(tx_buffer, n_to_read);
+    EXPECT_TRUE(IS_PROTOCOL_RESPONSE(tx_buffer, scrutiny::protocol::CommandId::MemoryControl, 2, scrutiny::protocol::ResponseCode::OK));
+    EXPECT_BUF_EQ(buf1, data1, sizeof(buf1));
+
+    // Then the other channel can write
+    scrutiny_handler.process(0);
+    channel2.receive_data(request2, request2_size);
+    scrutiny_handler.process(0, 16);
+    n_to_read = channel2.data_to_send();
+    ASSERT_GT(n_to_read, 0u);
+    ASSERT_LT(n_to_read, sizeof(tx_buffer));
+    channel2.pop_data(tx_buffer, n_to_read);
+    EXPECT_TRUE(IS_PROTOCOL_RESPONSE(tx_buffer, scrutiny::protocol::CommandId::MemoryControl, 2, scrutiny::protocol::ResponseCode::OK));
+    EXPECT_BUF_EQ(buf2, data2, sizeof(buf2));
+}
@@ -131,4 +131,165 @@ TEST_F(TestUserCommand, TestNoCallback)
 
     scrutiny_handler.pop_data(tx_buffer, n_to_read);
     ASSERT_TRUE(IS_PROTOCOL_RESPONSE(tx_buffer, cmd, 0, code));
-}
\ No newline at end of file
+}
+
+static uint32_t g_async_call_count = 0;
+static uint8_t const g_async_response[3] = {0xAB, 0xCD, 0xEF};
+
+static scrutiny::ctypes::scrutiny_c_user_command_status_e async_callback(uint8_t const subfunction,
+                                                                         uint8_t const *request_data,
+                                                                         uint16_t const request_data_length,
+                                                                         uint8_t *response_data,
+                                                                         uint16_t *response_data_length,
+                                                                         uint16_t const response_max_data_length)
+{
+    (void)request_data;             // Silence unused parameters warning
+    (void)request_data_length;      // Silence unused parameters warning
+    (void)response_max_data_length; // Silence unused parameters warning
+    g_async_call_count++;
+    if (subfunction == 0x10) // Fast command. Completed right away
+    {
+        response_data[0] = 0x55;
+        *response_data_length = 1;
+        return scrutiny::ctypes::SCRUTINY_C_USER_COMMAND_STATUS_COMPLETED;
+    }
+    return scrutiny::ctypes::SCRUTINY_C_USER_COMMAND_STATUS_PENDING;
+}
+
+TEST_F(TestUserCommand, TestAsyncCommand)
+{
+    uint8_t tx_buffer[32];
+    g_async_call_count = 0;
+    config.set_async_user_command_callback(async_callback);
+    config.set_user_command_timeout(SCRUTINY_REQUEST_MAX_PROCESS_TIME_US * 10 * 3);
+    scrutiny_handler.init(&config);
+    scrutiny_handler.comm()->connect();
+
+    // Completed by the callback
+    uint8_t fast_request[8] = {4, 0x10, 0, 0};
+    add_crc(fast_request, sizeof(fast_request) - 4);
+    uint8_t fast_response[9 + 1] = {0x84, 0x10, 0, 0, 1, 0x55};
+    add_crc(fast_response, sizeof(fast_response) - 4);
+    scrutiny_handler.receive_data(fast_request, sizeof(fast_request));
+    scrutiny_handler.process(0);
+    ASSERT_EQ(scrutiny_handler.data_to_send(), sizeof(fast_response));
+    scrutiny_handler.pop_data(tx_buffer, sizeof(fast_response));
+    EXPECT_BUF_EQ(tx_buffer, fast_response, sizeof(fast_response));
+
+    // Pending. Longer than any other request is allowed to take
+    uint8_t request_data[8] = {4, 0x20, 0, 0};
+    add_crc(request_data, sizeof(request_data) - 4);
+    scrutiny_handler.receive_data(request_data, sizeof(request_data));
+    for (uint32_t i = 0; i < 5; i++)
+    {
+        scrutiny_handler.process(SCRUTINY_REQUEST_MAX_PROCESS_TIME_US * 10 / 2);
+        ASSERT_EQ(scrutiny_handler.data_to_send(), 0u);
+    }
+    EXPECT_EQ(g_async_call_count, 2u);
+
+    EXPECT_TRUE(scrutiny_handler.complete_user_command(g_async_response, sizeof(g_async_response)));
+    EXPECT_FALSE(scrutiny_handler.complete_user_command(g_async_response, sizeof(g_async_response))); // Previous one not processed yet
+    scrutiny_handler.process(0);
+    uint8_t expected_response[9 + 3] = {0x84, 0x20, 0, 0, 3, 0xAB, 0xCD, 0xEF};
+    add_crc(expected_response, sizeof(expected_response) - 4);
+    ASSERT_EQ(scrutiny_handler.data_to_send(), sizeof(expected_response));
+    scrutiny_handler.pop_data(tx_buffer, sizeof(expected_response));
+    EXPECT_BUF_EQ(tx_buffer, expected_response, sizeof(expected_response));
+    EXPECT_EQ(g_async_call_count, 2u);
+
+    // Pending, then failed
+    scrutiny_handler.receive_data(request_data, sizeof(request_data));
+    scrutiny_handler.process(0);
+    ASSERT_EQ(scrutiny_handler.data_to_send(), 0u);
+    EXPECT_TRUE(scrutiny_handler.complete_user_command(nullptr, 0, false));
+    scrutiny_handler.process(0);
+    uint16_t const n_to_read = scrutiny_handler.data_to_send();
+    ASSERT_GT(n_to_read, 0u);
+    scrutiny_handler.pop_data(tx_buffer, n_to_read);
+    EXPECT_TRUE(IS_PROTOCOL_RESPONSE(tx_buffer, scrutiny::protocol::CommandId::UserCommand, 0x20, scrutiny::protocol::ResponseCode::FailureToProceed));
+}
+
+TEST_F(TestUserCommand, TestAsyncCommandTimeout)
+{
+    uint8_t tx_buffer[32];
+    g_async_call_count = 0;
+    config.set_async_user_command_callback(async_callback);
+    config.set_user_command_timeout(1000);
+    scrutiny_handler.init(&config);
+    scrutiny_handler.comm()->connect();
+
+    uint8_t request_data[8] = {4, 0x20, 0, 0};
+    add_crc(request_data, sizeof(request_data) - 4);
+    scrutiny_handler.receive_data(request_data, sizeof(request_data));
+    scrutiny_handler.process(0);
+    scrutiny_handler.process(999);
+    ASSERT_EQ(scrutiny_handler.data_to_send(), 0u);
+    scrutiny_handler.process(1);
+    uint16_t n_to_read = scrutiny_handler.data_to_send();
+    ASSERT_GT(n_to_read, 0u);
+    scrutiny_handler.pop_data(tx_buffer, n_to_read);
+    EXPECT_TRUE(IS_PROTOCOL_RESPONSE(tx_buffer, scrutiny::protocol::CommandId::UserCommand, 0x20, scrutiny::protocol::ResponseCode::FailureToProceed));
+
+    // The command is still running. A new one must wait
+    scrutiny_handler.receive_data(request_data, sizeof(request_data));
+    scrutiny_handler.process(0);
+    n_to_read = scrutiny_handler.data_to_send();
+    ASSERT_GT(n_to_read, 0u);
+    scrutiny_handler.pop_data(tx_buffer, n_to_read);
+    EXPECT_TRUE(IS_PROTOCOL_RESPONSE(tx_buffer, scrutiny::protocol::CommandId::UserCommand, 0x20, scrutiny::protocol::ResponseCode::Busy));
+    EXPECT_EQ(g_async_call_count, 1u);
+
+    // Late completion is dropped and the next command runs
+    EXPECT_TRUE(scrutiny_handler.complete_user_command(g_async_response, sizeof(g_async_response)));
+    scrutiny_handler.receive_data(request_data, sizeof(request_data));
+    scrutiny_handler.process(0);
+    EXPECT_EQ(scrutiny_handler.data_to_send(), 0u);
+    EXPECT_EQ(g_async_call_count, 2u);
+}
+
+TEST_F(TestUserCommand, TestAsyncCommandTimeoutLimited)
+{
+    config.set_user_command_timeout(SCRUTINY_COMM_HEARTBEAT_TIMEOUT_US * 10 * 2);
+    EXPECT_EQ(config.get_user_command_timeout(), static_cast<scrutiny::timediff_t>(scrutiny::Config::MAX_USER_COMMAND_TIMEOUT_100NS));
+    EXPECT_LT(config.get_user_command_timeout(), static_cast<scrutiny::timediff_t>(SCRUTINY_COMM_HEARTBEAT_TIMEOUT_US * 10));
+    config.set_user_command_timeout(1000);
+    EXPECT_EQ(config.get_user_command_timeout(), 1000u);
+}
+
+TEST_F(TestUserCommand, TestAsyncCommandSessionTimeout)
+{
+    uint8_t tx_buffer[32];
+    g_async_call_count = 0;
+    config.set_async_user_command_callback(async_callback);
+    config.set_user_command_timeout(scrutiny::Config::MAX_USER_COMMAND_TIMEOUT_100NS);
+    scrutiny_handler.init(&config);
+    scrutiny_handler.comm()->connect();
+
+    // The last heartbeat was a while ago. The session ends before the command times out
+    scrutiny_handler.process(SCRUTINY_COMM_HEARTBEAT_TIMEOUT_US * 10 / 2);
+    uint8_t request_data[8] = {4, 0x20, 0, 0};
+    add_crc(request_data, sizeof(request_data) - 4);
+    scrutiny_handler.receive_data(request_data, sizeof(request_data));
+    scrutiny_handler.process(0);
+    ASSERT_EQ(scrutiny_handler.data_to_send(), 0u);
+    EXPECT_EQ(g_async_call_count, 1u);
+    scrutiny_handler.process(SCRUTINY_COMM_HEARTBEAT_TIMEOUT_US * 10 / 2);
+    EXPECT_FALSE(scrutiny_handler.comm()->is_connected());
+    EXPECT_EQ(scrutiny_handler.data_to_send(), 0u);
+
+    // New session. The command is still running, and the same request in the new session is not mistaken for the lost one
+    scrutiny_handler.comm()->connect();
+    scrutiny_handler.receive_data(request_data, sizeof(request_data));
+    scrutiny_handler.process(0);
+    uint16_t const n_to_read = scrutiny_handler.data_to_send();
+    ASSERT_GT(n_to_read, 0u);
+    scrutiny_handler.pop_data(tx_buffer, n_to_read);
+    EXPECT_TRUE(IS_PROTOCOL_RESPONSE(tx_buffer, scrutiny::protocol::CommandId::UserCommand, 0x20, scrutiny::protocol::ResponseCode::Busy));
+
+    // Its completion is dropped, then the next command runs
+    EXPECT_TRUE(scrutiny_handler.complete_user_command(g_async_response, sizeof(g_async_response)));
+    scrutiny_handler.receive_data(request_data, sizeof(request_data));
+    scrutiny_handler.process(0);
+    EXPECT_EQ(scrutiny_handler.data_to_send(), 0u);
+    EXPECT_EQ(g_async_call_count, 2u);
+}
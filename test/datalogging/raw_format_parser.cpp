@@ -25,6 +25,23 @@ void RawFormatParser::init(scrutiny::MainHandler *main_handler, scrutiny::datalo
     }
 }
 
+uint32_t RawFormatParser::get_elem_size(uint16_t const item_index) const
+{
+    if (m_config->items_to_log[item_index].type == scrutiny::datalogging::LoggableType::MEMORY)
+    {
+        return m_config->items_to_log[item_index].data.memory.size;
+    }
+    else if (m_config->items_to_log[item_index].type == scrutiny::datalogging::LoggableType::RPV)
+    {
+        return scrutiny::tools::get_type_size(m_main_handler->get_rpv_type(m_config->items_to_log[item_index].data.rpv.id));
+    }
+    else if (m_config->items_to_log[item_index].type == scrutiny::datalogging::LoggableType::TIME)
+    {
+        return sizeof(scrutiny::timestamp_t);
+    }
+    return 0;
+}
+
 void RawFormatParser::parse(uint32_t entry_count)
 {
     if (m_error)
@@ -33,24 +50,24 @@ void RawFormatParser::parse(uint32_t entry_count)
     }
     uint32_t cursor = 0;
     uint32_t entry_size = 0;
+    uint32_t packed_bits = 0;
     for (uint16_t i = 0; i < m_config->items_count; i++)
     {
-        std::vector<uint8_t> item_data;
-        uint32_t elem_size = 0;
-
-        if (m_config->items_to_log[i].type == scrutiny::datalogging::LoggableType::MEMORY)
-        {
-            elem_size = m_config->items_to_log[i].data.memory.size;
-        }
-        else if (m_config->items_to_log[i].type == scrutiny::datalogging::LoggableType::RPV)
-        {
-            elem_size = scrutiny::tools::get_type_size(m_main_handler->get_rpv_type(m_config->items_to_log[i].data.rpv.id));
-        }
-        else if (m_config->items_to_log[i].type == scrutiny::datalogging::LoggableType::TIME)
+        if (m_config->items_to_log[i].type == scrutiny::datalogging::LoggableType::VARBIT)
         {
-            elem_size = sizeof(scrutiny::timestamp_t);
+            if (m_config->items_to_log[i].data.varbit.bitsize == 0)
+            {
+                m_error = true;
+                return;
+            }
+            packed_bits += m_config->items_to_log[i].data.varbit.bitsize;
+            continue;
         }
 
+        entry_size += (packed_bits + 7) / 8;
+        packed_bits = 0;
+
+        uint32_t const elem_size = get_elem_size(i);
         if (elem_size == 0)
         {
             m_error = true;
@@ -59,8 +76,9 @@ void RawFormatParser::parse(uint32_t entry_count)
 
         entry_size += elem_size;
     }
+    entry_size += (packed_bits + 7) / 8;
 
-    if (entry_count > (m_buffer_size / entry_size))
+    if (entry_size == 0 || entry_count > (m_buffer_size / entry_size))
     {
         m_error = true;
         return;
@@ -71,23 +89,34 @@ void RawFormatParser::parse(uint32_t entry_count)
     for (uint32_t i = 0; i < entry_count; i++)
     {
         std::vector<std::vector<uint8_t>> entry(m_config->items_count);
+        packed_bits = 0;
         for (uint16_t j = 0; j < m_config->items_count; j++)
         {
-            uint32_t elem_size = 0;
-
-            if (m_config->items_to_log[j].type == scrutiny::datalogging::LoggableType::MEMORY)
+            if (m_config->items_to_log[j].type == scrutiny::datalogging::LoggableType::VARBIT)
             {
-                elem_size = m_config->items_to_log[j].data.memory.size;
-            }
-            else if (m_config->items_to_log[j].type == scrutiny::datalogging::LoggableType::RPV)
-            {
-                elem_size = scrutiny::tools::get_type_size(m_main_handler->get_rpv_type(m_config->items_to_log[j].data.rpv.id));
-            }
-            else if (m_config->items_to_log[j].type == scrutiny::datalogging::LoggableType::TIME)
-            {
-                elem_size = sizeof(scrutiny::timestamp_t);
+                // Bits are packed LSB first. Output the value in big endian, like the RPVs.
+                uint8_t const bitsize = m_config->items_to_log[j].data.varbit.bitsize;
+                uint64_t value = 0;
+                for (uint8_t k = 0; k < bitsize; k++)
+                {
+                    uint32_t const bitpos = packed_bits + k;
+                    value |= static_cast<uint64_t>((m_buffer[cursor + bitpos / 8] >> (bitpos % 8)) & 1) << k;
+                }
+                packed_bits += bitsize;
+
+                std::vector<uint8_t> item_data((bitsize + 7) / 8);
+                for (uint32_t k = 0; k < item_data.size(); k++)
+                {
+                    item_data[item_data.size() - 1 - k] = static_cast<uint8_t>(value >> (8 * k));
+                }
+                entry[j] = item_data;
+                continue;
             }
 
+            cursor += (packed_bits + 7) / 8;
+            packed_bits = 0;
+
+            uint32_t const elem_size = get_elem_size(j);
             if (elem_size == 0)
             {
                 m_error = true;
@@ -103,6 +132,7 @@ void RawFormatParser::parse(uint32_t entry_count)
 
             entry[j] = item_data;
         }
+        cursor += (packed_bits + 7) / 8;
         m_data[i] = entry;
     }
 }
@@ -23,6 +23,8 @@ public:
     bool error(void) const { return m_error; }
 
 protected:
+    uint32_t get_elem_size(uint16_t const item_index) const;
+
     scrutiny::MainHandler *m_main_handler;
     uint8_t *m_buffer;
     uint32_t m_buffer_size;
@@ -164,6 +164,53 @@ TEST_F(TestDatalogger, TriggerBasics)
     check_canaries();
 }
 
+TEST_F(TestDatalogger, TriggerOnBitfield)
+{
+#pragma pack(push, 1)
+    struct
+    {
+        int16_t : 3;
+        int16_t val : 11;
+        int16_t : 2;
+    } my_struct;
+#pragma pack(pop)
+    float logged_var = 0.0;
+    my_struct.val = 0;
+
+    datalogging::Configuration dlconfig;
+    dlconfig.items_count = 1;
+    dlconfig.items_to_log[0].type = datalogging::LoggableType::MEMORY;
+    dlconfig.items_to_log[0].data.memory.size = sizeof(logged_var);
+    dlconfig.items_to_log[0].data.memory.address = &logged_var;
+    dlconfig.decimation = 1;
+    dlconfig.timeout_100ns = 0;
+    dlconfig.probe_location = 128;
+    dlconfig.trigger.hold_time_100ns = 0;
+    dlconfig.trigger.operand_count = 2;
+    dlconfig.trigger.condition = datalogging::SupportedTriggerConditions::Equal;
+
+    dlconfig.trigger.operands[0].type = datalogging::OperandType::VARBIT;
+    dlconfig.trigger.operands[0].data.varbit.addr = &my_struct;
+    dlconfig.trigger.operands[0].data.varbit.datatype = scrutiny::VariableType::sint16;
+    dlconfig.trigger.operands[0].data.varbit.bitoffset = 3;
+    dlconfig.trigger.operands[0].data.varbit.bitsize = 11;
+
+    dlconfig.trigger.operands[1].type = datalogging::OperandType::LITERAL;
+    dlconfig.trigger.operands[1].data.literal.val = -1000.0f;
+
+    datalogger.config()->copy_from(&dlconfig);
+    datalogger.configure(&tb);
+    ASSERT_TRUE(datalogger.config_valid());
+    EXPECT_EQ(datalogger.config()->trigger.operands[0].data.varbit.descriptor.output_type, scrutiny::VariableType::sint16);
+
+    datalogger.arm_trigger();
+    EXPECT_FALSE(datalogger.check_trigger());
+    my_struct.val = -1000;
+    EXPECT_TRUE(datalogger.check_trigger());
+
+    check_canaries();
+}
+
 TEST_F(TestDatalogger, TriggerHoldTime)
 {
     float my_var = 0.0;
@@ -439,6 +486,76 @@ TEST_F(TestDatalogger, ComplexAcquisition)
     }
 }
 
+TEST_F(TestDatalogger, BitPackedAcquisition)
+{
+    uint8_t counter = 0;
+
+    datalogging::Configuration dlconfig;
+    dlconfig.items_count = 3;
+    dlconfig.items_to_log[0].type = datalogging::LoggableType::MEMORY;
+    dlconfig.items_to_log[0].data.memory.size = sizeof(counter);
+    dlconfig.items_to_log[0].data.memory.address = &counter;
+    dlconfig.items_to_log[1].type = datalogging::LoggableType::VARBIT;
+    dlconfig.items_to_log[1].data.varbit.addr = &counter;
+    dlconfig.items_to_log[1].data.varbit.datatype = VariableType::uint8;
+    dlconfig.items_to_log[1].data.varbit.bitoffset = 0;
+    dlconfig.items_to_log[1].data.varbit.bitsize = 1;
+    dlconfig.items_to_log[2].type = datalogging::LoggableType::VARBIT;
+    dlconfig.items_to_log[2].data.varbit.addr = &counter;
+    dlconfig.items_to_log[2].data.varbit.datatype = VariableType::sint8;
+    dlconfig.items_to_log[2].data.varbit.bitoffset = 1;
+    dlconfig.items_to_log[2].data.varbit.bitsize = 3;
+    dlconfig.decimation = 1;
+    dlconfig.timeout_100ns = 0;
+    dlconfig.probe_location = 0;
+    dlconfig.trigger.hold_time_100ns = 0;
+    dlconfig.trigger.operand_count = 0;
+    dlconfig.trigger.condition = datalogging::SupportedTriggerConditions::AlwaysTrue;
+
+    datalogger.config()->copy_from(&dlconfig);
+    datalogger.configure(&tb);
+    ASSERT_TRUE(datalogger.config_valid());
+    datalogger.arm_trigger();
+
+    for (unsigned int i = 0; i < 200 && !datalogger.data_acquired(); i++)
+    {
+        datalogger.process();
+        tb.step(10);
+        counter++;
+    }
+    ASSERT_TRUE(datalogger.data_acquired());
+
+    // 1 byte of memory + 4 bits packed in 1 byte
+    datalogging::DataReader *reader = datalogger.get_reader();
+    reader->reset();
+    EXPECT_EQ(reader->get_total_size(), reader->get_entry_count() * 2u);
+
+    uint8_t output_buffer[sizeof(dlbuffer)];
+    uint32_t copied_count = 0;
+    while (!reader->finished())
+    {
+        copied_count += reader->read(&output_buffer[copied_count], 10);
+        ASSERT_LE(copied_count, sizeof(output_buffer));
+    }
+
+    RawFormatParser parser;
+    parser.init(&scrutiny_handler, &dlconfig, output_buffer, sizeof(output_buffer));
+    parser.parse(reader->get_entry_count());
+    ASSERT_FALSE(parser.error());
+
+    vector<vector<vector<uint8_t>>> data = parser.get();
+    ASSERT_GT(data.size(), 0u);
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        ASSERT_EQ(data[i].size(), 3u);
+        uint8_t const logged_counter = data[i][0][0];
+        EXPECT_EQ(data[i][1][0], logged_counter & 1) << "i=" << i;
+        EXPECT_EQ(data[i][2][0], (logged_counter >> 1) & 7) << "i=" << i; // Logged raw, not sign extended
+    }
+
+    check_canaries();
+}
+
 TEST_F(TestDatalogger, TestAlwaysUseFullBuffer)
 {
     float var1 = 0.0;
@@ -493,4 +610,205 @@ TEST_F(TestDatalogger, TestAlwaysUseFullBuffer)
 
         EXPECT_GE(reader->get_total_size(), 9 * sizeof(dlbuffer) / 10) << error_msg; // 90% usage at least
     }
-}
\ No newline at end of file
+}
+TEST_F(TestDatalogger, WindowedStorageAcquisition)
+{
+    // Storage that gives access to small windows only, so that the encoder and the reader have to remap while they go
+    class WindowedStorage : public datalogging::Storage
+    {
+    public:
+        uint8_t data[sizeof(dlbuffer)];
+        unsigned int map_count = 0;
+        unsigned int flush_count = 0;
+
+        virtual datalogging::buffer_size_t size(void) const override { return sizeof(data); }
+
+        virtual bool map(datalogging::buffer_size_t const offset, datalogging::buffer_size_t const length, datalogging::StorageWindow *const window) override
+        {
+            unmap(window);
+            if (offset > sizeof(data) || length > sizeof(data) - offset)
+            {
+                return false;
+            }
+            map_count++;
+            window->data = &data[offset];
+            window->offset = offset;
+            window->size = std::min<datalogging::buffer_size_t>(std::max<datalogging::buffer_size_t>(length, 16), sizeof(data) - offset);
+            return true;
+        }
+
+        virtual void flush(void) override { flush_count++; }
+    } storage;
+
+    float var1 = 0.0;
+    int32_t var2 = 0;
+    datalogging::DataLogger windowed_datalogger;
+    windowed_datalogger.init(&scrutiny_handler, &tb, &storage);
+    EXPECT_EQ(windowed_datalogger.get_buffer_size(), sizeof(storage.data));
+
+    datalogging::Configuration dlconfig;
+    dlconfig.items_count = 3;
+    dlconfig.items_to_log[0].type = datalogging::LoggableType::MEMORY;
+    dlconfig.items_to_log[0].data.memory.size = sizeof(var1);
+    dlconfig.items_to_log[0].data.memory.address = &var1;
+    dlconfig.items_to_log[1].type = datalogging::LoggableType::MEMORY;
+    dlconfig.items_to_log[1].data.memory.size = sizeof(var2);
+    dlconfig.items_to_log[1].data.memory.address = &var2;
+    dlconfig.items_to_log[2].type = datalogging::LoggableType::TIME;
+    dlconfig.decimation = 1;
+    dlconfig.timeout_100ns = 0;
+    dlconfig.probe_location = 100;
+    dlconfig.trigger.hold_time_100ns = 0;
+    dlconfig.trigger.operand_count = 2;
+    dlconfig.trigger.condition = datalogging::SupportedTriggerConditions::GreaterThan;
+    dlconfig.trigger.operands[0].type = datalogging::OperandType::VAR;
+    dlconfig.trigger.operands[0].data.var.addr = &var1;
+    dlconfig.trigger.operands[0].data.var.datatype = scrutiny::VariableType::float32;
+    dlconfig.trigger.operands[1].type = datalogging::OperandType::LITERAL;
+    dlconfig.trigger.operands[1].data.literal.val = 30.0f;
+
+    // The same acquisition is done in the RAM buffer as a reference
+    datalogging::DataLogger *dataloggers[2] = {&datalogger, &windowed_datalogger};
+    for (unsigned int i = 0; i < 2; i++)
+    {
+        dataloggers[i]->config()->copy_from(&dlconfig);
+        dataloggers[i]->configure(&tb);
+        ASSERT_TRUE(dataloggers[i]->config_valid());
+        dataloggers[i]->arm_trigger();
+    }
+
+    for (unsigned int i = 0; i < 200 && !windowed_datalogger.data_acquired(); i++)
+    {
+        datalogger.process();
+        windowed_datalogger.process();
+        tb.step(10);
+        var1 += 1.0f;
+        var2 -= 3;
+    }
+    ASSERT_TRUE(datalogger.data_acquired());
+    ASSERT_TRUE(windowed_datalogger.data_acquired());
+    ASSERT_FALSE(windowed_datalogger.get_encoder()->error());
+    EXPECT_EQ(storage.flush_count, 1u);
+    EXPECT_GT(storage.map_count, 1u);
+    check_canaries();
+
+    uint8_t expected[sizeof(dlbuffer)];
+    uint8_t output[sizeof(dlbuffer)];
+    datalogging::buffer_size_t sizes[2] = {0, 0};
+    uint8_t *outputs[2] = {expected, output};
+    for (unsigned int i = 0; i < 2; i++)
+    {
+        datalogging::DataReader *reader = dataloggers[i]->get_reader();
+        reader->reset();
+        while (!reader->finished())
+        {
+            ASSERT_FALSE(reader->error());
+            sizes[i] += reader->read(&outputs[i][sizes[i]], 7); // Reads that do not align with entries nor windows
+        }
+    }
+
+    ASSERT_GT(sizes[0], 0u);
+    ASSERT_EQ(sizes[0], sizes[1]);
+    EXPECT_BUF_EQ(output, expected, sizes[0]);
+    EXPECT_EQ(windowed_datalogger.log_points_after_trigger(), datalogger.log_points_after_trigger());
+}
+
+TEST_F(TestDatalogger, SegmentedAcquisition)
+{
+    constexpr uint16_t segment_count = 4;
+    constexpr uint32_t entries_per_segment = sizeof(dlbuffer) / sizeof(uint32_t) / segment_count;
+    uint32_t counter = 0;
+    uint32_t fault = 0;
+
+    datalogging::Configuration dlconfig;
+    dlconfig.items_count = 1;
+    dlconfig.items_to_log[0].type = datalogging::LoggableType::MEMORY;
+    dlconfig.items_to_log[0].data.memory.size = sizeof(counter);
+    dlconfig.items_to_log[0].data.memory.address = &counter;
+    dlconfig.decimation = 1;
+    dlconfig.timeout_100ns = 0;
+    dlconfig.probe_location = 128;
+    dlconfig.segment_count = segment_count;
+    dlconfig.trigger.hold_time_100ns = 0;
+    dlconfig.trigger.operand_count = 2;
+    dlconfig.trigger.condition = datalogging::SupportedTriggerConditions::GreaterThan;
+    dlconfig.trigger.operands[0].type = datalogging::OperandType::VAR;
+    dlconfig.trigger.operands[0].data.var.addr = &fault;
+    dlconfig.trigger.operands[0].data.var.datatype = scrutiny::VariableType::uint32;
+    dlconfig.trigger.operands[1].type = datalogging::OperandType::LITERAL;
+    dlconfig.trigger.operands[1].data.literal.val = 0;
+
+    datalogger.config()->copy_from(&dlconfig);
+    datalogger.configure(&tb);
+    ASSERT_TRUE(datalogger.config_valid());
+    EXPECT_EQ(datalogger.get_segment_count(), segment_count);
+    datalogger.arm_trigger();
+
+    for (uint16_t segment = 0; segment < segment_count; segment++)
+    {
+        fault = 0;
+        for (unsigned int i = 0; i < 20; i++)
+        {
+            counter++;
+            datalogger.process();
+            tb.step(100);
+        }
+
+        // The fault stays present. Only its first occurrence is captured
+        fault = 1;
+        for (unsigned int i = 0; i < 50; i++)
+        {
+            counter++;
+            datalogger.process();
+            tb.step(100);
+        }
+        EXPECT_EQ(g_trigger_callback_count, segment + 1u);
+        EXPECT_EQ(datalogger.get_completed_segment_count(), segment + 1u);
+        EXPECT_EQ(datalogger.data_acquired(), segment == segment_count - 1);
+    }
+    ASSERT_FALSE(datalogger.get_encoder()->error());
+    check_canaries();
+
+    datalogging::DataReader *reader = datalogger.get_reader();
+    reader->reset();
+    EXPECT_EQ(reader->get_entry_count(), segment_count * entries_per_segment);
+    EXPECT_EQ(reader->get_total_size(), sizeof(dlbuffer));
+
+    uint8_t output[sizeof(dlbuffer)];
+    datalogging::buffer_size_t size = 0;
+    while (!reader->finished())
+    {
+        size += reader->read(&output[size], 7);
+    }
+    ASSERT_EQ(size, sizeof(dlbuffer));
+
+    timestamp_t previous_trigger_timestamp = 0;
+    for (uint16_t segment = 0; segment < segment_count; segment++)
+    {
+        timestamp_t trigger_timestamp;
+        datalogging::buffer_size_t entry_count;
+        datalogging::buffer_size_t points_after_trigger;
+        ASSERT_TRUE(datalogger.get_segment_info(segment, &trigger_timestamp, &entry_count, &points_after_trigger));
+        EXPECT_EQ(entry_count, entries_per_segment);
+        EXPECT_GT(points_after_trigger, 0u);
+        EXPECT_LT(points_after_trigger, entries_per_segment);
+        EXPECT_GT(trigger_timestamp, previous_trigger_timestamp);
+        previous_trigger_timestamp = trigger_timestamp;
+
+        // Each segment holds consecutive samples and the sample at the trigger point is the first one with the fault. Fault is set after 20 samples
+        uint32_t values[entries_per_segment];
+        memcpy(values, &output[segment * entries_per_segment * sizeof(uint32_t)], sizeof(values));
+        for (uint32_t i = 1; i < entries_per_segment; i++)
+        {
+            EXPECT_EQ(values[i], values[i - 1] + 1) << "segment=" << segment;
+        }
+        uint32_t const trigger_value = static_cast<uint32_t>(segment * 70 + 21);
+        EXPECT_EQ(values[entries_per_segment - points_after_trigger], trigger_value + 1) << "segment=" << segment;
+    }
+    EXPECT_FALSE(datalogger.get_segment_info(segment_count, &previous_trigger_timestamp, &size, &size));
+
+    // Arming again starts over from the first segment
+    datalogger.arm_trigger();
+    EXPECT_EQ(datalogger.get_completed_segment_count(), 0u);
+    EXPECT_FALSE(datalogger.data_acquired());
+}
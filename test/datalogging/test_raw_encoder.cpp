@@ -154,4 +154,346 @@ TEST_F(TestRawEncoder, BasicEncoding)
     EXPECT_EQ(total_read, reader->get_total_size());
 }
 
+TEST_F(TestRawEncoder, BitPackedEncoding)
+{
+    Timebase timebase;
+    uint8_t dst_buffer[128];
+    uint16_t var1 = 0x1234;
+    uint8_t flags = 0x21; // bit 0 and 5
+#pragma pack(push, 1)
+    struct
+    {
+        uint16_t : 2;
+        uint16_t field : 9;
+        uint16_t : 5;
+    } my_struct;
+#pragma pack(pop)
+    my_struct.field = 0x15A;
+
+    // MEMORY, VARBIT x3 (packed together), TIME, VARBIT (alone at the end)
+    dlconfig.items_count = 6;
+    dlconfig.items_to_log[0].type = datalogging::LoggableType::MEMORY;
+    dlconfig.items_to_log[0].data.memory.size = sizeof(var1);
+    dlconfig.items_to_log[0].data.memory.address = &var1;
+
+    uint8_t const bitoffsets[] = {0, 5, 2, 0};
+    uint8_t const bitsizes[] = {1, 1, 9, 1};
+    void *const addresses[] = {&flags, &flags, &my_struct, &flags};
+    uint8_t const varbit_items[] = {1, 2, 3, 5};
+    for (unsigned int i = 0; i < sizeof(varbit_items); i++)
+    {
+        datalogging::LoggableItem *const item = &dlconfig.items_to_log[varbit_items[i]];
+        item->type = datalogging::LoggableType::VARBIT;
+        item->data.varbit.addr = addresses[i];
+        item->data.varbit.datatype = (addresses[i] == &flags) ? VariableType::uint8 : VariableType::uint16;
+        item->data.varbit.bitoffset = bitoffsets[i];
+        item->data.varbit.bitsize = bitsizes[i];
+        // Normally done by the datalogger
+        ASSERT_TRUE(tools::make_bitfield_descriptor(VariableTypeType::_uint, bitoffsets[i], bitsizes[i], &item->data.varbit.descriptor));
+    }
+    dlconfig.items_to_log[4].type = datalogging::LoggableType::TIME;
+
+    encoder.init(&scrutiny_handler, &timebase, &dlconfig, dlbuffer, sizeof(dlbuffer));
+    memset(dlbuffer, 0xFF, sizeof(dlbuffer)); // Make sure padding is cleared
+    encoder.encode_next_entry();
+    ASSERT_FALSE(encoder.error());
+
+    datalogging::RawFormatReader *reader = encoder.get_reader();
+    reader->reset();
+    // 2 (var1) + 2 (11 bits packed) + 4 (time) + 1 (1 bit)
+    ASSERT_EQ(reader->get_total_size(), 9u);
+    ASSERT_EQ(reader->read(dst_buffer, sizeof(dst_buffer)), 9u);
+
+    // Bit 0 = 1, Bit 1 = 1, Bits 2-10 = 0x15A
+    uint16_t const expected_packed = 1 | (1 << 1) | (0x15A << 2);
+    EXPECT_BUF_EQ(&dst_buffer[0], reinterpret_cast<uint8_t *>(&var1), 2);
+    EXPECT_EQ(dst_buffer[2], expected_packed & 0xFF);
+    EXPECT_EQ(dst_buffer[3], expected_packed >> 8);
+    EXPECT_EQ(dst_buffer[8], 0x01);
+
+    check_canaries();
+}
+
+TEST_F(TestRawEncoder, FlagVectorIsDense)
+{
+    Timebase timebase;
+    uint8_t state[SCRUTINY_DATALOGGING_MAX_SIGNAL / 8];
+    uint8_t dst_buffer[SCRUTINY_DATALOGGING_MAX_SIGNAL / 8];
+    for (unsigned int i = 0; i < sizeof(state); i++)
+    {
+        state[i] = static_cast<uint8_t>(0x3C + i * 53);
+    }
+
+    dlconfig.items_count = SCRUTINY_DATALOGGING_MAX_SIGNAL;
+    for (unsigned int i = 0; i < SCRUTINY_DATALOGGING_MAX_SIGNAL; i++)
+    {
+        datalogging::LoggableItem *const item = &dlconfig.items_to_log[i];
+        item->type = datalogging::LoggableType::VARBIT;
+        item->data.varbit.addr = &state[i / 8];
+        item->data.varbit.datatype = VariableType::uint8;
+        item->data.varbit.bitoffset = i % 8;
+        item->data.varbit.bitsize = 1;
+        ASSERT_TRUE(tools::make_bitfield_descriptor(VariableTypeType::_uint, i % 8, 1, &item->data.varbit.descriptor));
+    }
+
+    encoder.init(&scrutiny_handler, &timebase, &dlconfig, dlbuffer, sizeof(dlbuffer));
+    encoder.encode_next_entry();
+    datalogging::RawFormatReader *reader = encoder.get_reader();
+    reader->reset();
+
+    // One bit per flag
+    ASSERT_EQ(reader->get_total_size(), sizeof(state));
+    ASSERT_EQ(reader->read(dst_buffer, sizeof(dst_buffer)), sizeof(state));
+    EXPECT_BUF_EQ(dst_buffer, state, sizeof(state));
+
+    check_canaries();
+}
+
+TEST_F(TestRawEncoder, NativeOrderStorage)
+{
+    Timebase timebase;
+    uint8_t var1 = 0;
+    uint8_t dst_buffer[3]; // Cuts the timestamps
+    uint8_t read_buffer[sizeof(dlbuffer)];
+    uint8_t compare_buf[sizeof(dlbuffer)];
+
+    // 5 bytes per entry. 25 entries fit in the buffer
+    dlconfig.items_count = 2;
+    dlconfig.items_to_log[0].type = datalogging::LoggableType::TIME;
+    dlconfig.items_to_log[1].type = datalogging::LoggableType::MEMORY;
+    dlconfig.items_to_log[1].data.memory.size = sizeof(var1);
+    dlconfig.items_to_log[1].data.memory.address = &var1;
+
+    encoder.init(&scrutiny_handler, &timebase, &dlconfig, dlbuffer, sizeof(dlbuffer));
+    timebase.reset();
+    for (uint8_t i = 0; i < 30; i++)
+    {
+        timebase.step(0x01020304);
+        var1 = i;
+        encoder.encode_next_entry();
+    }
+
+    // Entry 25 overwrote entry 0. The storage holds the timestamp as it is in memory
+    timestamp_t const timestamp25 = 0x01020304u * 26;
+    EXPECT_BUF_EQ(dlbuffer, reinterpret_cast<uint8_t const *>(&timestamp25), sizeof(timestamp25));
+    EXPECT_EQ(dlbuffer[4], 25u);
+
+    // The reader outputs big endian, from the oldest entry (5) to the newest (29)
+    for (uint8_t i = 0; i < 25; i++)
+    {
+        codecs::encode_32_bits_big_endian(0x01020304u * (i + 6), &compare_buf[i * 5]);
+        compare_buf[i * 5 + 4] = static_cast<uint8_t>(i + 5);
+    }
+
+    datalogging::RawFormatReader *reader = encoder.get_reader();
+    reader->reset();
+    ASSERT_EQ(reader->get_total_size(), 125u);
+    uint32_t total_read = 0;
+    while (!reader->finished())
+    {
+        uint32_t const nread = reader->read(dst_buffer, sizeof(dst_buffer));
+        ASSERT_GT(nread, 0u);
+        memcpy(&read_buffer[total_read], dst_buffer, nread);
+        total_read += nread;
+    }
+    ASSERT_EQ(total_read, 125u);
+    EXPECT_BUF_EQ(read_buffer, compare_buf, total_read);
+
+    // Same after a seek in the middle of a timestamp
+    ASSERT_TRUE(reader->seek(52));
+    ASSERT_EQ(reader->read(dst_buffer, sizeof(dst_buffer)), sizeof(dst_buffer));
+    EXPECT_BUF_EQ(dst_buffer, &compare_buf[52], sizeof(dst_buffer));
+
+    check_canaries();
+}
+
+TEST_F(TestRawEncoder, ColumnLayout)
+{
+    Timebase timebase;
+    uint16_t var1 = 0;
+    uint8_t dst_buffer[5]; // Not a multiple of any field size
+    uint8_t read_buffer[sizeof(dlbuffer)];
+    uint8_t compare_buf[sizeof(dlbuffer)];
+
+    // 6 bytes per entry. 21 entries fit in the buffer
+    dlconfig.items_count = 2;
+    dlconfig.items_to_log[0].type = datalogging::LoggableType::TIME;
+    dlconfig.items_to_log[1].type = datalogging::LoggableType::MEMORY;
+    dlconfig.items_to_log[1].data.memory.size = sizeof(var1);
+    dlconfig.items_to_log[1].data.memory.address = &var1;
+
+    encoder.init(&scrutiny_handler, &timebase, &dlconfig, dlbuffer, sizeof(dlbuffer));
+    timebase.reset();
+    for (uint16_t i = 0; i < 30; i++)
+    {
+        timebase.step(100);
+        var1 = static_cast<uint16_t>(0x1000 + i);
+        encoder.encode_next_entry();
+    }
+    ASSERT_EQ(encoder.get_entry_count(), 21u);
+
+    // All the timestamps from the oldest entry (9) to the newest (29) in big endian, then all the memory values as they are in memory
+    for (uint16_t i = 0; i < 21; i++)
+    {
+        uint16_t const value = static_cast<uint16_t>(0x1000 + i + 9);
+        codecs::encode_32_bits_big_endian(100u * (i + 10), &compare_buf[i * 4]);
+        memcpy(&compare_buf[21 * 4 + i * 2], &value, sizeof(value));
+    }
+
+    datalogging::RawFormatReader *reader = encoder.get_reader();
+    reader->set_layout(datalogging::ReadLayout::Columns);
+    ASSERT_EQ(reader->get_layout(), datalogging::ReadLayout::Columns);
+    ASSERT_EQ(reader->get_total_size(), 126u);
+    uint32_t total_read = 0;
+    while (!reader->finished())
+    {
+        uint32_t const nread = reader->read(dst_buffer, sizeof(dst_buffer));
+        ASSERT_GT(nread, 0u);
+        memcpy(&read_buffer[total_read], dst_buffer, nread);
+        total_read += nread;
+    }
+    ASSERT_EQ(total_read, 126u);
+    EXPECT_BUF_EQ(read_buffer, compare_buf, total_read);
+
+    // Seek in the middle of a timestamp, then across the column boundary
+    ASSERT_TRUE(reader->seek(33));
+    ASSERT_EQ(reader->read(dst_buffer, sizeof(dst_buffer)), sizeof(dst_buffer));
+    EXPECT_BUF_EQ(dst_buffer, &compare_buf[33], sizeof(dst_buffer));
+    ASSERT_TRUE(reader->seek(82));
+    ASSERT_EQ(reader->read(dst_buffer, sizeof(dst_buffer)), sizeof(dst_buffer));
+    EXPECT_BUF_EQ(dst_buffer, &compare_buf[82], sizeof(dst_buffer));
+    EXPECT_FALSE(reader->seek(127));
+
+    // Going back to rows restarts from the beginning with the usual layout
+    reader->set_layout(datalogging::ReadLayout::Rows);
+    ASSERT_EQ(reader->read(dst_buffer, sizeof(dst_buffer)), sizeof(dst_buffer));
+    uint8_t const first_row_time[] = {0x00, 0x00, 0x03, 0xE8};
+    EXPECT_BUF_EQ(dst_buffer, first_row_time, sizeof(first_row_time));
+    EXPECT_EQ(dst_buffer[4], compare_buf[21 * 4]);
+
+    check_canaries();
+}
+
+/// @brief Time of the entries written by write_sparse_entries(). Entry N is at 100*N up to entry 12, then the time step goes to 250
+static timestamp_t sparse_entry_time(uint32_t n)
+{
+    return (n <= 12) ? 100 * n : 1200 + 250 * (n - 12);
+}
+
+/// @brief Writes entries first to last, each one with its number as value, stepping the timebase in between
+static void write_sparse_entries(datalogging::RawFormatEncoder *encoder, Timebase *timebase, uint32_t *var, uint32_t first, uint32_t last)
+{
+    for (uint32_t n = first; n <= last; n++)
+    {
+        if (n > 0)
+        {
+            timebase->step(sparse_entry_time(n) - sparse_entry_time(n - 1));
+        }
+        *var = n;
+        encoder->encode_next_entry();
+    }
+}
+
+TEST_F(TestRawEncoder, SparseTimeMarks)
+{
+    Timebase timebase;
+    uint32_t var1 = 0;
+
+    // 4 bytes per entry, no time stored. 32 entries fit in the buffer
+    dlconfig.items_count = 1;
+    dlconfig.items_to_log[0].type = datalogging::LoggableType::MEMORY;
+    dlconfig.items_to_log[0].data.memory.size = sizeof(var1);
+    dlconfig.items_to_log[0].data.memory.address = &var1;
+    dlconfig.time_axis = datalogging::TimeAxis::Sparse;
+    dlconfig.time_mark_interval = 10;
+    dlconfig.time_mark_tolerance_100ns = 0;
+
+    encoder.init(&scrutiny_handler, &timebase, &dlconfig, dlbuffer, sizeof(dlbuffer));
+    ASSERT_FALSE(encoder.error());
+    ASSERT_EQ(encoder.get_buffer_effective_size(), sizeof(dlbuffer));
+    timebase.reset();
+
+    datalogging::buffer_size_t entry_index;
+    timestamp_t timestamp;
+
+    // Marks on the first entry, every 10 entries, on both sides of the step change and on the newest entry
+    write_sparse_entries(&encoder, &timebase, &var1, 0, 19);
+    uint32_t const expected_marks1[] = {0, 10, 12, 13, 19};
+    ASSERT_EQ(encoder.get_time_mark_count(0), sizeof(expected_marks1) / sizeof(expected_marks1[0]));
+    for (uint16_t i = 0; i < encoder.get_time_mark_count(0); i++)
+    {
+        ASSERT_TRUE(encoder.get_time_mark(0, i, &entry_index, &timestamp));
+        EXPECT_EQ(entry_index, expected_marks1[i]) << "i=" << i;
+        EXPECT_EQ(timestamp, sparse_entry_time(expected_marks1[i])) << "i=" << i;
+    }
+    EXPECT_FALSE(encoder.get_time_mark(0, encoder.get_time_mark_count(0), &entry_index, &timestamp));
+
+    // After the buffer wraps, entries 14 to 45 remain. Marks of the overwritten entries are dropped, the oldest entry
+    // gets a mark interpolated from the last overwritten one and the entry indexes are relative to the oldest entry.
+    write_sparse_entries(&encoder, &timebase, &var1, 20, 45);
+    uint32_t const expected_marks2[] = {14, 20, 30, 40, 45};
+    ASSERT_EQ(encoder.get_entry_count(), 32u);
+    ASSERT_EQ(encoder.get_time_mark_count(0), sizeof(expected_marks2) / sizeof(expected_marks2[0]));
+    for (uint16_t i = 0; i < encoder.get_time_mark_count(0); i++)
+    {
+        ASSERT_TRUE(encoder.get_time_mark(0, i, &entry_index, &timestamp));
+        EXPECT_EQ(entry_index, expected_marks2[i] - 14) << "i=" << i;
+        EXPECT_EQ(timestamp, sparse_entry_time(expected_marks2[i])) << "i=" << i;
+    }
+
+    check_canaries();
+}
+
+TEST_F(TestRawEncoder, SparseTimeMarksWrapWithoutInterval)
+{
+    Timebase timebase;
+    uint32_t var1 = 0;
+
+    dlconfig.items_count = 1;
+    dlconfig.items_to_log[0].type = datalogging::LoggableType::MEMORY;
+    dlconfig.items_to_log[0].data.memory.size = sizeof(var1);
+    dlconfig.items_to_log[0].data.memory.address = &var1;
+    dlconfig.time_axis = datalogging::TimeAxis::Sparse;
+    dlconfig.time_mark_interval = 0;
+    dlconfig.time_mark_tolerance_100ns = 0;
+
+    encoder.init(&scrutiny_handler, &timebase, &dlconfig, dlbuffer, sizeof(dlbuffer));
+    ASSERT_FALSE(encoder.error());
+    timebase.reset();
+
+    datalogging::buffer_size_t entry_index;
+    timestamp_t timestamp;
+
+    // Only the first entry and the step change are marked. Once entries 0 to 13 are overwritten,
+    // the oldest entry still gets its time, from the mark on entry 13
+    write_sparse_entries(&encoder, &timebase, &var1, 0, 45);
+    ASSERT_EQ(encoder.get_entry_count(), 32u);
+    ASSERT_EQ(encoder.get_time_mark_count(0), 2u);
+    ASSERT_TRUE(encoder.get_time_mark(0, 0, &entry_index, &timestamp));
+    EXPECT_EQ(entry_index, 0u);
+    EXPECT_EQ(timestamp, sparse_entry_time(14));
+    ASSERT_TRUE(encoder.get_time_mark(0, 1, &entry_index, &timestamp));
+    EXPECT_EQ(entry_index, 31u);
+    EXPECT_EQ(timestamp, sparse_entry_time(45));
+
+    // Same once all the marks are overwritten: the time step is constant since the last one
+    write_sparse_entries(&encoder, &timebase, &var1, 46, 100);
+    ASSERT_EQ(encoder.get_time_mark_count(0), 2u);
+    ASSERT_TRUE(encoder.get_time_mark(0, 0, &entry_index, &timestamp));
+    EXPECT_EQ(entry_index, 0u);
+    EXPECT_EQ(timestamp, sparse_entry_time(69));
+    ASSERT_TRUE(encoder.get_time_mark(0, 1, &entry_index, &timestamp));
+    EXPECT_EQ(entry_index, 31u);
+    EXPECT_EQ(timestamp, sparse_entry_time(100));
+
+    // No marks are kept when the time is logged with TIME items
+    dlconfig.time_axis = datalogging::TimeAxis::Logged;
+    encoder.reset();
+    timebase.reset();
+    write_sparse_entries(&encoder, &timebase, &var1, 0, 5);
+    EXPECT_EQ(encoder.get_time_mark_count(0), 0u);
+
+    check_canaries();
+}
+
 #endif
\ No newline at end of file
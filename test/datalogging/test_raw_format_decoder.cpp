@@ -0,0 +1,243 @@
+//    test_raw_format_decoder.cpp
+//        Test suite for the host side decoder of the RawFormat acquisitions.
+//
+//   - License : MIT - See LICENSE file.
+//   - Project : Scrutiny Debugger (github.com/scrutinydebugger/scrutiny-embedded)
+//
+//   Copyright (c) 2021 Scrutiny Debugger
+
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "scrutiny_test.hpp"
+#include "scrutiny.hpp"
+#include "scrutiny_raw_format_decoder.hpp"
+
+#if SCRUTINY_DATALOGGING_ENCODING == SCRUTINY_DATALOGGING_ENCODING_RAW
+
+using namespace scrutiny;
+
+static uint32_t g_entry_number = 0;
+
+static bool rpv_read_callback(RuntimePublishedValue rpv, AnyType *outval)
+{
+    if (rpv.id == 0x2000 && rpv.type == VariableType::float32)
+    {
+        outval->float32 = static_cast<float>(g_entry_number) * 0.5f;
+    }
+    else if (rpv.id == 0x2001 && rpv.type == VariableType::sint16)
+    {
+        outval->sint16 = static_cast<int16_t>(-3 * static_cast<int32_t>(g_entry_number));
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+class TestRawFormatDecoder : public ScrutinyTest
+{
+protected:
+    void acquire(void);
+    std::vector<uint8_t> read_acquisition(datalogging::ReadLayout const layout);
+    void feed_by_chunks(std::vector<uint8_t> const &data, uint32_t const chunk_size);
+    void check_decoded(void);
+
+    MainHandler scrutiny_handler;
+    Config config;
+    datalogging::Configuration dlconfig;
+    datalogging::RawFormatEncoder encoder;
+    decoder::RawFormatDecoder raw_decoder;
+    RuntimePublishedValue rpvs[2] = {
+        {0x2000, VariableType::float32},
+        {0x2001, VariableType::sint16}};
+
+    uint16_t var16;
+    uint8_t flags;
+    uint16_t word;
+
+    uint8_t _rx_buffer[128];
+    uint8_t _tx_buffer[128];
+    uint8_t dlbuffer[256];
+
+    TestRawFormatDecoder() : ScrutinyTest(),
+                             scrutiny_handler{},
+                             config{},
+                             dlconfig{},
+                             encoder{},
+                             raw_decoder{},
+                             var16{0},
+                             flags{0},
+                             word{0},
+                             _rx_buffer{},
+                             _tx_buffer{},
+                             dlbuffer{}
+    {
+    }
+
+    virtual void SetUp()
+    {
+        config.set_buffers(_rx_buffer, sizeof(_rx_buffer), _tx_buffer, sizeof(_tx_buffer));
+        config.set_published_values(rpvs, sizeof(rpvs) / sizeof(rpvs[0]), rpv_read_callback);
+        scrutiny_handler.init(&config);
+
+        // TIME, RPV, MEMORY, VARBIT x2 (packed together), RPV. 14 bytes per entry
+        dlconfig.items_count = 6;
+        dlconfig.items_to_log[0].type = datalogging::LoggableType::TIME;
+        dlconfig.items_to_log[1].type = datalogging::LoggableType::RPV;
+        dlconfig.items_to_log[1].data.rpv.id = 0x2000;
+        dlconfig.items_to_log[2].type = datalogging::LoggableType::MEMORY;
+        dlconfig.items_to_log[2].data.memory.address = &var16;
+        dlconfig.items_to_log[2].data.memory.size = sizeof(var16);
+        dlconfig.items_to_log[3].type = datalogging::LoggableType::VARBIT;
+        dlconfig.items_to_log[3].data.varbit.addr = &flags;
+        dlconfig.items_to_log[3].data.varbit.datatype = VariableType::uint8;
+        dlconfig.items_to_log[3].data.varbit.bitoffset = 0;
+        dlconfig.items_to_log[3].data.varbit.bitsize = 3;
+        dlconfig.items_to_log[4].type = datalogging::LoggableType::VARBIT;
+        dlconfig.items_to_log[4].data.varbit.addr = &word;
+        dlconfig.items_to_log[4].data.varbit.datatype = VariableType::uint16;
+        dlconfig.items_to_log[4].data.varbit.bitoffset = 0;
+        dlconfig.items_to_log[4].data.varbit.bitsize = 11;
+        dlconfig.items_to_log[5].type = datalogging::LoggableType::RPV;
+        dlconfig.items_to_log[5].data.rpv.id = 0x2001;
+
+        // Normally done by the datalogger
+        tools::make_bitfield_descriptor(VariableTypeType::_uint, 0, 3, &dlconfig.items_to_log[3].data.varbit.descriptor);
+        tools::make_bitfield_descriptor(VariableTypeType::_uint, 0, 11, &dlconfig.items_to_log[4].data.varbit.descriptor);
+    }
+};
+
+/// @brief Logs entries 0 to 24 in a buffer that holds 18 of them. Entries 7 to 24 remain
+void TestRawFormatDecoder::acquire(void)
+{
+    Timebase timebase;
+    encoder.init(&scrutiny_handler, &timebase, &dlconfig, dlbuffer, sizeof(dlbuffer));
+    ASSERT_FALSE(encoder.error());
+    timebase.reset();
+    for (g_entry_number = 0; g_entry_number < 25; g_entry_number++)
+    {
+        timebase.step(100);
+        var16 = static_cast<uint16_t>(0x100 + g_entry_number);
+        flags = static_cast<uint8_t>(0xF8 | (g_entry_number & 0x7));
+        word = static_cast<uint16_t>(0xF800 | ((g_entry_number * 37) & 0x7FF));
+        encoder.encode_next_entry();
+    }
+    ASSERT_EQ(encoder.get_entry_count(), 18u);
+}
+
+/// @brief Reads the acquisition like the ReadAcquisition requests do
+std::vector<uint8_t> TestRawFormatDecoder::read_acquisition(datalogging::ReadLayout const layout)
+{
+    datalogging::RawFormatReader *const reader = encoder.get_reader();
+    reader->set_layout(layout);
+    std::vector<uint8_t> data(reader->get_total_size());
+    reader->read(data.data(), static_cast<datalogging::buffer_size_t>(data.size()));
+    return data;
+}
+
+void TestRawFormatDecoder::feed_by_chunks(std::vector<uint8_t> const &data, uint32_t const chunk_size)
+{
+    for (uint32_t cursor = 0; cursor < data.size(); cursor += chunk_size)
+    {
+        uint32_t const len = SCRUTINY_MIN(chunk_size, static_cast<uint32_t>(data.size()) - cursor);
+        ASSERT_TRUE(raw_decoder.feed(&data[cursor], len)) << "cursor=" << cursor;
+    }
+}
+
+void TestRawFormatDecoder::check_decoded(void)
+{
+    ASSERT_TRUE(raw_decoder.complete());
+    ASSERT_EQ(raw_decoder.entry_count(), 18u);
+    ASSERT_EQ(raw_decoder.signal_count(), 6u);
+    for (uint16_t i = 0; i < raw_decoder.signal_count(); i++)
+    {
+        ASSERT_EQ(raw_decoder.signal(i)->count(), 18u) << "i=" << i;
+    }
+
+    EXPECT_EQ(raw_decoder.signal(0)->type(), VariableType::uint32);
+    EXPECT_EQ(raw_decoder.signal(1)->type(), VariableType::float32);
+    EXPECT_EQ(raw_decoder.signal(2)->type(), VariableType::unknown);
+    EXPECT_EQ(raw_decoder.signal(3)->type(), VariableType::uint8);
+    EXPECT_EQ(raw_decoder.signal(4)->type(), VariableType::uint16);
+    EXPECT_EQ(raw_decoder.signal(5)->type(), VariableType::sint16);
+
+    for (uint32_t i = 0; i < 18; i++)
+    {
+        uint32_t const n = i + 7;
+        EXPECT_EQ(raw_decoder.signal(0)->values<uint32_t>()[i], 100 * (n + 1)) << "i=" << i;
+        EXPECT_EQ(raw_decoder.signal(1)->values<float>()[i], static_cast<float>(n) * 0.5f) << "i=" << i;
+        EXPECT_EQ(raw_decoder.signal(2)->values<uint16_t>()[i], 0x100 + n) << "i=" << i; // Memory copied as is. Same byte order as the host
+        EXPECT_EQ(raw_decoder.signal(3)->values<uint8_t>()[i], n & 0x7) << "i=" << i;
+        EXPECT_EQ(raw_decoder.signal(4)->values<uint16_t>()[i], (n * 37) & 0x7FF) << "i=" << i;
+        EXPECT_EQ(raw_decoder.signal(5)->values<int16_t>()[i], -3 * static_cast<int32_t>(n)) << "i=" << i;
+    }
+}
+
+TEST_F(TestRawFormatDecoder, DecodeRows)
+{
+    acquire();
+    ASSERT_TRUE(raw_decoder.configure(&dlconfig, rpvs, sizeof(rpvs) / sizeof(rpvs[0])));
+    ASSERT_EQ(raw_decoder.entry_size(), 14u);
+    std::vector<uint8_t> const data = read_acquisition(datalogging::ReadLayout::Rows);
+
+    // Chunks that cut the entries at every possible place, without knowing the entry count
+    raw_decoder.start(datalogging::ReadLayout::Rows);
+    feed_by_chunks(data, 5);
+    check_decoded();
+
+    // The whole acquisition at once
+    raw_decoder.start(datalogging::ReadLayout::Rows, 18);
+    feed_by_chunks(data, static_cast<uint32_t>(data.size()));
+    check_decoded();
+
+    // Incomplete entry, then more data than expected
+    raw_decoder.start(datalogging::ReadLayout::Rows, 18);
+    ASSERT_TRUE(raw_decoder.feed(data.data(), 20));
+    EXPECT_EQ(raw_decoder.entry_count(), 1u);
+    EXPECT_FALSE(raw_decoder.complete());
+    ASSERT_TRUE(raw_decoder.feed(data.data(), static_cast<uint32_t>(data.size()) - 20));
+    EXPECT_FALSE(raw_decoder.feed(data.data(), 1));
+    EXPECT_TRUE(raw_decoder.error());
+}
+
+TEST_F(TestRawFormatDecoder, DecodeColumns)
+{
+    acquire();
+    ASSERT_TRUE(raw_decoder.configure(&dlconfig, rpvs, sizeof(rpvs) / sizeof(rpvs[0])));
+    std::vector<uint8_t> const data = read_acquisition(datalogging::ReadLayout::Columns);
+
+    raw_decoder.start(datalogging::ReadLayout::Columns, 18);
+    feed_by_chunks(data, 3);
+    check_decoded();
+
+    raw_decoder.start(datalogging::ReadLayout::Columns, 18);
+    feed_by_chunks(data, static_cast<uint32_t>(data.size()));
+    check_decoded();
+    EXPECT_FALSE(raw_decoder.feed(data.data(), 1));
+    EXPECT_TRUE(raw_decoder.error());
+}
+
+TEST_F(TestRawFormatDecoder, BadConfiguration)
+{
+    // Type of the RPV unknown
+    EXPECT_FALSE(raw_decoder.configure(&dlconfig, rpvs, 1));
+    EXPECT_TRUE(raw_decoder.error());
+
+    // Nothing to decode
+    dlconfig.items_count = 0;
+    EXPECT_FALSE(raw_decoder.configure(&dlconfig, rpvs, sizeof(rpvs) / sizeof(rpvs[0])));
+
+    dlconfig.items_count = 1;
+    dlconfig.items_to_log[0].type = datalogging::LoggableType::VARBIT;
+    dlconfig.items_to_log[0].data.varbit.bitsize = 0;
+    EXPECT_FALSE(raw_decoder.configure(&dlconfig, rpvs, sizeof(rpvs) / sizeof(rpvs[0])));
+
+    dlconfig.items_to_log[0].data.varbit.bitsize = 4;
+    EXPECT_TRUE(raw_decoder.configure(&dlconfig, rpvs, sizeof(rpvs) / sizeof(rpvs[0])));
+    EXPECT_FALSE(raw_decoder.error());
+}
+
+#endif
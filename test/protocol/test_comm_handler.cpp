@@ -133,4 +133,333 @@ TEST_F(TestCommHandler, TestConnectDisconnectBehaviour)
     comm.connect();
     comm.receive_data(&dummy_request[sizeof(dummy_request) - 1], 1);
     EXPECT_FALSE(comm.request_received());
-}
\ No newline at end of file
+}
+
+TEST_F(TestCommHandler, TestDatagramModeReceive)
+{
+    comm.set_datagram_mode(64);
+    ASSERT_TRUE(comm.is_enabled());
+    comm.connect();
+
+    uint8_t request[12] = {1, 2, 0, 4, 0xAA, 0xBB, 0xCC, 0xDD};
+    add_crc(request, 8);
+
+    // A datagram that does not hold exactly one frame is dropped. No partial state is kept.
+    comm.receive_data(request, 10);
+    EXPECT_FALSE(comm.request_received());
+    comm.receive_data(&request[10], 2);
+    EXPECT_FALSE(comm.request_received());
+
+    comm.receive_data(request, sizeof(request));
+    ASSERT_TRUE(comm.request_received());
+    scrutiny::protocol::Request const *req = comm.get_request();
+    EXPECT_EQ(req->command_id, 1);
+    EXPECT_EQ(req->subfunction_id, 2);
+    ASSERT_EQ(req->data_length, 4);
+    EXPECT_BUF_EQ(req->data, &request[4], 4);
+    comm.wait_next_request();
+
+    request[11] ^= 0xFF; // Bad CRC
+    comm.receive_data(request, sizeof(request));
+    EXPECT_FALSE(comm.request_received());
+
+    comm.set_datagram_mode(64, false); // Integrity is guaranteed by the transport
+    comm.connect();
+    comm.receive_data(request, sizeof(request));
+    EXPECT_TRUE(comm.request_received());
+}
+
+TEST_F(TestCommHandler, TestDatagramModeSendsWholeFrames)
+{
+    uint8_t buf[256];
+    comm.set_datagram_mode(64);
+    ASSERT_TRUE(comm.is_enabled());
+    EXPECT_EQ(comm.tx_buffer_size(), 64u - scrutiny::protocol::RESPONSE_OVERHEAD);
+
+    response.command_id = 0x01;
+    response.subfunction_id = 0x02;
+    response.response_code = 0;
+    response.data_length = static_cast<uint16_t>(comm.tx_buffer_size() + 1);
+    EXPECT_FALSE(comm.send_response(&response)); // Would not fit in the MTU
+
+    response.data_length = static_cast<uint16_t>(comm.tx_buffer_size());
+    memset(response.data, 0x55, response.data_length);
+    ASSERT_TRUE(comm.send_response(&response));
+    uint16_t const frame_size = comm.data_to_send();
+    EXPECT_EQ(frame_size, 64u);
+
+    EXPECT_EQ(comm.pop_data(buf, frame_size - 1), 0u); // Never split
+    EXPECT_EQ(comm.data_to_send(), frame_size);
+    EXPECT_EQ(comm.pop_data(buf, sizeof(buf)), frame_size);
+    EXPECT_FALSE(comm.transmitting());
+
+    uint8_t expected_header[5] = {0x81, 2, 0, 0, static_cast<uint8_t>(frame_size - scrutiny::protocol::RESPONSE_OVERHEAD)};
+    EXPECT_BUF_EQ(buf, expected_header, sizeof(expected_header));
+    EXPECT_BUF_SET(&buf[5], 0x55, frame_size - scrutiny::protocol::RESPONSE_OVERHEAD);
+
+    comm.set_datagram_mode(8); // Responses could not fit
+    EXPECT_FALSE(comm.is_enabled());
+}
+
+TEST_F(TestCommHandler, TestCobsFraming)
+{
+    // Big buffers to have blocks of more than 254 bytes without zero
+    static uint8_t rx_buffer[600];
+    static uint8_t tx_buffer[600];
+    static uint8_t raw[700];
+    static uint8_t encoded[800];
+    static uint8_t decoded[800];
+    comm.init(rx_buffer, sizeof(rx_buffer), tx_buffer, sizeof(tx_buffer), &tb);
+    comm.connect();
+
+    // The framing changes once the response that acknowledges it is sent
+    ASSERT_TRUE(comm.set_framing_after_response(scrutiny::protocol::CommControl::Framing::COBS));
+    response.command_id = 2;
+    response.subfunction_id = 4;
+    response.response_code = 0;
+    response.data_length = 0;
+    ASSERT_TRUE(comm.send_response(&response));
+    EXPECT_EQ(comm.get_framing(), scrutiny::protocol::CommControl::Framing::Raw);
+    comm.pop_data(decoded, comm.data_to_send());
+    EXPECT_EQ(comm.get_framing(), scrutiny::protocol::CommControl::Framing::COBS);
+
+    // Request with zeros and a long run without zero, received byte per byte
+    uint16_t const request_data_length = 520;
+    raw[0] = 1;
+    raw[1] = 2;
+    raw[2] = request_data_length >> 8;
+    raw[3] = request_data_length & 0xFF;
+    for (uint16_t i = 0; i < request_data_length; i++)
+    {
+        raw[4 + i] = (i < 300) ? static_cast<uint8_t>(i % 255 + 1) : static_cast<uint8_t>(i % 3 == 0 ? 0 : i);
+    }
+    add_crc(raw, 4 + request_data_length);
+    uint32_t const encoded_size = cobs_encode(raw, 8 + request_data_length, encoded);
+    for (uint32_t i = 0; i < encoded_size; i++)
+    {
+        comm.receive_data(&encoded[i], 1);
+    }
+    ASSERT_TRUE(comm.request_received());
+    ASSERT_EQ(comm.get_request()->data_length, request_data_length);
+    EXPECT_BUF_EQ(comm.get_request()->data, &raw[4], request_data_length);
+    comm.wait_next_request();
+
+    // Response read by small chunks must decode to the raw frame
+    response.command_id = 1;
+    response.subfunction_id = 2;
+    response.data_length = 510;
+    response.data = &raw[4];
+    ASSERT_TRUE(comm.send_response(&response)) << static_cast<int>(comm.get_tx_error());
+    uint16_t const response_size = comm.data_to_send();
+    uint32_t nread = 0;
+    while (comm.data_to_send() > 0)
+    {
+        nread += comm.pop_data(&encoded[nread], 7);
+    }
+    ASSERT_EQ(nread, response_size);
+    EXPECT_EQ(encoded[nread - 1], 0);
+    for (uint32_t i = 0; i < nread - 1; i++)
+    {
+        ASSERT_NE(encoded[i], 0) << "i=" << i;
+    }
+
+    uint8_t expected[9 + 510] = {0x81, 2, 0, 510 >> 8, 510 & 0xFF};
+    memcpy(&expected[5], &raw[4], 510);
+    add_crc(expected, 5 + 510);
+    ASSERT_EQ(cobs_decode(encoded, nread, decoded), sizeof(expected));
+    EXPECT_BUF_EQ(decoded, expected, sizeof(expected));
+}
+
+TEST_F(TestCommHandler, TestCobsResyncOnDelimiter)
+{
+    uint8_t encoded[32];
+    uint8_t dummy[16];
+    comm.connect();
+    ASSERT_TRUE(comm.set_framing_after_response(scrutiny::protocol::CommControl::Framing::COBS));
+    response.command_id = 2;
+    response.data_length = 0;
+    ASSERT_TRUE(comm.send_response(&response));
+    comm.pop_data(dummy, sizeof(dummy));
+
+    uint8_t request[12] = {1, 2, 0, 4, 0x11, 0x00, 0x22, 0x33};
+    add_crc(request, 8);
+    uint32_t const encoded_size = cobs_encode(request, sizeof(request), encoded);
+
+    // Dropped byte: the frame is discarded at its delimiter and the next frame is received with no timeout
+    uint8_t damaged[32];
+    memcpy(damaged, encoded, 3);
+    memcpy(&damaged[3], &encoded[4], encoded_size - 4);
+    comm.receive_data(damaged, static_cast<uint16_t>(encoded_size - 1));
+    EXPECT_FALSE(comm.request_received());
+    comm.receive_data(encoded, static_cast<uint16_t>(encoded_size));
+    ASSERT_TRUE(comm.request_received());
+    EXPECT_BUF_EQ(comm.get_request()->data, &request[4], 4);
+    comm.wait_next_request();
+
+    // Corrupted byte making the length field invalid
+    memcpy(damaged, encoded, encoded_size);
+    damaged[3] = 0xFF;
+    comm.receive_data(damaged, static_cast<uint16_t>(encoded_size));
+    EXPECT_FALSE(comm.request_received());
+    comm.receive_data(encoded, static_cast<uint16_t>(encoded_size));
+    EXPECT_TRUE(comm.request_received());
+
+    comm.disconnect(); // Back to raw framing for the next session
+    EXPECT_EQ(comm.get_framing(), scrutiny::protocol::CommControl::Framing::Raw);
+}
+
+class IncrementalSource : public scrutiny::protocol::ResponseSource
+{
+public:
+    IncrementalSource(void) : m_position(0), m_fail_at(0xFFFFFFFF) {}
+
+    virtual bool read(uint8_t *const buffer, uint16_t const len) override
+    {
+        for (uint16_t i = 0; i < len; i++)
+        {
+            buffer[i] = static_cast<uint8_t>(m_position++ & 0xFFu);
+        }
+        return m_position <= m_fail_at;
+    }
+
+    uint32_t m_position; // Number of bytes produced so far
+    uint32_t m_fail_at;  // The read that goes past this position fails
+};
+
+TEST_F(TestCommHandler, TestStreamedResponse)
+{
+    uint8_t buf[512];
+    uint8_t expected[9 + 300];
+    IncrementalSource source;
+
+    response.command_id = 3;
+    response.subfunction_id = 1;
+    response.response_code = 0;
+    response.data_length = 300; // Bigger than the transmission buffer
+    EXPECT_FALSE(comm.send_response(&response));
+    ASSERT_TRUE(comm.send_streamed_response(&response, &source));
+    EXPECT_EQ(comm.data_to_send(), sizeof(expected));
+
+    uint16_t index = 0;
+    while (comm.transmitting())
+    {
+        index += comm.pop_data(&buf[index], 7);
+    }
+    EXPECT_EQ(index, sizeof(expected));
+    EXPECT_EQ(source.m_position, 300u);
+
+    expected[0] = 0x83;
+    expected[1] = 1;
+    expected[2] = 0;
+    expected[3] = 300 >> 8;
+    expected[4] = 300 & 0xFF;
+    fill_buffer_incremental(&expected[5], 300);
+    add_crc(expected, sizeof(expected) - 4);
+    EXPECT_BUF_EQ(buf, expected, sizeof(expected));
+
+    // A source that fails after the header is out makes the CRC invalid
+    source.m_position = 0;
+    source.m_fail_at = 100;
+    ASSERT_TRUE(comm.send_streamed_response(&response, &source));
+    EXPECT_EQ(comm.pop_data(buf, sizeof(buf)), sizeof(expected));
+    EXPECT_BUF_EQ(buf, expected, 5);
+    EXPECT_FALSE(COMPARE_BUF(&buf[sizeof(expected) - 4], &expected[sizeof(expected) - 4], 4));
+}
+
+TEST_F(TestCommHandler, TestStreamedResponseLimits)
+{
+    IncrementalSource source;
+    response.command_id = 3;
+    response.data_length = 100;
+
+    comm.connect();
+    ASSERT_TRUE(comm.set_framing_after_response(scrutiny::protocol::CommControl::Framing::COBS));
+    ASSERT_TRUE(comm.send_response(&response));
+    uint8_t buf[256];
+    comm.pop_data(buf, sizeof(buf));
+    EXPECT_EQ(comm.max_streamed_data_size(), 0u); // The COBS encoder must see the whole frame
+    EXPECT_FALSE(comm.send_streamed_response(&response, &source));
+    EXPECT_EQ(comm.get_tx_error(), scrutiny::protocol::TxError::Overflow);
+    comm.disconnect();
+
+    comm.set_datagram_mode(64);
+    EXPECT_EQ(comm.max_streamed_data_size(), 64u - scrutiny::protocol::RESPONSE_OVERHEAD);
+    response.data_length = comm.max_streamed_data_size() + 1;
+    EXPECT_FALSE(comm.send_streamed_response(&response, &source));
+}
+
+class RecordingSink : public scrutiny::protocol::RequestSink
+{
+public:
+    RecordingSink(void) : m_accept(true), m_length(0), m_begin_count(0), m_release_count(0) {}
+
+    virtual bool begin(uint8_t const command_id, uint8_t const subfunction_id, uint16_t const data_length) override
+    {
+        static_cast<void>(command_id);
+        static_cast<void>(subfunction_id);
+        static_cast<void>(data_length);
+        m_begin_count++;
+        m_length = 0;
+        return m_accept;
+    }
+
+    virtual void write(uint8_t const *const data, uint16_t const len) override
+    {
+        std::memcpy(&m_data[m_length], data, len);
+        m_length += len;
+    }
+
+    virtual void release(void) override { m_release_count++; }
+
+    bool m_accept;            // Return value of begin()
+    uint8_t m_data[512];      // Payload received so far
+    uint16_t m_length;        // Number of payload bytes received so far
+    uint32_t m_begin_count;   // Number of calls to begin()
+    uint32_t m_release_count; // Number of calls to release()
+};
+
+TEST_F(TestCommHandler, TestStreamedRequest)
+{
+    uint8_t request[4 + 300 + 4] = {3, 2, 0x01, 0x2C}; // Payload bigger than the reception buffer
+    fill_buffer_incremental(&request[4], 300);
+    add_crc(request, 4 + 300);
+    RecordingSink sink;
+    comm.set_request_sink(&sink);
+
+    comm.receive_data(request, sizeof(request));
+    EXPECT_FALSE(comm.request_received()); // No session
+    EXPECT_EQ(sink.m_begin_count, 0u);
+    EXPECT_EQ(comm.get_rx_error(), scrutiny::protocol::RxError::Overflow);
+
+    comm.reset();
+    comm.connect();
+    for (uint16_t i = 0; i < sizeof(request); i += 50) // Many chunks
+    {
+        uint16_t const remaining = static_cast<uint16_t>(sizeof(request) - i);
+        comm.receive_data(&request[i], (remaining < 50) ? remaining : 50);
+    }
+    ASSERT_TRUE(comm.request_received());
+    EXPECT_TRUE(comm.request_streamed());
+    EXPECT_EQ(comm.get_request()->data_length, 300u);
+    EXPECT_EQ(sink.m_length, 300u);
+    EXPECT_BUF_EQ(sink.m_data, &request[4], 300);
+    EXPECT_EQ(sink.m_release_count, 0u); // The payload is needed until the request is processed
+    comm.wait_next_request();
+    EXPECT_EQ(sink.m_release_count, 1u);
+    EXPECT_FALSE(comm.request_streamed());
+
+    // Bad CRC. The request is dropped and the sink released right away
+    request[sizeof(request) - 1] ^= 0xFF;
+    comm.receive_data(request, sizeof(request));
+    EXPECT_FALSE(comm.request_received());
+    EXPECT_EQ(sink.m_begin_count, 2u);
+    EXPECT_EQ(sink.m_release_count, 2u);
+    request[sizeof(request) - 1] ^= 0xFF;
+
+    // Refused by the sink
+    sink.m_accept = false;
+    comm.receive_data(request, sizeof(request));
+    EXPECT_FALSE(comm.request_received());
+    EXPECT_EQ(comm.get_rx_error(), scrutiny::protocol::RxError::Overflow);
+    EXPECT_EQ(sink.m_release_count, 2u);
+}
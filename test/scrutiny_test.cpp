@@ -35,6 +35,55 @@ void ScrutinyTest::add_crc(scrutiny::protocol::Response *response)
     response->crc = scrutiny::tools::crc32(response->data, response->data_length, crc);
 }
 
+uint32_t ScrutinyTest::cobs_encode(uint8_t const *data, uint32_t len, uint8_t *out)
+{
+    uint32_t code_pos = 0;
+    uint32_t n = 1;
+    uint8_t code = 1;
+    for (uint32_t i = 0; i < len; i++)
+    {
+        if (data[i] == 0)
+        {
+            out[code_pos] = code;
+            code_pos = n++;
+            code = 1;
+        }
+        else
+        {
+            out[n++] = data[i];
+            code++;
+            if (code == 0xFF && i + 1 < len)
+            {
+                out[code_pos] = code;
+                code_pos = n++;
+                code = 1;
+            }
+        }
+    }
+    out[code_pos] = code;
+    out[n++] = 0;
+    return n;
+}
+
+uint32_t ScrutinyTest::cobs_decode(uint8_t const *data, uint32_t len, uint8_t *out)
+{
+    uint32_t i = 0;
+    uint32_t n = 0;
+    while (i < len && data[i] != 0)
+    {
+        uint8_t const code = data[i++];
+        for (uint8_t k = 1; k < code && i < len; k++)
+        {
+            out[n++] = data[i++];
+        }
+        if (code != 0xFF && i < len && data[i] != 0)
+        {
+            out[n++] = 0;
+        }
+    }
+    return n;
+}
+
 void ScrutinyTest::fill_buffer_incremental(uint8_t *buffer, uint32_t length)
 {
     for (uint32_t i = 0; i < length; i++)
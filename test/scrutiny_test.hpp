@@ -26,6 +26,8 @@ protected:
     void add_crc(scrutiny::protocol::Response *response);
     void fill_buffer_incremental(uint8_t *buffer, uint32_t length);
     unsigned int encode_addr(uint8_t *buffer, void *addr);
+    uint32_t cobs_encode(uint8_t const *data, uint32_t len, uint8_t *out); // Includes the trailing delimiter
+    uint32_t cobs_decode(uint8_t const *data, uint32_t len, uint8_t *out); // Decodes up to the first delimiter
 
     ::testing::AssertionResult COMPARE_BUF(uint8_t const *candidate, uint8_t const *expected, uint32_t const size);
     ::testing::AssertionResult CHECK_SET(uint8_t const *buffer, uint8_t const val, uint32_t const size);
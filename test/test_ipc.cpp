@@ -139,4 +139,128 @@ TEST(TestIPC, CheckWithThread)
 
     EXPECT_FALSE(thread_data.error_found_in_main) << "At Iteration #" << thread_data.error_at_iter;
     EXPECT_FALSE(thread_data.error_found_in_thread) << "At Iteration #" << thread_data.error_at_iter;
-}
\ No newline at end of file
+}
+TEST(TestIPC, Ticket)
+{
+    scrutiny::IPCTicket ticket;
+    EXPECT_FALSE(ticket.redeem(0));
+
+    uint16_t const first = ticket.issue();
+    EXPECT_NE(first, 0u);
+    EXPECT_TRUE(ticket.redeem(first));
+    EXPECT_FALSE(ticket.redeem(first)); // Only once
+
+    // A newer number makes the older ones impossible to redeem
+    uint16_t const second = ticket.issue();
+    uint16_t const third = ticket.issue();
+    EXPECT_FALSE(ticket.redeem(second));
+    ticket.revoke();
+    EXPECT_FALSE(ticket.redeem(third));
+}
+
+TEST(TestIPC, ByteRing)
+{
+    uint8_t storage[8];
+    scrutiny::IPCByteRing ring;
+    ring.init(storage, sizeof(storage));
+    uint8_t const *data = nullptr;
+
+    EXPECT_EQ(ring.available(), 0u);
+    EXPECT_EQ(ring.peek(&data), 0u);
+
+    uint8_t const bytes[10] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    EXPECT_TRUE(ring.push(bytes[0]));
+    EXPECT_EQ(ring.push(&bytes[1], 9), 6u); // Holds 7 bytes. 3 dropped
+    EXPECT_EQ(ring.available(), 7u);
+    EXPECT_EQ(ring.dropped_count(), 3u);
+    EXPECT_FALSE(ring.push(0xFF));
+    EXPECT_EQ(ring.dropped_count(), 4u);
+
+    ASSERT_EQ(ring.peek(&data), 7u);
+    EXPECT_EQ(data[0], 1u);
+    EXPECT_EQ(data[6], 7u);
+    ring.release(5);
+    EXPECT_EQ(ring.available(), 2u);
+
+    // Wraps around. The oldest bytes are given in 2 chunks
+    EXPECT_EQ(ring.push(&bytes[7], 3), 3u);
+    EXPECT_EQ(ring.available(), 5u);
+    ASSERT_EQ(ring.peek(&data), 3u);
+    EXPECT_EQ(data[0], 6u);
+    EXPECT_EQ(data[1], 7u);
+    EXPECT_EQ(data[2], 8u);
+    ring.release(3);
+    ASSERT_EQ(ring.peek(&data), 2u);
+    EXPECT_EQ(data[0], 9u);
+    EXPECT_EQ(data[1], 10u);
+    ring.release(2);
+    EXPECT_EQ(ring.available(), 0u);
+
+    // No storage
+    scrutiny::IPCByteRing empty_ring;
+    EXPECT_FALSE(empty_ring.push(1));
+    EXPECT_EQ(empty_ring.available(), 0u);
+}
+
+static struct
+{
+    scrutiny::IPCByteRing ring;
+    uint8_t storage[61];
+    uint32_t byte_count;
+} ring_thread_data;
+
+static void ring_producer_func()
+{
+    uint32_t sent = 0;
+    while (sent < ring_thread_data.byte_count)
+    {
+        if (ring_thread_data.ring.push(static_cast<uint8_t>(sent * 7)))
+        {
+            sent++;
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+TEST(TestIPC, ByteRingWithThread)
+{
+    ring_thread_data.byte_count = 200000;
+    ring_thread_data.ring.init(ring_thread_data.storage, sizeof(ring_thread_data.storage));
+
+    std::thread thread(ring_producer_func);
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    uint32_t received = 0;
+    bool error = false;
+    while (received < ring_thread_data.byte_count && !error)
+    {
+        uint8_t const *data = nullptr;
+        uint16_t const len = ring_thread_data.ring.peek(&data);
+        for (uint16_t i = 0; i < len; i++)
+        {
+            if (data[i] != static_cast<uint8_t>((received + i) * 7))
+            {
+                error = true;
+                break;
+            }
+        }
+        ring_thread_data.ring.release(len);
+        received += len;
+        if (len == 0)
+        {
+            std::this_thread::yield();
+        }
+
+        if (std::chrono::high_resolution_clock::now() - t1 > std::chrono::seconds(5))
+        {
+            break;
+        }
+    }
+
+    thread.detach(); // Does not wait for the producer if the consumer failed. It never touches the stack of this test.
+    EXPECT_FALSE(error) << "At byte #" << received;
+    EXPECT_EQ(received, ring_thread_data.byte_count);
+}
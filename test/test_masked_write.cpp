@@ -0,0 +1,89 @@
+//    test_masked_write.cpp
+//        Make sure the word-wide masked write gives the same result as a byte per byte write
+//
+//   - License : MIT - See LICENSE file.
+//   - Project : Scrutiny Debugger (github.com/scrutinydebugger/scrutiny-embedded)
+//
+//   Copyright (c) 2021 Scrutiny Debugger
+
+#include <gtest/gtest.h>
+#include <cstring>
+#include <cstdlib>
+
+#include "scrutiny.hpp"
+#include "scrutiny_test.hpp"
+
+class TestMaskedWrite : public ScrutinyTest
+{
+protected:
+    static constexpr unsigned int MAX_LENGTH = 48;
+    static constexpr unsigned int MARGIN = 16;
+
+    static void reference_write_masked(uint8_t *dst, uint8_t const *data, uint8_t const *mask, uint16_t length)
+    {
+        for (uint16_t i = 0; i < length; i++)
+        {
+            uint8_t temp = dst[i];
+            temp |= (data[i] & mask[i]);    // Bit to 1
+            temp &= (data[i] | (~mask[i])); // Bit to 0
+            dst[i] = temp;
+        }
+    }
+
+    static void fill_random(uint8_t *buffer, unsigned int size)
+    {
+        for (unsigned int i = 0; i < size; i++)
+        {
+            buffer[i] = static_cast<uint8_t>(rand());
+        }
+    }
+};
+
+TEST_F(TestMaskedWrite, TestEquivalenceAllAlignments)
+{
+    srand(1234);
+    alignas(16) uint8_t initial[MAX_LENGTH + 2 * MARGIN];
+    alignas(16) uint8_t candidate[MAX_LENGTH + 2 * MARGIN];
+    alignas(16) uint8_t expected[MAX_LENGTH + 2 * MARGIN];
+    uint8_t data[MAX_LENGTH + 1];
+    uint8_t mask[MAX_LENGTH + 1];
+
+    for (unsigned int dst_offset = 0; dst_offset < MARGIN; dst_offset++)
+    {
+        for (unsigned int src_offset = 0; src_offset < 2; src_offset++) // Unaligned data and mask
+        {
+            for (uint16_t length = 0; length <= MAX_LENGTH; length++)
+            {
+                fill_random(initial, sizeof(initial));
+                fill_random(data, sizeof(data));
+                fill_random(mask, sizeof(mask));
+                memcpy(candidate, initial, sizeof(initial));
+                memcpy(expected, initial, sizeof(initial));
+
+                reference_write_masked(&expected[dst_offset], &data[src_offset], &mask[src_offset], length);
+                scrutiny::tools::write_masked(&candidate[dst_offset], &data[src_offset], &mask[src_offset], length);
+
+                ASSERT_BUF_EQ(candidate, expected, sizeof(candidate)) << "dst_offset=" << dst_offset << ", src_offset=" << src_offset << ", length=" << length;
+            }
+        }
+    }
+}
+
+TEST_F(TestMaskedWrite, TestFullAndEmptyMask)
+{
+    alignas(16) uint8_t buffer[20];
+    uint8_t data[20];
+    uint8_t mask[20];
+
+    memset(buffer, 0x5A, sizeof(buffer));
+    memset(data, 0xC3, sizeof(data));
+    memset(mask, 0x00, sizeof(mask));
+    scrutiny::tools::write_masked(&buffer[1], data, mask, 18);
+    EXPECT_BUF_SET(buffer, 0x5A, sizeof(buffer));
+
+    memset(mask, 0xFF, sizeof(mask));
+    scrutiny::tools::write_masked(&buffer[1], data, mask, 18);
+    EXPECT_EQ(buffer[0], 0x5A);
+    EXPECT_BUF_SET(&buffer[1], 0xC3, 18);
+    EXPECT_EQ(buffer[19], 0x5A);
+}
@@ -7,6 +7,8 @@
 //   Copyright (c) 2021 Scrutiny Debugger
 
 #include <cstddef>
+#include <cstdlib>
+#include <cstring>
 #include <gtest/gtest.h>
 #include "scrutiny_test.hpp"
 #include "scrutiny.hpp"
@@ -56,8 +58,131 @@ protected:
 
         scrutiny_handler.init(&config);
     }
+
+    static bool reference_fetch_variable_bitfield(
+        void const *const addr,
+        scrutiny::VariableTypeType const var_tt,
+        uint_fast8_t const bitoffset,
+        uint_fast8_t const bitsize,
+        scrutiny::AnyType *const val,
+        scrutiny::VariableType *const output_type);
 };
 
+// Per-bit mask construction and conditional sign extension. Kept as a reference for the descriptor based extraction
+bool TestVariableFetching::reference_fetch_variable_bitfield(
+    void const *const addr,
+    scrutiny::VariableTypeType const var_tt,
+    uint_fast8_t const bitoffset,
+    uint_fast8_t const bitsize,
+    scrutiny::AnyType *const val,
+    scrutiny::VariableType *const output_type)
+{
+    using scrutiny::VariableTypeSize;
+    using scrutiny::VariableTypeType;
+    namespace tools = scrutiny::tools;
+
+    bool success = true;
+    uint_fast8_t const fetch_required_size = ((bitoffset + bitsize - 1) >> 3) + 1;
+    uint_fast8_t const output_required_size = ((bitsize - 1) >> 3) + 1;
+    VariableTypeSize const fetch_type_size = tools::get_required_type_size(fetch_required_size);
+    VariableTypeSize const output_type_size = tools::get_required_type_size(output_required_size);
+    scrutiny::VariableType const output_variable_type = tools::make_type(var_tt, output_type_size);
+    uint8_t const fetch_size = tools::get_type_size(fetch_type_size);
+
+    if (bitsize == 0 || fetch_size == 0 || fetch_size > sizeof(scrutiny::uint_biggest_t))
+    {
+        success = false;
+    }
+    else if (var_tt == VariableTypeType::_sint || var_tt == VariableTypeType::_uint || var_tt == VariableTypeType::_boolean)
+    {
+        memcpy(val, addr, fetch_size);
+        if (fetch_type_size == VariableTypeSize::_8)
+        {
+            val->uint8 >>= bitoffset;
+        }
+        else if (fetch_type_size == VariableTypeSize::_16)
+        {
+            val->uint16 >>= bitoffset;
+        }
+        else if (fetch_type_size == VariableTypeSize::_32)
+        {
+            val->uint32 >>= bitoffset;
+        }
+#if SCRUTINY_SUPPORT_64BITS
+        else if (fetch_type_size == VariableTypeSize::_64)
+        {
+            val->uint64 >>= bitoffset;
+        }
+#endif
+
+        if (output_type_size == VariableTypeSize::_8)
+        {
+            uint8_t mask = 1;
+            for (uint_fast8_t i = 1; i < bitsize; i++)
+            {
+                mask |= static_cast<uint8_t>(1u << i);
+            }
+            val->uint8 &= mask;
+            if (var_tt == VariableTypeType::_sint && (val->uint8 >> (bitsize - 1)))
+            {
+                val->uint8 |= static_cast<uint8_t>(~mask);
+            }
+        }
+        else if (output_type_size == VariableTypeSize::_16)
+        {
+            uint16_t mask = 0x1FF;
+            for (uint_fast8_t i = 9; i < bitsize; i++)
+            {
+                mask |= static_cast<uint16_t>(1u << i);
+            }
+            val->uint16 &= mask;
+            if (var_tt == VariableTypeType::_sint && (val->uint16 >> (bitsize - 1)))
+            {
+                val->uint16 |= static_cast<uint16_t>(~mask);
+            }
+        }
+        else if (output_type_size == VariableTypeSize::_32)
+        {
+            uint32_t mask = 0x1FFFF;
+            for (uint_fast8_t i = 17; i < bitsize; i++)
+            {
+                mask |= (static_cast<uint32_t>(1) << i);
+            }
+            val->uint32 &= mask;
+            if (var_tt == VariableTypeType::_sint && (val->uint32 >> (bitsize - 1)))
+            {
+                val->uint32 |= ~mask;
+            }
+        }
+#if SCRUTINY_SUPPORT_64BITS
+        else if (output_type_size == VariableTypeSize::_64)
+        {
+            uint64_t mask = 0x1FFFFFFFF;
+            for (uint_fast8_t i = 33; i < bitsize; i++)
+            {
+                mask |= (static_cast<uint64_t>(1) << i);
+            }
+            val->uint64 &= mask;
+            if (var_tt == VariableTypeType::_sint && (val->uint64 >> (bitsize - 1)))
+            {
+                val->uint64 |= ~mask;
+            }
+        }
+#endif
+        else
+        {
+            success = false;
+        }
+    }
+    else
+    {
+        success = false;
+    }
+
+    *output_type = success ? output_variable_type : scrutiny::VariableType::unknown;
+    return success;
+}
+
 TEST_F(TestVariableFetching, RandomFetch)
 {
     uint8_t some_buffer[32];
@@ -257,3 +382,90 @@ TEST_F(TestVariableFetching, Bitfield)
     EXPECT_EQ(outtype, scrutiny::VariableType::sint64);
 #endif
 }
+
+TEST_F(TestVariableFetching, BitfieldEquivalence)
+{
+    // Compare the descriptor based extraction with the reference for every offset, size and type type, on a few memory patterns
+    constexpr unsigned int BIGGEST_BITS = sizeof(scrutiny::uint_biggest_t) * 8;
+    scrutiny::VariableTypeType const type_types[] = {
+        scrutiny::VariableTypeType::_uint,
+        scrutiny::VariableTypeType::_sint,
+        scrutiny::VariableTypeType::_boolean,
+        scrutiny::VariableTypeType::_float};
+
+    uint8_t buffer[2 * sizeof(scrutiny::uint_biggest_t)];
+    srand(1234);
+
+    for (unsigned int pattern = 0; pattern < 4; pattern++)
+    {
+        for (unsigned int i = 0; i < sizeof(buffer); i++)
+        {
+            buffer[i] = (pattern == 0) ? 0x00 : (pattern == 1) ? 0xFF
+                                                               : static_cast<uint8_t>(rand());
+        }
+
+        for (unsigned int tt = 0; tt < sizeof(type_types) / sizeof(type_types[0]); tt++)
+        {
+            for (unsigned int bitoffset = 0; bitoffset < BIGGEST_BITS; bitoffset++)
+            {
+                for (unsigned int bitsize = 0; bitsize <= BIGGEST_BITS; bitsize++)
+                {
+                    scrutiny::AnyType expected_val;
+                    scrutiny::AnyType val;
+                    scrutiny::VariableType expected_type;
+                    scrutiny::VariableType outtype;
+                    memset(&expected_val, 0, sizeof(expected_val));
+                    memset(&val, 0, sizeof(val));
+
+                    bool const expected_success = reference_fetch_variable_bitfield(buffer, type_types[tt], bitoffset, bitsize, &expected_val, &expected_type);
+                    bool const success = scrutiny_handler.fetch_variable_bitfield(buffer, type_types[tt], bitoffset, bitsize, &val, &outtype);
+
+                    if (expected_success && expected_type == scrutiny::VariableType::unknown)
+                    {
+                        // Booleans wider than 8 bits were accepted with an unknown output type. They are now refused.
+                        EXPECT_FALSE(success);
+                        continue;
+                    }
+
+                    ASSERT_EQ(success, expected_success) << "pattern=" << pattern << ", tt=" << tt << ", bitoffset=" << bitoffset << ", bitsize=" << bitsize;
+                    ASSERT_EQ(outtype, expected_type) << "pattern=" << pattern << ", tt=" << tt << ", bitoffset=" << bitoffset << ", bitsize=" << bitsize;
+                    if (success)
+                    {
+                        ASSERT_BUF_EQ(reinterpret_cast<uint8_t *>(&val), reinterpret_cast<uint8_t *>(&expected_val), scrutiny::tools::get_type_size(outtype))
+                            << "pattern=" << pattern << ", tt=" << tt << ", bitoffset=" << bitoffset << ", bitsize=" << bitsize;
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_F(TestVariableFetching, BitfieldDescriptor)
+{
+    uint8_t buffer[4] = {0xF8, 0xFF, 0x00, 0x00}; // bits 3-13 are 1 -> -1 in an 11 bits signed field
+    scrutiny::tools::BitfieldDescriptor descriptor;
+    scrutiny::AnyType outval;
+    scrutiny::VariableType outtype;
+
+    ASSERT_TRUE(scrutiny::tools::make_bitfield_descriptor(scrutiny::VariableTypeType::_sint, 3, 11, &descriptor));
+    EXPECT_EQ(descriptor.fetch_size, 2u);
+    EXPECT_EQ(descriptor.output_type, scrutiny::VariableType::sint16);
+    EXPECT_TRUE(scrutiny_handler.fetch_variable_bitfield(buffer, &descriptor, &outval, &outtype));
+    EXPECT_EQ(outtype, scrutiny::VariableType::sint16);
+    EXPECT_EQ(outval.sint16, -1);
+
+    ASSERT_TRUE(scrutiny::tools::make_bitfield_descriptor(scrutiny::VariableTypeType::_uint, 3, 11, &descriptor));
+    EXPECT_TRUE(scrutiny_handler.fetch_variable_bitfield(buffer, &descriptor, &outval, &outtype));
+    EXPECT_EQ(outtype, scrutiny::VariableType::uint16);
+    EXPECT_EQ(outval.uint16, 0x7FF);
+
+    // Forbidden region is still checked with a precomputed descriptor
+    EXPECT_FALSE(scrutiny_handler.fetch_variable_bitfield(forbidden_buffer, &descriptor, &outval, &outtype));
+    EXPECT_EQ(outtype, scrutiny::VariableType::unknown);
+
+    EXPECT_FALSE(scrutiny::tools::make_bitfield_descriptor(scrutiny::VariableTypeType::_float, 0, 8, &descriptor));
+    EXPECT_EQ(descriptor.extract, nullptr);
+    EXPECT_FALSE(scrutiny::tools::make_bitfield_descriptor(scrutiny::VariableTypeType::_uint, 0, 0, &descriptor));
+    EXPECT_FALSE(scrutiny::tools::make_bitfield_descriptor(scrutiny::VariableTypeType::_boolean, 0, 9, &descriptor));
+    EXPECT_FALSE(scrutiny_handler.fetch_variable_bitfield(buffer, &descriptor, &outval, &outtype));
+}